@@ -28,7 +28,9 @@ namespace ton {
 namespace adnl {
 
 td::actor::ActorOwn<AdnlNetworkManager> AdnlNetworkManager::create(td::uint16 port) {
-  return td::actor::create_actor<AdnlNetworkManagerImpl>("NetworkManager", port);
+  return td::actor::create_actor<AdnlNetworkManagerImpl>(
+      td::actor::ActorOptions().with_name("NetworkManager").on_scheduler(td::actor::dedicated_scheduler("adnl")),
+      port);
 }
 
 AdnlNetworkManagerImpl::OutDesc *AdnlNetworkManagerImpl::choose_out_iface(td::uint8 cat, td::uint32 priority) {
@@ -349,13 +349,43 @@ void AdnlPeerTableImpl::deliver_query(AdnlNodeIdShort src, AdnlNodeIdShort dst,
                                       td::Promise<td::BufferSlice> promise) {
   auto it = local_ids_.find(dst);
   if (it != local_ids_.end()) {
-    td::actor::send_closure(it->second.local_id, &AdnlLocalId::deliver_query, src, std::move(data), std::move(promise));
+    auto now = td::Time::now();
+    if (query_admission_.gc(now)) {
+      VLOG(ADNL_INFO) << this << ": inbound queries: " << query_admission_.total_rejected() << " rejected total";
+    }
+    auto category = AdnlQueryAdmission::query_category(data.as_slice());
+    if (!query_admission_.admit(src, category, data.size(), now)) {
+      VLOG(ADNL_DEBUG) << this << ": rejecting query " << td::format::as_hex(category) << " from " << src
+                       << ": over budget";
+      promise.set_error(td::Status::Error(ErrorCode::notready, "query rejected: over budget"));
+      return;
+    }
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), src, category,
+                                         promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+      td::uint64 answer_size = R.is_ok() ? R.ok().size() : 0;
+      td::actor::send_closure(SelfId, &AdnlPeerTableImpl::query_answered, src, category, answer_size);
+      promise.set_result(std::move(R));
+    });
+    td::actor::send_closure(it->second.local_id, &AdnlLocalId::deliver_query, src, std::move(data), std::move(P));
   } else {
     LOG(WARNING) << "deliver query: unknown dst " << dst;
     promise.set_error(td::Status::Error(ErrorCode::notready, "cannot deliver: unknown DST"));
   }
 }
 
+void AdnlPeerTableImpl::query_answered(AdnlNodeIdShort src, AdnlQueryAdmission::Category category,
+                                       td::uint64 answer_size) {
+  query_admission_.finished(src, category, answer_size, td::Time::now());
+}
+
+void AdnlPeerTableImpl::set_query_admission_options(AdnlQueryAdmissionOptions opts) {
+  query_admission_.set_options(opts);
+}
+
+void AdnlPeerTableImpl::get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  promise.set_value(query_admission_.stats());
+}
+
 void AdnlPeerTableImpl::decrypt_message(AdnlNodeIdShort dst, td::BufferSlice data,
                                         td::Promise<td::BufferSlice> promise) {
   auto it = local_ids_.find(dst);
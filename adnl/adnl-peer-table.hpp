@@ -31,6 +31,7 @@
 #include "adnl-static-nodes.h"
 #include "adnl-ext-server.h"
 #include "adnl-address-list.h"
+#include "adnl-query-admission.h"
 
 namespace ton {
 
@@ -95,6 +96,9 @@ class AdnlPeerTableImpl : public AdnlPeerTable {
   void deliver(AdnlNodeIdShort src, AdnlNodeIdShort dst, td::BufferSlice data) override;
   void deliver_query(AdnlNodeIdShort src, AdnlNodeIdShort dst, td::BufferSlice data,
                      td::Promise<td::BufferSlice> promise) override;
+  void query_answered(AdnlNodeIdShort src, AdnlQueryAdmission::Category category, td::uint64 answer_size);
+  void set_query_admission_options(AdnlQueryAdmissionOptions opts) override;
+  void get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
   void decrypt_message(AdnlNodeIdShort dst, td::BufferSlice data, td::Promise<td::BufferSlice> promise) override;
 
   void create_ext_server(std::vector<AdnlNodeIdShort> ids, std::vector<td::uint16> ports,
@@ -130,6 +134,8 @@ class AdnlPeerTableImpl : public AdnlPeerTable {
 
   td::actor::ActorOwn<AdnlExtServer> ext_server_;
 
+  AdnlQueryAdmission query_admission_;
+
   AdnlNodeIdShort proxy_addr_;
   //std::map<td::uint64, td::actor::ActorId<AdnlQuery>> out_queries_;
   //td::uint64 last_query_id_ = 1;
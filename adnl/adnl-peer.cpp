@@ -523,7 +523,7 @@ void AdnlPeerPairImpl::process_message(const adnlmessage::AdnlMessageQuery &mess
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), query_id = message.query_id(),
                                        flags = static_cast<td::uint32>(0)](td::Result<td::BufferSlice> R) {
     if (R.is_error()) {
-      LOG(WARNING) << "failed to answer query: " << R.move_as_error();
+      VLOG(ADNL_INFO) << "failed to answer query: " << R.move_as_error();
     } else {
       auto data = R.move_as_ok();
       if (data.size() > Adnl::huge_packet_max_size()) {
@@ -534,7 +534,8 @@ void AdnlPeerPairImpl::process_message(const adnlmessage::AdnlMessageQuery &mess
       }
     }
   });
-  td::actor::send_closure(local_actor_, &AdnlLocalId::deliver_query, peer_id_short_, message.data(), std::move(P));
+  td::actor::send_closure(peer_table_, &AdnlPeerTable::deliver_query, peer_id_short_, local_id_, message.data(),
+                          std::move(P));
 }
 
 void AdnlPeerPairImpl::process_message(const adnlmessage::AdnlMessageAnswer &message) {
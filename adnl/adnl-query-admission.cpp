@@ -0,0 +1,294 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "adnl-query-admission.h"
+
+#include "auto/tl/ton_api.h"
+#include "auto/tl/lite_api.h"
+#include "td/utils/as.h"
+#include "td/utils/format.h"
+
+namespace ton {
+
+namespace adnl {
+
+namespace {
+
+td::int32 raw_query_id(td::Slice data) {
+  if (data.size() < 4) {
+    return 0;
+  }
+  td::int32 id = td::as<td::int32>(data.ubegin());
+  if (id == ton_api::overlay_query::ID && data.size() >= 4 + 32 + 4) {
+    return td::as<td::int32>(data.ubegin() + 4 + 32);
+  }
+  if (id == lite_api::liteServer_query::ID && data.size() >= 4 + 1 + 4) {
+    // liteServer.query data:bytes; look at the first constructor inside the bytes
+    size_t offset = 5;
+    if (data.ubegin()[4] == 254) {
+      offset = 8;
+    }
+    if (data.size() >= offset + 4) {
+      td::int32 inner = td::as<td::int32>(data.ubegin() + offset);
+      if (inner == lite_api::liteServer_waitMasterchainSeqno::ID && data.size() >= offset + 12 + 4) {
+        inner = td::as<td::int32>(data.ubegin() + offset + 12);
+      }
+      return inner;
+    }
+  }
+  return id;
+}
+
+const std::vector<td::int32> &known_queries() {
+  static const std::vector<td::int32> res = [] {
+    std::vector<td::int32> v = {
+      ton_api::adnl_ping::ID,
+      ton_api::catchain_getBlock::ID,
+      ton_api::catchain_getBlockHistory::ID,
+      ton_api::catchain_getBlocks::ID,
+      ton_api::catchain_getDifference::ID,
+      ton_api::dht_findNode::ID,
+      ton_api::dht_findValue::ID,
+      ton_api::dht_getSignedAddressList::ID,
+      ton_api::dht_ping::ID,
+      ton_api::dht_query::ID,
+      ton_api::dht_store::ID,
+      ton_api::http_getNextPayloadPart::ID,
+      ton_api::http_request::ID,
+      ton_api::overlay_getBroadcast::ID,
+      ton_api::overlay_getBroadcastList::ID,
+      ton_api::overlay_getRandomPeers::ID,
+      ton_api::storage_addUpdate::ID,
+      ton_api::storage_getPiece::ID,
+      ton_api::storage_ping::ID,
+      ton_api::storage_queryPrefix::ID,
+      ton_api::tonNode_downloadBlock::ID,
+      ton_api::tonNode_downloadBlockFull::ID,
+      ton_api::tonNode_downloadBlockProof::ID,
+      ton_api::tonNode_downloadBlockProofLink::ID,
+      ton_api::tonNode_downloadBlockProofLinks::ID,
+      ton_api::tonNode_downloadBlockProofs::ID,
+      ton_api::tonNode_downloadBlocks::ID,
+      ton_api::tonNode_downloadKeyBlockProof::ID,
+      ton_api::tonNode_downloadKeyBlockProofLink::ID,
+      ton_api::tonNode_downloadKeyBlockProofLinks::ID,
+      ton_api::tonNode_downloadKeyBlockProofs::ID,
+      ton_api::tonNode_downloadNextBlockFull::ID,
+      ton_api::tonNode_downloadPersistentState::ID,
+      ton_api::tonNode_downloadPersistentStateSlice::ID,
+      ton_api::tonNode_downloadZeroState::ID,
+      ton_api::tonNode_getArchiveInfo::ID,
+      ton_api::tonNode_getArchiveSize::ID,
+      ton_api::tonNode_getArchiveSlice::ID,
+      ton_api::tonNode_getCapabilities::ID,
+      ton_api::tonNode_getNextBlockDescription::ID,
+      ton_api::tonNode_getNextBlocksDescription::ID,
+      ton_api::tonNode_getNextKeyBlockIds::ID,
+      ton_api::tonNode_getPersistentStateSize::ID,
+      ton_api::tonNode_getPrevBlocksDescription::ID,
+      ton_api::tonNode_prepareBlock::ID,
+      ton_api::tonNode_prepareBlockProof::ID,
+      ton_api::tonNode_prepareBlockProofs::ID,
+      ton_api::tonNode_prepareBlocks::ID,
+      ton_api::tonNode_prepareKeyBlockProof::ID,
+      ton_api::tonNode_prepareKeyBlockProofs::ID,
+      ton_api::tonNode_preparePersistentState::ID,
+      ton_api::tonNode_prepareZeroState::ID,
+      ton_api::validatorSession_downloadCandidate::ID,
+      ton_api::validatorSession_ping::ID,
+      lite_api::liteServer_getAccountState::ID,
+      lite_api::liteServer_getAllShardsInfo::ID,
+      lite_api::liteServer_getBlock::ID,
+      lite_api::liteServer_getBlockHeader::ID,
+      lite_api::liteServer_getBlockProof::ID,
+      lite_api::liteServer_getConfigAll::ID,
+      lite_api::liteServer_getConfigParams::ID,
+      lite_api::liteServer_getMasterchainInfo::ID,
+      lite_api::liteServer_getMasterchainInfoExt::ID,
+      lite_api::liteServer_getOneTransaction::ID,
+      lite_api::liteServer_getShardInfo::ID,
+      lite_api::liteServer_getState::ID,
+      lite_api::liteServer_getTime::ID,
+      lite_api::liteServer_getTransactions::ID,
+      lite_api::liteServer_getValidatorStats::ID,
+      lite_api::liteServer_getVersion::ID,
+      lite_api::liteServer_listBlockTransactions::ID,
+      lite_api::liteServer_lookupBlock::ID,
+      lite_api::liteServer_runSmcMethod::ID,
+      lite_api::liteServer_sendMessage::ID,
+      lite_api::liteServer_waitMasterchainSeqno::ID,
+    };
+    std::sort(v.begin(), v.end());
+    return v;
+  }();
+  return res;
+}
+
+}  // namespace
+
+AdnlQueryAdmission::Category AdnlQueryAdmission::query_category(td::Slice data) {
+  auto id = raw_query_id(data);
+  auto &known = known_queries();
+  if (id == other_category() || !std::binary_search(known.begin(), known.end(), id)) {
+    return other_category();
+  }
+  return id;
+}
+
+bool AdnlQueryAdmission::is_exempt(Category category) {
+  switch (category) {
+    case ton_api::catchain_getBlock::ID:
+    case ton_api::catchain_getBlockHistory::ID:
+    case ton_api::catchain_getBlocks::ID:
+    case ton_api::catchain_getDifference::ID:
+    case ton_api::validatorSession_downloadCandidate::ID:
+    case ton_api::validatorSession_ping::ID:
+    case ton_api::overlay_getBroadcast::ID:
+    case ton_api::overlay_getBroadcastList::ID:
+    case ton_api::overlay_getRandomPeers::ID:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void AdnlQueryAdmission::set_options(AdnlQueryAdmissionOptions opts) {
+  opts_ = opts;
+  // buckets are recreated with the new limits on next use
+  for (auto it = peers_.begin(); it != peers_.end();) {
+    if (it->second.inflight == 0) {
+      it = peers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+AdnlQueryAdmission::Peer &AdnlQueryAdmission::get_peer(AdnlNodeIdShort src, double now) {
+  auto it = peers_.find(src);
+  if (it == peers_.end()) {
+    it = peers_
+             .emplace(src, Peer{Budget{opts_.peer_queries_rate, opts_.peer_queries_burst, opts_.peer_bytes_rate,
+                                       opts_.peer_bytes_burst, now}})
+             .first;
+  }
+  return it->second;
+}
+
+AdnlQueryAdmission::Budget &AdnlQueryAdmission::category_budget(Peer &peer, Category category, double now) {
+  auto it = peer.categories.find(category);
+  if (it == peer.categories.end()) {
+    it = peer.categories
+             .emplace(category, Budget{opts_.category_queries_rate, opts_.category_queries_burst,
+                                       opts_.category_bytes_rate, opts_.category_bytes_burst, now})
+             .first;
+  }
+  return it->second;
+}
+
+bool AdnlQueryAdmission::admit(AdnlNodeIdShort src, Category category, td::uint64 size, double now) {
+  auto &counters = counters_[category];
+  if (is_exempt(category)) {
+    counters.admitted++;
+    total_admitted_++;
+    return true;
+  }
+  auto &peer = get_peer(src, now);
+  if (opts_.peer_max_inflight > 0 && peer.inflight >= opts_.peer_max_inflight) {
+    counters.rejected_inflight++;
+    total_rejected_++;
+    return false;
+  }
+  if (!peer.budget.check(now)) {
+    counters.rejected_peer++;
+    total_rejected_++;
+    return false;
+  }
+  auto &cat = category_budget(peer, category, now);
+  if (!cat.check(now)) {
+    counters.rejected_category++;
+    total_rejected_++;
+    return false;
+  }
+  peer.budget.charge(1, size);
+  cat.charge(1, size);
+  peer.inflight++;
+  counters.admitted++;
+  total_admitted_++;
+  return true;
+}
+
+void AdnlQueryAdmission::finished(AdnlNodeIdShort src, Category category, td::uint64 answer_size, double now) {
+  if (is_exempt(category)) {
+    return;
+  }
+  auto it = peers_.find(src);
+  if (it == peers_.end()) {
+    // options were changed while the query was processed
+    return;
+  }
+  auto &peer = it->second;
+  if (peer.inflight > 0) {
+    peer.inflight--;
+  }
+  peer.budget.charge(0, answer_size);
+  category_budget(peer, category, now).charge(0, answer_size);
+}
+
+bool AdnlQueryAdmission::gc(double now) {
+  if (now < next_gc_at_) {
+    return false;
+  }
+  for (auto it = peers_.begin(); it != peers_.end();) {
+    auto &peer = it->second;
+    peer.budget.check(now);
+    bool idle = peer.inflight == 0 && peer.budget.full();
+    for (auto &c : peer.categories) {
+      c.second.check(now);
+      idle = idle && c.second.full();
+    }
+    if (idle) {
+      it = peers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  next_gc_at_ = now + gc_period();
+  return true;
+}
+
+std::vector<std::pair<std::string, std::string>> AdnlQueryAdmission::stats() const {
+  std::vector<std::pair<std::string, std::string>> res;
+  res.emplace_back("adnl.queries.admitted", PSTRING() << total_admitted_);
+  res.emplace_back("adnl.queries.rejected", PSTRING() << total_rejected_);
+  res.emplace_back("adnl.queries.tracked_peers", PSTRING() << peers_.size());
+  for (auto &c : counters_) {
+    if (c.second.rejected_inflight == 0 && c.second.rejected_peer == 0 && c.second.rejected_category == 0) {
+      continue;
+    }
+    res.emplace_back(PSTRING() << "adnl.queries.rejected." << td::format::as_hex(c.first),
+                     PSTRING() << c.second.rejected_inflight << " by inflight, " << c.second.rejected_peer
+                               << " by peer, " << c.second.rejected_category << " by category, "
+                               << c.second.admitted << " admitted");
+  }
+  return res;
+}
+
+}  // namespace adnl
+
+}  // namespace ton
@@ -0,0 +1,163 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "adnl-node-id.hpp"
+#include "td/utils/Slice.h"
+#include "td/utils/Time.h"
+
+namespace ton {
+
+namespace adnl {
+
+// Limits for inbound queries of one peer. Rates are per second, bursts are bucket capacities. The per-category limits
+// apply to each query category of the peer separately, so that one kind of query can not use up the whole budget of
+// the peer. Zero disables a limit.
+struct AdnlQueryAdmissionOptions {
+  td::uint32 peer_max_inflight = 64;
+  double peer_queries_rate = 100.0;
+  double peer_queries_burst = 400.0;
+  double peer_bytes_rate = 16 << 20;
+  double peer_bytes_burst = 64 << 20;
+  double category_queries_rate = 50.0;
+  double category_queries_burst = 200.0;
+  double category_bytes_rate = 8 << 20;
+  double category_bytes_burst = 32 << 20;
+};
+
+// Token-bucket admission of inbound queries per source peer and per query category of the peer (TL constructor of the
+// query, looking through overlay.query and liteServer.query wrappers). A query costs one query token and its size plus
+// the size of its answer in byte tokens; answers are charged when they are ready, so the bytes buckets may go negative
+// and block further queries until refilled. The time a query takes is not charged: it is mostly waiting on other
+// actors or, for long polls like liteServer.waitMasterchainSeqno, on purpose. Instead the number of queries of a peer
+// being processed at once is limited. Consensus queries (catchain, validator session and overlay service queries)
+// are never rejected.
+class AdnlQueryAdmission {
+ public:
+  using Category = td::int32;
+
+  explicit AdnlQueryAdmission(AdnlQueryAdmissionOptions opts = {}) : opts_(opts) {
+  }
+  void set_options(AdnlQueryAdmissionOptions opts);
+
+  // constructor id of a known query, other_category() for the rest
+  static Category query_category(td::Slice data);
+  static constexpr Category other_category() {
+    return 0;
+  }
+  static bool is_exempt(Category category);
+
+  // checks budgets and charges the query; returns false if the query must be rejected
+  bool admit(AdnlNodeIdShort src, Category category, td::uint64 size, double now);
+  // charges the answer of an admitted query
+  void finished(AdnlNodeIdShort src, Category category, td::uint64 answer_size, double now);
+
+  // drops state of idle peers, returns true once per gc period
+  bool gc(double now);
+
+  std::vector<std::pair<std::string, std::string>> stats() const;
+  td::uint64 total_rejected() const {
+    return total_rejected_;
+  }
+  size_t tracked_peers() const {
+    return peers_.size();
+  }
+
+ private:
+  struct TokenBucket {
+    double tokens;
+    double rate;
+    double burst;
+    double updated_at;
+
+    TokenBucket(double rate, double burst, double now) : tokens(burst), rate(rate), burst(burst), updated_at(now) {
+    }
+    void refill(double now) {
+      if (now > updated_at) {
+        tokens = std::min(burst, tokens + (now - updated_at) * rate);
+        updated_at = now;
+      }
+    }
+    bool full() const {
+      return rate <= 0 || tokens >= burst;
+    }
+    bool check(double now) {
+      refill(now);
+      return rate <= 0 || tokens > 0;
+    }
+  };
+  struct Budget {
+    TokenBucket queries;
+    TokenBucket bytes;
+
+    Budget(double queries_rate, double queries_burst, double bytes_rate, double bytes_burst, double now)
+        : queries(queries_rate, queries_burst, now), bytes(bytes_rate, bytes_burst, now) {
+    }
+    bool check(double now) {
+      // both buckets are refilled even if the first check fails
+      bool ok = queries.check(now);
+      return bytes.check(now) && ok;
+    }
+    void charge(td::uint32 queries_cnt, td::uint64 size) {
+      queries.tokens -= queries_cnt;
+      bytes.tokens -= static_cast<double>(size);
+    }
+    bool full() const {
+      return queries.full() && bytes.full();
+    }
+  };
+  struct Peer {
+    Budget budget;
+    std::map<Category, Budget> categories;
+    td::uint32 inflight = 0;
+
+    explicit Peer(Budget budget) : budget(std::move(budget)) {
+    }
+  };
+  struct Counters {
+    td::uint64 admitted = 0;
+    td::uint64 rejected_inflight = 0;
+    td::uint64 rejected_peer = 0;
+    td::uint64 rejected_category = 0;
+  };
+
+  Peer &get_peer(AdnlNodeIdShort src, double now);
+  Budget &category_budget(Peer &peer, Category category, double now);
+
+  AdnlQueryAdmissionOptions opts_;
+  std::map<AdnlNodeIdShort, Peer> peers_;
+  // keyed by query_category(), so the number of entries is bounded
+  std::map<Category, Counters> counters_;
+  td::uint64 total_admitted_ = 0;
+  td::uint64 total_rejected_ = 0;
+  double next_gc_at_ = 0;
+
+  static constexpr double gc_period() {
+    return 60.0;
+  }
+};
+
+}  // namespace adnl
+
+}  // namespace ton
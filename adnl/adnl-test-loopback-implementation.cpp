@@ -33,6 +33,38 @@ AdnlAddressList TestLoopbackNetworkManager::generate_dummy_addr_list(bool empty)
   return addrR.move_as_ok();
 }
 
+double TestLoopbackNetworkManager::link_delay(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, size_t size) {
+  auto now = td::Time::now();
+  auto at = now;
+  auto it = links_.find(src_id);
+  if (it != links_.end()) {
+    auto &link = it->second;
+    if (link.bandwidth > 0) {
+      // packets leave a node one after another, a busy uplink delays the following ones
+      link.busy_until = std::max(link.busy_until, now) + static_cast<double>(size) / link.bandwidth;
+      at = link.busy_until;
+    }
+    at += link.latency;
+  }
+  it = links_.find(dst_id);
+  if (it != links_.end()) {
+    at += it->second.latency;
+  }
+  return at;
+}
+
+void TestLoopbackNetworkManager::alarm() {
+  auto now = td::Time::now();
+  while (!queue_.empty() && queue_.begin()->first <= now) {
+    auto packet = std::move(queue_.begin()->second);
+    queue_.erase(queue_.begin());
+    deliver_packet(packet.dst_addr, std::move(packet.data));
+  }
+  if (!queue_.empty()) {
+    alarm_timestamp() = td::Timestamp::at(queue_.begin()->first);
+  }
+}
+
 }  // namespace adnl
 
 }  // namespace ton
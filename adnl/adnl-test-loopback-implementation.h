@@ -21,6 +21,7 @@
 #include "adnl/adnl.h"
 #include "td/utils/Random.h"
 
+#include <map>
 #include <set>
 
 namespace ton {
@@ -49,9 +50,13 @@ class TestLoopbackNetworkManager : public ton::adnl::AdnlNetworkManager {
       return;
     }
     CHECK(callback_);
-    AdnlCategoryMask m;
-    m[0] = true;
-    callback_->receive_packet(dst_addr, std::move(m), std::move(data));
+    if (links_.empty()) {
+      deliver_packet(dst_addr, std::move(data));
+      return;
+    }
+    auto at = link_delay(src_id, dst_id, data.size());
+    queue_.emplace(at, Packet{dst_addr, std::move(data)});
+    alarm_timestamp().relax(td::Timestamp::at(queue_.begin()->first));
   }
 
   void add_node_id(AdnlNodeIdShort id, bool allow_send, bool allow_receive) {
@@ -71,6 +76,14 @@ class TestLoopbackNetworkManager : public ton::adnl::AdnlNetworkManager {
     CHECK(p >= 0 && p <= 1);
     loss_probability_ = p;
   }
+  // simulated link of a node: one-way latency in seconds and uplink bandwidth in bytes per second (0 - unlimited)
+  void set_node_link(AdnlNodeIdShort id, double latency, double bandwidth) {
+    CHECK(latency >= 0 && bandwidth >= 0);
+    auto &link = links_[id];
+    link.latency = latency;
+    link.bandwidth = bandwidth;
+  }
+  void alarm() override;
   void set_local_id_category(AdnlNodeIdShort id, td::uint8 cat) override {
   }
 
@@ -84,6 +97,25 @@ class TestLoopbackNetworkManager : public ton::adnl::AdnlNetworkManager {
   std::set<AdnlNodeIdShort> allowed_destinations_;
   std::unique_ptr<Callback> callback_;
   double loss_probability_ = 0.0;
+
+  struct Link {
+    double latency = 0.0;
+    double bandwidth = 0.0;
+    double busy_until = 0.0;
+  };
+  struct Packet {
+    td::IPAddress dst_addr;
+    td::BufferSlice data;
+  };
+  std::map<AdnlNodeIdShort, Link> links_;
+  std::multimap<double, Packet> queue_;
+
+  double link_delay(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, size_t size);
+  void deliver_packet(td::IPAddress dst_addr, td::BufferSlice data) {
+    AdnlCategoryMask m;
+    m[0] = true;
+    callback_->receive_packet(dst_addr, std::move(m), std::move(data));
+  }
 };
 
 }  // namespace adnl
@@ -23,6 +23,7 @@
 #include "td/utils/port/IPAddress.h"
 #include "adnl-node-id.hpp"
 #include "adnl-node.h"
+#include "adnl-query-admission.h"
 #include "common/errorcode.h"
 #include "keyring/keyring.h"
 
@@ -118,6 +119,10 @@ class Adnl : public AdnlSenderInterface {
   virtual void create_tunnel(AdnlNodeIdShort dst, td::uint32 size,
                              td::Promise<std::pair<td::actor::ActorOwn<AdnlTunnel>, AdnlAddress>> promise) = 0;
 
+  // inbound query admission counters and other runtime stats
+  virtual void get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
+  virtual void set_query_admission_options(AdnlQueryAdmissionOptions opts) = 0;
+
   static td::actor::ActorOwn<Adnl> create(std::string db, td::actor::ActorId<keyring::Keyring> keyring);
 
   static std::string int_to_bytestring(td::int32 id) {
@@ -322,7 +322,14 @@ void CatChainReceivedBlockImpl::schedule() {
 }
 
 void CatChainReceivedBlockImpl::find_pending_deps(std::vector<CatChainBlockHash> &vec, td::uint32 max_size) const {
-  if (height_ == 0 || is_ill() || delivered() || vec.size() == max_size) {
+  std::set<const CatChainReceivedBlockImpl *> visited;
+  find_pending_deps(vec, max_size, visited);
+}
+
+// undelivered blocks share most of their dependencies, so every block is visited only once
+void CatChainReceivedBlockImpl::find_pending_deps(std::vector<CatChainBlockHash> &vec, td::uint32 max_size,
+                                                  std::set<const CatChainReceivedBlockImpl *> &visited) const {
+  if (height_ == 0 || is_ill() || delivered() || vec.size() == max_size || !visited.insert(this).second) {
     return;
   }
   if (!initialized()) {
@@ -330,10 +337,10 @@ void CatChainReceivedBlockImpl::find_pending_deps(std::vector<CatChainBlockHash>
     return;
   }
   if (prev_) {
-    prev_->find_pending_deps(vec, max_size);
+    prev_->find_pending_deps(vec, max_size, visited);
   }
   for (auto &X : block_deps_) {
-    X->find_pending_deps(vec, max_size);
+    X->find_pending_deps(vec, max_size, visited);
   }
 }
 
@@ -20,6 +20,8 @@
 
 #include "catchain/catchain-received-block.h"
 
+#include <set>
+
 namespace ton {
 
 namespace catchain {
@@ -106,6 +108,8 @@ class CatChainReceivedBlockImpl : public CatChainReceivedBlock {
 
   void set_ill() override;
   void schedule();
+  void find_pending_deps(std::vector<CatChainBlockHash> &vec, td::uint32 max_size,
+                         std::set<const CatChainReceivedBlockImpl *> &visited) const;
 
   void written() override;
 
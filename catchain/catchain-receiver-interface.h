@@ -33,12 +33,18 @@ class CatChainReceiverInterface : public td::actor::Actor {
    public:
     virtual void new_block(td::uint32 src_id, td::uint32 fork_id, CatChainBlockHash hash, CatChainBlockHeight height,
                            CatChainBlockHash prev, std::vector<CatChainBlockHash> deps,
-                           std::vector<CatChainBlockHeight> vt, td::SharedSlice data) = 0;
+                           std::vector<CatChainBlockHeight> vt, td::SharedSlice data, bool restored) = 0;
     virtual void blame(td::uint32 src_id) = 0;
     virtual void on_custom_message(PublicKeyHash src, td::BufferSlice data) = 0;
     virtual void on_custom_query(PublicKeyHash src, td::BufferSlice data, td::Promise<td::BufferSlice> promise) = 0;
     virtual void on_broadcast(PublicKeyHash src, td::BufferSlice data) = 0;
     virtual void start() = 0;
+    // consumer state for the checkpoint, it covers all blocks delivered before the call
+    virtual void get_snapshot(td::Promise<td::BufferSlice> promise) = 0;
+    // consumer state from the checkpoint, blocks covered by it are delivered with restored = true;
+    // finish_restore() is called after all of them are delivered
+    virtual void restore_snapshot(td::BufferSlice data) = 0;
+    virtual void finish_restore() = 0;
     virtual ~Callback() = default;
   };
   virtual void add_block(td::BufferSlice payload, std::vector<CatChainBlockHash> deps) = 0;
@@ -43,10 +43,15 @@ void CatChainReceiverImpl::deliver_block(CatChainReceivedBlock *block) {
   VLOG(CATCHAIN_INFO) << this << ": delivering block " << block->get_hash() << " src=" << block->get_source_id()
                       << " fork=" << block->get_fork_id() << " height=" << block->get_height()
                       << " custom=" << block->is_custom();
+  bool restored = checkpoint_restored_.erase(block->get_hash()) > 0;
   callback_->new_block(block->get_source_id(), block->get_fork_id(), block->get_hash(), block->get_height(),
                        block->get_height() == 1 ? CatChainBlockHash::zero() : block->get_prev_hash(),
                        block->get_dep_hashes(), block->get_deps(),
-                       block->is_custom() ? block->get_payload().clone() : td::SharedSlice());
+                       block->is_custom() ? block->get_payload().clone() : td::SharedSlice(), restored);
+
+  if (!opts_.debug_disable_db && opts_.checkpoint_period > 0 && !checkpoint_loaded_.erase(block->get_hash())) {
+    checkpoint_blocks_.push_back(block->get_hash());
+  }
 
   std::vector<adnl::AdnlNodeIdShort> v;
 
@@ -168,14 +173,18 @@ CatChainReceivedBlock *CatChainReceiverImpl::create_block(tl_object_ptr<ton_api:
 
   auto it = blocks_.find(hash);
   if (it != blocks_.end()) {
-    if (!it->second->initialized()) {
-      it->second->initialize(std::move(block), std::move(payload));
+    // initialize() may add dependencies to blocks_, which invalidates the iterator
+    auto B = it->second.get();
+    if (!B->initialized()) {
+      B->initialize(std::move(block), std::move(payload));
     }
-    return it->second.get();
+    return B;
   } else {
-    blocks_.emplace(hash, CatChainReceivedBlock::create(std::move(block), std::move(payload), this));
-    it = blocks_.find(hash);
-    return it->second.get();
+    // the same holds for create(), so the block is inserted only after it is constructed
+    auto B = CatChainReceivedBlock::create(std::move(block), std::move(payload), this);
+    auto res = B.get();
+    blocks_.emplace(hash, std::move(B));
+    return res;
   }
 }
 
@@ -188,9 +197,10 @@ CatChainReceivedBlock *CatChainReceiverImpl::create_block(tl_object_ptr<ton_api:
   if (it != blocks_.end()) {
     return it->second.get();
   } else {
-    blocks_.emplace(hash, CatChainReceivedBlock::create(std::move(block), this));
-    it = blocks_.find(hash);
-    return it->second.get();
+    auto B = CatChainReceivedBlock::create(std::move(block), this);
+    auto res = B.get();
+    blocks_.emplace(hash, std::move(B));
+    return res;
   }
 }
 
@@ -495,28 +505,225 @@ void CatChainReceiverImpl::start_up() {
         td::RocksDb::open(db_root_ + "/catchainreceiver" + db_suffix_ + td::base64url_encode(as_slice(incarnation_)))
             .move_as_ok());
     db_ = DbType{std::move(kv)};
+    db_read_started_at_ = td::Time::now();
+    checkpoint_key_ = get_tl_object_sha_bits256(create_tl_object<ton_api::catchain_checkpoint_key>(incarnation_));
+    checkpoint_snapshot_key_ =
+        get_tl_object_sha_bits256(create_tl_object<ton_api::catchain_checkpoint_snapshotKey>(incarnation_));
+    read_checkpoint();
+  } else {
+    read_db();
+  }
+}
 
-    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<DbType::GetResult> R) {
-      R.ensure();
-      auto g = R.move_as_ok();
-      if (g.status == td::KeyValue::GetStatus::NotFound) {
-        td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_db);
-      } else {
-        auto B = std::move(g.value);
-        CHECK(B.size() == 32);
-        CatChainBlockHash x;
-        as_slice(x).copy_from(B.as_slice());
-        td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_db_from, x);
-      }
-    });
+void CatChainReceiverImpl::read_checkpoint() {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<DbType::GetResult> R) {
+    R.ensure();
+    auto g = R.move_as_ok();
+    if (g.status == td::KeyValue::GetStatus::NotFound) {
+      td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_db_root);
+    } else {
+      auto B = std::move(g.value);
+      CHECK(B.size() == 32);
+      CatChainBlockHash x;
+      as_slice(x).copy_from(B.as_slice());
+      td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_checkpoint_chunk, x);
+    }
+  });
+
+  db_.get(checkpoint_key_, std::move(P));
+}
 
-    db_.get(CatChainBlockHash::zero(), std::move(P));
+void CatChainReceiverImpl::read_checkpoint_chunk(CatChainBlockHash id) {
+  if (checkpoint_prev_.is_zero()) {
+    checkpoint_prev_ = id;
+  }
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), id](td::Result<DbType::GetResult> R) {
+    R.ensure();
+    auto g = R.move_as_ok();
+    CHECK(g.status == td::KeyValue::GetStatus::Ok);
+
+    td::actor::send_closure(SelfId, &CatChainReceiverImpl::got_checkpoint_chunk, id, std::move(g.value));
+  });
+
+  db_.get(id, std::move(P));
+}
+
+void CatChainReceiverImpl::got_checkpoint_chunk(CatChainBlockHash id, td::BufferSlice data) {
+  auto F = fetch_tl_object<ton_api::catchain_checkpoint>(std::move(data), true);
+  F.ensure();
+  auto chunk = F.move_as_ok();
+  CHECK(get_tl_object_sha_bits256(chunk) == id);
+
+  checkpoint_chunks_.emplace_back(id, std::move(chunk->blocks_));
+  if (!chunk->prev_.is_zero()) {
+    read_checkpoint_chunk(chunk->prev_);
   } else {
-    read_db();
+    read_checkpoint_snapshot();
+  }
+}
+
+void CatChainReceiverImpl::read_checkpoint_snapshot() {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<DbType::GetResult> R) {
+    R.ensure();
+    auto g = R.move_as_ok();
+    if (g.status == td::KeyValue::GetStatus::NotFound) {
+      td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_checkpoint_blocks, CatChainBlockHash::zero(),
+                              td::BufferSlice());
+      return;
+    }
+    auto F = fetch_tl_object<ton_api::catchain_checkpoint_snapshot>(std::move(g.value), true);
+    F.ensure();
+    auto snapshot = F.move_as_ok();
+    td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_checkpoint_blocks, snapshot->chunk_,
+                            std::move(snapshot->data_));
+  });
+
+  db_.get(checkpoint_snapshot_key_, std::move(P));
+}
+
+void CatChainReceiverImpl::read_checkpoint_blocks(CatChainBlockHash snapshot_chunk, td::BufferSlice snapshot) {
+  // blocks from chunks up to the one covered by the consumer snapshot are not preprocessed again
+  bool restore = false;
+  if (!snapshot.empty()) {
+    for (auto &chunk : checkpoint_chunks_) {
+      if (chunk.first == snapshot_chunk) {
+        restore = true;
+        break;
+      }
+    }
+  }
+  if (restore) {
+    checkpoint_restoring_ = true;
+    callback_->restore_snapshot(std::move(snapshot));
+  }
+
+  // chunks were read from the newest one, blocks are requested in delivery order
+  for (auto it = checkpoint_chunks_.rbegin(); it != checkpoint_chunks_.rend(); it++) {
+    for (auto &id : it->second) {
+      checkpoint_loaded_.insert(id);
+      if (restore) {
+        checkpoint_restored_.insert(id);
+      }
+      pending_in_db_++;
+      auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), id](td::Result<DbType::GetResult> R) {
+        R.ensure();
+        auto g = R.move_as_ok();
+        CHECK(g.status == td::KeyValue::GetStatus::Ok);
+
+        td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_checkpoint_block, id, std::move(g.value));
+      });
+
+      db_.get(id, std::move(P));
+    }
+    if (it->first == snapshot_chunk) {
+      restore = false;
+    }
   }
+  checkpoint_chunks_.clear();
+  VLOG(CATCHAIN_INFO) << this << ": loading " << checkpoint_loaded_.size() << " blocks from checkpoint, "
+                      << checkpoint_restored_.size() << " of them with consumer state";
+  if (!pending_in_db_) {
+    read_db_root();
+  }
+}
+
+void CatChainReceiverImpl::read_checkpoint_block(CatChainBlockHash id, td::BufferSlice data) {
+  pending_in_db_--;
+
+  auto F = fetch_tl_prefix<ton_api::catchain_block>(data, true);
+  F.ensure();
+
+  auto block = F.move_as_ok();
+  auto payload = std::move(data);
+
+  auto block_id = CatChainReceivedBlock::block_hash(this, block, payload);
+  CHECK(block_id == id);
+  CHECK(block->incarnation_ == incarnation_);
+
+  // signature was checked before the block was written to the db
+  CatChainReceivedBlock::pre_validate_block(this, block, payload).ensure();
+
+  auto B = create_block(std::move(block), td::SharedSlice{payload.as_slice()});
+  CHECK(B);
+  B->written();
+
+  if (!pending_in_db_) {
+    read_db_root();
+  }
+}
+
+void CatChainReceiverImpl::write_checkpoint() {
+  if (checkpoint_blocks_.empty()) {
+    return;
+  }
+  auto chunk = create_tl_object<ton_api::catchain_checkpoint>(checkpoint_prev_, std::move(checkpoint_blocks_));
+  checkpoint_blocks_.clear();
+  auto id = get_tl_object_sha_bits256(chunk);
+
+  // blocks listed in the chunk were written before, and db applies writes in order
+  db_.set(
+      id, serialize_tl_object(chunk, true), [](td::Unit) {}, 1.0);
+  td::BufferSlice raw_data{32};
+  raw_data.as_slice().copy_from(as_slice(id));
+  db_.set(
+      checkpoint_key_, std::move(raw_data), [](td::Unit) {}, 1.0);
+  checkpoint_prev_ = id;
+}
+
+void CatChainReceiverImpl::write_checkpoint_snapshot() {
+  if (!checkpoint_snapshots_ || checkpoint_prev_.is_zero() || checkpoint_snapshot_chunk_ == checkpoint_prev_ ||
+      checkpoint_snapshot_pending_) {
+    return;
+  }
+  checkpoint_snapshot_pending_ = true;
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this), chunk = checkpoint_prev_](td::Result<td::BufferSlice> R) {
+        td::actor::send_closure(SelfId, &CatChainReceiverImpl::got_checkpoint_snapshot, chunk, std::move(R));
+      });
+  callback_->get_snapshot(std::move(P));
+}
+
+void CatChainReceiverImpl::got_checkpoint_snapshot(CatChainBlockHash chunk, td::Result<td::BufferSlice> R) {
+  checkpoint_snapshot_pending_ = false;
+  if (R.is_error()) {
+    VLOG(CATCHAIN_WARNING) << this << ": failed to get consumer snapshot: " << R.move_as_error();
+    return;
+  }
+  auto data = R.move_as_ok();
+  if (data.empty()) {
+    // the consumer can't restore its state
+    checkpoint_snapshots_ = false;
+    return;
+  }
+  // blocks of the chunk were delivered before the snapshot was requested, so it covers all of them
+  auto snapshot = create_serialize_tl_object<ton_api::catchain_checkpoint_snapshot>(chunk, std::move(data));
+  db_.set(
+      checkpoint_snapshot_key_, std::move(snapshot), [](td::Unit) {}, 1.0);
+  checkpoint_snapshot_chunk_ = chunk;
+}
+
+void CatChainReceiverImpl::read_db_root() {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<DbType::GetResult> R) {
+    R.ensure();
+    auto g = R.move_as_ok();
+    if (g.status == td::KeyValue::GetStatus::NotFound) {
+      td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_db);
+    } else {
+      auto B = std::move(g.value);
+      CHECK(B.size() == 32);
+      CatChainBlockHash x;
+      as_slice(x).copy_from(B.as_slice());
+      td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_db_from, x);
+    }
+  });
+
+  db_.get(CatChainBlockHash::zero(), std::move(P));
 }
 
 void CatChainReceiverImpl::tear_down() {
+  if (read_db_ && !opts_.debug_disable_db && opts_.checkpoint_period > 0) {
+    write_checkpoint();
+  }
   td::actor::send_closure(overlay_manager_, &overlay::Overlays::delete_overlay, get_source(local_idx_)->get_adnl_id(),
                           overlay_id_);
 }
@@ -592,14 +799,27 @@ void CatChainReceiverImpl::read_block_from_db(CatChainBlockHash id, td::BufferSl
 }
 
 void CatChainReceiverImpl::read_db() {
+  run_scheduler();
+  if (checkpoint_restoring_) {
+    checkpoint_restoring_ = false;
+    checkpoint_restored_.clear();
+    callback_->finish_restore();
+  }
   if (!db_root_block_.is_zero()) {
-    run_scheduler();
     last_sent_block_ = get_block(db_root_block_);
     CHECK(last_sent_block_);
     CHECK(last_sent_block_->delivered());
   }
 
   read_db_ = true;
+  if (!opts_.debug_disable_db) {
+    VLOG(CATCHAIN_INFO) << this << ": read db in " << td::Time::now() - db_read_started_at_ << "s, "
+                        << blocks_.size() << " blocks";
+    if (opts_.checkpoint_period > 0) {
+      next_checkpoint_ = td::Timestamp::in(opts_.checkpoint_period);
+      alarm_timestamp().relax(next_checkpoint_);
+    }
+  }
 
   next_rotate_ = td::Timestamp::in(60 + td::Random::fast(0, 60));
   next_sync_ = td::Timestamp::in(0.001 * td::Random::fast(0, 60));
@@ -615,7 +835,8 @@ td::actor::ActorOwn<CatChainReceiverInterface> CatChainReceiverInterface::create
     std::vector<CatChainNode> ids, PublicKeyHash local_id, CatChainSessionId unique_hash, std::string db_root,
     std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
   auto A = td::actor::create_actor<CatChainReceiverImpl>(
-      "catchainreceiver", std::move(callback), std::move(opts), keyring, adnl, overlay_manager, std::move(ids),
+      td::actor::ActorOptions().with_name("catchainreceiver").with_priority(td::actor::ActorPriority::High),
+      std::move(callback), std::move(opts), keyring, adnl, overlay_manager, std::move(ids),
       local_id, unique_hash, db_root, db_suffix, allow_unsafe_self_blocks_resync);
   return std::move(A);
 }
@@ -991,6 +1212,11 @@ void CatChainReceiverImpl::alarm() {
     next_rotate_ = td::Timestamp::in(td::Random::fast(60.0, 120.0));
     choose_neighbours();
   }
+  if (next_checkpoint_ && next_checkpoint_.is_in_past()) {
+    next_checkpoint_ = td::Timestamp::in(opts_.checkpoint_period);
+    write_checkpoint();
+    write_checkpoint_snapshot();
+  }
   if (!started_ && read_db_ && initial_sync_complete_at_ && initial_sync_complete_at_.is_in_past()) {
     bool allow = false;
     if (allow_unsafe_self_blocks_resync_) {
@@ -1006,6 +1232,7 @@ void CatChainReceiverImpl::alarm() {
   }
   alarm_timestamp().relax(next_rotate_);
   alarm_timestamp().relax(next_sync_);
+  alarm_timestamp().relax(next_checkpoint_);
   alarm_timestamp().relax(initial_sync_complete_at_);
 }
 
@@ -21,6 +21,7 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 
 #include "catchain-types.h"
 #include "catchain-receiver.h"
@@ -28,6 +29,7 @@
 #include "catchain-received-block.h"
 
 #include "td/db/KeyValueAsync.h"
+#include "td/utils/HashMap.h"
 
 namespace ton {
 
@@ -128,6 +130,16 @@ class CatChainReceiverImpl : public CatChainReceiver {
   void alarm() override;
   void start_up() override;
   void tear_down() override;
+  void read_checkpoint();
+  void read_checkpoint_chunk(CatChainBlockHash id);
+  void got_checkpoint_chunk(CatChainBlockHash id, td::BufferSlice data);
+  void read_checkpoint_snapshot();
+  void read_checkpoint_blocks(CatChainBlockHash snapshot_chunk, td::BufferSlice snapshot);
+  void read_checkpoint_block(CatChainBlockHash id, td::BufferSlice data);
+  void write_checkpoint();
+  void write_checkpoint_snapshot();
+  void got_checkpoint_snapshot(CatChainBlockHash chunk, td::Result<td::BufferSlice> R);
+  void read_db_root();
   void read_db();
   void read_db_from(CatChainBlockHash id);
   void read_block_from_db(CatChainBlockHash id, td::BufferSlice data);
@@ -189,13 +201,30 @@ class CatChainReceiverImpl : public CatChainReceiver {
   td::uint32 pending_in_db_ = 0;
   CatChainBlockHash db_root_block_ = CatChainBlockHash::zero();
 
+  // checkpoint is a chain of db records, each listing blocks delivered since the previous one;
+  // blocks from it are already validated, so on restart they are loaded without signature checks.
+  // The consumer snapshot stored with it covers blocks up to some chunk, these blocks are not preprocessed again
+  CatChainBlockHash checkpoint_key_;
+  CatChainBlockHash checkpoint_snapshot_key_;
+  CatChainBlockHash checkpoint_prev_ = CatChainBlockHash::zero();
+  CatChainBlockHash checkpoint_snapshot_chunk_ = CatChainBlockHash::zero();
+  bool checkpoint_snapshot_pending_ = false;
+  bool checkpoint_snapshots_ = true;
+  bool checkpoint_restoring_ = false;
+  std::vector<CatChainBlockHash> checkpoint_blocks_;
+  std::vector<std::pair<CatChainBlockHash, std::vector<CatChainBlockHash>>> checkpoint_chunks_;
+  std::set<CatChainBlockHash> checkpoint_loaded_;
+  std::set<CatChainBlockHash> checkpoint_restored_;
+  td::Timestamp next_checkpoint_;
+  double db_read_started_at_ = 0;
+
   void choose_neighbours();
 
   std::vector<std::unique_ptr<CatChainReceiverSource>> sources_;
   std::map<PublicKeyHash, td::uint32> sources_hashes_;
   std::map<adnl::AdnlNodeIdShort, td::uint32> sources_adnl_addrs_;
   td::uint32 total_forks_ = 0;
-  std::map<CatChainBlockHash, std::unique_ptr<CatChainReceivedBlock>> blocks_;
+  td::HashMap<CatChainBlockHash, std::unique_ptr<CatChainReceivedBlock>, CatChainBlockHashHasher> blocks_;
   CatChainReceivedBlock *root_block_;
   CatChainReceivedBlock *last_sent_block_;
 
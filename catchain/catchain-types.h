@@ -19,6 +19,7 @@
 #pragma once
 
 #include "td/utils/int_types.h"
+#include "td/utils/as.h"
 #include "adnl/adnl-node-id.hpp"
 
 namespace ton {
@@ -30,6 +31,13 @@ using CatChainBlockPayloadHash = td::Bits256;
 using CatChainBlockHeight = td::uint32;
 using CatChainSessionId = td::Bits256;
 
+// block hashes are sha256 values, so their first bytes are already uniformly distributed
+struct CatChainBlockHashHasher {
+  std::size_t operator()(const CatChainBlockHash &hash) const {
+    return td::as<std::size_t>(hash.data());
+  }
+};
+
 struct CatChainNode {
   adnl::AdnlNodeIdShort adnl_id;
   PublicKey pub_key;
@@ -38,6 +46,8 @@ struct CatChainNode {
 struct CatChainOptions {
   double idle_timeout = 16.0;
   td::uint32 max_deps = 4;
+  // receiver state is checkpointed to the db with this period, so a restart does not re-validate old blocks
+  double checkpoint_period = 10.0;
 
   bool debug_disable_db = false;
 };
@@ -68,6 +68,24 @@ void CatChainImpl::send_preprocess(CatChainBlock *block) {
   VLOG(CATCHAIN_INFO) << this << ": sent preprocessing block " << block->hash() << " src=" << block->source();
 }
 
+void CatChainImpl::set_restored(CatChainBlock *block) {
+  if (block->preprocess_is_sent()) {
+    return;
+  }
+  auto prev = block->prev();
+  if (prev) {
+    set_restored(prev);
+  }
+
+  auto deps = block->deps();
+  for (auto X : deps) {
+    set_restored(X);
+  }
+
+  block->preprocess_sent();
+  restored_blocks_.push_back(block);
+}
+
 void CatChainImpl::set_processed(CatChainBlock *block) {
   if (block->is_processed()) {
     return;
@@ -118,7 +136,7 @@ void CatChainImpl::need_new_block(td::Timestamp t) {
 
 void CatChainImpl::on_new_block(td::uint32 src_id, td::uint32 fork, CatChainBlockHash hash, CatChainBlockHeight height,
                                 CatChainBlockHash prev, std::vector<CatChainBlockHash> deps,
-                                std::vector<CatChainBlockHeight> vt, td::SharedSlice data) {
+                                std::vector<CatChainBlockHeight> vt, td::SharedSlice data, bool restored) {
   VLOG(CATCHAIN_DEBUG) << this << ": new block " << hash;
   if (top_blocks_.size() == 0 && !active_process_ && receiver_started_) {
     alarm_timestamp().relax(td::Timestamp::in(opts_.idle_timeout));
@@ -152,7 +170,14 @@ void CatChainImpl::on_new_block(td::uint32 src_id, td::uint32 fork, CatChainBloc
   CHECK(B != nullptr);
 
   if (!blamed_sources_[src_id]) {
-    send_preprocess(B);
+    if (restored) {
+      CHECK(restoring_);
+      set_restored(B);
+    } else if (restoring_) {
+      delayed_blocks_.push_back(B);
+    } else {
+      send_preprocess(B);
+    }
     top_source_blocks_[src_id] = B;
 
     if (src_id != local_idx_) {
@@ -211,6 +236,35 @@ void CatChainImpl::on_broadcast(PublicKeyHash src, td::BufferSlice data) {
   VLOG(CATCHAIN_INFO) << this << ": sent processing broadcast";
 }
 
+void CatChainImpl::on_get_snapshot(td::Promise<td::BufferSlice> promise) {
+  std::vector<CatChainBlock *> v;
+  for (auto &it : blocks_) {
+    if (it.second->preprocess_is_sent()) {
+      v.push_back(it.second.get());
+    }
+  }
+  callback_->get_snapshot(std::move(v), std::move(promise));
+}
+
+void CatChainImpl::on_restore_snapshot(td::BufferSlice data) {
+  restoring_ = true;
+  restored_snapshot_ = std::move(data);
+}
+
+void CatChainImpl::on_finish_restore() {
+  CHECK(restoring_);
+  restoring_ = false;
+  VLOG(CATCHAIN_INFO) << this << ": restored " << restored_blocks_.size() << " blocks from checkpoint";
+  callback_->restore_blocks(std::move(restored_blocks_), std::move(restored_snapshot_));
+  restored_blocks_.clear();
+  for (auto B : delayed_blocks_) {
+    if (!blamed_sources_[B->source()]) {
+      send_preprocess(B);
+    }
+  }
+  delayed_blocks_.clear();
+}
+
 void CatChainImpl::on_receiver_started() {
   receiver_started_ = true;
   callback_->started();
@@ -256,9 +310,9 @@ void CatChainImpl::start_up() {
    public:
     void new_block(td::uint32 src_id, td::uint32 fork_id, CatChainBlockHash hash, CatChainBlockHeight height,
                    CatChainBlockHash prev, std::vector<CatChainBlockHash> deps, std::vector<CatChainBlockHeight> vt,
-                   td::SharedSlice data) override {
+                   td::SharedSlice data, bool restored) override {
       td::actor::send_closure(id_, &CatChainImpl::on_new_block, src_id, fork_id, hash, height, prev, std::move(deps),
-                              std::move(vt), std::move(data));
+                              std::move(vt), std::move(data), restored);
     }
     void blame(td::uint32 src_id) override {
       td::actor::send_closure(id_, &CatChainImpl::on_blame, src_id);
@@ -275,6 +329,15 @@ void CatChainImpl::start_up() {
     void start() override {
       td::actor::send_closure(id_, &CatChainImpl::on_receiver_started);
     }
+    void get_snapshot(td::Promise<td::BufferSlice> promise) override {
+      td::actor::send_closure(id_, &CatChainImpl::on_get_snapshot, std::move(promise));
+    }
+    void restore_snapshot(td::BufferSlice data) override {
+      td::actor::send_closure(id_, &CatChainImpl::on_restore_snapshot, std::move(data));
+    }
+    void finish_restore() override {
+      td::actor::send_closure(id_, &CatChainImpl::on_finish_restore);
+    }
     ChainCb(td::actor::ActorId<CatChainImpl> id) : id_(id) {
     }
 
@@ -298,9 +361,13 @@ td::actor::ActorOwn<CatChain> CatChain::create(std::unique_ptr<Callback> callbac
                                                std::vector<CatChainNode> ids, PublicKeyHash local_id,
                                                CatChainSessionId unique_hash, std::string db_root,
                                                std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
-  return td::actor::create_actor<CatChainImpl>("catchain", std::move(callback), std::move(opts), keyring, adnl,
-                                               overlay_manager, std::move(ids), local_id, unique_hash, db_root,
-                                               db_suffix, allow_unsafe_self_blocks_resync);
+  return td::actor::create_actor<CatChainImpl>(
+      td::actor::ActorOptions()
+          .with_name("catchain")
+          .with_priority(td::actor::ActorPriority::High)
+          .on_scheduler(td::actor::dedicated_scheduler("consensus")),
+      std::move(callback), std::move(opts), keyring, adnl, overlay_manager, std::move(ids), local_id, unique_hash,
+      db_root, db_suffix, allow_unsafe_self_blocks_resync);
 }
 
 CatChainBlock *CatChainImpl::get_block(CatChainBlockHash hash) const {
@@ -77,6 +77,16 @@ class CatChain : public td::actor::Actor {
     virtual void process_message(PublicKeyHash src, td::BufferSlice data) = 0;
     virtual void process_query(PublicKeyHash src, td::BufferSlice data, td::Promise<td::BufferSlice> promise) = 0;
     virtual void started() = 0;
+    // consumer state of the given preprocessed blocks, it is stored in the catchain checkpoint;
+    // an empty snapshot means that the consumer can't restore it, so blocks are preprocessed again after a restart
+    virtual void get_snapshot(std::vector<CatChainBlock *> blocks, td::Promise<td::BufferSlice> promise) {
+      promise.set_value(td::BufferSlice());
+    }
+    // blocks covered by the checkpoint snapshot, in delivery order; they are not preprocessed,
+    // the consumer must set their extra from the snapshot
+    virtual void restore_blocks(std::vector<CatChainBlock *> blocks, td::BufferSlice snapshot) {
+      UNREACHABLE();
+    }
     virtual ~Callback() = default;
   };
   struct PrintId {
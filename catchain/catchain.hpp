@@ -54,8 +54,16 @@ class CatChainImpl : public CatChain {
   std::string db_suffix_;
   bool allow_unsafe_self_blocks_resync_;
 
+  // while blocks are restored from the checkpoint snapshot, other delivered blocks wait for preprocessing,
+  // because they may depend on restored ones
+  bool restoring_ = false;
+  std::vector<CatChainBlock *> restored_blocks_;
+  std::vector<CatChainBlock *> delayed_blocks_;
+  td::BufferSlice restored_snapshot_;
+
   void send_process();
   void send_preprocess(CatChainBlock *block);
+  void set_restored(CatChainBlock *block);
   void set_processed(CatChainBlock *block);
 
   struct Args {
@@ -86,12 +94,15 @@ class CatChainImpl : public CatChain {
   CatChainBlock *get_block(CatChainBlockHash hash) const;
   void on_new_block(td::uint32 src_id, td::uint32 fork, CatChainBlockHash hash, CatChainBlockHeight height,
                     CatChainBlockHash prev, std::vector<CatChainBlockHash> deps, std::vector<CatChainBlockHeight> vt,
-                    td::SharedSlice data);
+                    td::SharedSlice data, bool restored);
   void on_blame(td::uint32 src_id);
   void on_custom_message(PublicKeyHash src, td::BufferSlice data);
   void on_custom_query(PublicKeyHash src, td::BufferSlice data, td::Promise<td::BufferSlice> promise);
   void on_broadcast(PublicKeyHash src, td::BufferSlice data);
   void on_receiver_started();
+  void on_get_snapshot(td::Promise<td::BufferSlice> promise);
+  void on_restore_snapshot(td::BufferSlice data);
+  void on_finish_restore();
   void processed_block(td::BufferSlice payload) override;
   void need_new_block(td::Timestamp t) override;
   void debug_add_fork(td::BufferSlice payload, CatChainBlockHeight height) override {
@@ -41,6 +41,7 @@
 #include "td/utils/format.h"
 #include "td/utils/misc.h"
 #include "td/utils/optional.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/tests.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_helpers.h"
@@ -804,6 +805,38 @@ TEST(TonDb, DynamicBoc) {
   ASSERT_EQ(0u, kv->count("").ok());
 };
 
+TEST(TonDb, DynamicBocReader) {
+  td::Random::Xorshift128plus rnd{123};
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto dboc = DynamicBagOfCellsDb::create();
+  dboc->set_loader(std::make_unique<CellLoader>(kv));
+  auto cell = gen_random_cell(100, rnd, false);
+  dboc->inc(cell);
+  dboc->prepare_commit();
+  {
+    CellStorer cell_storer(*kv);
+    dboc->commit(cell_storer);
+  }
+  dboc->set_loader(std::make_unique<CellLoader>(kv));
+  auto reader = dboc->get_cell_db_reader();
+  // the reader keeps its loader after the next set_loader
+  dboc->set_loader(std::make_unique<CellLoader>(kv));
+
+  std::vector<td::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 100; j++) {
+        auto loaded = reader->load_cell(cell->get_hash().as_slice()).move_as_ok();
+        ASSERT_EQ(serialize_boc(cell), serialize_boc(loaded));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(reader->load_cell(std::string(32, 'x')).is_error());
+}
+
 TEST(TonDb, DynamicBoc2) {
   int VERBOSITY_NAME(boc) = VERBOSITY_NAME(DEBUG) + 10;
   td::Random::Xorshift128plus rnd{123};
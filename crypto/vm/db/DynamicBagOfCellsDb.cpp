@@ -31,12 +31,6 @@
 namespace vm {
 namespace {
 
-class CellDbReader {
- public:
-  virtual ~CellDbReader() = default;
-  virtual td::Result<Ref<DataCell>> load_cell(td::Slice hash) = 0;
-};
-
 struct DynamicBocExtCellExtra {
   std::shared_ptr<CellDbReader> reader;
 };
@@ -176,6 +170,10 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     return td::Status::OK();
   }
 
+  std::shared_ptr<CellDbReader> get_cell_db_reader() override {
+    return cell_db_reader_;
+  }
+
   td::Status set_loader(std::unique_ptr<CellLoader> loader) override {
     reset_cell_db_reader();
     loader_ = std::move(loader);
@@ -240,7 +238,9 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
         return db_->load_cell(hash);
       }
       TRY_RESULT(load_result, cell_loader_->load(hash, true, *this));
-      CHECK(load_result.status == CellLoader::LoadResult::Ok);
+      if (load_result.status != CellLoader::LoadResult::Ok) {
+        return td::Status::Error("cell not found");
+      }
       return std::move(load_result.cell());
     }
 
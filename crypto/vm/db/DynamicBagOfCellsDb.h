@@ -22,6 +22,8 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <memory>
+
 namespace vm {
 class CellLoader;
 class CellStorer;
@@ -34,10 +36,19 @@ class ExtCellCreator {
   virtual td::Result<Ref<Cell>> ext_cell(Cell::LevelMask level_mask, td::Slice hash, td::Slice depth) = 0;
 };
 
+class CellDbReader {
+ public:
+  virtual ~CellDbReader() = default;
+  virtual td::Result<Ref<DataCell>> load_cell(td::Slice hash) = 0;
+};
+
 class DynamicBagOfCellsDb {
  public:
   virtual ~DynamicBagOfCellsDb() = default;
   virtual td::Result<Ref<DataCell>> load_cell(td::Slice hash) = 0;
+  // Thread safe reader of the loader set by set_loader(); it stays valid after the next set_loader(),
+  // cells loaded through it are not cached
+  virtual std::shared_ptr<CellDbReader> get_cell_db_reader() = 0;
   struct Stats {
     td::int64 cells_total_count{0};
     td::int64 cells_total_size{0};
@@ -98,6 +98,23 @@ td::Status DhtBucket::add_full_node(DhtKeyId id, DhtNode newnode, td::actor::Act
   return td::Status::OK();
 }
 
+td::Status DhtBucket::add_restored_node(DhtNode newnode, bool active, double rtt, td::actor::ActorId<adnl::Adnl> adnl,
+                                        adnl::AdnlNodeIdShort self_id) {
+  if (!active) {
+    return add_full_node(newnode.get_key(), std::move(newnode), adnl, self_id);
+  }
+  for (auto &node : active_nodes_) {
+    if (node == nullptr) {
+      TRY_RESULT_PREFIX(N, DhtRemoteNode::create(std::move(newnode), max_missed_pings_), "failed to add new node: ");
+      td::actor::send_closure(adnl, &adnl::Adnl::add_peer, self_id, N->get_full_id(), N->get_addr_list());
+      N->restore(rtt);
+      node = std::move(N);
+      return td::Status::OK();
+    }
+  }
+  return add_full_node(newnode.get_key(), std::move(newnode), adnl, self_id);
+}
+
 void DhtBucket::receive_ping(DhtKeyId id, DhtNode result, td::actor::ActorId<adnl::Adnl> adnl,
                              adnl::AdnlNodeIdShort self_id) {
   for (auto &node : active_nodes_) {
@@ -150,6 +167,11 @@ void DhtBucket::check(bool client_only, td::actor::ActorId<adnl::Adnl> adnl, td:
   size_t have_space = 0;
   for (size_t i = 0; i < active_nodes_.size(); i++) {
     auto &node = active_nodes_[i];
+    if (node && node->is_restored() && node->last_ping_at() > 0 &&
+        td::Time::now_cached() - node->last_ping_at() > restored_ping_timeout_) {
+      node->drop_restored();
+      demote_node(i);
+    }
     if (node && td::Time::now_cached() - node->last_ping_at() > ping_timeout_) {
       node->send_ping(client_only, adnl, dht, src);
       if (node->ready_from() == 0) {
@@ -203,6 +225,21 @@ DhtNodesList DhtBucket::export_nodes() const {
   return list;
 }
 
+std::vector<tl_object_ptr<ton_api::dht_db_node>> DhtBucket::export_db_nodes() const {
+  std::vector<tl_object_ptr<ton_api::dht_db_node>> vec;
+  for (auto &node : active_nodes_) {
+    if (node) {
+      vec.push_back(create_tl_object<ton_api::dht_db_node>(node->get_node().tl(), true, node->rtt()));
+    }
+  }
+  for (auto &node : backup_nodes_) {
+    if (node) {
+      vec.push_back(create_tl_object<ton_api::dht_db_node>(node->get_node().tl(), false, node->rtt()));
+    }
+  }
+  return vec;
+}
+
 }  // namespace dht
 
 }  // namespace ton
@@ -32,6 +32,8 @@ class DhtMember;
 class DhtBucket {
  private:
   double ping_timeout_ = 60;
+  // restored nodes that do not answer the first ping within this time are demoted
+  double restored_ping_timeout_ = 15;
   td::uint32 max_missed_pings_ = 3;
 
   std::vector<std::unique_ptr<DhtRemoteNode>> active_nodes_;
@@ -52,12 +54,15 @@ class DhtBucket {
   td::uint32 active_cnt();
   td::Status add_full_node(DhtKeyId id, DhtNode node, td::actor::ActorId<adnl::Adnl> adnl,
                            adnl::AdnlNodeIdShort self_id);
+  td::Status add_restored_node(DhtNode node, bool active, double rtt, td::actor::ActorId<adnl::Adnl> adnl,
+                               adnl::AdnlNodeIdShort self_id);
   void check(bool client_only, td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<DhtMember> node,
              adnl::AdnlNodeIdShort src);
   void receive_ping(DhtKeyId id, DhtNode result, td::actor::ActorId<adnl::Adnl> adnl, adnl::AdnlNodeIdShort self_id);
   void get_nearest_nodes(DhtKeyId id, td::uint32 bit, DhtNodesList &vec, td::uint32 k);
   void dump(td::StringBuilder &sb) const;
   DhtNodesList export_nodes() const;
+  std::vector<tl_object_ptr<ton_api::dht_db_node>> export_db_nodes() const;
 };
 
 }  // namespace dht
@@ -22,6 +22,7 @@
 #include "td/db/KeyValueAsync.h"
 
 #include <map>
+#include <set>
 
 namespace ton {
 
@@ -34,9 +35,10 @@ class DhtMemberImpl : public DhtMember {
  private:
   class DhtKeyValueLru : public td::ListNode {
    public:
-    DhtKeyValueLru(DhtValue value) : kv_(std::move(value)) {
+    DhtKeyValueLru(DhtValue value, td::Timestamp expire_at) : kv_(std::move(value)), expire_at_(expire_at) {
     }
     DhtValue kv_;
+    td::Timestamp expire_at_;
     static inline DhtKeyValueLru *from_list_node(ListNode *node) {
       return static_cast<DhtKeyValueLru *>(node);
     }
@@ -56,8 +58,13 @@ class DhtMemberImpl : public DhtMember {
   // to be republished once in a while
   std::map<DhtKeyId, DhtValue> our_values_;
 
+  // results of our own lookups, kept for at most max_cache_time_ and never past the value's ttl
   std::map<DhtKeyId, DhtKeyValueLru> cached_values_;
   td::ListNode cached_values_lru_;
+  // lookups in progress; a lookup of the same key waits for the running one
+  std::map<DhtKeyId, std::vector<td::Promise<DhtValue>>> pending_get_value_;
+  // lookups in progress whose key was stored meanwhile, their results are not cached
+  std::set<DhtKeyId> stale_get_value_;
 
   std::map<DhtKeyId, DhtValue> values_;
 
@@ -101,12 +108,22 @@ class DhtMemberImpl : public DhtMember {
   td::uint64 find_value_queries_{0};
   td::uint64 store_queries_{0};
   td::uint64 get_addr_list_queries_{0};
+  td::uint64 get_value_cache_hits_{0};
+  // lookups that joined a lookup of the same key already in flight
+  td::uint64 get_value_coalesced_{0};
+  td::uint64 get_value_cache_misses_{0};
+  td::uint32 restored_nodes_{0};
+  double started_at_{0};
+  // time from start to the first successful get_value, -1 if none yet
+  double first_lookup_in_{-1};
 
   using DbType = td::KeyValueAsync<td::Bits256, td::BufferSlice>;
   DbType db_;
   td::Timestamp next_save_to_db_at_ = td::Timestamp::in(10.0);
 
   void save_to_db();
+  // a new value of the key was stored here or by us, the cached result of an earlier lookup may be outdated
+  void drop_cached_value(DhtKeyId key);
 
   DhtNodesList get_nearest_nodes(DhtKeyId id, td::uint32 k);
   void check();
@@ -147,6 +164,7 @@ class DhtMemberImpl : public DhtMember {
   void send_store(DhtValue value, td::Promise<td::Unit> promise);
 
   void get_value_in(DhtKeyId key, td::Promise<DhtValue> result) override;
+  void got_value(DhtKeyId key, td::Result<DhtValue> R);
   void get_value(DhtKey key, td::Promise<DhtValue> result) override {
     get_value_in(key.compute_key_id(), std::move(result));
   }
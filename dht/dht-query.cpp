@@ -50,19 +50,37 @@ void DhtQuery::send_queries() {
     td::actor::send_closure(adnl_, &adnl::Adnl::add_peer, get_src(), it->second.adnl_id(), it->second.addr_list());
     send_one_query(id.to_adnl());
   }
-  if (active_queries_ == 0) {
-    CHECK(pending_ids_.size() == 0);
+  // done once all k closest known nodes answered; queries to farther nodes still in flight can not change the result
+  // (they could only return even farther nodes) and are dropped
+  if (pending_ids_.empty() && responded_ids_.size() == list_.size()) {
     DhtNodesList list;
     for (auto &node : list_) {
       list.push_back(std::move(node.second));
     }
     CHECK(list.size() <= k_);
-    VLOG(DHT_EXTRA_DEBUG) << this << ": finalizing " << get_name() << " query. List size=" << list.size();
+    VLOG(DHT_EXTRA_DEBUG) << this << ": finalizing " << get_name() << " query. List size=" << list.size()
+                          << " dropped_queries=" << active_queries_;
     finish(std::move(list));
     stop();
   }
 }
 
+void DhtQuery::finish_query(adnl::AdnlNodeIdShort dst, bool success) {
+  CHECK(active_queries_ > 0);
+  active_queries_--;
+  auto id_xor = DhtKeyId{dst} ^ key_;
+  auto it = list_.find(id_xor);
+  if (it != list_.end()) {
+    if (success) {
+      responded_ids_.insert(id_xor);
+    } else {
+      // unreachable nodes are not reported among the closest ones
+      list_.erase(it);
+    }
+  }
+  send_queries();
+}
+
 void DhtQuery::add_nodes(DhtNodesList list) {
   VLOG(DHT_EXTRA_DEBUG) << this << ": " << get_name() << " query: received " << list.size() << " new dht nodes";
   for (auto &node : list.list()) {
@@ -86,6 +104,7 @@ void DhtQuery::add_nodes(DhtNodesList list) {
         VLOG(DHT_EXTRA_DEBUG) << this << ": " << get_name() << " query: replacing " << (last_id_xor ^ key_)
                               << " key with " << id;
         pending_ids_.erase(last_id_xor);
+        responded_ids_.erase(last_id_xor);
         list_.erase(last_id_xor);
       } else {
         VLOG(DHT_EXTRA_DEBUG) << this << ": " << get_name() << " query: adding " << id << " key";
@@ -114,7 +133,7 @@ void DhtQueryFindNodes::send_one_query(adnl::AdnlNodeIdShort id) {
 void DhtQueryFindNodes::on_result(td::Result<td::BufferSlice> R, adnl::AdnlNodeIdShort dst) {
   if (R.is_error()) {
     VLOG(DHT_INFO) << this << ": failed find nodes query " << get_src() << "->" << dst << ": " << R.move_as_error();
-    finish_query();
+    finish_query(dst, false);
     return;
   }
 
@@ -122,10 +141,11 @@ void DhtQueryFindNodes::on_result(td::Result<td::BufferSlice> R, adnl::AdnlNodeI
   if (Res.is_error()) {
     VLOG(DHT_WARNING) << this << ": incorrect result on dht.findNodes query from " << dst << ": "
                       << Res.move_as_error();
-  } else {
-    add_nodes(DhtNodesList{Res.move_as_ok()});
+    finish_query(dst, false);
+    return;
   }
-  finish_query();
+  add_nodes(DhtNodesList{Res.move_as_ok()});
+  finish_query(dst, true);
 }
 
 void DhtQueryFindNodes::finish(DhtNodesList list) {
@@ -152,14 +172,14 @@ void DhtQueryFindValue::send_one_query(adnl::AdnlNodeIdShort id) {
 void DhtQueryFindValue::on_result(td::Result<td::BufferSlice> R, adnl::AdnlNodeIdShort dst) {
   if (R.is_error()) {
     VLOG(DHT_INFO) << this << ": failed find value query " << get_src() << "->" << dst << ": " << R.move_as_error();
-    finish_query();
+    finish_query(dst, false);
     return;
   }
   auto Res = fetch_tl_object<ton_api::dht_ValueResult>(R.move_as_ok(), true);
   if (Res.is_error()) {
     VLOG(DHT_WARNING) << this << ": dropping incorrect answer on dht.findValue query from " << dst << ": "
                       << Res.move_as_error();
-    finish_query();
+    finish_query(dst, false);
     return;
   }
 
@@ -187,7 +207,7 @@ void DhtQueryFindValue::on_result(td::Result<td::BufferSlice> R, adnl::AdnlNodeI
   if (need_stop) {
     stop();
   } else {
-    finish_query();
+    finish_query(dst, true);
   }
 }
 
@@ -63,11 +63,7 @@ class DhtQuery : public td::actor::Actor {
   }
   void send_queries();
   void add_nodes(DhtNodesList list);
-  void finish_query() {
-    active_queries_--;
-    CHECK(active_queries_ <= k_);
-    send_queries();
-  }
+  void finish_query(adnl::AdnlNodeIdShort dst, bool success);
   DhtKeyId get_key() const {
     return key_;
   }
@@ -87,8 +83,11 @@ class DhtQuery : public td::actor::Actor {
  private:
   DhtMember::PrintId print_id_;
   adnl::AdnlNodeIdShort src_;
+  // k closest known nodes, by distance to key
   std::map<DhtKeyId, DhtNode> list_;
+  // nodes from list_ that are not queried yet / that answered
   std::set<DhtKeyId> pending_ids_;
+  std::set<DhtKeyId> responded_ids_;
   td::uint32 k_;
   td::uint32 a_;
   td::actor::ActorId<DhtMember> node_;
@@ -39,6 +39,11 @@ td::Status DhtRemoteNode::receive_ping(DhtNode node, td::actor::ActorId<adnl::Ad
                                        adnl::AdnlNodeIdShort self_id) {
   TRY_STATUS(update_value(std::move(node), adnl, self_id));
   missed_pings_ = 0;
+  restored_ = false;
+  if (last_ping_at_ > 0) {
+    auto rtt = td::Time::now() - last_ping_at_;
+    rtt_ = rtt_ < 0 ? rtt : rtt_ * 0.75 + rtt * 0.25;
+  }
   if (ready_from_ == 0) {
     ready_from_ = td::Time::now_cached();
   }
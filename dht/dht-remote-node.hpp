@@ -44,6 +44,9 @@ class DhtRemoteNode {
   double last_ping_at_ = 0;
   double ready_from_ = 0;
   double failed_from_ = 0;
+  double rtt_ = -1;
+  // loaded from db as active and not confirmed by a ping yet
+  bool restored_ = false;
   td::int32 version_;
 
  public:
@@ -76,6 +79,24 @@ class DhtRemoteNode {
   double last_ping_at() const {
     return last_ping_at_;
   }
+  // ping round-trip time, -1 if unknown
+  double rtt() const {
+    return rtt_;
+  }
+  bool is_restored() const {
+    return restored_;
+  }
+  // node was active before restart: use it right away, until the first ping tells otherwise
+  void restore(double rtt) {
+    restored_ = true;
+    ready_from_ = td::Time::now_cached();
+    rtt_ = rtt;
+  }
+  void drop_restored() {
+    restored_ = false;
+    ready_from_ = 0;
+    failed_from_ = td::Time::now_cached();
+  }
   void send_ping(bool client_only, td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<DhtMember> node,
                  adnl::AdnlNodeIdShort src);
   td::Status receive_ping(DhtNode node, td::actor::ActorId<adnl::Adnl> adnl, adnl::AdnlNodeIdShort self_id);
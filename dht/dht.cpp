@@ -23,6 +23,7 @@
 #include "td/utils/tl_parsers.h"
 #include "td/utils/Random.h"
 #include "td/utils/base64.h"
+#include "td/utils/overloaded.h"
 
 #include "td/utils/format.h"
 
@@ -98,6 +99,7 @@ void DhtMemberImpl::start_up() {
                             std::make_unique<Callback>(actor_id(this), id_));
   }
   alarm_timestamp() = td::Timestamp::in(1.0);
+  started_at_ = td::Time::now();
 
   if (!db_root_.empty()) {
     std::shared_ptr<td::KeyValue> kv = std::make_shared<td::RocksDb>(
@@ -108,20 +110,45 @@ void DhtMemberImpl::start_up() {
       auto R = kv->get(key.as_slice(), value);
       R.ensure();
       if (R.move_as_ok() == td::KeyValue::GetStatus::Ok) {
-        auto V = fetch_tl_object<ton_api::dht_db_bucket>(td::BufferSlice{value}, true);
+        auto V = fetch_tl_object<ton_api::dht_db_Bucket>(td::BufferSlice{value}, true);
         V.ensure();
-        auto nodes = std::move(V.move_as_ok()->nodes_);
-        auto s = nodes->nodes_.size();
-        DhtNodesList list{std::move(nodes)};
-        CHECK(list.size() == s);
         auto &B = buckets_[bit];
-        for (auto &node : list.list()) {
-          auto key = node.get_key();
-          B.add_full_node(key, std::move(node), adnl_, id_);
-        }
+        ton_api::downcast_call(
+            *V.ok_ref(),
+            td::overloaded(
+                [&](ton_api::dht_db_bucket &obj) {
+                  auto s = obj.nodes_->nodes_.size();
+                  DhtNodesList list{std::move(obj.nodes_)};
+                  CHECK(list.size() == s);
+                  for (auto &node : list.list()) {
+                    auto key = node.get_key();
+                    B.add_full_node(key, std::move(node), adnl_, id_);
+                  }
+                },
+                [&](ton_api::dht_db_bucketNodes &obj) {
+                  // previously active nodes first, fastest first
+                  std::stable_sort(obj.nodes_.begin(), obj.nodes_.end(), [](const auto &a, const auto &b) {
+                    if (a->active_ != b->active_) {
+                      return a->active_;
+                    }
+                    return (a->rtt_ < 0 ? 1e9 : a->rtt_) < (b->rtt_ < 0 ? 1e9 : b->rtt_);
+                  });
+                  for (auto &n : obj.nodes_) {
+                    auto N = DhtNode::create(std::move(n->node_));
+                    if (N.is_error()) {
+                      continue;
+                    }
+                    if (B.add_restored_node(N.move_as_ok(), n->active_, n->rtt_, adnl_, id_).is_ok()) {
+                      restored_nodes_++;
+                    }
+                  }
+                }));
       }
     }
     db_ = DbType{std::move(kv)};
+    if (restored_nodes_ > 0) {
+      VLOG(DHT_NOTICE) << this << ": restored " << restored_nodes_ << " nodes from db";
+    }
   }
 }
 
@@ -137,23 +164,23 @@ void DhtMemberImpl::tear_down() {
   for (auto it : methods) {
     td::actor::send_closure(adnl_, &adnl::Adnl::unsubscribe, id_, adnl::Adnl::int_to_bytestring(it));
   }
+  save_to_db();
 }
 
 void DhtMemberImpl::save_to_db() {
   if (db_root_.empty()) {
     return;
   }
-  next_save_to_db_at_ = td::Timestamp::in(10.0);
-  alarm_timestamp().relax(next_save_to_db_at_);
+  next_save_to_db_at_ = td::Timestamp::in(60.0);
 
-  td::uint32 bit = td::Random::fast(0, 255);
-  auto &B = buckets_[bit];
-  auto list = B.export_nodes();
-  if (list.size() > 0) {
-    auto key = create_hash_tl_object<ton_api::dht_db_key_bucket>(bit);
-    auto value = create_serialize_tl_object<ton_api::dht_db_bucket>(list.tl());
+  for (td::uint32 bit = 0; bit < 256; bit++) {
+    auto nodes = buckets_[bit].export_db_nodes();
+    if (nodes.size() > 0) {
+      auto key = create_hash_tl_object<ton_api::dht_db_key_bucket>(bit);
+      auto value = create_serialize_tl_object<ton_api::dht_db_bucketNodes>(std::move(nodes));
 
-    db_.set(key, std::move(value));
+      db_.set(key, std::move(value));
+    }
   }
 }
 
@@ -253,6 +280,7 @@ td::Status DhtMemberImpl::store_in(DhtValue value) {
   TRY_STATUS(value.check());
 
   auto key_id = value.key_id();
+  drop_cached_value(key_id);
 
   auto dist = distance(key_id, k_ + 10);
   if (dist < k_ + 10) {
@@ -329,7 +357,10 @@ void DhtMemberImpl::receive_query(adnl::AdnlNodeIdShort src, td::BufferSlice dat
   if (td::Random::fast(0, 127) == 0) {
     VLOG(DHT_DEBUG) << this << ": ping=" << ping_queries_ << " fnode=" << find_node_queries_
                     << " fvalue=" << find_value_queries_ << " store=" << store_queries_
-                    << " addrlist=" << get_addr_list_queries_;
+                    << " addrlist=" << get_addr_list_queries_ << " cached_values=" << cached_values_.size()
+                    << " getvalue_cache_hits=" << get_value_cache_hits_
+                    << " getvalue_coalesced=" << get_value_coalesced_
+                    << " getvalue_cache_misses=" << get_value_cache_misses_ << " first_lookup_in=" << first_lookup_in_;
     VLOG(DHT_DEBUG) << this << ": query to DHT from " << src << ": " << ton_api::to_string(Q);
   }
 
@@ -379,12 +410,44 @@ void DhtMemberImpl::set_value(DhtValue value, td::Promise<td::Unit> promise) {
   }
   auto h = value.key_id();
   our_values_.emplace(h, value.clone());
+  drop_cached_value(h);
 
   send_store(std::move(value), std::move(promise));
 }
 
+void DhtMemberImpl::drop_cached_value(DhtKeyId key) {
+  cached_values_.erase(key);
+  if (pending_get_value_.count(key)) {
+    stale_get_value_.insert(key);
+  }
+}
+
 void DhtMemberImpl::get_value_in(DhtKeyId key, td::Promise<DhtValue> result) {
-  auto P = td::PromiseCreator::lambda([key, promise = std::move(result), SelfId = actor_id(this), print_id = print_id(),
+  auto it = cached_values_.find(key);
+  if (it != cached_values_.end()) {
+    if (it->second.expire_at_.is_in_past() || it->second.kv_.expired()) {
+      cached_values_.erase(it);
+    } else {
+      get_value_cache_hits_++;
+      it->second.remove();
+      cached_values_lru_.put(&it->second);
+      result.set_value(it->second.kv_.clone());
+      return;
+    }
+  }
+
+  auto &pending = pending_get_value_[key];
+  pending.push_back(std::move(result));
+  if (pending.size() > 1) {
+    get_value_coalesced_++;
+    return;
+  }
+  get_value_cache_misses_++;
+
+  auto promise = td::PromiseCreator::lambda([key, SelfId = actor_id(this)](td::Result<DhtValue> R) {
+    td::actor::send_closure(SelfId, &DhtMemberImpl::got_value, key, std::move(R));
+  });
+  auto P = td::PromiseCreator::lambda([key, promise = std::move(promise), SelfId = actor_id(this), print_id = print_id(),
                                        adnl = adnl_, list = get_nearest_nodes(key, k_), k = k_, a = a_, id = id_,
                                        client_only = client_only_](td::Result<DhtNode> R) mutable {
     R.ensure();
@@ -396,6 +459,48 @@ void DhtMemberImpl::get_value_in(DhtKeyId key, td::Promise<DhtValue> result) {
   get_self_node(std::move(P));
 }
 
+void DhtMemberImpl::got_value(DhtKeyId key, td::Result<DhtValue> R) {
+  auto it = pending_get_value_.find(key);
+  CHECK(it != pending_get_value_.end());
+  auto promises = std::move(it->second);
+  pending_get_value_.erase(it);
+  bool stale = stale_get_value_.erase(key) > 0;
+
+  if (R.is_error()) {
+    for (auto &promise : promises) {
+      promise.set_error(R.error().clone());
+    }
+    return;
+  }
+  auto value = R.move_as_ok();
+  if (first_lookup_in_ < 0) {
+    first_lookup_in_ = td::Time::now() - started_at_;
+    VLOG(DHT_NOTICE) << this << ": first successful lookup in " << first_lookup_in_ << "s (" << restored_nodes_
+                     << " nodes restored from db)";
+  }
+  if (max_cache_size_ > 0 && !stale && !value.expired()) {
+    auto expire_at = td::Timestamp::in(
+        std::min<double>(max_cache_time_, static_cast<double>(value.ttl()) - td::Clocks::system()));
+    auto it2 = cached_values_.find(key);
+    if (it2 != cached_values_.end()) {
+      it2->second.kv_ = value.clone();
+      it2->second.expire_at_ = expire_at;
+      it2->second.remove();
+    } else {
+      it2 = cached_values_.emplace(key, DhtKeyValueLru{value.clone(), expire_at}).first;
+    }
+    cached_values_lru_.put(&it2->second);
+    while (cached_values_.size() > max_cache_size_) {
+      auto lru = DhtKeyValueLru::from_list_node(cached_values_lru_.get());
+      CHECK(lru);
+      cached_values_.erase(lru->kv_.key_id());
+    }
+  }
+  for (auto &promise : promises) {
+    promise.set_value(value.clone());
+  }
+}
+
 void DhtMemberImpl::check() {
   VLOG(DHT_INFO) << this << ": ping=" << ping_queries_ << " fnode=" << find_node_queries_
                  << " fvalue=" << find_value_queries_ << " store=" << store_queries_
@@ -25,12 +25,15 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <new>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -41,6 +44,64 @@ bool is_memprof_on() {
   return true;
 }
 
+#if USE_MEMPROF_SAMPLE
+static constexpr std::size_t default_sample_rate = 512 << 10;
+#else
+static constexpr std::size_t default_sample_rate = 0;
+#endif
+
+std::size_t get_memprof_sample_rate() {
+  // can't be changed at runtime, because all recorded allocations must be sampled with the same rate
+  static const std::size_t sample_rate = [] {
+    const char *env = std::getenv("MEMPROF_SAMPLE_RATE");
+    if (env == nullptr || *env == 0) {
+      return default_sample_rate;
+    }
+    return static_cast<std::size_t>(std::strtoull(env, nullptr, 10));
+  }();
+  return sample_rate;
+}
+
+// the distance between samples is exponentially distributed, so an allocation of size s is recorded
+// with probability 1 - exp(-s / sample_rate) independently of the allocation pattern
+static std::int64_t get_sample_interval(std::size_t sample_rate, std::uint64_t &random_state) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 7;
+  random_state ^= random_state << 17;
+  double q = static_cast<double>((random_state >> 11) + 1) * (1.0 / 9007199254740992.0);
+  return static_cast<std::int64_t>(-std::log(q) * static_cast<double>(sample_rate)) + 1;
+}
+
+static bool need_sample(std::size_t size) {
+  auto sample_rate = get_memprof_sample_rate();
+  if (sample_rate == 0) {
+    return true;
+  }
+  static __thread std::int64_t bytes_until_sample;  // static zero-initialized
+  static __thread std::uint64_t random_state;       // static zero-initialized
+  if (random_state == 0) {
+    random_state = reinterpret_cast<std::uintptr_t>(&bytes_until_sample) * 0x9E3779B97F4A7C15ull | 1;
+    bytes_until_sample = get_sample_interval(sample_rate, random_state);
+  }
+  bytes_until_sample -= static_cast<std::int64_t>(size);
+  if (bytes_until_sample >= 0) {
+    return false;
+  }
+  bytes_until_sample = get_sample_interval(sample_rate, random_state);
+  return true;
+}
+
+// estimated total size of all allocations, if `count` of them with total size `size` were sampled
+static std::size_t unsample(std::size_t size, std::size_t count) {
+  auto sample_rate = get_memprof_sample_rate();
+  if (sample_rate == 0 || count == 0) {
+    return size;
+  }
+  double average_size = static_cast<double>(size) / static_cast<double>(count);
+  double probability = 1 - std::exp(-average_size / static_cast<double>(sample_rate));
+  return static_cast<std::size_t>(static_cast<double>(size) / probability);
+}
+
 #if USE_MEMPROF_SAFE
 double get_fast_backtrace_success_rate() {
   return 0;
@@ -151,6 +212,9 @@ struct HashtableNode {
   std::atomic<std::uint64_t> hash;
   Backtrace backtrace;
   std::atomic<std::size_t> size;
+  std::atomic<std::size_t> count;
+  std::atomic<std::size_t> total_size;
+  std::atomic<std::size_t> total_count;
 };
 
 static constexpr std::size_t ht_max_size = 1000000;
@@ -205,25 +269,97 @@ void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
     if (node.size == 0) {
       continue;
     }
-    func(AllocInfo{node.backtrace, node.size.load()});
+    func(AllocInfo{node.backtrace, unsample(node.size.load(), node.count.load())});
   }
 }
 
-void register_xalloc(malloc_info *info, std::int32_t diff) {
-  if (diff > 0) {
-    ht[info->ht_pos].size += info->size;
+static void append_format(std::string &res, const char *format, std::size_t a, std::size_t b, std::size_t c,
+                          std::size_t d) {
+  char buf[128];
+  auto len = std::snprintf(buf, sizeof(buf), format, a, b, c, d);
+  res.append(buf, std::min(static_cast<std::size_t>(std::max(len, 0)), sizeof(buf) - 1));
+}
+
+std::string get_pprof_heap_profile() {
+  // see heap_v2 profiles in pprof's legacy_profile.go; pprof unsamples the counts by itself
+  std::string samples;
+  std::size_t size = 0;
+  std::size_t count = 0;
+  std::size_t total_size = 0;
+  std::size_t total_count = 0;
+  for (auto &node : ht) {
+    if (node.total_count == 0) {
+      continue;
+    }
+    auto node_size = node.size.load();
+    auto node_count = node.count.load();
+    auto node_total_size = node.total_size.load();
+    auto node_total_count = node.total_count.load();
+    append_format(samples, "%zu: %zu [%zu: %zu] @", node_count, node_size, node_total_count, node_total_size);
+    for (auto *ip : node.backtrace) {
+      if (ip == nullptr) {
+        break;
+      }
+      char buf[32];
+      auto len = std::snprintf(buf, sizeof(buf), " 0x%zx", reinterpret_cast<std::size_t>(ip));
+      samples.append(buf, std::min(static_cast<std::size_t>(std::max(len, 0)), sizeof(buf) - 1));
+    }
+    samples += '\n';
+    size += node_size;
+    count += node_count;
+    total_size += node_total_size;
+    total_count += node_total_count;
+  }
+
+  std::string res;
+  append_format(res, "heap profile: %zu: %zu [%zu: %zu] @ ", count, size, total_count, total_size);
+  auto sample_rate = get_memprof_sample_rate();
+  if (sample_rate == 0) {
+    res += "heapprofile\n";
   } else {
-    assert(ht[info->ht_pos].size >= info->size);
-    ht[info->ht_pos].size -= info->size;
+    res += "heap_v2/" + std::to_string(sample_rate) + "\n";
+  }
+  res += samples;
+
+#if TD_LINUX
+  // pprof needs the memory map to symbolize the addresses
+  res += "\nMAPPED_LIBRARIES:\n";
+  if (auto *maps = std::fopen("/proc/self/maps", "r")) {
+    char buf[4096];
+    std::size_t len;
+    while ((len = std::fread(buf, 1, sizeof(buf), maps)) > 0) {
+      res.append(buf, len);
+    }
+    std::fclose(maps);
   }
+#endif
+  return res;
+}
+
+void register_xalloc(malloc_info *info, std::int32_t diff) {
   assert(info->magic == malloc_info_magic);
   assert(info->size < 1000000000000ull);
-  assert(ht[info->ht_pos].size < 1000000000000ull);
+  if (info->ht_pos < 0) {
+    // allocation wasn't sampled
+    return;
+  }
+  auto &node = ht[info->ht_pos];
+  if (diff > 0) {
+    node.size += info->size;
+    node.count++;
+    node.total_size += info->size;
+    node.total_count++;
+  } else {
+    assert(node.size >= info->size);
+    node.size -= info->size;
+    node.count--;
+  }
+  assert(node.size < 1000000000000ull);
 }
 
 extern "C" {
 
-static void *malloc_with_frame(std::size_t size, const Backtrace &frame, std::size_t aligment = 0) {
+static void *malloc_with_ht_pos(std::size_t size, std::int32_t ht_pos, std::size_t aligment) {
   static_assert(reserved % alignof(std::max_align_t) == 0, "fail");
   static_assert(reserved >= sizeof(malloc_info), "fail");
 #if TD_DARWIN
@@ -255,7 +391,7 @@ static void *malloc_with_frame(std::size_t size, const Backtrace &frame, std::si
   info->size = static_cast<std::uint32_t>(size);
   assert(info->size == size);
   info->offset = offset;
-  info->ht_pos = get_ht_pos(frame);
+  info->ht_pos = ht_pos;
 
   register_xalloc(info, +1);
 
@@ -268,6 +404,11 @@ static void *malloc_with_frame(std::size_t size, const Backtrace &frame, std::si
   return data;
 }
 
+// must be inlined into the allocation functions, because get_backtrace skips a fixed number of frames
+static inline __attribute__((always_inline)) void *malloc_with_frame(std::size_t size, std::size_t aligment = 0) {
+  return malloc_with_ht_pos(size, need_sample(size) ? get_ht_pos(get_backtrace()) : -1, aligment);
+}
+
 static malloc_info *get_info(void *data_void) {
   char *data = static_cast<char *>(data_void);
   auto *buf = data - reserved;
@@ -278,7 +419,7 @@ static malloc_info *get_info(void *data_void) {
 }
 
 void *malloc(std::size_t size) {
-  return malloc_with_frame(size, get_backtrace());
+  return malloc_with_frame(size);
 }
 
 void free(void *data_void) {
@@ -302,27 +443,27 @@ void free(void *data_void) {
 }
 void *calloc(std::size_t size_a, std::size_t size_b) {
   auto size = size_a * size_b;
-  void *res = malloc_with_frame(size, get_backtrace());
+  void *res = malloc_with_frame(size);
   std::memset(res, 0, size);
   return res;
 }
 void *realloc(void *ptr, std::size_t size) {
   if (ptr == nullptr) {
-    return malloc_with_frame(size, get_backtrace());
+    return malloc_with_frame(size);
   }
   auto *info = get_info(ptr);
-  auto *new_ptr = malloc_with_frame(size, get_backtrace());
+  auto *new_ptr = malloc_with_frame(size);
   auto to_copy = std::min(static_cast<std::uint32_t>(size), info->size);
   std::memcpy(new_ptr, ptr, to_copy);
   free(ptr);
   return new_ptr;
 }
 int posix_memalign(void **res, std::size_t aligment, std::size_t size) {
-  *res = malloc_with_frame(size, get_backtrace(), aligment);
+  *res = malloc_with_frame(size, aligment);
   return 0;
 }
 void *memalign(std::size_t aligment, std::size_t size) {
-  return malloc_with_frame(size, get_backtrace(), aligment);
+  return malloc_with_frame(size, aligment);
 }
 std::size_t malloc_usable_size(void *ptr) {
   if (ptr == nullptr) {
@@ -335,7 +476,7 @@ std::size_t malloc_usable_size(void *ptr) {
 
 // c++14 guarantees that it is enough to override these two operators.
 void *operator new(std::size_t count) {
-  return malloc_with_frame(count, get_backtrace());
+  return malloc_with_frame(count);
 }
 void operator delete(void *ptr) noexcept(true) {
   free(ptr);
@@ -353,6 +494,12 @@ void operator delete(void *ptr, std::size_t) noexcept(true) {
 bool is_memprof_on() {
   return false;
 }
+std::size_t get_memprof_sample_rate() {
+  return 0;
+}
+std::string get_pprof_heap_profile() {
+  return std::string();
+}
 void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
 }
 double get_fast_backtrace_success_rate() {
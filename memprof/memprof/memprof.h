@@ -21,6 +21,7 @@
 #include <array>
 #include <cstddef>
 #include <functional>
+#include <string>
 
 constexpr std::size_t BACKTRACE_SHIFT = 2;
 constexpr std::size_t BACKTRACE_HASHED_LENGTH = 6;
@@ -33,7 +34,12 @@ struct AllocInfo {
 };
 
 bool is_memprof_on();
+// average number of allocated bytes between two recorded allocations, 0 if every allocation is recorded
+std::size_t get_memprof_sample_rate();
 std::size_t get_ht_size();
 double get_fast_backtrace_success_rate();
+// in sampling mode the sizes are estimates of the memory used by all allocations with the backtrace
 void dump_alloc(const std::function<void(const AllocInfo &)> &func);
 std::size_t get_used_memory_size();
+// heap profile in the legacy text format understood by pprof, empty if memprof is off
+std::string get_pprof_heap_profile();
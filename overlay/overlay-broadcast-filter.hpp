@@ -0,0 +1,145 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include <vector>
+
+#include "overlay/overlay.h"
+#include "td/utils/as.h"
+#include "td/utils/Time.h"
+
+namespace ton {
+
+namespace overlay {
+
+// Set of recently delivered broadcast hashes, split into time buckets. Broadcast hashes are sha256 outputs, so a
+// 64-bit prefix is used as a fingerprint and stored in an open-addressed table per bucket; a whole bucket is dropped
+// on rotation instead of erasing hashes one by one. A false positive (two broadcasts sharing a prefix inside one
+// window) drops a broadcast, which at 2^-64 per pair is never expected to happen.
+class BroadcastDeliveredFilter {
+ public:
+  BroadcastDeliveredFilter(double bucket_ttl, td::uint32 buckets)
+      : buckets_(buckets), bucket_ttl_(bucket_ttl), rotate_at_(td::Timestamp::in(bucket_ttl)) {
+  }
+
+  bool contains(const Overlay::BroadcastHash &hash) const {
+    return contains(fingerprint(hash));
+  }
+  void insert(const Overlay::BroadcastHash &hash) {
+    auto fp = fingerprint(hash);
+    if (!contains(fp)) {
+      buckets_[cur_].insert(fp);
+    }
+  }
+
+  // starts a new bucket and forgets the oldest one, once per bucket_ttl
+  bool rotate() {
+    if (!rotate_at_.is_in_past()) {
+      return false;
+    }
+    cur_ = (cur_ + 1) % buckets_.size();
+    buckets_[cur_].clear();
+    rotate_at_ = td::Timestamp::in(bucket_ttl_);
+    return true;
+  }
+
+  size_t size() const {
+    size_t res = 0;
+    for (auto &b : buckets_) {
+      res += b.size;
+    }
+    return res;
+  }
+  size_t memory_usage() const {
+    size_t res = 0;
+    for (auto &b : buckets_) {
+      res += b.slots.capacity() * sizeof(td::uint64);
+    }
+    return res;
+  }
+
+ private:
+  struct Bucket {
+    std::vector<td::uint64> slots;
+    size_t size = 0;
+
+    bool contains(td::uint64 fp) const {
+      if (slots.empty()) {
+        return false;
+      }
+      size_t mask = slots.size() - 1;
+      for (size_t i = static_cast<size_t>(fp) & mask; slots[i] != 0; i = (i + 1) & mask) {
+        if (slots[i] == fp) {
+          return true;
+        }
+      }
+      return false;
+    }
+    void insert(td::uint64 fp) {
+      if (2 * (size + 1) > slots.size()) {
+        grow();
+      }
+      size_t mask = slots.size() - 1;
+      size_t i = static_cast<size_t>(fp) & mask;
+      while (slots[i] != 0) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = fp;
+      size++;
+    }
+    void grow() {
+      std::vector<td::uint64> old(slots.empty() ? 64 : slots.size() * 2, 0);
+      std::swap(old, slots);
+      size = 0;
+      for (auto fp : old) {
+        if (fp != 0) {
+          insert(fp);
+        }
+      }
+    }
+    void clear() {
+      // keep the capacity reached in the previous window, the broadcast rate rarely changes abruptly
+      std::fill(slots.begin(), slots.end(), 0);
+      size = 0;
+    }
+  };
+
+  static td::uint64 fingerprint(const Overlay::BroadcastHash &hash) {
+    td::uint64 fp = td::as<td::uint64>(hash.data());
+    // zero marks an empty slot
+    return fp != 0 ? fp : 1;
+  }
+  bool contains(td::uint64 fp) const {
+    for (auto &b : buckets_) {
+      if (b.contains(fp)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<Bucket> buckets_;
+  size_t cur_ = 0;
+  double bucket_ttl_;
+  td::Timestamp rotate_at_;
+};
+
+}  // namespace overlay
+
+}  // namespace ton
@@ -56,13 +56,13 @@ td::Status BroadcastSimple::run_checks() {
 
 td::Status BroadcastSimple::distribute() {
   auto B = serialize();
-  auto nodes = overlay_->get_neighbours(3);
+  auto nodes = overlay_->get_neighbours(overlay_->simple_broadcast_fanout());
 
-  auto manager = overlay_->overlay_manager();
+  td::actor::ClosureBatch<OverlayManager> batch;
   for (auto &n : nodes) {
-    td::actor::send_closure(manager, &OverlayManager::send_message, n, overlay_->local_id(), overlay_->overlay_id(),
-                            B.clone());
+    batch.add(&OverlayManager::send_message, n, overlay_->local_id(), overlay_->overlay_id(), B.clone());
   }
+  td::actor::send_closure_batch(overlay_->overlay_manager(), std::move(batch));
   return td::Status::OK();
 }
 
@@ -81,7 +81,7 @@ td::Status BroadcastSimple::create(OverlayImpl *overlay, tl_object_ptr<ton_api::
   auto broadcast_hash = compute_broadcast_id(src, data_hash, broadcast->flags_);
 
   TRY_STATUS(overlay->check_date(broadcast->date_));
-  TRY_STATUS(overlay->check_delivered(broadcast_hash));
+  TRY_STATUS(overlay->check_received(broadcast_hash));
   TRY_RESULT(cert, Certificate::create(std::move(broadcast->certificate_)));
 
   auto B = std::make_unique<BroadcastSimple>(broadcast_hash, src, std::move(cert), broadcast->flags_,
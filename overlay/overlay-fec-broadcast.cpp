@@ -115,10 +115,9 @@ td::Status OverlayFecBroadcastPart::apply() {
 
 td::Status OverlayFecBroadcastPart::distribute() {
   auto B = export_serialized();
-  auto nodes = overlay_->get_neighbours(5);
-
-  auto manager = overlay_->overlay_manager();
+  auto nodes = overlay_->get_neighbours(overlay_->fec_broadcast_fanout());
 
+  td::actor::ClosureBatch<OverlayManager> batch;
   td::BufferSlice data;
   td::BufferSlice data_short;
 
@@ -130,8 +129,7 @@ td::Status OverlayFecBroadcastPart::distribute() {
       if (data_short.size() == 0) {
         data_short = export_serialized_short();
       }
-      td::actor::send_closure(manager, &OverlayManager::send_message, n, overlay_->local_id(), overlay_->overlay_id(),
-                              data_short.clone());
+      batch.add(&OverlayManager::send_message, n, overlay_->local_id(), overlay_->overlay_id(), data_short.clone());
     } else {
       if (data.size() == 0) {
         data = export_serialized();
@@ -140,10 +138,10 @@ td::Status OverlayFecBroadcastPart::distribute() {
       if (broadcast_hash_.count_leading_zeroes() >= 12) {
         VLOG(OVERLAY_INFO) << "broadcast " << broadcast_hash_ << ": sending part " << part_hash_ << " to " << n;
       }
-      td::actor::send_closure(manager, &OverlayManager::send_message, n, overlay_->local_id(), overlay_->overlay_id(),
-                              data.clone());
+      batch.add(&OverlayManager::send_message, n, overlay_->local_id(), overlay_->overlay_id(), data.clone());
     }
   }
+  td::actor::send_closure_batch(overlay_->overlay_manager(), std::move(batch));
   return td::Status::OK();
 }
 
@@ -176,8 +174,8 @@ td::BufferSlice OverlayFecBroadcastPart::to_sign() {
   return serialize_tl_object(obj, true);
 }
 
-td::Status OverlayFecBroadcastPart::create(OverlayImpl *overlay,
-                                           tl_object_ptr<ton_api::overlay_broadcastFec> broadcast) {
+td::Status OverlayFecBroadcastPart::create(OverlayImpl *overlay, tl_object_ptr<ton_api::overlay_broadcastFec> broadcast,
+                                           bool &late) {
   TRY_STATUS(overlay->check_date(broadcast->date_));
 
   auto source = PublicKey{broadcast->src_};
@@ -192,7 +190,9 @@ td::Status OverlayFecBroadcastPart::create(OverlayImpl *overlay,
     VLOG(OVERLAY_INFO) << "broadcast " << broadcast_hash << ": received part " << part_hash;
   }
 
-  TRY_STATUS(overlay->check_delivered(broadcast_hash));
+  auto bcast = overlay->get_fec_broadcast(broadcast_hash);
+  late = bcast && bcast->finalized();
+  TRY_STATUS(overlay->check_received(broadcast_hash));
   TRY_RESULT(cert, Certificate::create(std::move(broadcast->certificate_)));
 
   OverlayFecBroadcastPart B{broadcast_hash,
@@ -209,7 +209,7 @@ td::Status OverlayFecBroadcastPart::create(OverlayImpl *overlay,
                             static_cast<td::uint32>(broadcast->date_),
                             std::move(broadcast->signature_),
                             false,
-                            overlay->get_fec_broadcast(broadcast_hash),
+                            bcast,
                             overlay};
   TRY_STATUS(B.run());
   return td::Status::OK();
@@ -233,7 +233,7 @@ td::Status OverlayFecBroadcastPart::create(OverlayImpl *overlay,
   auto broadcast_hash = bcast->get_hash();
   auto part_hash = compute_broadcast_part_id(broadcast_hash, part_data_hash, broadcast->seqno_);
 
-  TRY_STATUS(overlay->check_delivered(broadcast_hash));
+  TRY_STATUS(overlay->check_received(broadcast_hash));
   TRY_RESULT(cert, Certificate::create(std::move(broadcast->certificate_)));
 
   OverlayFecBroadcastPart B{broadcast_hash,
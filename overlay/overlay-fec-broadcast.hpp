@@ -120,6 +120,7 @@ class BroadcastFec : public td::ListNode {
   td::Status init_fec_type() {
     TRY_RESULT(D, fec_type_.create_decoder());
     decoder_ = std::move(D);
+    decoder_->set_online();
     return td::Status::OK();
   }
 
@@ -291,7 +292,8 @@ class OverlayFecBroadcastPart : public td::ListNode {
     return td::Status::OK();
   }
 
-  static td::Status create(OverlayImpl *overlay, tl_object_ptr<ton_api::overlay_broadcastFec> broadcast);
+  // late is set if the broadcast was already decoded when the part arrived
+  static td::Status create(OverlayImpl *overlay, tl_object_ptr<ton_api::overlay_broadcastFec> broadcast, bool &late);
   static td::Status create(OverlayImpl *overlay, tl_object_ptr<ton_api::overlay_broadcastFecShort> broadcast);
   static td::Status create_new(OverlayImpl *overlay, td::actor::ActorId<OverlayImpl> overlay_actor_id,
                                PublicKeyHash local_id, Overlay::BroadcastDataHash data_hash, td::uint32 size,
@@ -25,6 +25,7 @@
 #include "td/db/RocksDb.h"
 
 #include "td/utils/overloaded.h"
+#include "td/actor/MultiPromise.h"
 
 #include "keys/encryptor.h"
 
@@ -228,6 +229,17 @@ void OverlayManager::update_certificate(adnl::AdnlNodeIdShort local_id, OverlayI
   }
 }
 
+void OverlayManager::set_broadcast_options(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id,
+                                           OverlayBroadcastOptions options) {
+  auto it = overlays_.find(local_id);
+  if (it != overlays_.end()) {
+    auto it2 = it->second.find(overlay_id);
+    if (it2 != it->second.end()) {
+      td::actor::send_closure(it2->second, &Overlay::set_broadcast_options, std::move(options));
+    }
+  }
+}
+
 void OverlayManager::get_overlay_random_peers(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id,
                                               td::uint32 max_peers,
                                               td::Promise<std::vector<adnl::AdnlNodeIdShort>> promise) {
@@ -240,6 +252,35 @@ void OverlayManager::get_overlay_random_peers(adnl::AdnlNodeIdShort local_id, Ov
   }
 }
 
+void OverlayManager::get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  // overlays answer from their own threads, so the results are merged back on this actor
+  auto stats = std::make_shared<std::vector<std::pair<std::string, std::string>>>();
+  td::MultiPromise mp;
+  auto ig = mp.init_guard();
+  ig.add_promise([stats, promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+    promise.set_value(std::move(*stats));
+  });
+  for (auto &x : overlays_) {
+    for (auto &y : x.second) {
+      auto prefix = PSTRING() << "overlay." << x.first << "." << y.first << ".";
+      auto P = td::PromiseCreator::lambda(
+          [SelfId = actor_id(this), stats, prefix = std::move(prefix),
+           promise = ig.get_promise()](td::Result<std::vector<std::pair<std::string, std::string>>> R) mutable {
+            td::actor::send_lambda(SelfId, [stats, prefix = std::move(prefix), R = std::move(R),
+                                            promise = std::move(promise)]() mutable {
+              if (R.is_ok()) {
+                for (auto &s : R.move_as_ok()) {
+                  stats->emplace_back(prefix + s.first, std::move(s.second));
+                }
+              }
+              promise.set_value(td::Unit());
+            });
+          });
+      td::actor::send_closure(y.second, &Overlay::get_stats, std::move(P));
+    }
+  }
+}
+
 td::actor::ActorOwn<Overlays> Overlays::create(std::string db_root, td::actor::ActorId<keyring::Keyring> keyring,
                                                td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<dht::Dht> dht) {
   return td::actor::create_actor<OverlayManager>("overlaymanager", db_root, keyring, adnl, dht);
@@ -81,10 +81,14 @@ class OverlayManager : public Overlays {
   void set_privacy_rules(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id, OverlayPrivacyRules rules) override;
   void update_certificate(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id, PublicKeyHash key,
                           std::shared_ptr<Certificate> cert) override;
+  void set_broadcast_options(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id,
+                             OverlayBroadcastOptions options) override;
 
   void get_overlay_random_peers(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay, td::uint32 max_peers,
                                 td::Promise<std::vector<adnl::AdnlNodeIdShort>> promise) override;
 
+  void get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
+
   void receive_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data,
                      td::Promise<td::BufferSlice> promise);
   void receive_message(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data);
@@ -18,6 +18,8 @@
 */
 #include "overlay.hpp"
 
+#include <algorithm>
+
 namespace ton {
 
 namespace overlay {
@@ -157,14 +159,15 @@ void OverlayImpl::send_random_peers_cont(adnl::AdnlNodeIdShort src, OverlayNode
     auto Q = create_tl_object<ton_api::overlay_nodes>(std::move(vec));
     promise.set_value(serialize_tl_object(Q, true));
   } else {
-    auto P =
-        td::PromiseCreator::lambda([SelfId = actor_id(this), src, oid = print_id()](td::Result<td::BufferSlice> res) {
-          if (res.is_error()) {
-            VLOG(OVERLAY_NOTICE) << oid << ": failed getRandomPeers query: " << res.move_as_error();
-            return;
-          }
-          td::actor::send_closure(SelfId, &OverlayImpl::receive_random_peers, src, res.move_as_ok());
-        });
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), src, oid = print_id(),
+                                         started_at = td::Time::now()](td::Result<td::BufferSlice> res) {
+      if (res.is_error()) {
+        VLOG(OVERLAY_NOTICE) << oid << ": failed getRandomPeers query: " << res.move_as_error();
+        return;
+      }
+      td::actor::send_closure(SelfId, &OverlayImpl::update_peer_rtt, src, td::Time::now() - started_at);
+      td::actor::send_closure(SelfId, &OverlayImpl::receive_random_peers, src, res.move_as_ok());
+    });
     auto Q =
         create_tl_object<ton_api::overlay_getRandomPeers>(create_tl_object<ton_api::overlay_nodes>(std::move(vec)));
     td::actor::send_closure(manager_, &OverlayManager::send_query, src, local_id_, overlay_id_,
@@ -244,6 +247,132 @@ void OverlayImpl::update_neighbours(td::uint32 nodes_to_change) {
   }
 }
 
+void OverlayImpl::rank_neighbours() {
+  if (neighbours_.empty()) {
+    return;
+  }
+  double sum = 0.0;
+  td::uint32 cnt = 0;
+  for (auto &n : neighbours_) {
+    auto P = peers_.get(n);
+    CHECK(P != nullptr);
+    if (P->has_delivery_delay()) {
+      sum += P->delivery_delay(0.0);
+      cnt++;
+    }
+  }
+  // peers without measurements are assumed to be average, so that they are tried but do not displace good ones
+  double default_delay = cnt > 0 ? sum / cnt : 1.0;
+
+  auto now = td::Time::now();
+  double period = ranked_at_ > 0 ? now - ranked_at_ : 0.0;
+  ranked_at_ = now;
+  double rate_sum = 0.0;
+  td::uint32 rate_cnt = 0;
+  for (auto &n : neighbours_) {
+    auto P = peers_.get(n);
+    P->age_stats(period);
+    if (P->delivered_rate() >= 0) {
+      rate_sum += P->delivered_rate();
+      rate_cnt++;
+    }
+  }
+  double average_rate = rate_cnt > 0 ? rate_sum / rate_cnt : 0.0;
+
+  std::vector<std::pair<double, adnl::AdnlNodeIdShort>> ranked;
+  for (auto &n : neighbours_) {
+    ranked.emplace_back(peers_.get(n)->cost(default_delay, average_rate), n);
+  }
+  std::sort(ranked.begin(), ranked.end());
+  for (size_t i = 0; i < ranked.size(); i++) {
+    neighbours_[i] = ranked[i].second;
+  }
+
+  if (neighbours_.size() >= max_neighbours() && peers_.size() > neighbours_.size() + 1) {
+    OverlayPeer *best = nullptr;
+    double best_cost = 0.0;
+    for (td::uint32 i = 0; i < 3; i++) {
+      auto X = peers_.get_random();
+      if (X->get_id() == local_id_ || X->is_neighbour()) {
+        continue;
+      }
+      auto c = X->cost(default_delay, average_rate);
+      if (!best || c < best_cost) {
+        best = X;
+        best_cost = c;
+      }
+    }
+    auto worst_cost = ranked.back().first;
+    if (best && best_cost * 1.5 < worst_cost) {
+      auto Y = peers_.get(neighbours_.back());
+      VLOG(OVERLAY_INFO) << this << ": replacing slow neighbour " << Y->get_id() << " (cost " << worst_cost << ") with "
+                         << best->get_id() << " (cost " << best_cost << ")";
+      Y->set_neighbour(false);
+      neighbours_.back() = best->get_id();
+      best->set_neighbour(true);
+    }
+  }
+
+  for (auto &n : neighbours_) {
+    auto P = peers_.get(n);
+    VLOG(OVERLAY_DEBUG) << this << ": neighbour " << n << " delay=" << P->delivery_delay(-1.0)
+                        << " redundancy=" << P->redundancy() << " useful_bytes=" << P->useful_bytes()
+                        << " bytes_per_sec=" << P->delivered_rate();
+  }
+}
+
+void OverlayImpl::update_peer_rtt(adnl::AdnlNodeIdShort id, double rtt) {
+  auto P = peers_.get(id);
+  if (P) {
+    P->on_query_answered(rtt);
+  }
+}
+
+void OverlayImpl::update_peer_broadcast_part(adnl::AdnlNodeIdShort id, td::uint32 size, const td::Status &S,
+                                             bool late) {
+  if (S.is_error() && S.code() != ErrorCode::notready) {
+    return;
+  }
+  auto P = peers_.get(id);
+  if (P) {
+    // notready is returned for duplicates and for data that is too old to be useful; parts of an already decoded
+    // FEC broadcast are accepted and forwarded, but are duplicates for us as well
+    P->on_broadcast_part(size, S.is_ok() && !late);
+  }
+}
+
+std::vector<adnl::AdnlNodeIdShort> OverlayImpl::get_neighbours(td::uint32 max_size) const {
+  if (broadcast_options_.prefer_fast_peers && max_size > 0 && !neighbours_.empty()) {
+    // neighbours_ are ranked: take the best ones, but give the last slot to a random peer, so that peers which
+    // were dropped from every neighbour list for a slow uplink still get data
+    std::vector<adnl::AdnlNodeIdShort> vec;
+    for (td::uint32 i = 0; i + 1 < max_size && i < neighbours_.size(); i++) {
+      vec.push_back(neighbours_[i]);
+    }
+    for (td::uint32 i = 0; i < 3 && vec.size() < max_size; i++) {
+      auto X = peers_.get_random();
+      if (X->get_id() != local_id_ && std::find(vec.begin(), vec.end(), X->get_id()) == vec.end()) {
+        vec.push_back(X->get_id());
+      }
+    }
+    if (vec.size() < max_size && vec.size() < neighbours_.size()) {
+      vec.push_back(neighbours_[vec.size()]);
+    }
+    return vec;
+  }
+  if (max_size == 0 || max_size >= neighbours_.size()) {
+    return neighbours_;
+  }
+  std::vector<adnl::AdnlNodeIdShort> vec;
+  std::vector<adnl::AdnlNodeIdShort> rest(neighbours_.begin(), neighbours_.end());
+  for (td::uint32 j = 0; vec.size() < max_size; j++) {
+    auto k = td::Random::fast(static_cast<td::int32>(j), static_cast<td::int32>(rest.size()) - 1);
+    std::swap(rest[j], rest[k]);
+    vec.push_back(rest[j]);
+  }
+  return vec;
+}
+
 OverlayPeer *OverlayImpl::get_random_peer() {
   while (peers_.size() > 0) {
     auto P = peers_.get_random();
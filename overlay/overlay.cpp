@@ -110,12 +110,6 @@ void OverlayImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::overlay_getB
     promise.set_value(create_serialize_tl_object<ton_api::overlay_broadcastNotFound>());
     return;
   }
-  if (delivered_broadcasts_.find(query.hash_) != delivered_broadcasts_.end()) {
-    VLOG(OVERLAY_DEBUG) << this << ": received getBroadcastQuery(" << query.hash_ << ") from " << src
-                        << " but broadcast already deleted";
-    promise.set_value(create_serialize_tl_object<ton_api::overlay_broadcastNotFound>());
-    return;
-  }
 
   VLOG(OVERLAY_DEBUG) << this << ": received getBroadcastQuery(" << query.hash_ << ") from " << src
                       << " sending broadcast";
@@ -159,12 +153,19 @@ void OverlayImpl::receive_query(adnl::AdnlNodeIdShort src, td::BufferSlice data,
 
 td::Status OverlayImpl::process_broadcast(adnl::AdnlNodeIdShort message_from,
                                           tl_object_ptr<ton_api::overlay_broadcast> bcast) {
-  return BroadcastSimple::create(this, std::move(bcast));
+  auto size = static_cast<td::uint32>(bcast->data_.size());
+  auto S = BroadcastSimple::create(this, std::move(bcast));
+  update_peer_broadcast_part(message_from, size, S, false);
+  return S;
 }
 
 td::Status OverlayImpl::process_broadcast(adnl::AdnlNodeIdShort message_from,
                                           tl_object_ptr<ton_api::overlay_broadcastFec> b) {
-  return OverlayFecBroadcastPart::create(this, std::move(b));
+  auto size = static_cast<td::uint32>(b->data_.size());
+  bool late = false;
+  auto S = OverlayFecBroadcastPart::create(this, std::move(b), late);
+  update_peer_broadcast_part(message_from, size, S, late);
+  return S;
 }
 
 td::Status OverlayImpl::process_broadcast(adnl::AdnlNodeIdShort message_from,
@@ -265,6 +266,13 @@ void OverlayImpl::alarm() {
     update_neighbours(0);
     alarm_timestamp() = td::Timestamp::in(60.0 + td::Random::fast(0, 100) * 0.6);
   }
+  if (broadcast_options_.prefer_fast_peers) {
+    if (rank_neighbours_at_.is_in_past()) {
+      rank_neighbours();
+      rank_neighbours_at_ = td::Timestamp::in(broadcast_options_.neighbours_update_period);
+    }
+    alarm_timestamp().relax(rank_neighbours_at_);
+  }
 }
 
 void OverlayImpl::receive_dht_nodes(td::Result<dht::DhtValue> res, bool dummy) {
@@ -334,9 +342,6 @@ void OverlayImpl::bcast_gc() {
     CHECK(bcast);
     auto hash = bcast->get_hash();
     broadcasts_.erase(hash);
-    if (delivered_broadcasts_.insert(hash).second) {
-      bcast_lru_.push(hash);
-    }
   }
   while (fec_broadcasts_.size() > 0) {
     auto bcast = BroadcastFec::from_list_node(bcast_fec_lru_.prev);
@@ -347,22 +352,21 @@ void OverlayImpl::bcast_gc() {
     auto hash = bcast->get_hash();
     CHECK(fec_broadcasts_.count(hash) == 1);
     fec_broadcasts_.erase(hash);
-    if (delivered_broadcasts_.insert(hash).second) {
-      bcast_lru_.push(hash);
-    }
+    delivered_broadcasts_.insert(hash);
   }
-  while (bcast_lru_.size() > max_bcasts()) {
-    auto Id = bcast_lru_.front();
-    bcast_lru_.pop();
-    CHECK(delivered_broadcasts_.erase(Id));
+  if (delivered_broadcasts_.rotate()) {
+    VLOG(OVERLAY_INFO) << this << ": delivered broadcasts filter: " << delivered_broadcasts_.size() << " hashes ("
+                       << delivered_broadcasts_.memory_usage() << " bytes), " << bcasts_duplicate_ << " of "
+                       << bcasts_received_ << " received broadcasts were duplicates";
   }
-  CHECK(delivered_broadcasts_.size() == bcast_lru_.size());
 }
 
 void OverlayImpl::send_message_to_neighbours(td::BufferSlice data) {
+  td::actor::ClosureBatch<OverlayManager> batch;
   for (auto &n : neighbours_) {
-    td::actor::send_closure(manager_, &OverlayManager::send_message, n, local_id_, overlay_id_, data.clone());
+    batch.add(&OverlayManager::send_message, n, local_id_, overlay_id_, data.clone());
   }
+  td::actor::send_closure_batch(manager_, std::move(batch));
 }
 
 void OverlayImpl::send_broadcast(PublicKeyHash send_as, td::uint32 flags, td::BufferSlice data) {
@@ -376,6 +380,27 @@ void OverlayImpl::send_broadcast_fec(PublicKeyHash send_as, td::uint32 flags, td
   OverlayOutboundFecBroadcast::create(std::move(data), flags, actor_id(this), send_as);
 }
 
+void OverlayImpl::set_broadcast_options(OverlayBroadcastOptions options) {
+  broadcast_options_ = std::move(options);
+  rank_neighbours_at_ = td::Timestamp::now();
+  alarm_timestamp().relax(rank_neighbours_at_);
+}
+
+void OverlayImpl::get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("broadcasts.received", td::to_string(bcasts_received_));
+  vec.emplace_back("broadcasts.duplicate", td::to_string(bcasts_duplicate_));
+  vec.emplace_back("delivered_filter.size", td::to_string(delivered_broadcasts_.size()));
+  vec.emplace_back("delivered_filter.memory", td::to_string(delivered_broadcasts_.memory_usage()));
+  for (auto &n : neighbours_) {
+    auto P = peers_.get(n);
+    if (P && P->delivered_rate() >= 0) {
+      vec.emplace_back(PSTRING() << "neighbour." << n << ".bytes_per_sec", td::to_string(P->delivered_rate()));
+    }
+  }
+  promise.set_value(std::move(vec));
+}
+
 void OverlayImpl::print(td::StringBuilder &sb) {
   sb << this;
 }
@@ -413,13 +438,22 @@ td::Status OverlayImpl::check_source_eligible(PublicKey source, const Certificat
 }
 
 td::Status OverlayImpl::check_delivered(BroadcastHash hash) {
-  if (delivered_broadcasts_.count(hash) == 1 || broadcasts_.count(hash) == 1) {
+  if (delivered_broadcasts_.contains(hash)) {
     return td::Status::Error(ErrorCode::notready, "duplicate broadcast");
   } else {
     return td::Status::OK();
   }
 }
 
+td::Status OverlayImpl::check_received(BroadcastHash hash) {
+  bcasts_received_++;
+  auto S = check_delivered(hash);
+  if (S.is_error()) {
+    bcasts_duplicate_++;
+  }
+  return S;
+}
+
 BroadcastFec *OverlayImpl::get_fec_broadcast(BroadcastHash hash) {
   auto it = fec_broadcasts_.find(hash);
   if (it == fec_broadcasts_.end()) {
@@ -508,6 +542,7 @@ void OverlayImpl::register_simple_broadcast(std::unique_ptr<BroadcastSimple> bca
   auto hash = bcast->get_hash();
   bcast_data_lru_.put(bcast.get());
   broadcasts_.emplace(hash, std::move(bcast));
+  delivered_broadcasts_.insert(hash);
   bcast_gc();
 }
 
@@ -21,13 +21,13 @@
 #include <vector>
 #include <map>
 #include <set>
-#include <queue>
 
 #include "overlay.h"
 #include "overlay-manager.h"
 #include "overlay-fec.hpp"
 #include "overlay-broadcast.hpp"
 #include "overlay-fec-broadcast.hpp"
+#include "overlay-broadcast-filter.hpp"
 #include "overlay-id.hpp"
 
 #include "td/utils/DecTree.h"
@@ -74,17 +74,76 @@ class OverlayPeer {
     return is_neighbour_;
   }
   void set_neighbour(bool value) {
+    if (value && !is_neighbour_) {
+      // delivered rate is measured for neighbours only, over whole ranking periods
+      period_useful_bytes_ = 0.0;
+    }
     is_neighbour_ = value;
   }
   td::int32 get_version() const {
     return node_.version();
   }
 
+  void on_query_answered(double rtt) {
+    rtt_ = rtt_ < 0 ? rtt : rtt_ * 0.8 + rtt * 0.2;
+  }
+  void on_broadcast_part(td::uint32 size, bool useful) {
+    (useful ? useful_bytes_ : duplicate_bytes_) += size;
+    if (useful) {
+      period_useful_bytes_ += size;
+    }
+  }
+  // called once per ranking period of given length
+  void age_stats(double period) {
+    if (period > 0) {
+      auto rate = period_useful_bytes_ / period;
+      delivered_rate_ = delivered_rate_ < 0 ? rate : delivered_rate_ * 0.5 + rate * 0.5;
+    }
+    period_useful_bytes_ = 0.0;
+    useful_bytes_ *= 0.5;
+    duplicate_bytes_ *= 0.5;
+  }
+  // expected time for a broadcast to reach this peer, given a default for peers without measurements
+  double delivery_delay(double default_delay) const {
+    return rtt_ >= 0 ? rtt_ : default_delay;
+  }
+  bool has_delivery_delay() const {
+    return rtt_ >= 0;
+  }
+  // fraction of broadcast data received from this peer that we already had
+  double redundancy() const {
+    auto total = useful_bytes_ + duplicate_bytes_;
+    return total > 0 ? duplicate_bytes_ / total : 0.5;
+  }
+  // new broadcast bytes per second received from this peer, -1 before the first ranking period ends
+  double delivered_rate() const {
+    return delivered_rate_;
+  }
+  // peers without measurements are given the defaults; a peer delivering new data at the average rate keeps its
+  // delay-based cost, a faster one is cheaper
+  double cost(double default_delay, double average_rate) const {
+    auto c = delivery_delay(default_delay) * (0.5 + redundancy());
+    if (average_rate > 0) {
+      auto rate = delivered_rate_ >= 0 ? delivered_rate_ : average_rate;
+      c *= 2.0 / (1.0 + rate / average_rate);
+    }
+    return c;
+  }
+  double useful_bytes() const {
+    return useful_bytes_;
+  }
+
  private:
   OverlayNode node_;
   adnl::AdnlNodeIdShort id_;
 
   bool is_neighbour_ = false;
+
+  double rtt_ = -1.0;
+  double useful_bytes_ = 0.0;
+  double duplicate_bytes_ = 0.0;
+  double period_useful_bytes_ = 0.0;
+  double delivered_rate_ = -1.0;
 };
 
 class OverlayImpl : public Overlay {
@@ -120,6 +179,8 @@ class OverlayImpl : public Overlay {
   void send_random_peers_cont(adnl::AdnlNodeIdShort dst, OverlayNode node, td::Promise<td::BufferSlice> promise);
   void get_overlay_random_peers(td::uint32 max_peers, td::Promise<std::vector<adnl::AdnlNodeIdShort>> promise) override;
   void set_privacy_rules(OverlayPrivacyRules rules) override;
+  void set_broadcast_options(OverlayBroadcastOptions options) override;
+  void get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
   void add_certificate(PublicKeyHash key, std::shared_ptr<Certificate> cert) override {
     certs_[key] = std::move(cert);
   }
@@ -128,6 +189,9 @@ class OverlayImpl : public Overlay {
   void update_dht_nodes(OverlayNode node);
 
   void update_neighbours(td::uint32 nodes_to_change);
+  void rank_neighbours();
+  void update_peer_rtt(adnl::AdnlNodeIdShort id, double rtt);
+  void update_peer_broadcast_part(adnl::AdnlNodeIdShort id, td::uint32 size, const td::Status &S, bool late);
 
   void finish_fec_bcast(BroadcastHash id) {
     out_fec_bcasts_.erase(id);
@@ -146,6 +210,8 @@ class OverlayImpl : public Overlay {
   td::Status check_date(td::uint32 date);
   td::Status check_source_eligible(PublicKey source, const Certificate *cert, td::uint32 size);
   td::Status check_delivered(BroadcastHash hash);
+  // check_delivered() for a broadcast (or FEC part) as it arrives from the network, counted in the stats
+  td::Status check_received(BroadcastHash hash);
 
   BroadcastFec *get_fec_broadcast(BroadcastHash hash);
   void register_fec_broadcast(std::unique_ptr<BroadcastFec> bcast);
@@ -158,16 +224,12 @@ class OverlayImpl : public Overlay {
   void send_new_fec_broadcast_part(PublicKeyHash local_id, Overlay::BroadcastDataHash data_hash, td::uint32 size,
                                    td::uint32 flags, td::BufferSlice part, td::uint32 seqno, fec::FecType fec_type,
                                    td::uint32 date);
-  std::vector<adnl::AdnlNodeIdShort> get_neighbours(td::uint32 max_size = 0) const {
-    if (max_size == 0 || max_size >= neighbours_.size()) {
-      return neighbours_;
-    } else {
-      std::vector<adnl::AdnlNodeIdShort> vec;
-      for (td::uint32 i = 0; i < max_size; i++) {
-        vec.push_back(neighbours_[td::Random::fast(0, static_cast<td::int32>(neighbours_.size()))]);
-      }
-      return vec;
-    }
+  std::vector<adnl::AdnlNodeIdShort> get_neighbours(td::uint32 max_size = 0) const;
+  td::uint32 simple_broadcast_fanout() const {
+    return broadcast_options_.simple_fanout;
+  }
+  td::uint32 fec_broadcast_fanout() const {
+    return broadcast_options_.fec_fanout;
   }
   td::actor::ActorId<OverlayManager> overlay_manager() const {
     return manager_;
@@ -236,12 +298,18 @@ class OverlayImpl : public Overlay {
 
   std::map<BroadcastHash, std::unique_ptr<BroadcastSimple>> broadcasts_;
   std::map<BroadcastHash, std::unique_ptr<BroadcastFec>> fec_broadcasts_;
-  std::set<BroadcastHash> delivered_broadcasts_;
+  BroadcastDeliveredFilter delivered_broadcasts_{delivered_bucket_ttl(), delivered_buckets()};
+  td::uint64 bcasts_received_ = 0;
+  td::uint64 bcasts_duplicate_ = 0;
 
+  // sorted by OverlayPeer::cost() if broadcast_options_.prefer_fast_peers is set
   std::vector<adnl::AdnlNodeIdShort> neighbours_;
+  OverlayBroadcastOptions broadcast_options_;
+  td::Timestamp rank_neighbours_at_;
+  // start of the current ranking period, delivered rates of peers are measured over it
+  double ranked_at_ = 0.0;
   td::ListNode bcast_data_lru_;
   td::ListNode bcast_fec_lru_;
-  std::queue<BroadcastHash> bcast_lru_;
 
   std::map<BroadcastHash, td::actor::ActorOwn<OverlayOutboundFecBroadcast>> out_fec_bcasts_;
 
@@ -250,8 +318,11 @@ class OverlayImpl : public Overlay {
   static td::uint32 max_data_bcasts() {
     return 100;
   }
-  static td::uint32 max_bcasts() {
-    return 1000;
+  static double delivered_bucket_ttl() {
+    return 30.0;
+  }
+  static td::uint32 delivered_buckets() {
+    return 4;
   }
   static td::uint32 max_fec_bcasts() {
     return 20;
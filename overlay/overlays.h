@@ -104,6 +104,16 @@ class OverlayPrivacyRules {
   std::map<PublicKeyHash, td::uint32> authorized_keys_;
 };
 
+struct OverlayBroadcastOptions {
+  // number of neighbours each simple broadcast / FEC broadcast part is forwarded to
+  td::uint32 simple_fanout = 3;
+  td::uint32 fec_fanout = 5;
+  // rank neighbours by query rtt, redundancy and new broadcast bytes per second they deliver, forward to the best
+  // ones and periodically replace the worst neighbour; otherwise neighbours are fixed and forwarded to at random
+  bool prefer_fast_peers = true;
+  double neighbours_update_period = 30.0;
+};
+
 class Certificate {
  public:
   Certificate(PublicKeyHash issued_by, td::int32 expire_at, td::uint32 max_size, td::BufferSlice signature);
@@ -196,9 +206,13 @@ class Overlays : public td::actor::Actor {
                                  OverlayPrivacyRules rules) = 0;
   virtual void update_certificate(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id, PublicKeyHash key,
                                   std::shared_ptr<Certificate> cert) = 0;
+  virtual void set_broadcast_options(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id,
+                                     OverlayBroadcastOptions options) = 0;
 
   virtual void get_overlay_random_peers(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay, td::uint32 max_peers,
                                         td::Promise<std::vector<adnl::AdnlNodeIdShort>> promise) = 0;
+
+  virtual void get_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
 };
 
 }  // namespace overlay
@@ -131,6 +131,7 @@ void RldpTransferReceiverImpl::receive_part(fec::FecType fec_type, td::uint32 pa
       return;
     }
     decoder_ = D.move_as_ok();
+    decoder_->set_online();
   }
   decoder_->add_symbol(td::fec::Symbol{seqno, std::move(data)});
   if (decoder_->may_try_decode()) {
@@ -0,0 +1,40 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+
+#include "FecEncoderWorker.h"
+
+namespace ton {
+namespace rldp2 {
+
+void FecEncoderWorker::prepare_symbols(std::shared_ptr<td::fec::Encoder> encoder, td::uint32 first_seqno,
+                                       td::uint32 count, td::Promise<std::vector<td::BufferSlice>> promise) {
+  CHECK(encoder);
+  if (encoder->get_info().ready_symbol_count < first_seqno + count) {
+    encoder->prepare_more_symbols();
+  }
+  std::vector<td::BufferSlice> symbols;
+  symbols.reserve(count);
+  for (td::uint32 i = 0; i < count; i++) {
+    symbols.push_back(encoder->gen_symbol(first_seqno + i).data);
+  }
+  promise.set_value(std::move(symbols));
+}
+
+}  // namespace rldp2
+}  // namespace ton
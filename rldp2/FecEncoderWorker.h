@@ -0,0 +1,37 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+
+#pragma once
+
+#include "td/actor/actor.h"
+#include "td/fec/fec.h"
+
+namespace ton {
+namespace rldp2 {
+
+// Generates batches of FEC repair symbols, so that RaptorQ precalculation and symbol generation
+// do not block the connection actor
+class FecEncoderWorker : public td::actor::Actor {
+ public:
+  void prepare_symbols(std::shared_ptr<td::fec::Encoder> encoder, td::uint32 first_seqno, td::uint32 count,
+                       td::Promise<std::vector<td::BufferSlice>> promise);
+};
+
+}  // namespace rldp2
+}  // namespace ton
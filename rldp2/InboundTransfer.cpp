@@ -52,6 +52,7 @@ td::Result<InboundTransfer::Part *> InboundTransfer::get_part(td::uint32 part_i,
     }
 
     auto decoder = fec_type.create_decoder().move_as_ok();
+    decoder->set_online();
     auto it = parts_.emplace(part_i, Part{std::move(decoder), RldpReceiver(RldpSender::Config()), offset});
     next_part_++;
     return &it.first->second;
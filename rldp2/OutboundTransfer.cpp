@@ -40,6 +40,28 @@ std::map<td::uint32, OutboundTransfer::Part> &OutboundTransfer::parts(const Rldp
   return parts_;
 }
 
+td::optional<td::BufferSlice> OutboundTransfer::Part::pop_ready_symbol(td::uint32 seqno) {
+  while (!ready_symbols.empty() && ready_seqno < seqno) {
+    ready_symbols.pop();
+    ready_seqno++;
+  }
+  if (ready_symbols.empty() || ready_seqno != seqno) {
+    return {};
+  }
+  ready_seqno++;
+  return ready_symbols.pop();
+}
+
+void OutboundTransfer::Part::add_ready_symbols(td::uint32 first_seqno, std::vector<td::BufferSlice> symbols) {
+  if (first_seqno != next_unprepared_seqno()) {
+    ready_symbols = {};
+    ready_seqno = first_seqno;
+  }
+  for (auto &symbol : symbols) {
+    ready_symbols.push(std::move(symbol));
+  }
+}
+
 void OutboundTransfer::drop_part(td::uint32 part_i) {
   parts_.erase(part_i);
 }
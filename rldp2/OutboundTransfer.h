@@ -22,6 +22,9 @@
 #include "RldpSender.h"
 #include "fec/fec.h"
 
+#include "td/utils/optional.h"
+#include "td/utils/VectorQueue.h"
+
 #include <map>
 
 namespace ton {
@@ -29,9 +32,20 @@ namespace rldp2 {
 struct OutboundTransfer {
  public:
   struct Part {
-    std::unique_ptr<td::fec::Encoder> encoder;
+    std::shared_ptr<td::fec::Encoder> encoder;
     RldpSender sender;
     ton::fec::FecType fec_type;
+
+    // repair symbols generated outside of the connection, ready_symbols[i] has seqno ready_seqno + i
+    td::uint32 ready_seqno{0};
+    td::VectorQueue<td::BufferSlice> ready_symbols;
+    bool is_preparing{false};
+
+    td::optional<td::BufferSlice> pop_ready_symbol(td::uint32 seqno);
+    void add_ready_symbols(td::uint32 first_seqno, std::vector<td::BufferSlice> symbols);
+    td::uint32 next_unprepared_seqno() const {
+      return ready_seqno + static_cast<td::uint32>(ready_symbols.size());
+    }
   };
 
   OutboundTransfer(td::BufferSlice data) : data_(std::move(data)) {
@@ -199,6 +199,10 @@ td::Timestamp RldpConnection::run(ConnectionCallback &callback) {
     callback.on_sent(res.first, std::move(res.second));
   }
   to_on_sent_.clear();
+  for (auto &request : to_prepare_) {
+    callback.prepare_symbols(std::move(request));
+  }
+  to_prepare_.clear();
 
   return alarm_timestamp;
 }
@@ -244,10 +248,12 @@ td::optional<td::Timestamp> RldpConnection::step(const TransferId &transfer_id,
     action.visit(td::overloaded(
         [&](const RldpSender::ActionSend &send) {
           auto seqno = send.seqno - 1;
-          if (part.encoder->get_info().ready_symbol_count <= seqno) {
-            part.encoder->prepare_more_symbols();
+          auto o_symbol = get_symbol(transfer_id, it.first, part, seqno);
+          if (!o_symbol) {
+            // we will be woken up by on_symbols_prepared
+            return;
           }
-          auto symbol = part.encoder->gen_symbol(seqno).data;
+          auto symbol = o_symbol.unwrap();
           send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_messagePart>(
               transfer_id, part.fec_type.tl(), it.first, outbound.total_size(), seqno, std::move(symbol)));
           if (!send.is_probe) {
@@ -272,6 +278,48 @@ td::optional<td::Timestamp> RldpConnection::step(const TransferId &transfer_id,
   return wakeup_at;
 }
 
+td::optional<td::BufferSlice> RldpConnection::get_symbol(const TransferId &transfer_id, td::uint32 part_i,
+                                                         OutboundTransfer::Part &part, td::uint32 seqno) {
+  if (symbols_batch_size_ == 0) {
+    if (part.encoder->get_info().ready_symbol_count <= seqno) {
+      part.encoder->prepare_more_symbols();
+    }
+    return part.encoder->gen_symbol(seqno).data;
+  }
+
+  // source symbols are just copied from data, so it is cheaper to generate them right here
+  if (seqno < part.fec_type.symbols_count()) {
+    return part.encoder->gen_symbol(seqno).data;
+  }
+
+  auto o_symbol = part.pop_ready_symbol(seqno);
+  if (!part.is_preparing && part.ready_symbols.size() < symbols_batch_size_ / 2) {
+    part.is_preparing = true;
+    to_prepare_.push_back(SymbolsRequest{transfer_id, part_i, part.encoder,
+                                         std::max(seqno + (o_symbol ? 1 : 0), part.next_unprepared_seqno()),
+                                         symbols_batch_size_});
+  }
+  return o_symbol;
+}
+
+void RldpConnection::on_symbols_prepared(TransferId transfer_id, td::uint32 part_i, td::uint32 first_seqno,
+                                         td::Result<std::vector<td::BufferSlice>> r_symbols) {
+  auto it = outbound_transfers_.find(transfer_id);
+  if (it == outbound_transfers_.end()) {
+    return;
+  }
+  auto *part = it->second.get_part(part_i);
+  if (!part) {
+    return;
+  }
+  part->is_preparing = false;
+  if (r_symbols.is_error()) {
+    LOG(ERROR) << "Failed to prepare symbols for " << transfer_id.to_hex() << ": " << r_symbols.error();
+    return;
+  }
+  part->add_ready_symbols(first_seqno, r_symbols.move_as_ok());
+}
+
 void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
   if (completed_set_.count(part.transfer_id_) > 0) {
     send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_complete>(part.transfer_id_, part.part_));
@@ -37,6 +37,14 @@
 namespace ton {
 namespace rldp2 {
 using TransferId = td::Bits256;
+struct SymbolsRequest {
+  TransferId transfer_id;
+  td::uint32 part;
+  std::shared_ptr<td::fec::Encoder> encoder;
+  td::uint32 first_seqno;
+  td::uint32 count;
+};
+
 class ConnectionCallback {
  public:
   virtual ~ConnectionCallback() {
@@ -44,6 +52,9 @@ class ConnectionCallback {
   virtual void send_raw(td::BufferSlice small_datagram) = 0;
   virtual void receive(TransferId transfer_id, td::Result<td::BufferSlice> r_data) = 0;
   virtual void on_sent(TransferId transfer_id, td::Result<td::Unit> state) = 0;
+
+  // Called only if symbols batch size is set. The result must be returned via RldpConnection::on_symbols_prepared
+  virtual void prepare_symbols(SymbolsRequest request) = 0;
 };
 
 class RldpConnection {
@@ -65,8 +76,16 @@ class RldpConnection {
     return default_mtu_;
   }
 
+  // Zero means that repair symbols are generated synchronously by the connection itself
+  void set_symbols_batch_size(td::uint32 batch_size) {
+    symbols_batch_size_ = batch_size;
+  }
+  void on_symbols_prepared(TransferId transfer_id, td::uint32 part_i, td::uint32 first_seqno,
+                           td::Result<std::vector<td::BufferSlice>> r_symbols);
+
  private:
   td::uint64 default_mtu_ = 7680;
+  td::uint32 symbols_batch_size_{0};
 
   std::map<TransferId, OutboundTransfer> outbound_transfers_;
   td::uint32 in_flight_count_{0};
@@ -108,6 +127,7 @@ class RldpConnection {
   std::vector<td::BufferSlice> to_send_raw_;
   std::vector<std::pair<TransferId, td::Result<td::BufferSlice>>> to_receive_;
   std::vector<std::pair<TransferId, td::Result<td::Unit>>> to_on_sent_;
+  std::vector<SymbolsRequest> to_prepare_;
 
   void send_packet(td::BufferSlice packet) {
     to_send_raw_.push_back(std::move(packet));
@@ -127,6 +147,8 @@ class RldpConnection {
   };
 
   td::optional<td::Timestamp> step(const TransferId &transfer_id, OutboundTransfer &outbound, td::Timestamp now);
+  td::optional<td::BufferSlice> get_symbol(const TransferId &transfer_id, td::uint32 part_i,
+                                           OutboundTransfer::Part &part, td::uint32 seqno);
 
   void receive_raw_obj(ton::ton_api::rldp2_messagePart &part);
 
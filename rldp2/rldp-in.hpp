@@ -19,6 +19,7 @@
 #pragma once
 
 #include "rldp.hpp"
+#include "FecEncoderWorker.h"
 
 #include "tl-utils/tl-utils.hpp"
 #include "adnl/adnl-query.h"
@@ -61,6 +62,12 @@ class RldpIn : public RldpImpl {
   static constexpr td::uint32 lru_size() {
     return 128;
   }
+  static constexpr td::uint32 fec_workers_count() {
+    return 4;
+  }
+  static constexpr td::uint32 symbols_batch_size() {
+    return 64;
+  }
   void on_sent(TransferId transfer_id, td::Result<td::Unit> state);
 
   void send_message(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data) override;
@@ -90,6 +97,8 @@ class RldpIn : public RldpImpl {
 
   void add_id(adnl::AdnlNodeIdShort local_id) override;
 
+  void start_up() override;
+
   RldpIn(td::actor::ActorId<adnl::AdnlPeerTable> adnl) : adnl_(adnl) {
   }
 
@@ -105,6 +114,8 @@ class RldpIn : public RldpImpl {
 
   std::set<adnl::AdnlNodeIdShort> local_ids_;
 
+  std::vector<td::actor::ActorOwn<FecEncoderWorker>> fec_workers_;
+
   td::actor::ActorId<RldpConnectionActor> create_connection(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst);
 };
 
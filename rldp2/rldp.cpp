@@ -30,8 +30,12 @@ namespace rldp2 {
 class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback {
  public:
   RldpConnectionActor(td::actor::ActorId<RldpIn> rldp, adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst,
-                      td::actor::ActorId<adnl::Adnl> adnl)
-      : rldp_(std::move(rldp)), src_(src), dst_(dst), adnl_(std::move(adnl)){};
+                      td::actor::ActorId<adnl::Adnl> adnl, std::vector<td::actor::ActorId<FecEncoderWorker>> fec_workers)
+      : rldp_(std::move(rldp)), src_(src), dst_(dst), adnl_(std::move(adnl)), fec_workers_(std::move(fec_workers)) {
+    if (!fec_workers_.empty()) {
+      connection_.set_symbols_batch_size(RldpIn::symbols_batch_size());
+    }
+  };
 
   void send(TransferId transfer_id, td::BufferSlice query, td::Timestamp timeout = td::Timestamp::never()) {
     connection_.send(transfer_id, std::move(query), timeout);
@@ -44,12 +48,19 @@ class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback
     connection_.receive_raw(std::move(data));
     yield();
   }
+  void on_symbols_prepared(TransferId transfer_id, td::uint32 part, td::uint32 first_seqno,
+                           td::Result<std::vector<td::BufferSlice>> r_symbols) {
+    connection_.on_symbols_prepared(transfer_id, part, first_seqno, std::move(r_symbols));
+    yield();
+  }
 
  private:
   td::actor::ActorId<RldpIn> rldp_;
   adnl::AdnlNodeIdShort src_;
   adnl::AdnlNodeIdShort dst_;
   td::actor::ActorId<adnl::Adnl> adnl_;
+  std::vector<td::actor::ActorId<FecEncoderWorker>> fec_workers_;
+  size_t next_fec_worker_{0};
   RldpConnection connection_;
 
   void loop() override {
@@ -65,6 +76,16 @@ class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback
   void on_sent(TransferId transfer_id, td::Result<td::Unit> state) override {
     send_closure(rldp_, &RldpIn::on_sent, transfer_id, std::move(state));
   }
+  void prepare_symbols(SymbolsRequest request) override {
+    auto &worker = fec_workers_[next_fec_worker_++ % fec_workers_.size()];
+    send_closure(worker, &FecEncoderWorker::prepare_symbols, std::move(request.encoder), request.first_seqno,
+                 request.count,
+                 [SelfId = actor_id(this), transfer_id = request.transfer_id, part = request.part,
+                  first_seqno = request.first_seqno](td::Result<std::vector<td::BufferSlice>> R) {
+                   td::actor::send_closure(SelfId, &RldpConnectionActor::on_symbols_prepared, transfer_id, part,
+                                           first_seqno, std::move(R));
+                 });
+  }
 };
 
 namespace {
@@ -128,7 +149,12 @@ td::actor::ActorId<RldpConnectionActor> RldpIn::create_connection(adnl::AdnlNode
   if (it != connections_.end()) {
     return it->second.get();
   }
-  auto connection = td::actor::create_actor<RldpConnectionActor>("RldpConnection", actor_id(this), src, dst, adnl_);
+  std::vector<td::actor::ActorId<FecEncoderWorker>> fec_workers;
+  for (auto &worker : fec_workers_) {
+    fec_workers.push_back(worker.get());
+  }
+  auto connection = td::actor::create_actor<RldpConnectionActor>("RldpConnection", actor_id(this), src, dst, adnl_,
+                                                                 std::move(fec_workers));
   auto res = connection.get();
   connections_[std::make_pair(src, dst)] = std::move(connection);
   return res;
@@ -202,6 +228,12 @@ void RldpIn::on_sent(TransferId transfer_id, td::Result<td::Unit> state) {
   //TODO: completed transfer
 }
 
+void RldpIn::start_up() {
+  for (td::uint32 i = 0; i < fec_workers_count(); i++) {
+    fec_workers_.push_back(td::actor::create_actor<FecEncoderWorker>(PSTRING() << "RldpFecWorker" << i));
+  }
+}
+
 void RldpIn::add_id(adnl::AdnlNodeIdShort local_id) {
   if (local_ids_.count(local_id) == 1) {
     return;
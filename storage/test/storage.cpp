@@ -585,6 +585,21 @@ class Rldp : public td::actor::Actor, public ConnectionCallback {
     //LOG(ERROR) << "GOT ";
   }
 
+  void prepare_symbols(SymbolsRequest request) override {
+    // symbols are generated by the actor itself, but not inside RldpConnection::run
+    send_lambda(actor_id(this), [this, request = std::move(request)]() {
+      if (request.encoder->get_info().ready_symbol_count < request.first_seqno + request.count) {
+        request.encoder->prepare_more_symbols();
+      }
+      std::vector<td::BufferSlice> symbols;
+      for (td::uint32 i = 0; i < request.count; i++) {
+        symbols.push_back(request.encoder->gen_symbol(request.first_seqno + i).data);
+      }
+      connection_.on_symbols_prepared(request.transfer_id, request.part, request.first_seqno, std::move(symbols));
+      yield();
+    });
+  }
+
   void on_sent(TransferId query_id, td::Result<td::Unit> state) override {
     stats_->last_sent_packet_at = td::Timestamp::now();
     //LOG(ERROR) << "SENT " << query_id;
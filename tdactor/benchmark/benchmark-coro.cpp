@@ -0,0 +1,196 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+// Compares a chain of queries written with td::PromiseCreator::lambda callbacks with the same chain written as a
+// td::actor::Task coroutine: time and heap allocations per query. Built only when the compiler supports C++20.
+#include "td/actor/coro.h"
+
+#include "td/utils/benchmark.h"
+#include "td/utils/logging.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<td::uint64> allocations{0};
+
+// every replaceable form is replaced, so that each delete frees memory of the matching new
+static void *counted_alloc(std::size_t size, std::size_t alignment) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = nullptr;
+  if (alignment <= alignof(std::max_align_t)) {
+    ptr = std::malloc(size == 0 ? 1 : size);
+  } else if (posix_memalign(&ptr, alignment, size == 0 ? 1 : size) != 0) {
+    ptr = nullptr;
+  }
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void *operator new(std::size_t size) {
+  return counted_alloc(size, 0);
+}
+void *operator new[](std::size_t size) {
+  return counted_alloc(size, 0);
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+#if TD_ACTOR_HAVE_TASKS
+class Server : public td::actor::Actor {
+ public:
+  void get(int x, td::Promise<int> promise) {
+    promise.set_value(x + 1);
+  }
+};
+
+class LambdaClient : public td::actor::Actor {
+ public:
+  LambdaClient(td::actor::ActorId<Server> server, int n, td::Promise<int> promise)
+      : server_(server), n_(n), promise_(std::move(promise)) {
+  }
+  void start_up() override {
+    step(0);
+  }
+  void step(int x) {
+    if (x == n_) {
+      promise_.set_value(std::move(x));
+      stop();
+      return;
+    }
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<int> R) {
+      R.ensure();
+      td::actor::send_closure(SelfId, &LambdaClient::step, R.move_as_ok());
+    });
+    td::actor::send_closure(server_, &Server::get, x, std::move(P));
+  }
+
+ private:
+  td::actor::ActorId<Server> server_;
+  int n_;
+  td::Promise<int> promise_;
+};
+
+class CoroClient : public td::actor::Actor {
+ public:
+  CoroClient(td::actor::ActorId<Server> server, int n, td::Promise<int> promise)
+      : server_(server), n_(n), promise_(std::move(promise)) {
+  }
+  void start_up() override {
+    td::actor::start_task(run(), td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<int> R) {
+                            td::actor::send_closure(SelfId, &CoroClient::finish, std::move(R));
+                          }));
+  }
+  td::actor::Task<int> run() {
+    int x = 0;
+    while (x < n_) {
+      CO_TRY_RESULT(next, co_await td::actor::ask(server_, &Server::get, x));
+      x = next;
+    }
+    co_return x;
+  }
+  void finish(td::Result<int> R) {
+    promise_.set_result(std::move(R));
+    stop();
+  }
+
+ private:
+  td::actor::ActorId<Server> server_;
+  int n_;
+  td::Promise<int> promise_;
+};
+
+template <class ClientT>
+void run_chain(const char *name, int n) {
+  td::actor::Scheduler scheduler({1});
+  td::uint64 allocated = 0;
+  double elapsed = 0;
+  scheduler.run_in_context([&] {
+    auto server = td::actor::create_actor<Server>("Server").release();
+    td::actor::create_actor<ClientT>(
+        "Client", server, n, td::PromiseCreator::lambda([&, started_at = td::Time::now(),
+                                                         allocated_at = allocations.load()](td::Result<int> R) {
+          R.ensure();
+          CHECK(R.ok() == n);
+          elapsed = td::Time::now() - started_at;
+          allocated = allocations.load() - allocated_at;
+          td::actor::SchedulerContext::get()->stop();
+        }))
+        .release();
+  });
+  while (scheduler.run(1)) {
+  }
+  LOG(ERROR) << name << ": " << td::StringBuilder::FixedDouble(elapsed * 1e9 / n, 1) << " ns/query, "
+             << td::StringBuilder::FixedDouble(static_cast<double>(allocated) / n, 2) << " allocations/query";
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  for (int i = 0; i < 2; i++) {
+    run_chain<LambdaClient>("lambda promise chain", 1000000);
+    run_chain<CoroClient>("coroutine task", 1000000);
+  }
+  return 0;
+}
+#else
+int main() {
+  LOG(ERROR) << "coroutines are not supported by the compiler";
+  return 0;
+}
+#endif
@@ -43,6 +43,7 @@ extern "C" {
 #endif
 
 #include "td/actor/core/ActorLocker.h"
+#include "td/actor/core/ActorProfiler.h"
 #include "td/actor/actor.h"
 
 #include "td/utils/benchmark.h"
@@ -1637,8 +1638,202 @@ class YieldMany : public td::Benchmark {
   bool use_io_{false};
 };
 
+// Many senders flood one busy receiver (like AdnlPeerTable), either with separate messages or with closure batches
+class MessageFlood : public td::Benchmark {
+ public:
+  MessageFlood(size_t batch_size, size_t message_budget) : batch_size_(batch_size), message_budget_(message_budget) {
+  }
+  std::string get_description() const {
+    return PSTRING() << "Message flood batch_size(" << batch_size_ << ") message_budget(" << message_budget_
+                     << ") profiler(" << td::actor::core::ActorProfiler::is_enabled() << ")";
+  }
+
+  void run(int n) {
+    class Receiver : public td::actor::Actor {
+     public:
+      Receiver(size_t total, Sem *sem) : total_(total), sem_(sem) {
+      }
+      void on_message(size_t x) {
+        sum_ += x;
+        if (++received_ == total_) {
+          sem_->post();
+          stop();
+        }
+      }
+
+     private:
+      size_t total_;
+      size_t received_{0};
+      size_t sum_{0};
+      Sem *sem_;
+    };
+    class Sender : public td::actor::Actor {
+     public:
+      Sender(td::actor::ActorId<Receiver> receiver, size_t total, size_t batch_size)
+          : receiver_(receiver), left_(total), batch_size_(batch_size) {
+      }
+      void loop() override {
+        auto n = td::min(left_, batch_size_ * 16);
+        if (batch_size_ == 1) {
+          for (size_t i = 0; i < n; i++) {
+            td::actor::send_closure(receiver_, &Receiver::on_message, i);
+          }
+        } else {
+          for (size_t i = 0; i < n; i += batch_size_) {
+            td::actor::ClosureBatch<Receiver> batch;
+            for (size_t j = i; j < td::min(n, i + batch_size_); j++) {
+              batch.add(&Receiver::on_message, j);
+            }
+            td::actor::send_closure_batch(receiver_, std::move(batch));
+          }
+        }
+        left_ -= n;
+        if (left_ == 0) {
+          return stop();
+        }
+        yield();
+      }
+
+     private:
+      td::actor::ActorId<Receiver> receiver_;
+      size_t left_;
+      size_t batch_size_;
+    };
+
+    size_t cpu_n = 4;
+    size_t senders_n = 4;
+    size_t per_sender = 1 << 16;
+    td::actor::Scheduler scheduler{{td::actor::Scheduler::NodeInfo{cpu_n}.with_message_budget(message_budget_)}};
+    auto sch = td::thread([&] { scheduler.run(); });
+    Sem sem;
+    scheduler.run_in_context_external([&] {
+      for (int i = 0; i < n; i++) {
+        auto receiver = td::actor::create_actor<Receiver>("Receiver", senders_n * per_sender, &sem).release();
+        for (size_t j = 0; j < senders_n; j++) {
+          td::actor::create_actor<Sender>("Sender", receiver, per_sender, batch_size_).release();
+        }
+        sem.wait();
+      }
+    });
+    scheduler.run_in_context_external([&] { td::actor::SchedulerContext::get()->stop(); });
+    sch.join();
+  }
+
+ private:
+  size_t batch_size_;
+  size_t message_budget_;
+};
+
+// Latency of messages to a consensus-like actor while all cpu workers are busy with bulk (liteserver-like) actors
+void run_consensus_latency_bench(bool use_priority) {
+  class Bulk : public td::actor::Actor {
+   public:
+    explicit Bulk(std::atomic<bool> *stop_flag) : stop_flag_(stop_flag) {
+    }
+    void loop() override {
+      if (stop_flag_->load(std::memory_order_relaxed)) {
+        stop();
+        return;
+      }
+      auto end_at = td::Time::now() + 50e-6;
+      while (td::Time::now() < end_at) {
+      }
+      yield();
+    }
+
+   private:
+    std::atomic<bool> *stop_flag_;
+  };
+  class Consensus : public td::actor::Actor {
+   public:
+    Consensus(size_t total, std::vector<double> *latency, Sem *sem) : total_(total), latency_(latency), sem_(sem) {
+    }
+    void on_message(double sent_at) {
+      latency_->push_back(td::Time::now() - sent_at);
+      if (latency_->size() == total_) {
+        sem_->post();
+      }
+    }
+
+   private:
+    size_t total_;
+    std::vector<double> *latency_;
+    Sem *sem_;
+  };
+  class Pinger : public td::actor::Actor {
+   public:
+    Pinger(td::actor::ActorId<Consensus> consensus, size_t total, bool use_priority)
+        : consensus_(consensus), total_(total), use_priority_(use_priority) {
+    }
+    void start_up() override {
+      alarm_timestamp() = td::Timestamp::in(0.001);
+    }
+    void alarm() override {
+      if (use_priority_) {
+        td::actor::send_closure_high_priority(consensus_, &Consensus::on_message, td::Time::now());
+      } else {
+        td::actor::send_closure(consensus_, &Consensus::on_message, td::Time::now());
+      }
+      if (++sent_ == total_) {
+        stop();
+        return;
+      }
+      alarm_timestamp() = td::Timestamp::in(0.001);
+    }
+
+   private:
+    td::actor::ActorId<Consensus> consensus_;
+    size_t total_;
+    size_t sent_{0};
+    bool use_priority_;
+  };
+
+  size_t cpu_n = 4;
+  size_t bulk_n = cpu_n * 16;
+  size_t total = 2000;
+  std::atomic<bool> stop_flag{false};
+  std::vector<double> latency;
+  Sem sem;
+
+  td::actor::Scheduler scheduler{{cpu_n}};
+  auto sch = td::thread([&] { scheduler.run(); });
+  scheduler.run_in_context_external([&] {
+    for (size_t i = 0; i < bulk_n; i++) {
+      td::actor::create_actor<Bulk>("Bulk", &stop_flag).release();
+    }
+    auto consensus = td::actor::create_actor<Consensus>("Consensus", total, &latency, &sem).release();
+    td::actor::create_actor<Pinger>(td::actor::ActorOptions().with_name("Pinger").with_poll(), consensus, total,
+                                    use_priority)
+        .release();
+  });
+  sem.wait();
+  stop_flag = true;
+  scheduler.run_in_context_external([&] { td::actor::SchedulerContext::get()->stop(); });
+  sch.join();
+
+  std::sort(latency.begin(), latency.end());
+  auto at = [&](double q) { return latency[static_cast<size_t>(q * static_cast<double>(latency.size() - 1))] * 1e6; };
+  LOG(ERROR) << "Consensus latency under bulk load use_priority(" << use_priority << "): p50=" << at(0.5)
+             << "us p90=" << at(0.9) << "us p99=" << at(0.99) << "us max=" << at(1.0) << "us";
+}
+
 int main(int argc, char **argv) {
   if (argc > 1) {
+    if (argv[1][0] == 'p') {
+      run_consensus_latency_bench(false);
+      run_consensus_latency_bench(true);
+      return 0;
+    }
+    if (argv[1][0] == 'f') {
+      bench(MessageFlood(1, 0));
+      bench(MessageFlood(1, 256));
+      bench(MessageFlood(64, 0));
+      bench(MessageFlood(64, 256));
+      td::actor::core::ActorProfiler::set_enabled(false);
+      bench(MessageFlood(1, 0));
+      bench(MessageFlood(64, 0));
+      return 0;
+    }
     if (argv[1][0] == 'a') {
       bench_n(MpmcQueueBenchmark2<WaitQueue<td::MpmcQueue<size_t>, td::MpmcEagerWaiter, size_t>>(50, 1), 1 << 26);
       //bench_n(MpmcQueueBenchmark<td::MpmcQueue<size_t>>(1, 1), 1 << 26);
@@ -1662,6 +1857,8 @@ int main(int argc, char **argv) {
   bench(ChainedSpawnInplace(true));
   bench(ChainedSpawn(false));
   bench(ChainedSpawn(true));
+  bench(MessageFlood(1, 0));
+  bench(MessageFlood(64, 0));
 
   run_queue_bench(10, 10);
   run_queue_bench(10, 1);
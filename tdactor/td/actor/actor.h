@@ -22,6 +22,8 @@
 #include "td/actor/ActorOwn.h"
 #include "td/actor/ActorShared.h"
 
+#include "td/utils/buffer.h"
+
 namespace td {
 namespace actor {
 
@@ -163,6 +165,18 @@ bool send_closure_later_bool(ActorIdT &&actor_id, FunctionT function, ArgsT &&..
   return true;
 }
 
+// Same as send_closure_later, but the receiver is scheduled through the high priority queue
+template <class ActorIdT, class FunctionT, class... ArgsT, class FunctionClassT = member_function_class_t<FunctionT>,
+          size_t argument_count = member_function_argument_count<FunctionT>(),
+          std::enable_if_t<argument_count == sizeof...(ArgsT), bool> with_promise = false>
+void send_closure_high_priority(ActorIdT &&actor_id, FunctionT function, ArgsT &&... args) {
+  using ActorT = typename std::decay_t<ActorIdT>::ActorT;
+  static_assert(std::is_base_of<FunctionClassT, ActorT>::value, "unsafe send_closure");
+
+  ActorIdT id = std::forward<ActorIdT>(actor_id);
+  detail::send_closure_high_priority(id.as_actor_ref(), function, std::forward<ArgsT>(args)...);
+}
+
 template <class ActorIdT, class... ArgsT>
 void send_lambda(ActorIdT &&actor_id, ArgsT &&... args) {
   ActorIdT id = std::forward<ActorIdT>(actor_id);
@@ -173,6 +187,39 @@ void send_lambda_later(ActorIdT &&actor_id, ArgsT &&... args) {
   ActorIdT id = std::forward<ActorIdT>(actor_id);
   detail::send_lambda_later(id.as_actor_ref(), std::forward<ArgsT>(args)...);
 }
+// Closures to one actor, which are sent with a single mailbox operation by send_closure_batch.
+// They are run in order, but other messages to the actor may be run between them.
+template <class ActorT>
+class ClosureBatch {
+ public:
+  template <class FunctionT, class... ArgsT, class FunctionClassT = member_function_class_t<FunctionT>>
+  void add(FunctionT function, ArgsT &&... args) {
+    static_assert(std::is_base_of<FunctionClassT, ActorT>::value, "unsafe send_closure");
+    messages_.push_back(detail::create_closure_message(create_delayed_closure(function, std::forward<ArgsT>(args)...)));
+  }
+  size_t size() const {
+    return messages_.size();
+  }
+  bool empty() const {
+    return messages_.empty();
+  }
+
+ private:
+  template <class ActorIdT, class T>
+  friend void send_closure_batch(ActorIdT &&actor_id, ClosureBatch<T> batch);
+
+  std::vector<core::ActorMessage> messages_;
+};
+
+template <class ActorIdT, class T>
+void send_closure_batch(ActorIdT &&actor_id, ClosureBatch<T> batch) {
+  using ActorT = typename std::decay_t<ActorIdT>::ActorT;
+  static_assert(std::is_base_of<T, ActorT>::value, "unsafe send_closure");
+
+  ActorIdT id = std::forward<ActorIdT>(actor_id);
+  detail::send_messages_later(id.as_actor_ref(), std::move(batch.messages_));
+}
+
 template <class ActorIdT>
 void send_signals(ActorIdT &&actor_id, ActorSignals signals) {
   ActorIdT id = std::forward<ActorIdT>(actor_id);
@@ -183,6 +230,141 @@ void send_signals_later(ActorIdT &&actor_id, ActorSignals signals) {
   ActorIdT id = std::forward<ActorIdT>(actor_id);
   detail::send_signals_later(id.as_actor_ref(), signals);
 }
+
+namespace detail {
+template <class T>
+struct BlockingResult {
+  using type = T;
+};
+template <class T>
+struct BlockingResult<Result<T>> {
+  using type = T;
+};
+
+template <class R, class F>
+class BlockingTaskImpl : public core::BlockingTask {
+ public:
+  template <class FromF>
+  BlockingTaskImpl(ActorId<> owner, FromF &&f, Promise<R> &&promise)
+      : owner_(std::move(owner)), f_(std::forward<FromF>(f)), promise_(std::move(promise)) {
+  }
+  void run() override {
+    Result<R> result = f_();
+    send_lambda_later(owner_.as_actor_ref(),
+                      [promise = std::move(promise_), result = std::move(result)]() mutable {
+                        promise.set_result(std::move(result));
+                      });
+  }
+
+ private:
+  ActorId<> owner_;
+  F f_;
+  Promise<R> promise_;
+};
+
+class FileReadTaskImpl final : public core::FileIoTask {
+ public:
+  FileReadTaskImpl(ActorId<> owner, const FileFd &fd, BufferSlice buffer, uint64 offset,
+                   Promise<BufferSlice> &&promise)
+      : FileIoTask(fd, buffer.as_slice(), offset)
+      , owner_(std::move(owner))
+      , buffer_(std::move(buffer))
+      , promise_(std::move(promise)) {
+  }
+  void on_finished(Result<size_t> r_size) override {
+    Result<BufferSlice> result;
+    if (r_size.is_error()) {
+      result = r_size.move_as_error();
+    } else {
+      buffer_.truncate(r_size.ok());
+      result = std::move(buffer_);
+    }
+    send_lambda_later(owner_.as_actor_ref(),
+                      [promise = std::move(promise_), result = std::move(result)]() mutable {
+                        promise.set_result(std::move(result));
+                      });
+  }
+
+ private:
+  ActorId<> owner_;
+  BufferSlice buffer_;
+  Promise<BufferSlice> promise_;
+};
+
+class FileWriteTaskImpl final : public core::FileIoTask {
+ public:
+  FileWriteTaskImpl(ActorId<> owner, FileFd &fd, BufferSlice data, uint64 offset, Promise<Unit> &&promise)
+      : FileIoTask(fd, Slice(data.as_slice()), offset)
+      , owner_(std::move(owner))
+      , data_(std::move(data))
+      , promise_(std::move(promise)) {
+  }
+  void on_finished(Result<size_t> r_size) override {
+    Result<Unit> result;
+    if (r_size.is_error()) {
+      result = r_size.move_as_error();
+    } else {
+      result = Unit();
+    }
+    send_lambda_later(owner_.as_actor_ref(),
+                      [promise = std::move(promise_), result = std::move(result)]() mutable {
+                        promise.set_result(std::move(result));
+                      });
+  }
+
+ private:
+  ActorId<> owner_;
+  BufferSlice data_;
+  Promise<Unit> promise_;
+};
+}  // namespace detail
+
+// Runs f() (returning T or td::Result<T>) on a blocking thread of the current scheduler, so slow disk or database
+// calls do not occupy a cpu worker. f must not touch the state of the calling actor. The promise is set in the
+// context of the calling actor.
+template <class F, class PromiseT>
+void run_blocking(F &&f, PromiseT &&promise) {
+  using R = typename detail::BlockingResult<decltype(f())>::type;
+  Promise<R> result_promise = std::forward<PromiseT>(promise);
+  core::SchedulerContext::get()->add_blocking_task(std::make_unique<detail::BlockingTaskImpl<R, std::decay_t<F>>>(
+      actor_id(), std::forward<F>(f), std::move(result_promise)));
+}
+
+inline core::BlockingStats get_blocking_stats() {
+  return core::SchedulerContext::get()->get_blocking_stats();
+}
+
+// Reads size bytes at offset, or less at the end of file, without blocking the calling actor. The read is submitted
+// to io_uring by the io worker of the current scheduler, or is run on a blocking thread if io_uring is not available.
+// fd must stay open till the promise is set, which happens in the context of the calling actor.
+template <class PromiseT>
+void file_pread(const FileFd &fd, size_t size, uint64 offset, PromiseT &&promise) {
+  Promise<BufferSlice> result_promise = std::forward<PromiseT>(promise);
+  core::SchedulerContext::get()->add_file_io_task(std::make_unique<detail::FileReadTaskImpl>(
+      actor_id(), fd, BufferSlice(size), offset, std::move(result_promise)));
+}
+
+// Writes all data at offset, same as file_pread
+template <class PromiseT>
+void file_pwrite(FileFd &fd, BufferSlice data, uint64 offset, PromiseT &&promise) {
+  Promise<Unit> result_promise = std::forward<PromiseT>(promise);
+  core::SchedulerContext::get()->add_file_io_task(std::make_unique<detail::FileWriteTaskImpl>(
+      actor_id(), fd, std::move(data), offset, std::move(result_promise)));
+}
+
+inline core::FileIoStats get_file_io_stats() {
+  return core::SchedulerContext::get()->get_file_io_stats();
+}
+
+// Scheduler configured with NodeInfo::with_dedicated_role(role), or an invalid id, which makes
+// ActorOptions().on_scheduler() keep the default placement
+inline SchedulerId dedicated_scheduler(Slice role) {
+  auto scheduler_context = core::SchedulerContext::get();
+  if (scheduler_context == nullptr) {
+    return SchedulerId{};
+  }
+  return scheduler_context->get_dedicated_scheduler(role);
+}
 }  // namespace actor
 
 class SendClosure {
@@ -27,9 +27,12 @@
 
 #include "td/utils/Timer.h"
 
+#include <typeinfo>
+
 namespace td {
 namespace actor {
 using core::ActorOptions;
+using core::ActorPriority;
 
 // Replacement for core::ActorSignals. Easier to use and do not allow internal signals
 class ActorSignals {
@@ -101,8 +104,32 @@ class Scheduler {
     }
     NodeInfo(size_t cpu_threads, size_t io_threads) : cpu_threads_(cpu_threads), io_threads_(io_threads) {
     }
+    NodeInfo &with_blocking_threads(size_t blocking_threads) {
+      blocking_threads_ = blocking_threads;
+      return *this;
+    }
+    // pins cpu worker i to cpus[i % cpus.size()], other threads of the node may run on any of the cpus
+    NodeInfo &with_cpu_affinity(std::vector<int32> cpus) {
+      cpu_affinity_ = std::move(cpus);
+      return *this;
+    }
+    // the node is returned by dedicated_scheduler(role)
+    NodeInfo &with_dedicated_role(std::string role) {
+      dedicated_roles_.push_back(std::move(role));
+      return *this;
+    }
+    // at most message_budget messages are run in one activation of an actor, 0 means no limit
+    NodeInfo &with_message_budget(size_t message_budget) {
+      message_budget_ = message_budget;
+      return *this;
+    }
     size_t cpu_threads_;
     size_t io_threads_{1};
+    // threads for run_blocking, without them blocking calls run on the calling thread
+    size_t blocking_threads_{0};
+    std::vector<int32> cpu_affinity_;
+    std::vector<std::string> dedicated_roles_;
+    size_t message_budget_{0};
   };
 
   enum Mode { Running, Paused };
@@ -136,6 +163,10 @@ class Scheduler {
           }
         });
         thread.set_name(PSLICE() << "#" << it << ":io");
+        if (!scheduler->get_cpu_affinity().empty()) {
+          auto status = thread.set_affinity(scheduler->get_cpu_affinity());
+          LOG_IF(WARNING, status.is_error()) << "Failed to pin io thread of scheduler " << it << ": " << status;
+        }
         thread.detach();
       }
     }
@@ -193,8 +224,13 @@ class Scheduler {
     group_info_ = std::make_shared<core::SchedulerGroupInfo>(infos_.size());
     td::uint8 id = 0;
     for (const auto &info : infos_) {
-      schedulers_.emplace_back(
-          td::make_unique<core::Scheduler>(group_info_, core::SchedulerId{id}, info.cpu_threads_, skip_timeouts_));
+      schedulers_.emplace_back(td::make_unique<core::Scheduler>(group_info_, core::SchedulerId{id}, info.cpu_threads_,
+                                                                skip_timeouts_, info.blocking_threads_));
+      schedulers_.back()->set_cpu_affinity(info.cpu_affinity_);
+      schedulers_.back()->set_message_budget(info.message_budget_);
+      for (auto &role : info.dedicated_roles_) {
+        group_info_->dedicated_schedulers.emplace_back(role, core::SchedulerId{id});
+      }
       id++;
     }
   }
@@ -213,6 +249,10 @@ class ActorMessageLambda : public core::ActorMessageImpl {
     //delivery_warning_.reset();
     lambda_();
   }
+  const core::ActorProfileSite *get_profile_site() const override {
+    static const core::ActorProfileSite site{typeid(LambdaT).name()};
+    return &site;
+  }
 
  private:
   LambdaT lambda_;
@@ -285,6 +325,21 @@ inline void send_message_later(ActorRef actor_ref, core::ActorMessage message) {
   send_message_later(actor_ref.actor_info, std::move(message));
 }
 
+inline void send_messages_later(ActorRef actor_ref, std::vector<core::ActorMessage> messages) {
+  auto scheduler_context_ptr = core::SchedulerContext::get();
+  if (scheduler_context_ptr == nullptr) {
+    //LOG(ERROR) << "send to actor is silently ignored";
+    return;
+  }
+  auto &scheduler_context = *scheduler_context_ptr;
+  core::ActorExecutor executor(actor_ref.actor_info, scheduler_context,
+                               core::ActorExecutor::Options().with_has_poll(scheduler_context.has_poll()));
+  for (auto &message : messages) {
+    message.set_link_token(actor_ref.link_token);
+  }
+  executor.send(std::move(messages));
+}
+
 template <class ExecuteF, class ToMessageF>
 void send_immediate(ActorRef actor_ref, ExecuteF &&execute, ToMessageF &&to_message) {
   auto scheduler_context_ptr = core::SchedulerContext::get();
@@ -369,6 +424,27 @@ void send_closure_later(ActorRef actor_ref, ArgsT &&... args) {
   send_closure_later_impl(actor_ref, create_delayed_closure(std::forward<ArgsT>(args)...));
 }
 
+template <class ClosureT>
+core::ActorMessage create_closure_message(ClosureT &&closure) {
+  using ActorType = typename ClosureT::ActorType;
+  return ActorMessageCreator::lambda(
+      [closure = to_delayed_closure(std::move(closure))]() mutable { closure.run(&current_actor<ActorType>()); });
+}
+
+template <class ClosureT>
+void send_closure_high_priority_impl(ActorRef actor_ref, ClosureT &&closure) {
+  using ActorType = typename ClosureT::ActorType;
+  auto message = ActorMessageCreator::lambda(
+      [closure = to_delayed_closure(std::move(closure))]() mutable { closure.run(&current_actor<ActorType>()); });
+  message.set_high_priority();
+  send_message_later(actor_ref, std::move(message));
+}
+
+template <class... ArgsT>
+void send_closure_high_priority(ActorRef actor_ref, ArgsT &&... args) {
+  send_closure_high_priority_impl(actor_ref, create_delayed_closure(std::forward<ArgsT>(args)...));
+}
+
 inline void send_signals(ActorRef actor_ref, ActorSignals signals) {
   auto scheduler_context_ptr = core::SchedulerContext::get();
   if (scheduler_context_ptr == nullptr) {
@@ -23,6 +23,12 @@
 namespace td {
 namespace actor {
 namespace core {
+namespace {
+const ActorProfileSite start_up_site{"start_up"};
+const ActorProfileSite wake_up_site{"wake_up"};
+const ActorProfileSite alarm_site{"alarm"};
+}  // namespace
+
 void ActorExecutor::send_immediate(ActorMessage message) {
   CHECK(can_send_immediate());
   if (is_closed()) {
@@ -63,6 +69,14 @@ void ActorExecutor::send(ActorMessage message) {
   pending_signals_.add_signal(ActorSignals::Message);
 }
 
+void ActorExecutor::send(std::vector<ActorMessage> messages) {
+  if (is_closed() || messages.empty()) {
+    return;
+  }
+  actor_info_.mailbox().push_all(std::move(messages));
+  pending_signals_.add_signal(ActorSignals::Message);
+}
+
 void ActorExecutor::send(ActorSignals signals) {
   if (is_closed()) {
     return;
@@ -119,11 +133,16 @@ void ActorExecutor::start() noexcept {
       return;
     }
   }
-  while (flush_one_message()) {
-    if (actor_execute_context_.has_immediate_flags()) {
+  // an actor with more messages is put back to the end of the queue, so a flooded actor doesn't hold a worker
+  auto message_budget = dispatcher_.get_message_budget();
+  for (size_t i = 0; message_budget == 0 || i < message_budget; i++) {
+    if (!flush_one_message() || actor_execute_context_.has_immediate_flags()) {
       return;
     }
   }
+  // the rest of the messages will be run after the actor is taken from the queue again
+  pending_signals_.add_signal(ActorSignals::Message);
+  is_message_budget_exhausted_ = true;
 }
 
 void ActorExecutor::finish() noexcept {
@@ -177,7 +196,11 @@ void ActorExecutor::finish() noexcept {
     }
     if (actor_locker_.try_unlock(flags())) {
       if (add_to_queue) {
-        dispatcher_.add_to_queue(std::move(actor_info_ptr), flags().get_scheduler_id(), !flags().is_shared());
+        if (is_message_budget_exhausted_) {
+          dispatcher_.add_to_queue_tail(std::move(actor_info_ptr), flags().get_scheduler_id(), !flags().is_shared());
+        } else {
+          dispatcher_.add_to_queue(std::move(actor_info_ptr), flags().get_scheduler_id(), !flags().is_shared());
+        }
       }
       break;
     }
@@ -201,16 +224,16 @@ bool ActorExecutor::flush_one_signal(ActorSignals &signals) {
       actor_execute_context_.set_stop();
       break;
     case ActorSignals::StartUp:
-      actor_info_.actor().start_up();
+      run_profiled(&start_up_site, 0, [&] { actor_info_.actor().start_up(); });
       break;
     case ActorSignals::Wakeup:
-      actor_info_.actor().wake_up();
+      run_profiled(&wake_up_site, 0, [&] { actor_info_.actor().wake_up(); });
       break;
     case ActorSignals::Alarm:
       if (actor_execute_context_.get_alarm_timestamp() && actor_execute_context_.get_alarm_timestamp().is_in_past()) {
         actor_execute_context_.alarm_timestamp() = Timestamp::never();
         actor_info_.set_alarm_timestamp(Timestamp::never());
-        actor_info_.actor().alarm();
+        run_profiled(&alarm_site, 0, [&] { actor_info_.actor().alarm(); });
       }
       break;
     case ActorSignals::Io:
@@ -245,7 +268,7 @@ bool ActorExecutor::flush_one_message() {
   }
 
   actor_execute_context_.set_link_token(message.get_link_token());
-  message.run();
+  run_profiled(message.get_profile_site(), message.get_pushed_at(), [&] { message.run(); });
   return true;
 }
 
@@ -22,11 +22,17 @@
 #include "td/actor/core/ActorInfo.h"
 #include "td/actor/core/ActorLocker.h"
 #include "td/actor/core/ActorMessage.h"
+#include "td/actor/core/ActorProfiler.h"
 #include "td/actor/core/ActorSignals.h"
 #include "td/actor/core/ActorState.h"
 #include "td/actor/core/SchedulerContext.h"
 
 #include "td/utils/format.h"
+#include "td/utils/port/Clocks.h"
+
+#include <atomic>
+#include <typeinfo>
+#include <vector>
 
 namespace td {
 namespace actor {
@@ -90,6 +96,8 @@ class ActorExecutor {
   void send_immediate(ActorSignals signals);
   void send(ActorMessage message);
   void send(ActorSignals signals);
+  // the messages are always delivered through the mailbox
+  void send(std::vector<ActorMessage> messages);
 
  private:
   ActorInfo &actor_info_;
@@ -105,6 +113,9 @@ class ActorExecutor {
 
   ActorState::Flags flags_;
   ActorSignals pending_signals_;
+  bool is_message_budget_exhausted_{false};
+  // when the previous profiled message finished, it is the start of the next one
+  double profiled_until_{0};
 
   const char *old_log_tag_;
 
@@ -115,6 +126,22 @@ class ActorExecutor {
   void start() noexcept;
   void finish() noexcept;
 
+  template <class F>
+  void run_profiled(const ActorProfileSite *site, double pushed_at, F &&f) {
+    if (!ActorProfiler::is_enabled()) {
+      f();
+      return;
+    }
+    // the actor may be destroyed by f
+    auto actor_type = typeid(actor_info_.actor()).name();
+    auto started_at = profiled_until_ > 0 ? profiled_until_ : Clocks::monotonic();
+    f();
+    auto finished_at = Clocks::monotonic();
+    profiled_until_ = finished_at;
+    ActorProfiler::add(site, actor_type, finished_at - started_at,
+                       pushed_at > 0 ? td::max(started_at - pushed_at, 0.0) : -1);
+  }
+
   bool flush_one(ActorSignals &signals);
   bool flush_one_signal(ActorSignals &signals);
   bool flush_one_message();
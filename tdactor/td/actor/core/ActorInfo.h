@@ -34,8 +34,9 @@ class ActorInfo;
 using ActorInfoPtr = SharedObjectPool<ActorInfo>::Ptr;
 class ActorInfo : private HeapNode, private ListNode {
  public:
-  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name)
-      : actor_(std::move(actor)), name_(name.begin(), name.size()) {
+  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name,
+            ActorPriority priority = ActorPriority::Normal)
+      : actor_(std::move(actor)), name_(name.begin(), name.size()), priority_(priority) {
     state_.set_flags_unsafe(state_flags);
     VLOG(actor) << "Create actor [" << name_ << "]";
   }
@@ -70,6 +71,13 @@ class ActorInfo : private HeapNode, private ListNode {
   CSlice get_name() const {
     return name_;
   }
+  ActorPriority get_priority() const {
+    return priority_;
+  }
+  // decides which cpu queue the actor goes to; consumes the boost of a high priority message
+  bool take_high_priority() {
+    return mailbox_.take_high_priority() || priority_ == ActorPriority::High;
+  }
 
   HeapNode *as_heap_node() {
     return this;
@@ -100,6 +108,7 @@ class ActorInfo : private HeapNode, private ListNode {
   ActorState state_;
   ActorMailbox mailbox_;
   std::string name_;
+  ActorPriority priority_;
   std::atomic<double> alarm_timestamp_at_{0};
 
   ActorInfoPtr pin_;
@@ -45,6 +45,10 @@ class ActorInfoCreator {
       is_shared = !has_poll;
       return *this;
     }
+    Options &with_priority(ActorPriority new_priority) {
+      priority = new_priority;
+      return *this;
+    }
 
    private:
     friend class ActorInfoCreator;
@@ -52,6 +56,7 @@ class ActorInfoCreator {
     SchedulerId scheduler_id;
     bool is_shared{true};
     bool in_queue{true};
+    ActorPriority priority{ActorPriority::Normal};
     //TODO: rename
   };
 
@@ -65,7 +70,7 @@ class ActorInfoCreator {
     flags.set_in_queue(args.in_queue);
     flags.set_signals(ActorSignals::one(ActorSignals::StartUp));
 
-    auto actor_info_ptr = pool_.alloc(std::move(actor), flags, args.name);
+    auto actor_info_ptr = pool_.alloc(std::move(actor), flags, args.name, args.priority);
     actor_info_ptr->actor().set_actor_info_ptr(actor_info_ptr);
     return actor_info_ptr;
   }
@@ -19,7 +19,12 @@
 #pragma once
 
 #include "td/actor/core/ActorMessage.h"
+#include "td/actor/core/ActorProfiler.h"
 #include "td/utils/MpscLinkQueue.h"
+#include "td/utils/port/Clocks.h"
+
+#include <atomic>
+#include <vector>
 
 namespace td {
 namespace actor {
@@ -35,12 +40,43 @@ class ActorMailbox {
     clear();
   }
   void push(ActorMessage message) {
+    if (ActorProfiler::is_enabled() && ActorProfiler::sample_queue_delay()) {
+      message.set_pushed_at(Clocks::monotonic());
+    }
+    if (message.is_high_priority()) {
+      has_high_priority_.store(true, std::memory_order_relaxed);
+    }
     queue_.push(std::move(message));
   }
+  // all messages are pushed with a single atomic operation
+  void push_all(std::vector<ActorMessage> messages) {
+    td::MpscLinkQueue<ActorMessage>::List list;
+    double pushed_at = ActorProfiler::is_enabled() && ActorProfiler::sample_queue_delay() ? Clocks::monotonic() : 0;
+    for (auto &message : messages) {
+      message.set_pushed_at(pushed_at);
+      if (message.is_high_priority()) {
+        has_high_priority_.store(true, std::memory_order_relaxed);
+      }
+      list.push(std::move(message));
+    }
+    queue_.push_list(list);
+  }
   void push_unsafe(ActorMessage message) {
+    if (ActorProfiler::is_enabled() && ActorProfiler::sample_queue_delay()) {
+      message.set_pushed_at(Clocks::monotonic());
+    }
+    if (message.is_high_priority()) {
+      has_high_priority_.store(true, std::memory_order_relaxed);
+    }
     queue_.push_unsafe(std::move(message));
   }
 
+  // true if a high priority message was pushed since the last call
+  bool take_high_priority() {
+    return has_high_priority_.load(std::memory_order_relaxed) &&
+           has_high_priority_.exchange(false, std::memory_order_relaxed);
+  }
+
   td::MpscLinkQueue<ActorMessage>::Reader &reader() {
     return reader_;
   }
@@ -62,6 +98,7 @@ class ActorMailbox {
  private:
   td::MpscLinkQueue<ActorMessage> queue_;
   td::MpscLinkQueue<ActorMessage>::Reader reader_;
+  std::atomic<bool> has_high_priority_{false};
 };
 }  // namespace core
 }  // namespace actor
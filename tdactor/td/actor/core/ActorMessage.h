@@ -19,12 +19,17 @@
 #pragma once
 
 #include "td/actor/core/ActorExecuteContext.h"
+#include "td/actor/core/ActorProfiler.h"
 
 #include "td/utils/MpscLinkQueue.h"
 
 namespace td {
 namespace actor {
 namespace core {
+// High priority actors are put into a separate scheduler queue which cpu workers drain first.
+// A high priority message boosts the next scheduling of its (normal priority) receiver.
+enum class ActorPriority : uint8 { Normal, High };
+
 class ActorMessageImpl : private MpscLinkQueueImpl::Node {
  public:
   ActorMessageImpl() = default;
@@ -35,6 +40,11 @@ class ActorMessageImpl : private MpscLinkQueueImpl::Node {
 
   virtual ~ActorMessageImpl() = default;
   virtual void run() = 0;
+  // used by ActorProfiler as the message type, must have static storage duration
+  virtual const ActorProfileSite *get_profile_site() const {
+    static const ActorProfileSite site{"message"};
+    return &site;
+  }
 
  private:
   friend class ActorMessage;
@@ -50,6 +60,8 @@ class ActorMessageImpl : private MpscLinkQueueImpl::Node {
 
   uint64 link_token_{EmptyLinkToken};
   bool is_big_{false};
+  bool is_high_priority_{false};
+  double pushed_at_{0};
 };
 
 class ActorMessage {
@@ -78,6 +90,21 @@ class ActorMessage {
   void set_big() {
     impl_->is_big_ = true;
   }
+  const ActorProfileSite *get_profile_site() const {
+    return impl_->get_profile_site();
+  }
+  double get_pushed_at() const {
+    return impl_->pushed_at_;
+  }
+  void set_pushed_at(double pushed_at) {
+    impl_->pushed_at_ = pushed_at;
+  }
+  bool is_high_priority() const {
+    return impl_->is_high_priority_;
+  }
+  void set_high_priority() {
+    impl_->is_high_priority_ = true;
+  }
 
  private:
   std::unique_ptr<ActorMessageImpl> impl_;
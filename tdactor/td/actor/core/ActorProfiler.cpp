@@ -0,0 +1,326 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/core/ActorProfiler.h"
+
+#include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+namespace td {
+namespace actor {
+namespace core {
+namespace {
+struct Stat {
+  uint64 count{0};
+  double total_time{0};
+  double total_queue_delay{0};
+  uint64 queue_delay_count{0};
+  double max_time{0};
+
+  void merge(const Stat &other) {
+    count += other.count;
+    total_time += other.total_time;
+    total_queue_delay += other.total_queue_delay;
+    queue_delay_count += other.queue_delay_count;
+    max_time = std::max(max_time, other.max_time);
+  }
+};
+
+// Written only by the owning thread, so updates are plain loads and stores; the atomics let dump() read them.
+struct Entry {
+  std::atomic<const ActorProfileSite *> site{nullptr};
+  std::atomic<const char *> actor_type{nullptr};
+  std::atomic<uint64> count{0};
+  std::atomic<double> total_time{0};
+  std::atomic<double> total_queue_delay{0};
+  std::atomic<uint64> queue_delay_count{0};
+  std::atomic<double> max_time{0};
+
+  template <class T>
+  static void add(std::atomic<T> &value, T x) {
+    value.store(value.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+  }
+  void add(double run_time, double queue_delay) {
+    add<uint64>(count, 1);
+    add(total_time, run_time);
+    if (queue_delay >= 0) {
+      add(total_queue_delay, queue_delay);
+      add<uint64>(queue_delay_count, 1);
+    }
+    if (run_time > max_time.load(std::memory_order_relaxed)) {
+      max_time.store(run_time, std::memory_order_relaxed);
+    }
+  }
+  void clear() {
+    count.store(0, std::memory_order_relaxed);
+    total_time.store(0, std::memory_order_relaxed);
+    total_queue_delay.store(0, std::memory_order_relaxed);
+    queue_delay_count.store(0, std::memory_order_relaxed);
+    max_time.store(0, std::memory_order_relaxed);
+  }
+  Stat get() const {
+    Stat res;
+    res.count = count.load(std::memory_order_relaxed);
+    res.total_time = total_time.load(std::memory_order_relaxed);
+    res.total_queue_delay = total_queue_delay.load(std::memory_order_relaxed);
+    res.queue_delay_count = queue_delay_count.load(std::memory_order_relaxed);
+    res.max_time = max_time.load(std::memory_order_relaxed);
+    return res;
+  }
+};
+
+struct Key {
+  const ActorProfileSite *site;
+  const char *actor_type;
+  bool operator<(const Key &other) const {
+    return std::tie(site, actor_type) < std::tie(other.site, other.actor_type);
+  }
+};
+
+// incremented by dump(true); tables of an older reset epoch are not reported and are cleared by their threads
+std::atomic<uint64> reset_epoch{0};
+
+struct ThreadStats;
+struct Registry {
+  std::mutex mutex;
+  std::vector<ThreadStats *> threads;
+  // stats of exited threads
+  std::map<Key, Stat> retired;
+};
+Registry &registry() {
+  static Registry *res = new Registry();
+  return *res;
+}
+// Open addressing by (site, actor type); sites and actor classes are bounded by the code, so the table does not fill
+// up in practice. Messages that find no free slot within MAX_PROBES are counted in the overflow entry.
+constexpr size_t TABLE_SIZE = 1 << 12;
+constexpr size_t MAX_PROBES = 64;
+struct ThreadStats {
+  std::atomic<uint64> epoch{reset_epoch.load()};
+  std::array<Entry, TABLE_SIZE> table;
+  Entry overflow;
+
+  ThreadStats() {
+    auto &r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    r.threads.push_back(this);
+  }
+  ThreadStats(const ThreadStats &) = delete;
+  ThreadStats &operator=(const ThreadStats &) = delete;
+  ~ThreadStats() {
+    auto &r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    if (epoch.load() == reset_epoch.load()) {
+      for_each([&](const Key &key, Stat stat) { r.retired[key].merge(stat); });
+    }
+    r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+  }
+
+  Entry &get_entry(const ActorProfileSite *site, const char *actor_type) {
+    auto epoch_now = reset_epoch.load(std::memory_order_relaxed);
+    if (epoch.load(std::memory_order_relaxed) != epoch_now) {
+      for (auto &entry : table) {
+        entry.clear();
+      }
+      overflow.clear();
+      epoch.store(epoch_now, std::memory_order_release);
+    }
+    auto hash = (static_cast<uint64>(reinterpret_cast<std::uintptr_t>(site)) ^
+                 (static_cast<uint64>(reinterpret_cast<std::uintptr_t>(actor_type)) >> 3)) *
+                0x9E3779B97F4A7C15ull;
+    auto pos = static_cast<size_t>(hash >> 52);
+    for (size_t i = 0; i < MAX_PROBES; i++) {
+      auto &entry = table[(pos + i) & (TABLE_SIZE - 1)];
+      auto entry_site = entry.site.load(std::memory_order_relaxed);
+      if (entry_site == site && entry.actor_type.load(std::memory_order_relaxed) == actor_type) {
+        return entry;
+      }
+      if (entry_site == nullptr) {
+        entry.actor_type.store(actor_type, std::memory_order_relaxed);
+        entry.site.store(site, std::memory_order_release);
+        return entry;
+      }
+    }
+    return overflow;
+  }
+
+  template <class F>
+  void for_each(F &&f) const {
+    static const ActorProfileSite overflow_site{"(profiler table overflow)"};
+    for (auto &entry : table) {
+      auto site = entry.site.load(std::memory_order_acquire);
+      if (site == nullptr) {
+        continue;
+      }
+      auto stat = entry.get();
+      if (stat.count > 0) {
+        f(Key{site, entry.actor_type.load(std::memory_order_relaxed)}, stat);
+      }
+    }
+    auto stat = overflow.get();
+    if (stat.count > 0) {
+      f(Key{&overflow_site, "?"}, stat);
+    }
+  }
+};
+ThreadStats &thread_stats() {
+  static TD_THREAD_LOCAL ThreadStats *stats;
+  init_thread_local<ThreadStats>(stats);
+  return *stats;
+}
+
+std::string demangle(const char *type) {
+  std::string res = type;
+#if defined(__GNUC__) || defined(__clang__)
+  int status = 0;
+  char *demangled = abi::__cxa_demangle(type, nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    res = demangled;
+  }
+  std::free(demangled);
+#endif
+  return res;
+}
+
+// "ns::Outer<ns::T>::Actor" -> "Actor"
+std::string actor_type_name(const char *type) {
+  auto res = demangle(type);
+  size_t depth = 0;
+  size_t name_begin = 0;
+  for (size_t i = 0; i < res.size(); i++) {
+    char c = res[i];
+    if (c == '<' || c == '(' || c == '{') {
+      depth++;
+    } else if ((c == '>' || c == ')' || c == '}') && depth > 0) {
+      depth--;
+    } else if (c == ':' && depth == 0 && i + 1 < res.size() && res[i + 1] == ':') {
+      name_begin = i + 2;
+      i++;
+    }
+  }
+  return res.substr(name_begin);
+}
+
+std::string message_type_name(const char *type) {
+  auto res = demangle(type);
+  // closures are lambdas inside send_closure* helpers; "void (ns::Actor::*)(Args...)" -> "Actor(Args...)"
+  auto pos = res.find("::*)(");
+  if (pos != std::string::npos) {
+    auto name_begin = pos;
+    auto is_name_char = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+    while (name_begin > 0 && is_name_char(res[name_begin - 1])) {
+      name_begin--;
+    }
+    auto args_begin = pos + 5;
+    size_t depth = 1;
+    auto args_end = args_begin;
+    for (; args_end < res.size(); args_end++) {
+      if (res[args_end] == '(') {
+        depth++;
+      } else if (res[args_end] == ')' && --depth == 0) {
+        break;
+      }
+    }
+    return res.substr(name_begin, pos - name_begin) + "(" + res.substr(args_begin, args_end - args_begin) + ")";
+  }
+  if (res.size() > 120) {
+    res = res.substr(0, 117) + "...";
+  }
+  return res;
+}
+}  // namespace
+
+std::atomic<bool> ActorProfiler::enabled_{true};
+
+bool ActorProfiler::sample_queue_delay() {
+  static TD_THREAD_LOCAL uint32 pushed;
+  return ++pushed % QUEUE_DELAY_SAMPLE_RATE == 0;
+}
+
+void ActorProfiler::add(const ActorProfileSite *site, const char *actor_type, double run_time, double queue_delay) {
+  thread_stats().get_entry(site, actor_type).add(run_time, queue_delay);
+}
+
+std::vector<ActorProfileEntry> ActorProfiler::dump(bool reset) {
+  auto &r = registry();
+  std::lock_guard<std::mutex> guard(r.mutex);
+  // the same key is reported by several threads, and several sites may demangle equally
+  std::map<std::pair<std::string, std::string>, Stat> merged;
+  std::unordered_map<const char *, std::string> actor_names;
+  std::unordered_map<const char *, std::string> site_names;
+  auto merge = [&](const Key &key, const Stat &stat) {
+    auto actor_it = actor_names.find(key.actor_type);
+    if (actor_it == actor_names.end()) {
+      actor_it = actor_names.emplace(key.actor_type, actor_type_name(key.actor_type)).first;
+    }
+    auto site_it = site_names.find(key.site->name);
+    if (site_it == site_names.end()) {
+      site_it = site_names.emplace(key.site->name, message_type_name(key.site->name)).first;
+    }
+    merged[std::make_pair(actor_it->second, site_it->second)].merge(stat);
+  };
+  auto epoch = reset_epoch.load();
+  for (auto t : r.threads) {
+    if (t->epoch.load(std::memory_order_acquire) == epoch) {
+      t->for_each(merge);
+    }
+  }
+  for (auto &it : r.retired) {
+    merge(it.first, it.second);
+  }
+  if (reset) {
+    r.retired.clear();
+    reset_epoch.fetch_add(1);
+  }
+
+  std::vector<ActorProfileEntry> res;
+  res.reserve(merged.size());
+  for (auto &it : merged) {
+    ActorProfileEntry entry;
+    entry.actor = it.first.first;
+    entry.message = it.first.second;
+    entry.count = it.second.count;
+    entry.total_time = it.second.total_time;
+    if (it.second.queue_delay_count > 0) {
+      entry.total_queue_delay = it.second.total_queue_delay / static_cast<double>(it.second.queue_delay_count) *
+                                static_cast<double>(it.second.count);
+    }
+    entry.max_time = it.second.max_time;
+    res.push_back(std::move(entry));
+  }
+  std::sort(res.begin(), res.end(), [](const auto &a, const auto &b) { return a.total_time > b.total_time; });
+  return res;
+}
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,75 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+#include <atomic>
+
+namespace td {
+namespace actor {
+namespace core {
+struct ActorProfileEntry {
+  std::string actor;
+  std::string message;
+  uint64 count{0};
+  double total_time{0};
+  // estimated from the sampled messages
+  double total_queue_delay{0};
+  double max_time{0};
+};
+
+// What a message runs: one static object per message class (a closure type or a signal), so that profile entries
+// are keyed by its address. The name is an RTTI name or a plain name like "alarm"; it is demangled only on dump.
+struct ActorProfileSite {
+  const char *name;
+};
+
+// Aggregation of message execution time per (actor class, message site), on by default.
+// Each thread writes into its own fixed-size open addressing table without locks or atomic read-modify-writes;
+// dump() reads all tables concurrently through relaxed atomics. A reset drops the tables lazily: every thread clears
+// its own one on its next message, so a few messages finishing during dump(true) may be lost.
+// Reading the clock costs more than the table update, so consecutive messages of one actor run share a timestamp
+// and only one message in QUEUE_DELAY_SAMPLE_RATE gets its push time recorded for the queue delay.
+class ActorProfiler {
+ public:
+  static bool is_enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  static void set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  static constexpr uint32 QUEUE_DELAY_SAMPLE_RATE = 16;
+  // whether a message pushed by the current thread should record its push time
+  static bool sample_queue_delay();
+
+  // queue_delay is negative for a message without the push time
+  static void add(const ActorProfileSite *site, const char *actor_type, double run_time, double queue_delay);
+
+  // sorted by total time, most expensive first
+  static std::vector<ActorProfileEntry> dump(bool reset);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,126 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/core/BlockingWorker.h"
+
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace td {
+namespace actor {
+namespace core {
+namespace {
+void update_max(std::atomic<int64> &max, int64 value) {
+  auto old = max.load(std::memory_order_relaxed);
+  while (old < value && !max.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+  }
+}
+int64 to_us(double time) {
+  return static_cast<int64>(time * 1e6);
+}
+}  // namespace
+
+void BlockingStats::add(const BlockingStats &other) {
+  threads += other.threads;
+  queue_size += other.queue_size;
+  max_queue_size = std::max(max_queue_size, other.max_queue_size);
+  tasks += other.tasks;
+  total_wait_time += other.total_wait_time;
+  max_wait_time = std::max(max_wait_time, other.max_wait_time);
+  total_run_time += other.total_run_time;
+  max_run_time = std::max(max_run_time, other.max_run_time);
+}
+
+BlockingQueue::BlockingQueue(size_t threads_count, size_t max_thread_id)
+    : threads_count_(threads_count), queue_(1024, max_thread_id) {
+}
+
+void BlockingQueue::push(BlockingTask *task, size_t thread_id) {
+  if (task) {
+    task->queued_at_ = Time::now();
+    update_max(max_queue_size_, queue_size_.fetch_add(1, std::memory_order_relaxed) + 1);
+  }
+  queue_.push(task, thread_id);
+  waiter_.notify();
+}
+
+bool BlockingQueue::try_pop_unsafe(BlockingTask *&task, size_t thread_id) {
+  if (!queue_.try_pop(task, thread_id)) {
+    return false;
+  }
+  if (task) {
+    queue_size_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+void BlockingQueue::on_popped(BlockingTask &task) {
+  queue_size_.fetch_sub(1, std::memory_order_relaxed);
+  // counted before the task runs, because the result may reach the caller before on_finished
+  tasks_.fetch_add(1, std::memory_order_relaxed);
+  auto wait_time_us = to_us(Time::now() - task.queued_at_);
+  total_wait_time_us_.fetch_add(wait_time_us, std::memory_order_relaxed);
+  update_max(max_wait_time_us_, wait_time_us);
+}
+
+void BlockingQueue::on_finished(double run_time) {
+  auto run_time_us = to_us(run_time);
+  total_run_time_us_.fetch_add(run_time_us, std::memory_order_relaxed);
+  update_max(max_run_time_us_, run_time_us);
+}
+
+BlockingStats BlockingQueue::get_stats() const {
+  BlockingStats stats;
+  stats.threads = threads_count_;
+  stats.queue_size = queue_size_.load(std::memory_order_relaxed);
+  stats.max_queue_size = max_queue_size_.load(std::memory_order_relaxed);
+  stats.tasks = tasks_.load(std::memory_order_relaxed);
+  stats.total_wait_time = static_cast<double>(total_wait_time_us_.load(std::memory_order_relaxed)) * 1e-6;
+  stats.max_wait_time = static_cast<double>(max_wait_time_us_.load(std::memory_order_relaxed)) * 1e-6;
+  stats.total_run_time = static_cast<double>(total_run_time_us_.load(std::memory_order_relaxed)) * 1e-6;
+  stats.max_run_time = static_cast<double>(max_run_time_us_.load(std::memory_order_relaxed)) * 1e-6;
+  return stats;
+}
+
+void BlockingWorker::run() {
+  auto thread_id = get_thread_id();
+  MpmcWaiter::Slot slot;
+  queue_.waiter_.init_slot(slot, thread_id);
+  while (true) {
+    BlockingTask *raw_task;
+    if (queue_.queue_.try_pop(raw_task, thread_id)) {
+      queue_.waiter_.stop_wait(slot);
+      if (!raw_task) {
+        return;
+      }
+      std::unique_ptr<BlockingTask> task(raw_task);
+      queue_.on_popped(*task);
+      auto started_at = Time::now();
+      task->run();
+      queue_.on_finished(Time::now() - started_at);
+    } else {
+      queue_.waiter_.wait(slot);
+    }
+  }
+}
+}  // namespace core
+}  // namespace actor
+}  // namespace td
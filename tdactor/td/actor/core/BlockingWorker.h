@@ -0,0 +1,100 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/MpmcQueue.h"
+#include "td/utils/MpmcWaiter.h"
+
+#include <atomic>
+
+namespace td {
+namespace actor {
+namespace core {
+// A blocking call (disk read, database lookup) offloaded from an actor, so it does not occupy a cpu worker
+class BlockingTask {
+ public:
+  BlockingTask() = default;
+  BlockingTask(const BlockingTask &) = delete;
+  BlockingTask &operator=(const BlockingTask &) = delete;
+  virtual ~BlockingTask() = default;
+  virtual void run() = 0;
+
+ private:
+  friend class BlockingQueue;
+  friend class BlockingWorker;
+  double queued_at_{0};
+};
+
+struct BlockingStats {
+  size_t threads{0};
+  int64 queue_size{0};
+  int64 max_queue_size{0};
+  uint64 tasks{0};
+  double total_wait_time{0};
+  double max_wait_time{0};
+  double total_run_time{0};
+  double max_run_time{0};
+
+  void add(const BlockingStats &other);
+};
+
+class BlockingQueue {
+ public:
+  // max_thread_id bounds the thread ids of everybody who pushes or pops
+  BlockingQueue(size_t threads_count, size_t max_thread_id);
+
+  // Takes ownership of the task. A null task stops one worker
+  void push(BlockingTask *task, size_t thread_id);
+
+  // Returns the tasks which were not run, used only after all workers are stopped
+  bool try_pop_unsafe(BlockingTask *&task, size_t thread_id);
+
+  BlockingStats get_stats() const;
+
+ private:
+  friend class BlockingWorker;
+  size_t threads_count_;
+  MpmcQueue<BlockingTask *> queue_;
+  MpmcWaiter waiter_;
+
+  std::atomic<int64> queue_size_{0};
+  std::atomic<int64> max_queue_size_{0};
+  std::atomic<uint64> tasks_{0};
+  std::atomic<int64> total_wait_time_us_{0};
+  std::atomic<int64> max_wait_time_us_{0};
+  std::atomic<int64> total_run_time_us_{0};
+  std::atomic<int64> max_run_time_us_{0};
+
+  void on_popped(BlockingTask &task);
+  void on_finished(double run_time);
+};
+
+class BlockingWorker {
+ public:
+  explicit BlockingWorker(BlockingQueue &queue) : queue_(queue) {
+  }
+  void run();
+
+ private:
+  BlockingQueue &queue_;
+};
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -31,23 +31,39 @@ template <class T>
 struct LocalQueue;
 class CpuWorker {
  public:
-  CpuWorker(MpmcQueue<SchedulerMessage::Raw *> &queue, MpmcWaiter &waiter, size_t id,
-            MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues)
-      : queue_(queue), waiter_(waiter), id_(id), local_queues_(local_queues) {
+  CpuWorker(MpmcQueue<SchedulerMessage::Raw *> &queue, MpmcQueue<SchedulerMessage::Raw *> &high_queue,
+            MpmcWaiter &waiter, size_t id, MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues,
+            Span<size_t> steal_order)
+      : queue_(queue)
+      , high_queue_(high_queue)
+      , waiter_(waiter)
+      , id_(id)
+      , local_queues_(local_queues)
+      , steal_order_(steal_order) {
   }
   void run();
 
+  // after this many high priority actors in a row one normal actor is run, so bulk work can't starve
+  static constexpr size_t max_high_priority_in_row() {
+    return 16;
+  }
+
  private:
   MpmcQueue<SchedulerMessage::Raw *> &queue_;
+  MpmcQueue<SchedulerMessage::Raw *> &high_queue_;
   MpmcWaiter &waiter_;
   size_t id_;
   MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues_;
+  Span<size_t> steal_order_;
   size_t cnt_{0};
+  size_t high_in_row_{0};
 
   bool try_pop(SchedulerMessage &message, size_t thread_id);
+  bool try_pop_normal(SchedulerMessage &message, size_t thread_id);
 
   bool try_pop_local(SchedulerMessage &message);
   bool try_pop_global(SchedulerMessage &message, size_t thread_id);
+  bool try_pop_high(SchedulerMessage &message, size_t thread_id);
 };
 }  // namespace core
 }  // namespace actor
@@ -0,0 +1,197 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/core/FileIoQueue.h"
+
+#include "td/utils/logging.h"
+
+#include <algorithm>
+#include <cerrno>
+
+namespace td {
+namespace actor {
+namespace core {
+void FileIoTask::run() {
+  while (done_ < size_) {
+    auto r_size = is_write() ? write_fd_->pwrite(data_.substr(done_), offset_ + done_)
+                             : fd_.pread(dest_.substr(done_), offset_ + done_);
+    if (r_size.is_error()) {
+      return on_finished(r_size.move_as_error());
+    }
+    if (r_size.ok() == 0) {
+      break;
+    }
+    done_ += r_size.ok();
+  }
+  if (is_write() && done_ != size_) {
+    return on_finished(Status::Error("short write"));
+  }
+  on_finished(done_);
+}
+
+bool FileIoTask::on_result(int32 result) {
+  if (result == -EINTR || result == -EAGAIN) {
+    return false;
+  }
+  if (result < 0) {
+    auto message = is_write() ? Slice("io_uring write failed") : Slice("io_uring read failed");
+    on_finished(Status::PosixError(-result, message));
+    return true;
+  }
+  done_ += static_cast<size_t>(result);
+  if (done_ == size_) {
+    on_finished(done_);
+    return true;
+  }
+  if (result == 0) {
+    if (is_write()) {
+      on_finished(Status::Error("short write"));
+    } else {
+      on_finished(done_);
+    }
+    return true;
+  }
+  return false;
+}
+
+void FileIoStats::add(const FileIoStats &other) {
+  tasks += other.tasks;
+  submits += other.submits;
+  completions += other.completions;
+  max_in_flight = std::max(max_in_flight, other.max_in_flight);
+}
+
+Result<std::unique_ptr<FileIoQueue>> FileIoQueue::create(uint32 entries) {
+  std::unique_ptr<FileIoQueue> queue(new FileIoQueue());
+  TRY_STATUS(queue->ring_.init(entries));
+  queue->event_fd_.init();
+  TRY_STATUS(queue->ring_.register_event_fd(queue->event_fd_.get_poll_info().native_fd()));
+  queue->completions_.resize(queue->ring_.get_capacity());
+  return std::move(queue);
+}
+
+FileIoQueue::~FileIoQueue() {
+  // the kernel may still write to buffers of submitted tasks
+  while (in_flight_ != 0) {
+    ring_.submit().ensure();
+    ring_.wait_completions(1).ensure();
+    auto n = ring_.pop_completions(completions_.data(), completions_.size());
+    for (size_t i = 0; i < n; i++) {
+      delete reinterpret_cast<FileIoTask *>(static_cast<uintptr_t>(completions_[i].user_data));
+    }
+    in_flight_ -= n;
+  }
+  clear_unsafe();
+}
+
+void FileIoQueue::push(FileIoTask *task) {
+  tasks_.fetch_add(1, std::memory_order_relaxed);
+  queue_.push(task->to_mpsc_link_queue_node());
+  event_fd_.release();
+}
+
+void FileIoQueue::prepare_pending() {
+  while (in_flight_ < ring_.get_capacity()) {
+    auto *node = pending_.read();
+    if (node == nullptr) {
+      break;
+    }
+    auto *task = FileIoTask::from_mpsc_link_queue_node(node);
+    auto &fd = task->fd_.get_native_fd();
+    auto offset = task->offset_ + task->done_;
+    auto user_data = static_cast<uint64>(reinterpret_cast<uintptr_t>(task));
+    bool ok = task->is_write() ? ring_.prepare_write(fd, task->data_.substr(task->done_), offset, user_data)
+                               : ring_.prepare_read(fd, task->dest_.substr(task->done_), offset, user_data);
+    if (!ok) {
+      pending_.delay(node);
+      break;
+    }
+    in_flight_++;
+  }
+  if (static_cast<int64>(in_flight_) > max_in_flight_.load(std::memory_order_relaxed)) {
+    max_in_flight_.store(static_cast<int64>(in_flight_), std::memory_order_relaxed);
+  }
+}
+
+std::vector<std::unique_ptr<FileIoTask>> FileIoQueue::run() {
+  std::vector<std::unique_ptr<FileIoTask>> failed_tasks;
+  event_fd_.acquire();
+  queue_.pop_all(pending_);
+  while (true) {
+    if (!is_failed()) {
+      prepare_pending();
+      auto r_submitted = ring_.submit();
+      if (r_submitted.is_error()) {
+        LOG(ERROR) << "File io falls back to blocking threads: " << r_submitted.error();
+        failed_.store(true, std::memory_order_relaxed);
+        for (auto user_data : ring_.drop_unsubmitted()) {
+          failed_tasks.emplace_back(reinterpret_cast<FileIoTask *>(static_cast<uintptr_t>(user_data)));
+          in_flight_--;
+        }
+      } else if (r_submitted.ok() != 0) {
+        submits_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    if (is_failed()) {
+      // tasks, which were submitted before the failure, are still completed by the kernel
+      queue_.pop_all(pending_);
+      while (auto *node = pending_.read()) {
+        failed_tasks.emplace_back(FileIoTask::from_mpsc_link_queue_node(node));
+      }
+    }
+
+    auto n = ring_.pop_completions(completions_.data(), completions_.size());
+    if (n == 0) {
+      break;
+    }
+    completions_count_.fetch_add(n, std::memory_order_relaxed);
+    in_flight_ -= n;
+    for (size_t i = 0; i < n; i++) {
+      auto *task = reinterpret_cast<FileIoTask *>(static_cast<uintptr_t>(completions_[i].user_data));
+      if (task->on_result(completions_[i].result)) {
+        delete task;
+      } else {
+        // partial transfer, the rest is submitted again
+        pending_.delay(task->to_mpsc_link_queue_node());
+      }
+    }
+  }
+  return failed_tasks;
+}
+
+size_t FileIoQueue::clear_unsafe() {
+  queue_.pop_all_unsafe(pending_);
+  size_t res = 0;
+  while (auto *node = pending_.read()) {
+    delete FileIoTask::from_mpsc_link_queue_node(node);
+    res++;
+  }
+  return res;
+}
+
+FileIoStats FileIoQueue::get_stats() const {
+  FileIoStats stats;
+  stats.tasks = tasks_.load(std::memory_order_relaxed);
+  stats.submits = submits_.load(std::memory_order_relaxed);
+  stats.completions = completions_count_.load(std::memory_order_relaxed);
+  stats.max_in_flight = max_in_flight_.load(std::memory_order_relaxed);
+  return stats;
+}
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,144 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/MpscLinkQueue.h"
+#include "td/utils/port/EventFd.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/IoUring.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace td {
+namespace actor {
+namespace core {
+// A positioned read or write of a file offloaded from an actor.
+// The file and the buffer must stay alive till on_finished is called
+class FileIoTask : private MpscLinkQueueImpl::Node {
+ public:
+  // reads dest.size() bytes or till the end of file
+  FileIoTask(const FileFd &fd, MutableSlice dest, uint64 offset)
+      : fd_(fd), dest_(dest), size_(dest.size()), offset_(offset) {
+  }
+  // data must be passed as Slice, a MutableSlice selects the read constructor
+  FileIoTask(FileFd &fd, Slice data, uint64 offset)
+      : fd_(fd), write_fd_(&fd), data_(data), size_(data.size()), offset_(offset) {
+  }
+  FileIoTask(const FileIoTask &) = delete;
+  FileIoTask &operator=(const FileIoTask &) = delete;
+  virtual ~FileIoTask() = default;
+
+  // Gets the number of transferred bytes, which is less than the buffer size only if a read reached the end of file
+  virtual void on_finished(Result<size_t> r_size) = 0;
+
+  // Synchronous fallback, used when io_uring is not available
+  void run();
+
+ private:
+  friend class FileIoQueue;
+  const FileFd &fd_;
+  FileFd *write_fd_{nullptr};
+  MutableSlice dest_;
+  Slice data_;
+  size_t size_;
+  uint64 offset_;
+  size_t done_{0};
+
+  bool is_write() const {
+    return write_fd_ != nullptr;
+  }
+
+  MpscLinkQueueImpl::Node *to_mpsc_link_queue_node() {
+    return static_cast<MpscLinkQueueImpl::Node *>(this);
+  }
+  static FileIoTask *from_mpsc_link_queue_node(MpscLinkQueueImpl::Node *node) {
+    return static_cast<FileIoTask *>(node);
+  }
+
+  // returns true if the task is finished
+  bool on_result(int32 result);
+};
+
+struct FileIoStats {
+  uint64 tasks{0};
+  uint64 submits{0};
+  uint64 completions{0};
+  int64 max_in_flight{0};
+
+  void add(const FileIoStats &other);
+};
+
+// Tasks are submitted to io_uring in batches by the io worker of a scheduler,
+// which also reaps the completions in its poll loop
+class FileIoQueue {
+ public:
+  // Fails if io_uring is not available
+  static Result<std::unique_ptr<FileIoQueue>> create(uint32 entries);
+
+  FileIoQueue(const FileIoQueue &) = delete;
+  FileIoQueue &operator=(const FileIoQueue &) = delete;
+  ~FileIoQueue();
+
+  // Takes ownership of the task, may be called from any thread
+  void push(FileIoTask *task);
+
+  // Must be called only by the io worker
+  EventFd &get_event_fd() {
+    return event_fd_;
+  }
+  // Returns the tasks, which can't be submitted because io_uring failed, they must be run in another way
+  std::vector<std::unique_ptr<FileIoTask>> run();
+
+  // io_uring failed, new tasks must not be pushed
+  bool is_failed() const {
+    return failed_.load(std::memory_order_relaxed);
+  }
+
+  // Destroys the tasks which were not run, used only after all workers are stopped
+  size_t clear_unsafe();
+
+  FileIoStats get_stats() const;
+
+ private:
+  FileIoQueue() = default;
+
+  IoUring ring_;
+  EventFd event_fd_;
+  MpscLinkQueueImpl queue_;
+  MpscLinkQueueImpl::Reader pending_;
+  size_t in_flight_{0};
+  std::vector<IoUring::Completion> completions_;
+
+  std::atomic<bool> failed_{false};
+
+  std::atomic<uint64> tasks_{0};
+  std::atomic<uint64> submits_{0};
+  std::atomic<uint64> completions_count_{0};
+  std::atomic<int64> max_in_flight_{0};
+
+  void prepare_pending();
+};
+}  // namespace core
+}  // namespace actor
+}  // namespace td
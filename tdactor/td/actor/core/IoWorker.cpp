@@ -28,12 +28,18 @@ void IoWorker::start_up() {
 #if TD_PORT_POSIX
   auto &poll = SchedulerContext::get()->get_poll();
   poll.subscribe(queue_.reader_get_event_fd().get_poll_info().extract_pollable_fd(nullptr), PollFlags::Read());
+  if (file_io_queue_) {
+    poll.subscribe(file_io_queue_->get_event_fd().get_poll_info().extract_pollable_fd(nullptr), PollFlags::Read());
+  }
 #endif
 }
 void IoWorker::tear_down() {
 #if TD_PORT_POSIX
   auto &poll = SchedulerContext::get()->get_poll();
   poll.unsubscribe(queue_.reader_get_event_fd().get_poll_info().get_pollable_fd_ref());
+  if (file_io_queue_) {
+    poll.unsubscribe(file_io_queue_->get_event_fd().get_poll_info().get_pollable_fd_ref());
+  }
 #endif
 }
 
@@ -76,6 +82,14 @@ bool IoWorker::run_once(double timeout, bool skip_timeouts) {
   }
   queue_.reader_flush();
 
+  // submits new file io tasks and reaps all completions in batches,
+  // the event fd is signaled both on new tasks and on completions
+  if (file_io_queue_) {
+    for (auto &task : file_io_queue_->run()) {
+      dispatcher.add_file_io_task(std::move(task));
+    }
+  }
+
   bool can_sleep = size == 0 && timeout != 0;
   int32 timeout_ms = 0;
   if (can_sleep) {
@@ -18,6 +18,7 @@
 */
 #pragma once
 
+#include "td/actor/core/FileIoQueue.h"
 #include "td/actor/core/SchedulerContext.h"
 #include "td/actor/core/SchedulerMessage.h"
 #include "td/utils/MpscPollableQueue.h"
@@ -27,7 +28,8 @@ namespace actor {
 namespace core {
 class IoWorker {
  public:
-  explicit IoWorker(MpscPollableQueue<SchedulerMessage> &queue) : queue_(queue) {
+  IoWorker(MpscPollableQueue<SchedulerMessage> &queue, FileIoQueue *file_io_queue)
+      : queue_(queue), file_io_queue_(file_io_queue) {
   }
 
   void start_up();
@@ -37,6 +39,8 @@ class IoWorker {
 
  private:
   MpscPollableQueue<SchedulerMessage> &queue_;
+  // may be null
+  FileIoQueue *file_io_queue_;
 };
 }  // namespace core
 }  // namespace actor
@@ -18,9 +18,13 @@
 */
 #include "td/actor/core/Scheduler.h"
 
+#include "td/actor/core/BlockingWorker.h"
 #include "td/actor/core/CpuWorker.h"
 #include "td/actor/core/IoWorker.h"
 
+#include "td/utils/port/CpuTopology.h"
+#include "td/utils/port/IoUring.h"
+
 namespace td {
 namespace actor {
 namespace core {
@@ -34,9 +38,10 @@ bool need_debug() {
 }
 
 Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, SchedulerId id, size_t cpu_threads_count,
-                     bool skip_timeouts)
+                     bool skip_timeouts, size_t blocking_threads_count)
     : scheduler_group_info_(std::move(scheduler_group_info))
     , cpu_threads_(cpu_threads_count)
+    , blocking_threads_(blocking_threads_count)
     , skip_timeouts_(skip_timeouts) {
   scheduler_group_info_->active_scheduler_count++;
   info_ = &scheduler_group_info_->schedulers.at(id.value());
@@ -44,12 +49,25 @@ Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, S
   if (cpu_threads_count != 0) {
     info_->cpu_threads_count = cpu_threads_count;
     info_->cpu_queue = std::make_unique<MpmcQueue<SchedulerMessage::Raw *>>(1024, max_thread_count());
+    info_->cpu_high_queue = std::make_unique<MpmcQueue<SchedulerMessage::Raw *>>(1024, max_thread_count());
     info_->cpu_queue_waiter = std::make_unique<MpmcWaiter>();
 
     info_->cpu_local_queue = std::vector<LocalQueue<SchedulerMessage::Raw *>>(cpu_threads_count);
   }
   info_->io_queue = std::make_unique<MpscPollableQueue<SchedulerMessage>>();
   info_->io_queue->init();
+  if (blocking_threads_count != 0) {
+    info_->blocking_threads_count = blocking_threads_count;
+    info_->blocking_queue = std::make_unique<BlockingQueue>(blocking_threads_count, max_thread_count());
+  }
+  if (IoUring::is_supported()) {
+    auto r_file_io_queue = FileIoQueue::create(256);
+    if (r_file_io_queue.is_ok()) {
+      info_->file_io_queue = r_file_io_queue.move_as_ok();
+    } else {
+      LOG(WARNING) << "Failed to create io_uring, file io falls back to blocking threads: " << r_file_io_queue.error();
+    }
+  }
 
   info_->cpu_workers.resize(cpu_threads_count);
   td::uint8 cpu_worker_id = 0;
@@ -57,10 +75,15 @@ Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, S
     worker = std::make_unique<WorkerInfo>(WorkerInfo::Type::Cpu, true, CpuWorkerId{cpu_worker_id});
     cpu_worker_id++;
   }
+  info_->blocking_workers.resize(blocking_threads_count);
+  for (auto &worker : info_->blocking_workers) {
+    // not a cpu worker of its own: actors it wakes up go to the shared cpu queue
+    worker = std::make_unique<WorkerInfo>(WorkerInfo::Type::Cpu, true, CpuWorkerId{});
+  }
   info_->io_worker = std::make_unique<WorkerInfo>(WorkerInfo::Type::Io, !info_->cpu_workers.empty(), CpuWorkerId{});
 
   poll_.init();
-  io_worker_ = std::make_unique<IoWorker>(*info_->io_queue);
+  io_worker_ = std::make_unique<IoWorker>(*info_->io_queue, info_->file_io_queue.get());
 
 #if TD_PORT_WINDOWS
   if (info_->id.value() == 0) {
@@ -75,14 +98,64 @@ Scheduler::~Scheduler() {
   do_stop();
 }
 
+void Scheduler::set_cpu_affinity(std::vector<int32> cpus) {
+  info_->cpu_affinity = std::move(cpus);
+}
+
+void Scheduler::set_message_budget(size_t message_budget) {
+  info_->message_budget = message_budget;
+}
+
+void Scheduler::init_steal_order() {
+  auto n = cpu_threads_.size();
+  std::vector<int32> numa_node(n, 0);
+  if (!info_->cpu_affinity.empty()) {
+    auto topology = CpuTopology::get();
+    for (size_t i = 0; i < n; i++) {
+      numa_node[i] = topology.get_numa_node(info_->cpu_affinity[i % info_->cpu_affinity.size()]);
+    }
+  }
+  info_->cpu_steal_order.assign(n, {});
+  for (size_t i = 0; i < n; i++) {
+    auto &order = info_->cpu_steal_order[i];
+    for (bool same_node : {true, false}) {
+      for (size_t j = 1; j < n; j++) {
+        auto pos = (i + j) % n;
+        if ((numa_node[pos] == numa_node[i]) == same_node) {
+          order.push_back(pos);
+        }
+      }
+    }
+  }
+}
+
 void Scheduler::start() {
+  init_steal_order();
+  auto &affinity = info_->cpu_affinity;
   for (size_t i = 0; i < cpu_threads_.size(); i++) {
     cpu_threads_[i] = td::thread([this, i] {
       this->run_in_context_impl(*this->info_->cpu_workers[i], [this, i] {
-        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue).run();
+        CpuWorker(*info_->cpu_queue, *info_->cpu_high_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue,
+                  info_->cpu_steal_order[i])
+            .run();
       });
     });
     cpu_threads_[i].set_name(PSLICE() << "#" << info_->id.value() << ":cpu#" << i);
+    if (!affinity.empty()) {
+      auto status = cpu_threads_[i].set_affinity({affinity[i % affinity.size()]});
+      LOG_IF(WARNING, status.is_error()) << "Failed to pin cpu worker " << i << ": " << status;
+    }
+  }
+  for (size_t i = 0; i < blocking_threads_.size(); i++) {
+    blocking_threads_[i] = td::thread([this, i] {
+      this->run_in_context_impl(*this->info_->blocking_workers[i],
+                                [this] { BlockingWorker(*info_->blocking_queue).run(); });
+    });
+    blocking_threads_[i].set_name(PSLICE() << "#" << info_->id.value() << ":blocking#" << i);
+    if (!affinity.empty()) {
+      auto status = blocking_threads_[i].set_affinity(affinity);
+      LOG_IF(WARNING, status.is_error()) << "Failed to pin blocking worker " << i << ": " << status;
+    }
   }
 #if TD_PORT_WINDOWS
   // FIXME: use scheduler_id
@@ -125,6 +198,9 @@ void Scheduler::do_stop() {
   for (auto &thread : cpu_threads_) {
     thread.join();
   }
+  for (auto &thread : blocking_threads_) {
+    thread.join();
+  }
   // Can't do anything else, other schedulers may send queries to this one.
   // Must wait till every scheduler is stopped first..
   is_stopped_ = true;
@@ -161,6 +237,11 @@ void Scheduler::ContextImpl::add_to_queue(ActorInfoPtr actor_info_ptr, Scheduler
   if (need_poll || !info.cpu_queue) {
     info.io_queue->writer_put(std::move(actor_info_ptr));
   } else {
+    if (actor_info_ptr->take_high_priority()) {
+      info.cpu_high_queue->push(actor_info_ptr.release(), get_thread_id());
+      info.cpu_queue_waiter->notify();
+      return;
+    }
     if (scheduler_id == get_scheduler_id() && cpu_worker_id_.is_valid()) {
       // may push local
       CHECK(actor_info_ptr);
@@ -177,6 +258,21 @@ void Scheduler::ContextImpl::add_to_queue(ActorInfoPtr actor_info_ptr, Scheduler
   }
 }
 
+void Scheduler::ContextImpl::add_to_queue_tail(ActorInfoPtr actor_info_ptr, SchedulerId scheduler_id,
+                                               bool need_poll) {
+  if (!scheduler_id.is_valid()) {
+    scheduler_id = get_scheduler_id();
+  }
+  auto &info = scheduler_group()->schedulers.at(scheduler_id.value());
+  if (need_poll || !info.cpu_queue || !(scheduler_id == get_scheduler_id()) || !cpu_worker_id_.is_valid() ||
+      actor_info_ptr->get_priority() == ActorPriority::High) {
+    return add_to_queue(std::move(actor_info_ptr), scheduler_id, need_poll);
+  }
+  info.cpu_local_queue[cpu_worker_id_.value()].push_back(
+      actor_info_ptr.release(), [&](auto value) { info.cpu_queue->push(value, get_thread_id()); });
+  info.cpu_queue_waiter->notify();
+}
+
 ActorInfoCreator &Scheduler::ContextImpl::get_actor_info_creator() {
   return *creator_;
 }
@@ -200,6 +296,67 @@ Debug &Scheduler::ContextImpl::get_debug() {
   return *debug_;
 }
 
+void Scheduler::ContextImpl::add_blocking_task(std::unique_ptr<BlockingTask> task) {
+  auto &info = scheduler_group()->schedulers.at(get_scheduler_id().value());
+  if (!info.blocking_queue) {
+    task->run();
+    return;
+  }
+  info.blocking_queue->push(task.release(), get_thread_id());
+}
+
+namespace {
+class FileIoBlockingTask final : public BlockingTask {
+ public:
+  explicit FileIoBlockingTask(std::unique_ptr<FileIoTask> task) : task_(std::move(task)) {
+  }
+  void run() override {
+    task_->run();
+  }
+
+ private:
+  std::unique_ptr<FileIoTask> task_;
+};
+}  // namespace
+
+void Scheduler::ContextImpl::add_file_io_task(std::unique_ptr<FileIoTask> task) {
+  auto &info = scheduler_group()->schedulers.at(get_scheduler_id().value());
+  if (!info.file_io_queue || info.file_io_queue->is_failed()) {
+    add_blocking_task(std::make_unique<FileIoBlockingTask>(std::move(task)));
+    return;
+  }
+  info.file_io_queue->push(task.release());
+}
+
+FileIoStats Scheduler::ContextImpl::get_file_io_stats() {
+  FileIoStats stats;
+  for (auto &scheduler_info : scheduler_group()->schedulers) {
+    if (scheduler_info.file_io_queue) {
+      stats.add(scheduler_info.file_io_queue->get_stats());
+    }
+  }
+  return stats;
+}
+
+SchedulerId Scheduler::ContextImpl::get_dedicated_scheduler(Slice role) {
+  for (auto &it : scheduler_group()->dedicated_schedulers) {
+    if (it.first == role) {
+      return it.second;
+    }
+  }
+  return SchedulerId{};
+}
+
+BlockingStats Scheduler::ContextImpl::get_blocking_stats() {
+  BlockingStats stats;
+  for (auto &scheduler_info : scheduler_group()->schedulers) {
+    if (scheduler_info.blocking_queue) {
+      stats.add(scheduler_info.blocking_queue->get_stats());
+    }
+  }
+  return stats;
+}
+
 void Scheduler::ContextImpl::set_alarm_timestamp(const ActorInfoPtr &actor_info_ptr) {
   // Ideas for optimization
   // 1. Several cpu actors with separate heaps. They ask io worker to update timeout only when it has been changed
@@ -229,6 +386,10 @@ void Scheduler::ContextImpl::set_alarm_timestamp(const ActorInfoPtr &actor_info_
   }
 }
 
+size_t Scheduler::ContextImpl::get_message_budget() const {
+  return scheduler_group()->schedulers.at(get_scheduler_id().value()).message_budget;
+}
+
 bool Scheduler::ContextImpl::is_stop_requested() {
   return scheduler_group()->is_stop_requested;
 }
@@ -248,6 +409,9 @@ void Scheduler::ContextImpl::stop() {
       scheduler_info.cpu_queue->push({}, get_thread_id());
       scheduler_info.cpu_queue_waiter->notify();
     }
+    for (size_t i = 0; i < scheduler_info.blocking_threads_count; i++) {
+      scheduler_info.blocking_queue->push(nullptr, get_thread_id());
+    }
   }
 }
 void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
@@ -303,8 +467,11 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
           queues_are_empty = false;
         }
       }
-      if (scheduler_info.cpu_queue) {
-        auto &cpu_queue = *scheduler_info.cpu_queue;
+      for (auto *queue : {scheduler_info.cpu_queue.get(), scheduler_info.cpu_high_queue.get()}) {
+        if (!queue) {
+          continue;
+        }
+        auto &cpu_queue = *queue;
         while (true) {
           SchedulerMessage::Raw *raw_message;
           if (!cpu_queue.try_pop(raw_message, get_thread_id())) {
@@ -315,6 +482,22 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
           queues_are_empty = false;
         }
       }
+
+      // Drain blocking queue, tasks are destroyed without being run
+      if (scheduler_info.blocking_queue) {
+        BlockingTask *raw_task;
+        while (scheduler_info.blocking_queue->try_pop_unsafe(raw_task, get_thread_id())) {
+          if (raw_task) {
+            delete raw_task;
+            queues_are_empty = false;
+          }
+        }
+      }
+
+      // Drain file io queue, tasks are destroyed without being run
+      if (scheduler_info.file_io_queue && scheduler_info.file_io_queue->clear_unsafe() != 0) {
+        queues_are_empty = false;
+      }
     }
     if (++it > 100) {
       LOG(FATAL) << "Failed to drain all queues";
@@ -326,12 +509,18 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
   for (auto &scheduler_info : group_info.schedulers) {
     scheduler_info.io_queue.reset();
     scheduler_info.cpu_queue.reset();
+    scheduler_info.cpu_high_queue.reset();
+    scheduler_info.blocking_queue.reset();
+    scheduler_info.file_io_queue.reset();
 
     // Do not destroy worker infos. run_in_context will crash if they are empty
     scheduler_info.io_worker->actor_info_creator.clear();
     for (auto &worker : scheduler_info.cpu_workers) {
       worker->actor_info_creator.clear();
     }
+    for (auto &worker : scheduler_info.blocking_workers) {
+      worker->actor_info_creator.clear();
+    }
   }
 
   //for (auto &scheduler : group_info.schedulers) {
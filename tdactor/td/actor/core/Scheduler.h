@@ -26,7 +26,9 @@
 #include "td/actor/core/ActorLocker.h"
 #include "td/actor/core/ActorMailbox.h"
 #include "td/actor/core/ActorMessage.h"
+#include "td/actor/core/BlockingWorker.h"
 #include "td/actor/core/Context.h"
+#include "td/actor/core/FileIoQueue.h"
 #include "td/actor/core/SchedulerContext.h"
 #include "td/actor/core/SchedulerId.h"
 #include "td/actor/core/SchedulerMessage.h"
@@ -138,6 +140,11 @@ struct LocalQueue {
     }
     return false;
   }
+  // bypasses the next_ slot, so the value is popped after all values already in the queue
+  template <class F>
+  void push_back(T value, F &&overflow_f) {
+    queue_.local_push(std::move(value), overflow_f);
+  }
   bool try_pop(T &message) {
     if (!next_) {
       return queue_.local_pop(message);
@@ -159,17 +166,33 @@ struct SchedulerInfo {
   SchedulerId id;
   // will be read by all workers is any thread
   std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>> cpu_queue;
+  // high priority actors, drained by workers before cpu_queue and local queues
+  std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>> cpu_high_queue;
   std::unique_ptr<MpmcWaiter> cpu_queue_waiter;
 
   std::vector<LocalQueue<SchedulerMessage::Raw *>> cpu_local_queue;
   //std::vector<td::StealingQueue<SchedulerMessage>> cpu_stealing_queue;
+  // for each cpu worker, the local queues it steals from; workers on the same numa node go first
+  std::vector<std::vector<size_t>> cpu_steal_order;
+  // cpus the workers are pinned to, cpu worker i gets cpu_affinity[i % size]; empty if not pinned
+  std::vector<int32> cpu_affinity;
+  // see SchedulerDispatcher::get_message_budget
+  size_t message_budget{0};
 
   // only scheduler itself may read from io_queue_
   std::unique_ptr<MpscPollableQueue<SchedulerMessage>> io_queue;
   size_t cpu_threads_count{0};
 
+  // blocking calls offloaded by actors, may be null
+  std::unique_ptr<BlockingQueue> blocking_queue;
+  size_t blocking_threads_count{0};
+
+  // file reads and writes submitted to io_uring by the io worker, null if io_uring is not available
+  std::unique_ptr<FileIoQueue> file_io_queue;
+
   std::unique_ptr<WorkerInfo> io_worker;
   std::vector<std::unique_ptr<WorkerInfo>> cpu_workers;
+  std::vector<std::unique_ptr<WorkerInfo>> blocking_workers;
 };
 
 struct SchedulerGroupInfo {
@@ -186,6 +209,8 @@ struct SchedulerGroupInfo {
   td::thread iocp_thread;
 #endif
   std::vector<SchedulerInfo> schedulers;
+  // schedulers reserved for some kind of actors, see dedicated_scheduler(); filled before start
+  std::vector<std::pair<std::string, SchedulerId>> dedicated_schedulers;
 };
 
 class Scheduler {
@@ -201,7 +226,7 @@ class Scheduler {
   }
 
   Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, SchedulerId id, size_t cpu_threads_count,
-            bool skip_timeouts = false);
+            bool skip_timeouts = false, size_t blocking_threads_count = 0);
 
   Scheduler(const Scheduler &) = delete;
   Scheduler &operator=(const Scheduler &) = delete;
@@ -209,6 +234,14 @@ class Scheduler {
   Scheduler &operator=(Scheduler &&other) = delete;
   ~Scheduler();
 
+  // must be called before start
+  void set_cpu_affinity(std::vector<int32> cpus);
+  const std::vector<int32> &get_cpu_affinity() const {
+    return info_->cpu_affinity;
+  }
+  // must be called before start
+  void set_message_budget(size_t message_budget);
+
   void start();
 
   template <class F>
@@ -238,6 +271,7 @@ class Scheduler {
   std::shared_ptr<SchedulerGroupInfo> scheduler_group_info_;
   SchedulerInfo *info_;
   std::vector<td::thread> cpu_threads_;
+  std::vector<td::thread> blocking_threads_;
   bool is_stopped_{false};
   Poll poll_;
   KHeap<double> heap_;
@@ -251,6 +285,7 @@ class Scheduler {
 
     SchedulerId get_scheduler_id() const override;
     void add_to_queue(ActorInfoPtr actor_info_ptr, SchedulerId scheduler_id, bool need_poll) override;
+    void add_to_queue_tail(ActorInfoPtr actor_info_ptr, SchedulerId scheduler_id, bool need_poll) override;
 
     ActorInfoCreator &get_actor_info_creator() override;
 
@@ -262,7 +297,16 @@ class Scheduler {
 
     Debug &get_debug() override;
 
+    void add_blocking_task(std::unique_ptr<BlockingTask> task) override;
+    BlockingStats get_blocking_stats() override;
+
+    void add_file_io_task(std::unique_ptr<FileIoTask> task) override;
+    FileIoStats get_file_io_stats() override;
+
+    SchedulerId get_dedicated_scheduler(Slice role) override;
+
     void set_alarm_timestamp(const ActorInfoPtr &actor_info_ptr) override;
+    size_t get_message_budget() const override;
 
     bool is_stop_requested() override;
     void stop() override;
@@ -296,6 +340,7 @@ class Scheduler {
     f();
   }
 
+  void init_steal_order();
   void do_stop();
 
  public:
@@ -308,12 +353,20 @@ class ActorMessageHangup : public core::ActorMessageImpl {
   void run() override {
     ActorExecuteContext::get()->actor().hangup();
   }
+  const ActorProfileSite *get_profile_site() const override {
+    static const ActorProfileSite site{"hangup"};
+    return &site;
+  }
 };
 class ActorMessageHangupShared : public core::ActorMessageImpl {
  public:
   void run() override {
     ActorExecuteContext::get()->actor().hangup_shared();
   }
+  const ActorProfileSite *get_profile_site() const override {
+    static const ActorProfileSite site{"hangup_shared"};
+    return &site;
+  }
 };
 }  // namespace core
 }  // namespace actor
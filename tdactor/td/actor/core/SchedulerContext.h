@@ -21,6 +21,8 @@
 #include "td/actor/core/SchedulerId.h"
 #include "td/actor/core/ActorInfo.h"
 #include "td/actor/core/ActorInfoCreator.h"
+#include "td/actor/core/BlockingWorker.h"
+#include "td/actor/core/FileIoQueue.h"
 
 #include "td/utils/port/Poll.h"
 #include "td/utils/Heap.h"
@@ -34,7 +36,15 @@ class SchedulerDispatcher {
 
   virtual SchedulerId get_scheduler_id() const = 0;
   virtual void add_to_queue(ActorInfoPtr actor_info_ptr, SchedulerId scheduler_id, bool need_poll) = 0;
+  // used for an actor which was interrupted, so the actors queued before it run first
+  virtual void add_to_queue_tail(ActorInfoPtr actor_info_ptr, SchedulerId scheduler_id, bool need_poll) {
+    add_to_queue(std::move(actor_info_ptr), scheduler_id, need_poll);
+  }
   virtual void set_alarm_timestamp(const ActorInfoPtr &actor_info_ptr) = 0;
+  // maximum number of messages run in one activation of an actor, 0 means no limit
+  virtual size_t get_message_budget() const {
+    return 0;
+  }
 };
 
 struct Debug;
@@ -53,6 +63,21 @@ class SchedulerContext : public Context<SchedulerContext>, public SchedulerDispa
   virtual bool has_heap() = 0;
   virtual KHeap<double> &get_heap() = 0;
 
+  // Blocking calls interface
+  // The task is run by blocking workers of the current scheduler, or right away if it has none
+  virtual void add_blocking_task(std::unique_ptr<BlockingTask> task) = 0;
+  // Summary over all schedulers
+  virtual BlockingStats get_blocking_stats() = 0;
+
+  // File io interface
+  // The task is submitted to io_uring of the current scheduler, or run as a blocking task if there is none
+  virtual void add_file_io_task(std::unique_ptr<FileIoTask> task) = 0;
+  // Summary over all schedulers
+  virtual FileIoStats get_file_io_stats() = 0;
+
+  // Scheduler reserved for actors of the role, invalid if there is none
+  virtual SchedulerId get_dedicated_scheduler(Slice role) = 0;
+
   // Stop all schedulers
   virtual bool is_stop_requested() = 0;
   virtual void stop() = 0;
@@ -0,0 +1,310 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+// Coroutine tasks for actor code. Requires a C++20 translation unit; with older standards the header only defines
+// TD_ACTOR_HAVE_TASKS to 0, so the rest of the tree may keep building as C++14.
+// No library code uses tasks yet: the validator and the other libraries are built as C++14, so only the C++20 targets
+// (test-tdactor-coro and benchmark-coro) can await anything.
+//
+//   td::actor::Task<int> MyActor::run() {
+//     CO_TRY_RESULT(state, co_await td::actor::ask(db_, &Db::get_state, block_id));
+//     auto size = co_await sub_task(std::move(state));  // Task<T> may await other tasks
+//     co_return size;
+//   }
+//   ...
+//   td::actor::start_task(run(), std::move(promise));  // must be called from the owning actor
+//
+// A task is resumed only on its owning actor: the reply of an ask() is delivered as an ordinary mailbox message, so
+// code between co_awaits runs exactly like a message handler. The result is stored in the coroutine frame and the
+// promise doubles as the resume message, so a step allocates only the request message and this promise. If the
+// owning actor is closed while a task is suspended, the whole task (with all tasks it awaits) is destroyed and its
+// promise gets "Lost promise".
+
+#include "td/actor/actor.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define TD_ACTOR_HAVE_TASKS 1
+#endif
+#endif
+#ifndef TD_ACTOR_HAVE_TASKS
+#define TD_ACTOR_HAVE_TASKS 0
+#endif
+
+#if TD_ACTOR_HAVE_TASKS
+#include <atomic>
+#include <coroutine>
+#include <new>
+#include <tuple>
+#include <utility>
+
+namespace td {
+namespace actor {
+template <class T = Unit>
+class Task;
+
+namespace detail {
+struct TaskPromiseBase {
+  std::coroutine_handle<> continuation;
+  std::coroutine_handle<> root;
+
+  std::suspend_always initial_suspend() noexcept {
+    return {};
+  }
+  void unhandled_exception() noexcept {
+    LOG(FATAL) << "Unhandled exception in coroutine";
+  }
+};
+
+template <class T>
+struct TaskPromise : public TaskPromiseBase {
+  Result<T> result;
+  Promise<T> detached_promise;
+
+  Task<T> get_return_object() noexcept;
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept {
+      return false;
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<TaskPromise> handle) noexcept {
+      auto &promise = handle.promise();
+      if (promise.continuation) {
+        return promise.continuation;
+      }
+      // root task: nobody awaits it, report the result and free the frame
+      auto detached_promise = std::move(promise.detached_promise);
+      auto result = std::move(promise.result);
+      handle.destroy();
+      detached_promise.set_result(std::move(result));
+      return std::noop_coroutine();
+    }
+    void await_resume() noexcept {
+    }
+  };
+  FinalAwaiter final_suspend() noexcept {
+    return {};
+  }
+
+  void return_value(Result<T> &&value) {
+    result = std::move(value);
+  }
+};
+
+// One step of a suspended task: the promise handed to the callee and the message resuming the task on its owning
+// actor share a single allocation, which is freed when both the promise and the message are released. If the message
+// is dropped because the owning actor is closed, the root task is destroyed with all tasks it awaits.
+template <class T>
+class TaskStep final
+    : public PromiseInterface<T>
+    , public core::ActorMessageImpl {
+ public:
+  static Promise<T> create(Result<T> *result, ActorId<> owner, std::coroutine_handle<> handle,
+                           std::coroutine_handle<> root) {
+    return Promise<T>(std::unique_ptr<PromiseInterface<T>>(new TaskStep(result, std::move(owner), handle, root)));
+  }
+
+  void set_value(T &&value) override {
+    set_result(std::move(value));
+  }
+  void set_error(Status &&error) override {
+    set_result(std::move(error));
+  }
+  void set_result(Result<T> &&result) override {
+    CHECK(result_);
+    *std::exchange(result_, nullptr) = std::move(result);
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    detail::send_message_later(owner_.as_actor_ref(), core::ActorMessage(std::unique_ptr<core::ActorMessageImpl>(this)));
+  }
+
+  void run() override {
+    ran_ = true;
+    handle_.resume();
+  }
+  const core::ActorProfileSite *get_profile_site() const override {
+    static const core::ActorProfileSite site{"task_resume"};
+    return &site;
+  }
+
+  // called instead of the destructor whenever the promise or the message is deleted
+  static void operator delete(TaskStep *step, std::destroying_delete_t) {
+    if (step->result_) {
+      step->set_result(Status::Error("Lost promise"));
+    }
+    if (step->refs_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    if (!step->ran_) {
+      step->root_.destroy();
+    }
+    step->~TaskStep();
+    ::operator delete(step);
+  }
+
+ private:
+  TaskStep(Result<T> *result, ActorId<> owner, std::coroutine_handle<> handle, std::coroutine_handle<> root)
+      : result_(result), owner_(std::move(owner)), handle_(handle), root_(root) {
+  }
+  ~TaskStep() override = default;
+
+  Result<T> *result_;
+  ActorId<> owner_;
+  std::coroutine_handle<> handle_;
+  std::coroutine_handle<> root_;
+  std::atomic<int> refs_{1};
+  bool ran_{false};
+};
+
+template <class T, class SendF>
+class PromiseAwaiter {
+ public:
+  explicit PromiseAwaiter(SendF &&send) : send_(std::move(send)) {
+  }
+  bool await_ready() noexcept {
+    return false;
+  }
+  template <class P>
+  void await_suspend(std::coroutine_handle<P> handle) {
+    send_(TaskStep<T>::create(&result_, actor_id(), handle, handle.promise().root));
+  }
+  Result<T> await_resume() noexcept {
+    return std::move(result_);
+  }
+
+ private:
+  SendF send_;
+  Result<T> result_;
+};
+
+template <class T>
+struct PromiseValue;
+template <class T>
+struct PromiseValue<Promise<T>> {
+  using type = T;
+};
+
+template <class FunctionT>
+struct AskResult;
+template <class ActorT, class... ArgsT>
+struct AskResult<void (ActorT::*)(ArgsT...)> {
+  using type = typename PromiseValue<std::decay_t<std::tuple_element_t<sizeof...(ArgsT) - 1, std::tuple<ArgsT...>>>>::type;
+};
+}  // namespace detail
+
+template <class T>
+class Task {
+ public:
+  using promise_type = detail::TaskPromise<T>;
+  using ResultPromise = Promise<T>;
+
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+  }
+  Task &operator=(Task &&other) noexcept {
+    reset();
+    handle_ = std::exchange(other.handle_, nullptr);
+    return *this;
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task() {
+    reset();
+  }
+
+  // co_await task runs it inline (symmetric transfer) and yields its Result<T>
+  bool await_ready() noexcept {
+    return false;
+  }
+  template <class P>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<P> parent) noexcept {
+    handle_.promise().continuation = parent;
+    handle_.promise().root = parent.promise().root;
+    return handle_;
+  }
+  Result<T> await_resume() noexcept {
+    return std::move(handle_.promise().result);
+  }
+
+ private:
+  friend promise_type;
+  template <class S>
+  friend void start_task(Task<S> task, typename Task<S>::ResultPromise promise);
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+  }
+  void reset() {
+    if (handle_) {
+      std::exchange(handle_, nullptr).destroy();
+    }
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template <class T>
+Task<T> detail::TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+// Starts a task on the current actor; its result is delivered to promise
+template <class T>
+void start_task(Task<T> task, typename Task<T>::ResultPromise promise) {
+  auto handle = std::exchange(task.handle_, nullptr);
+  handle.promise().root = handle;
+  handle.promise().detached_promise = std::move(promise);
+  handle.resume();
+}
+
+// co_await ask(actor_id, &Actor::method, args...) for methods taking td::Promise<R> as the last argument
+template <class ActorIdT, class FunctionT, class... ArgsT>
+auto ask(ActorIdT &&actor_id, FunctionT function, ArgsT &&... args) {
+  using R = typename detail::AskResult<FunctionT>::type;
+  auto send = [actor_id = std::forward<ActorIdT>(actor_id), function,
+               args = std::make_tuple(std::forward<ArgsT>(args)...)](Promise<R> promise) mutable {
+    std::apply(
+        [&](auto &&... unpacked) {
+          send_closure(std::move(actor_id), function, std::move(unpacked)..., std::move(promise));
+        },
+        std::move(args));
+  };
+  return detail::PromiseAwaiter<R, decltype(send)>(std::move(send));
+}
+
+// co_await await_promise<R>([&](td::Promise<R> promise) { ... }) for any promise based API
+template <class R, class F>
+auto await_promise(F &&f) {
+  return detail::PromiseAwaiter<R, std::decay_t<F>>(std::forward<F>(f));
+}
+}  // namespace actor
+}  // namespace td
+
+#define CO_TRY_STATUS(status)            \
+  {                                      \
+    auto try_status = (status);          \
+    if (try_status.is_error()) {         \
+      co_return std::move(try_status);   \
+    }                                    \
+  }
+#define CO_TRY_RESULT(name, result)                          \
+  auto TD_CONCAT(r_, name) = (result);                       \
+  if (TD_CONCAT(r_, name).is_error()) {                      \
+    co_return TD_CONCAT(r_, name).move_as_error();           \
+  }                                                          \
+  auto name = TD_CONCAT(r_, name).move_as_ok();
+#endif
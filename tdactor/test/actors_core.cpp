@@ -22,8 +22,13 @@
 
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/IoUring.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/sleep.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
+#include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
@@ -793,6 +798,102 @@ TEST(Actor2, actor_ping_pong) {
   sb.clear();
 }
 
+TEST(Actor2, actor_priority_starvation) {
+  // high priority actors that never stop yielding must not starve normal ones
+  Scheduler scheduler{{1}};
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  auto stop_flag = std::make_shared<std::atomic<bool>>(false);
+  scheduler.run_in_context([watcher = std::move(watcher), stop_flag] {
+    class Spinner : public Actor {
+     public:
+      Spinner(std::shared_ptr<std::atomic<bool>> stop_flag, std::shared_ptr<td::Destructor> watcher)
+          : stop_flag_(std::move(stop_flag)), watcher_(std::move(watcher)) {
+      }
+      void loop() override {
+        if (stop_flag_->load()) {
+          stop();
+          return;
+        }
+        yield();
+      }
+
+     private:
+      std::shared_ptr<std::atomic<bool>> stop_flag_;
+      std::shared_ptr<td::Destructor> watcher_;
+    };
+    class Stopper : public Actor {
+     public:
+      Stopper(std::shared_ptr<std::atomic<bool>> stop_flag, std::shared_ptr<td::Destructor> watcher)
+          : stop_flag_(std::move(stop_flag)), watcher_(std::move(watcher)) {
+      }
+      void start_up() override {
+        yield();
+      }
+      void loop() override {
+        if (++cnt_ < 100) {
+          yield();
+          return;
+        }
+        *stop_flag_ = true;
+        stop();
+      }
+
+     private:
+      std::shared_ptr<std::atomic<bool>> stop_flag_;
+      std::shared_ptr<td::Destructor> watcher_;
+      int cnt_{0};
+    };
+    for (int i = 0; i < 4; i++) {
+      create_actor<Spinner>(ActorOptions().with_name("Spinner").with_priority(ActorPriority::High), stop_flag, watcher)
+          .release();
+    }
+    create_actor<Stopper>("Stopper", stop_flag, watcher).release();
+  });
+  scheduler.run();
+  CHECK(stop_flag->load());
+}
+
+TEST(Actor2, actor_profiler) {
+  Scheduler scheduler{{2}};
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  core::ActorProfiler::set_enabled(true);
+  core::ActorProfiler::dump(true);
+  scheduler.run_in_context([watcher = std::move(watcher)] {
+    class ProfiledPinger : public Actor {
+     public:
+      explicit ProfiledPinger(std::shared_ptr<td::Destructor> watcher) : watcher_(std::move(watcher)) {
+      }
+      void ping(int left) {
+        if (left == 0) {
+          stop();
+          return;
+        }
+        send_closure(actor_id(this), &ProfiledPinger::ping, left - 1);
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+    };
+    // per-instance names are merged by actor class
+    for (int i = 0; i < 2; i++) {
+      auto actor = create_actor<ProfiledPinger>(PSLICE() << "ProfiledPinger " << i, watcher).release();
+      send_closure(actor, &ProfiledPinger::ping, 100);
+    }
+  });
+  scheduler.run();
+
+  bool found = false;
+  for (auto &entry : core::ActorProfiler::dump(true)) {
+    if (entry.actor == "ProfiledPinger" && entry.message.find("ProfiledPinger(int)") != std::string::npos) {
+      LOG_CHECK(entry.count == 202) << entry.count;
+      CHECK(entry.max_time <= entry.total_time);
+      found = true;
+    }
+  }
+  CHECK(found);
+  core::ActorProfiler::set_enabled(false);
+}
+
 TEST(Actor2, Schedulers) {
   for (auto mode : {Scheduler::Running, Scheduler::Paused}) {
     for (auto start_count : {0, 1, 2}) {
@@ -1103,3 +1204,208 @@ TEST(Actor2, send_vs_close2) {
   }
 }
 #endif  //!TD_THREAD_UNSUPPORTED
+
+TEST(Actor2, run_blocking) {
+  Scheduler scheduler{{Scheduler::NodeInfo{1}.with_blocking_threads(2)}};
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([watcher = std::move(watcher)] {
+    class BlockingCaller : public Actor {
+     public:
+      explicit BlockingCaller(std::shared_ptr<td::Destructor> watcher) : watcher_(std::move(watcher)) {
+      }
+      void start_up() override {
+        for (int i = 0; i < 10; i++) {
+          run_blocking(
+              [i]() -> td::Result<int> {
+                td::usleep_for(1000);
+                if (i == 9) {
+                  return td::Status::Error("failed");
+                }
+                return td::get_thread_id();
+              },
+              [self = this, i](td::Result<int> r_thread_id) {
+                // the promise is run by the caller, so its state may be used here
+                CHECK(&core::ActorExecuteContext::get()->actor() == self);
+                if (i == 9) {
+                  CHECK(r_thread_id.is_error());
+                } else {
+                  CHECK(r_thread_id.ok() != td::get_thread_id());
+                }
+                self->on_result();
+              });
+        }
+      }
+      void on_result() {
+        if (++results_ == 10) {
+          auto stats = get_blocking_stats();
+          CHECK(stats.threads == 2);
+          LOG_CHECK(stats.tasks == 10) << stats.tasks;
+          CHECK(stats.queue_size == 0);
+          CHECK(stats.max_run_time <= stats.total_run_time);
+          stop();
+        }
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      int results_{0};
+    };
+    create_actor<BlockingCaller>("BlockingCaller", watcher).release();
+  });
+  scheduler.run();
+}
+
+TEST(Actor2, file_io) {
+  td::CSlice path = "file_io.txt";
+  td::unlink(path).ignore();
+  Scheduler scheduler{{Scheduler::NodeInfo{1}.with_blocking_threads(1)}};
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([watcher = std::move(watcher), path] {
+    class FileIoCaller : public Actor {
+     public:
+      FileIoCaller(std::shared_ptr<td::Destructor> watcher, td::FileFd fd)
+          : watcher_(std::move(watcher)), fd_(std::move(fd)) {
+      }
+      void start_up() override {
+        for (int i = 0; i < chunks_count; i++) {
+          file_pwrite(fd_, td::BufferSlice(get_chunk(i)), i * chunk_size, [self = this](td::Result<td::Unit> r) {
+            CHECK(&core::ActorExecuteContext::get()->actor() == self);
+            r.ensure();
+            self->on_written();
+          });
+        }
+      }
+      void on_written() {
+        if (++written_ != chunks_count) {
+          return;
+        }
+        for (int i = 0; i < chunks_count; i++) {
+          file_pread(fd_, chunk_size, i * chunk_size, [self = this, i](td::Result<td::BufferSlice> r) {
+            CHECK(r.ok().as_slice() == get_chunk(i));
+            self->on_read();
+          });
+        }
+        // reads at the end of file are short
+        file_pread(fd_, chunk_size, chunks_count * chunk_size - 10, [self = this](td::Result<td::BufferSlice> r) {
+          CHECK(r.ok().size() == 10);
+          self->on_read();
+        });
+      }
+      void on_read() {
+        if (++read_ != chunks_count + 1) {
+          return;
+        }
+        auto stats = get_file_io_stats();
+        if (td::IoUring::is_supported()) {
+          CHECK(stats.tasks == 2 * chunks_count + 1);
+          CHECK(stats.completions >= stats.tasks);
+          CHECK(stats.submits <= stats.tasks);
+        } else {
+          CHECK(stats.tasks == 0);
+        }
+        fd_.close();
+        stop();
+      }
+
+     private:
+      enum : int { chunks_count = 100, chunk_size = 10000 };
+      std::shared_ptr<td::Destructor> watcher_;
+      td::FileFd fd_;
+      int written_{0};
+      int read_{0};
+
+      static std::string get_chunk(int i) {
+        return std::string(chunk_size, static_cast<char>('a' + i % 26));
+      }
+    };
+    auto fd = td::FileFd::open(path, td::FileFd::Read | td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+    create_actor<FileIoCaller>("FileIoCaller", watcher, std::move(fd)).release();
+  });
+  scheduler.run();
+  td::unlink(path).ensure();
+}
+
+TEST(Actor2, dedicated_scheduler) {
+  Scheduler scheduler{{1, Scheduler::NodeInfo{1}.with_cpu_affinity({0}).with_dedicated_role("consensus")}};
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([watcher = std::move(watcher)] {
+    class Pinned : public Actor {
+     public:
+      explicit Pinned(std::shared_ptr<td::Destructor> watcher, int depth)
+          : watcher_(std::move(watcher)), depth_(depth) {
+      }
+      void start_up() override {
+        CHECK(SchedulerContext::get()->get_scheduler_id() == SchedulerId{1});
+        if (depth_ > 0) {
+          // children stay on the scheduler of their parent
+          create_actor<Pinned>("Pinned", watcher_, depth_ - 1).release();
+        }
+        stop();
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      int depth_;
+    };
+    CHECK(!dedicated_scheduler("unknown").is_valid());
+    CHECK(dedicated_scheduler("consensus") == SchedulerId{1});
+    create_actor<Pinned>(ActorOptions().with_name("Pinned").on_scheduler(dedicated_scheduler("consensus")), watcher, 3)
+        .release();
+  });
+  scheduler.run();
+}
+
+TEST(Actor2, closure_batch) {
+  std::vector<int> log;
+  Scheduler scheduler{{Scheduler::NodeInfo{1}.with_message_budget(3)}};
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([watcher = std::move(watcher), &log] {
+    class Receiver : public Actor {
+     public:
+      Receiver(std::shared_ptr<td::Destructor> watcher, std::vector<int> *log, ActorId<Receiver> other)
+          : watcher_(std::move(watcher)), log_(log), other_(std::move(other)) {
+      }
+      void on_value(int value) {
+        log_->push_back(value);
+        if (value == 0) {
+          // queued while the receiver is still running
+          send_closure(other_, &Receiver::on_value, -1);
+          send_closure(other_, &Receiver::on_last);
+        }
+      }
+      void on_last() {
+        stop();
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      std::vector<int> *log_;
+      ActorId<Receiver> other_;
+    };
+
+    auto other = create_actor<Receiver>("Other", watcher, &log, ActorId<Receiver>()).release();
+    auto receiver = create_actor<Receiver>("Receiver", watcher, &log, other).release();
+    ClosureBatch<Receiver> batch;
+    for (int i = 0; i < 10; i++) {
+      batch.add(&Receiver::on_value, i);
+    }
+    batch.add(&Receiver::on_last);
+    CHECK(batch.size() == 11);
+    send_closure_batch(receiver, std::move(batch));
+  });
+  scheduler.run();
+
+  std::vector<int> values;
+  for (auto value : log) {
+    if (value >= 0) {
+      values.push_back(value);
+    }
+  }
+  ASSERT_EQ(10u, values.size());
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(i, values[i]);
+  }
+  // the receiver was interrupted after 3 messages, so the other actor ran in between
+  ASSERT_EQ(11u, log.size());
+  ASSERT_TRUE(log.back() != -1);
+}
@@ -0,0 +1,172 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/coro.h"
+#include "td/utils/Destructor.h"
+#include "td/utils/logging.h"
+#include "td/utils/tests.h"
+
+#include <atomic>
+#include <memory>
+
+#if !TD_ACTOR_HAVE_TASKS
+#error "actors_coro.cpp must be compiled with C++20 coroutines"
+#endif
+
+using namespace td::actor;
+
+namespace {
+class Calculator : public Actor {
+ public:
+  void square(int x, td::Promise<int> promise) {
+    if (x < 0) {
+      promise.set_error(td::Status::Error(PSLICE() << "negative " << x));
+      return;
+    }
+    promise.set_value(x * x);
+  }
+  // answers in a separate message, so the caller is suspended by then
+  void hold(td::Promise<int> promise) {
+    send_closure_later(actor_id(this), &Calculator::answer, std::move(promise));
+  }
+  void answer(td::Promise<int> promise) {
+    promise.set_value(1);
+  }
+};
+
+// counts live coroutine frames
+struct FrameGuard {
+  explicit FrameGuard(std::shared_ptr<std::atomic<int>> frames) : frames_(std::move(frames)) {
+    frames_->fetch_add(1);
+  }
+  FrameGuard(const FrameGuard &) = delete;
+  FrameGuard &operator=(const FrameGuard &) = delete;
+  ~FrameGuard() {
+    frames_->fetch_sub(1);
+  }
+
+ private:
+  std::shared_ptr<std::atomic<int>> frames_;
+};
+
+class Client : public Actor {
+ public:
+  Client(ActorId<Calculator> calculator, std::shared_ptr<std::atomic<int>> frames)
+      : calculator_(calculator), frames_(std::move(frames)) {
+  }
+
+  Task<int> square(int x) {
+    FrameGuard guard{frames_};
+    CO_TRY_RESULT(res, co_await ask(calculator_, &Calculator::square, x));
+    co_return res;
+  }
+  // awaits other tasks, errors of nested tasks are propagated by CO_TRY_RESULT
+  Task<int> sum_of_squares(std::vector<int> xs) {
+    FrameGuard guard{frames_};
+    int sum = 0;
+    for (auto x : xs) {
+      CO_TRY_RESULT(sq, co_await square(x));
+      sum += sq;
+    }
+    co_return sum;
+  }
+  Task<int> hold_twice() {
+    FrameGuard guard{frames_};
+    CO_TRY_RESULT(a, co_await ask(calculator_, &Calculator::hold));
+    CO_TRY_RESULT(b, co_await square(a + 1));
+    co_return b;
+  }
+  Task<int> lost() {
+    FrameGuard guard{frames_};
+    auto r = co_await await_promise<int>([](td::Promise<int> promise) {});
+    CHECK(r.is_error());
+    co_return r.move_as_error();
+  }
+
+  void run(std::vector<int> xs, td::Promise<int> promise) {
+    start_task(sum_of_squares(std::move(xs)), std::move(promise));
+  }
+  void run_held(td::Promise<int> promise) {
+    start_task(hold_twice(), std::move(promise));
+  }
+  void run_held_and_close(td::Promise<int> promise) {
+    start_task(hold_twice(), std::move(promise));
+    stop();
+  }
+  void run_lost(td::Promise<int> promise) {
+    start_task(lost(), std::move(promise));
+  }
+
+ private:
+  ActorId<Calculator> calculator_;
+  std::shared_ptr<std::atomic<int>> frames_;
+};
+
+struct Results {
+  std::atomic<int> done{0};
+  td::Result<int> value;
+  td::Result<int> error;
+  td::Result<int> lost;
+  td::Result<int> held;
+  td::Result<int> closed;
+};
+
+void store(std::shared_ptr<Results> results, td::Result<int> Results::*field, td::Result<int> r) {
+  (*results).*field = std::move(r);
+  results->done.fetch_add(1);
+}
+}  // namespace
+
+TEST(Actor2, coro_tasks) {
+  Scheduler scheduler{{2}};
+  auto frames = std::make_shared<std::atomic<int>>(0);
+  auto results = std::make_shared<Results>();
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([&, watcher = std::move(watcher)] {
+    auto calculator = create_actor<Calculator>("Calculator").release();
+    auto client = create_actor<Client>("Client", calculator, frames).release();
+    // the scheduler is stopped when all promises are done
+    auto make_promise = [results, watcher](td::Result<int> Results::*field) {
+      return td::PromiseCreator::lambda(
+          [results, field, watcher](td::Result<int> r) { store(results, field, std::move(r)); });
+    };
+
+    // nested tasks
+    send_closure(client, &Client::run, std::vector<int>{1, 2, 3}, make_promise(&Results::value));
+    // the error of the innermost ask is propagated through both tasks
+    send_closure(client, &Client::run, std::vector<int>{1, -2, 3}, make_promise(&Results::error));
+    // a promise dropped without an answer resumes the task with an error
+    send_closure(client, &Client::run_lost, make_promise(&Results::lost));
+    // a promise answered later
+    send_closure(client, &Client::run_held, make_promise(&Results::held));
+
+    // the owner is closed while its task is suspended: the task is destroyed once the promise is answered
+    auto owner = create_actor<Client>("Owner", calculator, frames).release();
+    send_closure(owner, &Client::run_held_and_close, make_promise(&Results::closed));
+  });
+  scheduler.run();
+
+  LOG_CHECK(results->done.load() == 5) << results->done.load();
+  LOG_CHECK(results->value.is_ok() && results->value.ok() == 14) << results->value.is_ok();
+  CHECK(results->error.is_error());
+  LOG_CHECK(results->error.error().message() == "negative -2") << results->error.error();
+  CHECK(results->lost.is_error());
+  LOG_CHECK(results->held.is_ok() && results->held.ok() == 4) << results->held.is_ok();
+  CHECK(results->closed.is_error());
+  LOG_CHECK(frames->load() == 0) << frames->load();
+}
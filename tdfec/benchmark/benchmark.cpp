@@ -35,6 +35,10 @@
 #include "td/fec/algebra/Octet.h"
 #include "td/fec/algebra/GaussianElimination.h"
 #include "td/fec/algebra/Simd.h"
+#include "td/fec/common/SymbolsView.h"
+#include "td/fec/raptorq/Decoder.h"
+#include "td/fec/raptorq/Encoder.h"
+#include "td/fec/raptorq/Solver.h"
 #include <cstdio>
 
 template <class Simd, size_t size = 256>
@@ -185,6 +189,36 @@ class SolverBenchmark : public td::Benchmark {
   size_t symbol_size_;
 };
 
+class PrecodeBenchmark : public td::Benchmark {
+ public:
+  PrecodeBenchmark(td::uint32 symbols_count, size_t symbol_size, bool use_cache)
+      : p_(td::raptorq::Rfc::get_parameters(symbols_count).move_as_ok())
+      , symbol_size_(symbol_size)
+      , use_cache_(use_cache) {
+    data_ = td::rand_string('a', 'z', td::narrow_cast<int>(symbols_count * symbol_size));
+  }
+  std::string get_description() const override {
+    return PSTRING() << "PrecodeBenchmark " << (use_cache_ ? "cached " : "") << p_.K << " " << symbol_size_;
+  }
+
+  void run(int n) override {
+    td::raptorq::SymbolsView symbols(p_.K_padded, symbol_size_, data_);
+    for (int j = 0; j < n; j++) {
+      if (use_cache_) {
+        td::raptorq::Solver::run_precode(p_, symbols.symbols()).ensure();
+      } else {
+        td::raptorq::Solver::run(p_, symbols.symbols()).ensure();
+      }
+    }
+  }
+
+ private:
+  td::raptorq::Rfc::Parameters p_;
+  size_t symbol_size_;
+  bool use_cache_;
+  std::string data_;
+};
+
 template <class Encoder, class Decoder>
 class FecBenchmark : public td::Benchmark {
  public:
@@ -235,12 +269,150 @@ class FecBenchmark : public td::Benchmark {
 template <template <class T, size_t size> class O, size_t size = 256 * 8>
 void bench_simd() {
   bench(O<td::Simd_null, size>("baseline"));
-#if TD_SSSE3
-  bench(O<td::Simd_sse, size>("SSE"));
+#if TD_SSE3
+  if (td::Simd_sse::is_supported()) {
+    bench(O<td::Simd_sse, size>("SSE"));
+  }
 #endif
 #if TD_AVX2
-  bench(O<td::Simd_avx, size>("AVX"));
+  if (td::Simd_avx::is_supported()) {
+    bench(O<td::Simd_avx, size>("AVX"));
+  }
 #endif
+#if TD_AVX512
+  if (td::Simd_avx512::is_supported()) {
+    bench(O<td::Simd_avx512, size>("AVX-512"));
+  }
+#endif
+#if TD_GFNI
+  if (td::Simd_gfni::is_supported()) {
+    bench(O<td::Simd_gfni, size>("GFNI"));
+  }
+#endif
+}
+
+// RaptorQ encode and decode throughput with each supported kernel selected in td::Simd
+void run_kernels_benchmark() {
+  constexpr size_t TARGET_TOTAL_BYTES = 64 * 1024 * 1024;
+  constexpr size_t symbol_size = 768;
+  auto initial_kernel = td::Simd::get_kernel();
+
+  for (auto kernel : {td::Simd::Kernel::Null, td::Simd::Kernel::Sse, td::Simd::Kernel::Avx, td::Simd::Kernel::Avx512,
+                      td::Simd::Kernel::Gfni}) {
+    if (!td::Simd::is_supported(kernel)) {
+      continue;
+    }
+    td::Simd::set_kernel(kernel);
+    for (size_t symbol_count : {100, 1000, 10000}) {
+      auto elements = symbol_count * symbol_size;
+      td::BufferSlice data(elements);
+      td::Random::Xorshift128plus rnd(123);
+      for (auto &c : data.as_slice()) {
+        c = static_cast<td::uint8>(rnd());
+      }
+      auto iterations = td::max<size_t>(TARGET_TOTAL_BYTES / elements, 1);
+
+      // every fifth source symbol is replaced by a repair symbol, so decoding has to solve the system
+      std::vector<td::fec::Symbol> symbols;
+      double encode_time = 0;
+      for (size_t i = 0; i < iterations; i++) {
+        symbols.clear();
+        double start = td::Time::now();
+        auto encoder = td::fec::RaptorQEncoder::create(data.clone(), symbol_size);
+        encoder->prepare_more_symbols();
+        for (td::uint32 j = 0; symbols.size() < symbol_count + 2; j++) {
+          if (j % 5 != 0 || j >= symbol_count) {
+            symbols.push_back(encoder->gen_symbol(j));
+          }
+        }
+        encode_time += td::Time::now() - start;
+      }
+
+      auto parameters = td::fec::RaptorQEncoder::create(data.clone(), symbol_size)->get_parameters();
+      double decode_time = 0;
+      for (size_t i = 0; i < iterations; i++) {
+        double start = td::Time::now();
+        auto decoder = td::fec::RaptorQDecoder::create(parameters);
+        for (auto &symbol : symbols) {
+          decoder->add_symbol({symbol.id, symbol.data.clone()});
+        }
+        auto res = decoder->try_decode(false);
+        decode_time += td::Time::now() - start;
+        LOG_CHECK(res.is_ok()) << res.error();
+        CHECK(res.ok().data.as_slice() == data.as_slice());
+      }
+
+      double total_mb = static_cast<double>(elements) * static_cast<double>(iterations) / 1024 / 1024;
+      fprintf(stderr, "%-14s symbol count = %5d, encode: %8.1lfMB/s, decode: %8.1lfMB/s\n",
+              td::Simd::get_name().c_str(), (int)symbol_count, total_mb / encode_time, total_mb / decode_time);
+    }
+  }
+  td::Simd::set_kernel(initial_kernel);
+}
+
+// Time spent in raptorq::Decoder per added symbol and after the last symbol (last add_symbol + try_decode),
+// for batch decoding and for the online mode
+void run_decoder_latency_benchmark() {
+  constexpr size_t symbol_size = 768;
+  constexpr int runs = 5;
+  for (td::uint32 symbol_count : {100, 1000, 10000}) {
+    auto data = td::rand_string('a', 'z', td::narrow_cast<int>(symbol_count * symbol_size));
+    auto encoder = td::raptorq::Encoder::create(symbol_size, td::BufferSlice(data)).move_as_ok();
+    encoder->precalc();
+    auto parameters = encoder->get_parameters();
+
+    // every tenth symbol is lost
+    std::vector<td::uint32> ids;
+    for (td::uint32 id = 0; ids.size() < symbol_count + symbol_count / 10 + 10; id++) {
+      if (td::Random::fast(0, 9) != 0) {
+        ids.push_back(id);
+      }
+    }
+    std::vector<std::string> symbols;
+    for (auto id : ids) {
+      std::string symbol(symbol_size, '\0');
+      encoder->gen_symbol(id, symbol);
+      symbols.push_back(std::move(symbol));
+    }
+
+    for (size_t lookahead : {0, 16, 64}) {
+      double add_time = 0;
+      double max_add_time = 0;
+      double tail_time = 0;
+      size_t added = 0;
+      for (int run = 0; run < runs; run++) {
+        auto decoder = td::raptorq::Decoder::create(parameters).move_as_ok();
+        if (lookahead != 0) {
+          decoder->set_online(lookahead);
+        }
+        for (size_t i = 0; i < ids.size(); i++) {
+          double start = td::Time::now();
+          decoder->add_symbol({ids[i], td::Slice(symbols[i])}).ensure();
+          double add_end = td::Time::now();
+          if (!decoder->may_try_decode()) {
+            add_time += add_end - start;
+            max_add_time = td::max(max_add_time, add_end - start);
+            added++;
+            continue;
+          }
+          auto res = decoder->try_decode(false);
+          double end = td::Time::now();
+          if (res.is_ok()) {
+            CHECK(res.ok().data.as_slice() == data);
+            tail_time += end - start;
+            break;
+          }
+          add_time += end - start;
+          max_add_time = td::max(max_add_time, end - start);
+          added++;
+        }
+      }
+      fprintf(stderr,
+              "%-11s symbol count = %5d, per symbol: avg %7.1lfus, max %8.1lfus, tail: %8.1lfus\n",
+              (lookahead == 0 ? std::string("batch") : PSTRING() << "online(" << lookahead << ")").c_str(),
+              (int)symbol_count, add_time / (double)added * 1e6, max_add_time * 1e6, tail_time / runs * 1e6);
+    }
+  }
 }
 
 void run_encode_benchmark() {
@@ -278,6 +450,8 @@ void run_encode_benchmark() {
 int main(void) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   run_encode_benchmark();
+  run_kernels_benchmark();
+  run_decoder_latency_benchmark();
   bench_simd<Simd_gf256_mul, 32>();
   bench_simd<Simd_gf256_add_mul, 32>();
   bench_simd<Simd_gf256_add, 32>();
@@ -300,5 +474,9 @@ int main(void) {
 
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
   bench(SolverBenchmark(50000 * 200, 200));
+  for (td::uint32 symbols_count : {100, 1000, 10000}) {
+    bench(PrecodeBenchmark(symbols_count, 768, false));
+    bench(PrecodeBenchmark(symbols_count, 768, true));
+  }
   return 0;
 }
@@ -36,6 +36,12 @@ InactivationDecodingResult InactivationDecoding::run() {
   }
 
   uint32 side = narrow_cast<uint32>(p_cols_.size());
+  // columns not covered by any row are possible only in an underdetermined system
+  for (uint32 col = 0; col < cols_; col++) {
+    if (!was_col_[col]) {
+      inactive_cols_.push_back(col);
+    }
+  }
   std::reverse(inactive_cols_.begin(), inactive_cols_.end());
   for (auto col : inactive_cols_) {
     p_cols_.push_back(col);
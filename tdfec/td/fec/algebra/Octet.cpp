@@ -9239,4 +9239,72 @@ const uint8 Octet::OctMulHi[256][16] = {
         142,
     },
 };
+
+// OctMulAffine[u] is the bit matrix of multiplication by u in the form expected by gf2p8affineqb
+const uint64 Octet::OctMulAffine[256] = {
+    0x0000000000000000ull, 0x0102040810204080ull, 0x8001828488102040ull, 0x8103868c983060c0ull,
+    0x408041c2c4881020ull, 0x418245cad4a850a0ull, 0xc081c3464c983060ull, 0xc183c74e5cb870e0ull,
+    0x2040a061e2c48810ull, 0x2142a469f2e4c890ull, 0xa04122e56ad4a850ull, 0xa14326ed7af4e8d0ull,
+    0x60c0e1a3264c9830ull, 0x61c2e5ab366cd8b0ull, 0xe0c16327ae5cb870ull, 0xe1c3672fbe7cf8f0ull,
+    0x102050b071e2c488ull, 0x112254b861c28408ull, 0x9021d234f9f2e4c8ull, 0x9123d63ce9d2a448ull,
+    0x50a01172b56ad4a8ull, 0x51a2157aa54a9428ull, 0xd0a193f63d7af4e8ull, 0xd1a397fe2d5ab468ull,
+    0x3060f0d193264c98ull, 0x3162f4d983060c18ull, 0xb06172551b366cd8ull, 0xb163765d0b162c58ull,
+    0x70e0b11357ae5cb8ull, 0x71e2b51b478e1c38ull, 0xf0e13397dfbe7cf8ull, 0xf1e3379fcf9e3c78ull,
+    0x8810a8d83871e2c4ull, 0x8912acd02851a244ull, 0x08112a5cb061c284ull, 0x09132e54a0418204ull,
+    0xc890e91afcf9f2e4ull, 0xc992ed12ecd9b264ull, 0x48916b9e74e9d2a4ull, 0x49936f9664c99224ull,
+    0xa85008b9dab56ad4ull, 0xa9520cb1ca952a54ull, 0x28518a3d52a54a94ull, 0x29538e3542850a14ull,
+    0xe8d0497b1e3d7af4ull, 0xe9d24d730e1d3a74ull, 0x68d1cbff962d5ab4ull, 0x69d3cff7860d1a34ull,
+    0x9830f8684993264cull, 0x9932fc6059b366ccull, 0x18317aecc183060cull, 0x19337ee4d1a3468cull,
+    0xd8b0b9aa8d1b366cull, 0xd9b2bda29d3b76ecull, 0x58b13b2e050b162cull, 0x59b33f26152b56acull,
+    0xb8705809ab57ae5cull, 0xb9725c01bb77eedcull, 0x3871da8d23478e1cull, 0x3973de853367ce9cull,
+    0xf8f019cb6fdfbe7cull, 0xf9f21dc37ffffefcull, 0x78f19b4fe7cf9e3cull, 0x79f39f47f7efdebcull,
+    0xc488d46c1c3871e2ull, 0xc58ad0640c183162ull, 0x448956e8942851a2ull, 0x458b52e084081122ull,
+    0x840895aed8b061c2ull, 0x850a91a6c8902142ull, 0x0409172a50a04182ull, 0x050b132240800102ull,
+    0xe4c8740dfefcf9f2ull, 0xe5ca7005eedcb972ull, 0x64c9f68976ecd9b2ull, 0x65cbf28166cc9932ull,
+    0xa44835cf3a74e9d2ull, 0xa54a31c72a54a952ull, 0x2449b74bb264c992ull, 0x254bb343a2448912ull,
+    0xd4a884dc6ddab56aull, 0xd5aa80d47dfaf5eaull, 0x54a90658e5ca952aull, 0x55ab0250f5ead5aaull,
+    0x9428c51ea952a54aull, 0x952ac116b972e5caull, 0x1429479a2142850aull, 0x152b43923162c58aull,
+    0xf4e824bd8f1e3d7aull, 0xf5ea20b59f3e7dfaull, 0x74e9a639070e1d3aull, 0x75eba231172e5dbaull,
+    0xb468657f4b962d5aull, 0xb56a61775bb66ddaull, 0x3469e7fbc3860d1aull, 0x356be3f3d3a64d9aull,
+    0x4c987cb424499326ull, 0x4d9a78bc3469d3a6ull, 0xcc99fe30ac59b366ull, 0xcd9bfa38bc79f3e6ull,
+    0x0c183d76e0c18306ull, 0x0d1a397ef0e1c386ull, 0x8c19bff268d1a346ull, 0x8d1bbbfa78f1e3c6ull,
+    0x6cd8dcd5c68d1b36ull, 0x6ddad8ddd6ad5bb6ull, 0xecd95e514e9d3b76ull, 0xeddb5a595ebd7bf6ull,
+    0x2c589d1702050b16ull, 0x2d5a991f12254b96ull, 0xac591f938a152b56ull, 0xad5b1b9b9a356bd6ull,
+    0x5cb82c0455ab57aeull, 0x5dba280c458b172eull, 0xdcb9ae80ddbb77eeull, 0xddbbaa88cd9b376eull,
+    0x1c386dc69123478eull, 0x1d3a69ce8103070eull, 0x9c39ef42193367ceull, 0x9d3beb4a0913274eull,
+    0x7cf88c65b76fdfbeull, 0x7dfa886da74f9f3eull, 0xfcf90ee13f7ffffeull, 0xfdfb0ae92f5fbf7eull,
+    0x3c78cda773e7cf9eull, 0x3d7ac9af63c78f1eull, 0xbc794f23fbf7efdeull, 0xbd7b4b2bebd7af5eull,
+    0xe2c46a368e1c3871ull, 0xe3c66e3e9e3c78f1ull, 0x62c5e8b2060c1831ull, 0x63c7ecba162c58b1ull,
+    0xa2442bf44a942851ull, 0xa3462ffc5ab468d1ull, 0x2245a970c2840811ull, 0x2347ad78d2a44891ull,
+    0xc284ca576cd8b061ull, 0xc386ce5f7cf8f0e1ull, 0x428548d3e4c89021ull, 0x43874cdbf4e8d0a1ull,
+    0x82048b95a850a041ull, 0x83068f9db870e0c1ull, 0x0205091120408001ull, 0x03070d193060c081ull,
+    0xf2e43a86fffefcf9ull, 0xf3e63e8eefdebc79ull, 0x72e5b80277eedcb9ull, 0x73e7bc0a67ce9c39ull,
+    0xb2647b443b76ecd9ull, 0xb3667f4c2b56ac59ull, 0x3265f9c0b366cc99ull, 0x3367fdc8a3468c19ull,
+    0xd2a49ae71d3a74e9ull, 0xd3a69eef0d1a3469ull, 0x52a51863952a54a9ull, 0x53a71c6b850a1429ull,
+    0x9224db25d9b264c9ull, 0x9326df2dc9922449ull, 0x122559a151a24489ull, 0x13275da941820409ull,
+    0x6ad4c2eeb66ddab5ull, 0x6bd6c6e6a64d9a35ull, 0xead5406a3e7dfaf5ull, 0xebd744622e5dba75ull,
+    0x2a54832c72e5ca95ull, 0x2b56872462c58a15ull, 0xaa5501a8faf5ead5ull, 0xab5705a0ead5aa55ull,
+    0x4a94628f54a952a5ull, 0x4b96668744891225ull, 0xca95e00bdcb972e5ull, 0xcb97e403cc993265ull,
+    0x0a14234d90214285ull, 0x0b16274580010205ull, 0x8a15a1c9183162c5ull, 0x8b17a5c108112245ull,
+    0x7af4925ec78f1e3dull, 0x7bf69656d7af5ebdull, 0xfaf510da4f9f3e7dull, 0xfbf714d25fbf7efdull,
+    0x3a74d39c03070e1dull, 0x3b76d79413274e9dull, 0xba7551188b172e5dull, 0xbb7755109b376eddull,
+    0x5ab4323f254b962dull, 0x5bb63637356bd6adull, 0xdab5b0bbad5bb66dull, 0xdbb7b4b3bd7bf6edull,
+    0x1a3473fde1c3860dull, 0x1b3677f5f1e3c68dull, 0x9a35f17969d3a64dull, 0x9b37f57179f3e6cdull,
+    0x264cbe5a92244993ull, 0x274eba5282040913ull, 0xa64d3cde1a3469d3ull, 0xa74f38d60a142953ull,
+    0x66ccff9856ac59b3ull, 0x67cefb90468c1933ull, 0xe6cd7d1cdebc79f3ull, 0xe7cf7914ce9c3973ull,
+    0x060c1e3b70e0c183ull, 0x070e1a3360c08103ull, 0x860d9cbff8f0e1c3ull, 0x870f98b7e8d0a143ull,
+    0x468c5ff9b468d1a3ull, 0x478e5bf1a4489123ull, 0xc68ddd7d3c78f1e3ull, 0xc78fd9752c58b163ull,
+    0x366ceeeae3c68d1bull, 0x376eeae2f3e6cd9bull, 0xb66d6c6e6bd6ad5bull, 0xb76f68667bf6eddbull,
+    0x76ecaf28274e9d3bull, 0x77eeab20376eddbbull, 0xf6ed2dacaf5ebd7bull, 0xf7ef29a4bf7efdfbull,
+    0x162c4e8b0102050bull, 0x172e4a831122458bull, 0x962dcc0f8912254bull, 0x972fc807993265cbull,
+    0x56ac0f49c58a152bull, 0x57ae0b41d5aa55abull, 0xd6ad8dcd4d9a356bull, 0xd7af89c55dba75ebull,
+    0xae5c1682aa55ab57ull, 0xaf5e128aba75ebd7ull, 0x2e5d940622458b17ull, 0x2f5f900e3265cb97ull,
+    0xeedc57406eddbb77ull, 0xefde53487efdfbf7ull, 0x6eddd5c4e6cd9b37ull, 0x6fdfd1ccf6eddbb7ull,
+    0x8e1cb6e348912347ull, 0x8f1eb2eb58b163c7ull, 0x0e1d3467c0810307ull, 0x0f1f306fd0a14387ull,
+    0xce9cf7218c193367ull, 0xcf9ef3299c3973e7ull, 0x4e9d75a504091327ull, 0x4f9f71ad142953a7ull,
+    0xbe7c4632dbb76fdfull, 0xbf7e423acb972f5full, 0x3e7dc4b653a74f9full, 0x3f7fc0be43870f1full,
+    0xfefc07f01f3f7fffull, 0xfffe03f80f1f3f7full, 0x7efd8574972f5fbfull, 0x7fff817c870f1f3full,
+    0x9e3ce6533973e7cfull, 0x9f3ee25b2953a74full, 0x1e3d64d7b163c78full, 0x1f3f60dfa143870full,
+    0xdebca791fdfbf7efull, 0xdfbea399eddbb76full, 0x5ebd251575ebd7afull, 0x5fbf211d65cb972full,
+};
 }  // namespace td
@@ -144,6 +144,7 @@ class Octet {
 
   static const uint8 OctMulLo[256][16];
   static const uint8 OctMulHi[256][16];
+  static const uint64 OctMulAffine[256];
 
  private:
   uint8 data_;
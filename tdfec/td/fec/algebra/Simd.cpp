@@ -0,0 +1,149 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/fec/algebra/Simd.h"
+
+#if TD_SIMD_DISPATCH
+#include <cpuid.h>
+#endif
+
+namespace td {
+namespace {
+SimdCpuFeatures detect_simd_cpu_features() {
+  SimdCpuFeatures res;
+#if TD_SIMD_DISPATCH
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return res;
+  }
+  res.ssse3 = (ecx & bit_SSSE3) != 0;
+  bool osxsave = (ecx & bit_OSXSAVE) != 0;
+  bool avx = (ecx & bit_AVX) != 0;
+  if (!osxsave || !avx) {
+    return res;
+  }
+
+  // the OS must save ymm (and zmm) registers on context switch
+  unsigned xcr0_lo, xcr0_hi;
+  __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  bool ymm_enabled = (xcr0_lo & 0x06) == 0x06;
+  bool zmm_enabled = (xcr0_lo & 0xe6) == 0xe6;
+
+  if (__get_cpuid_max(0, nullptr) < 7) {
+    return res;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  res.avx2 = ymm_enabled && (ebx & (1u << 5)) != 0;
+  res.avx512bw = res.avx2 && zmm_enabled && (ebx & (1u << 16)) != 0 && (ebx & (1u << 30)) != 0;
+  res.gfni = (ecx & (1u << 8)) != 0;
+#else
+#if TD_SSE3
+  res.ssse3 = true;
+#endif
+#if TD_AVX2
+  res.avx2 = true;
+#endif
+#endif
+  return res;
+}
+
+template <class SimdT>
+constexpr Simd::Kernels make_kernels(Simd::Kernel kernel, const char *name) {
+  return Simd::Kernels{kernel,
+                       name,
+                       &SimdT::gf256_add,
+                       &SimdT::gf256_mul,
+                       &SimdT::gf256_add_mul,
+                       &SimdT::gf256_from_gf2};
+}
+
+const Simd::Kernels null_kernels = make_kernels<Simd_null>(Simd::Kernel::Null, "Without simd");
+#if TD_SSE3
+const Simd::Kernels sse_kernels = make_kernels<Simd_sse>(Simd::Kernel::Sse, "With SSE");
+#endif
+#if TD_AVX2
+const Simd::Kernels avx_kernels = make_kernels<Simd_avx>(Simd::Kernel::Avx, "With AVX");
+#endif
+#if TD_AVX512
+const Simd::Kernels avx512_kernels = make_kernels<Simd_avx512>(Simd::Kernel::Avx512, "With AVX-512");
+#endif
+#if TD_GFNI
+const Simd::Kernels gfni_kernels = make_kernels<Simd_gfni>(Simd::Kernel::Gfni, "With GFNI");
+#endif
+
+const Simd::Kernels *get_kernels(Simd::Kernel kernel) {
+  switch (kernel) {
+    case Simd::Kernel::Null:
+      return &null_kernels;
+#if TD_SSE3
+    case Simd::Kernel::Sse:
+      return Simd_sse::is_supported() ? &sse_kernels : nullptr;
+#endif
+#if TD_AVX2
+    case Simd::Kernel::Avx:
+      return Simd_avx::is_supported() ? &avx_kernels : nullptr;
+#endif
+#if TD_AVX512
+    case Simd::Kernel::Avx512:
+      return Simd_avx512::is_supported() ? &avx512_kernels : nullptr;
+#endif
+#if TD_GFNI
+    case Simd::Kernel::Gfni:
+      return Simd_gfni::is_supported() ? &gfni_kernels : nullptr;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+const Simd::Kernels *get_best_kernels() {
+  for (auto kernel : {Simd::Kernel::Gfni, Simd::Kernel::Avx512, Simd::Kernel::Avx, Simd::Kernel::Sse}) {
+    auto res = get_kernels(kernel);
+    if (res) {
+      return res;
+    }
+  }
+  return &null_kernels;
+}
+}  // namespace
+
+const SimdCpuFeatures &get_simd_cpu_features() {
+  static const SimdCpuFeatures features = detect_simd_cpu_features();
+  return features;
+}
+
+// Simd may be used before dynamic initialization of this file, so start with the portable kernel
+const Simd::Kernels *Simd::kernels_ = &null_kernels;
+
+namespace {
+const bool simd_kernels_selected = [] {
+  Simd::set_kernel(get_best_kernels()->kernel);
+  return true;
+}();
+}  // namespace
+
+bool Simd::is_supported(Kernel kernel) {
+  return get_kernels(kernel) != nullptr;
+}
+
+void Simd::set_kernel(Kernel kernel) {
+  auto kernels = get_kernels(kernel);
+  CHECK(kernels != nullptr);
+  kernels_ = kernels;
+}
+}  // namespace td
@@ -21,24 +21,50 @@
 
 #include "td/fec/algebra/Octet.h"
 
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+// all x86 kernels are compiled with target attributes and chosen at runtime according to cpuid
+#define TD_SIMD_DISPATCH 1
+#define TD_SIMD_TARGET(features) __attribute__((target(features)))
+#define TD_SSE3 1
+#define TD_AVX2 1
+#if (defined(__clang__) && __clang_major__ >= 7) || (!defined(__clang__) && __GNUC__ >= 8)
+#define TD_AVX512 1
+#define TD_GFNI 1
+#endif
+#include <immintrin.h>
+#else
+#define TD_SIMD_TARGET(features)
 #if __SSSE3__
 #define TD_SSE3 1
 #endif
-
 #if __AVX2__
 #define TD_AVX2 1
 #define TD_SSE3 1
 #endif
-
 #if TD_AVX2
 #include <immintrin.h> /* avx2 */
 #elif TD_SSE3
 #include <tmmintrin.h> /* ssse3 */
 #endif
+#endif
 
 namespace td {
+struct SimdCpuFeatures {
+  bool ssse3{false};
+  bool avx2{false};
+  bool avx512bw{false};
+  bool gfni{false};
+};
+const SimdCpuFeatures &get_simd_cpu_features();
+
 class Simd_null {
  public:
+  static bool is_supported() {
+    return true;
+  }
+
   static constexpr size_t alignment() {
     return 32;  // gf256_from_gf2 relies on 32 alignment
   }
@@ -98,12 +124,15 @@ class Simd_sse : public Simd_null {
   static std::string get_name() {
     return "With SSE";
   }
+  static bool is_supported() {
+    return get_simd_cpu_features().ssse3;
+  }
 
   static bool is_aligned_pointer(const void *ptr) {
     return ::td::is_aligned_pointer<alignment()>(ptr);
   }
 
-  static void gf256_add(void *a, const void *b, size_t size) {
+  static TD_SIMD_TARGET("ssse3") void gf256_add(void *a, const void *b, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(is_aligned_pointer(b));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
@@ -116,7 +145,7 @@ class Simd_sse : public Simd_null {
       bp128++;
     }
   }
-  static void gf256_mul(void *a, uint8 u, size_t size) {
+  static TD_SIMD_TARGET("ssse3") void gf256_mul(void *a, uint8 u, size_t size) {
     DCHECK(is_aligned_pointer(a));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
 
@@ -137,7 +166,7 @@ class Simd_sse : public Simd_null {
       ap128++;
     }
   }
-  static void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  static TD_SIMD_TARGET("ssse3") void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(is_aligned_pointer(b));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
@@ -164,14 +193,17 @@ class Simd_sse : public Simd_null {
 };
 #endif  // SSSE3
 
-#ifdef TD_AVX2
+#if TD_AVX2
 class Simd_avx : public Simd_sse {
  public:
   static std::string get_name() {
     return "With AVX";
   }
+  static bool is_supported() {
+    return get_simd_cpu_features().avx2;
+  }
 
-  static void gf256_add(void *a, const void *b, size_t size) {
+  static TD_SIMD_TARGET("avx2") void gf256_add(void *a, const void *b, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(is_aligned_pointer(b));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
@@ -185,7 +217,7 @@ class Simd_avx : public Simd_sse {
     }
   }
 
-  static __m256i get_mask(const uint32 mask) {
+  static TD_SIMD_TARGET("avx2") __m256i get_mask(const uint32 mask) {
     // abcd -> abcd * 8
     __m256i vmask(_mm256_set1_epi32(mask));
 
@@ -199,7 +231,7 @@ class Simd_avx : public Simd_sse {
     return _mm256_and_si256(_mm256_cmpeq_epi8(vmask, _mm256_set1_epi64x(-1)), _mm256_set1_epi8(1));
   }
 
-  static void gf256_from_gf2(void *a, const void *b, size_t size) {
+  static TD_SIMD_TARGET("avx2") void gf256_from_gf2(void *a, const void *b, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(size % 4 == 0);
     __m256i *ap256 = reinterpret_cast<__m256i *>(a);
@@ -210,7 +242,7 @@ class Simd_avx : public Simd_sse {
     }
   }
 
-  static __attribute__((noinline)) void gf256_mul(void *a, uint8 u, size_t size) {
+  static TD_SIMD_TARGET("avx2") __attribute__((noinline)) void gf256_mul(void *a, uint8 u, size_t size) {
     const __m128i urow_hi_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u]));
     const __m256i urow_hi = _mm256_broadcastsi128_si256(urow_hi_small);
     const __m128i urow_lo_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u]));
@@ -231,7 +263,7 @@ class Simd_avx : public Simd_sse {
     }
   }
 
-  static __attribute__((noinline)) void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  static TD_SIMD_TARGET("avx2") __attribute__((noinline)) void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
     const __m128i urow_hi_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u]));
     const __m256i urow_hi = _mm256_broadcastsi128_si256(urow_hi_small);
     const __m128i urow_lo_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u]));
@@ -255,12 +287,187 @@ class Simd_avx : public Simd_sse {
 };
 #endif  // AVX2
 
-#if TD_AVX2
-using Simd = Simd_avx;
-#elif TD_SSE3
-using Simd = Simd_sse;
-#else
-using Simd = Simd_null;
-#endif
+#if TD_AVX512
+class Simd_avx512 : public Simd_avx {
+ public:
+  static std::string get_name() {
+    return "With AVX-512";
+  }
+  static bool is_supported() {
+    return get_simd_cpu_features().avx512bw;
+  }
+
+  // sizes are multiples of 32, so the last 32 bytes may be processed by the AVX2 kernel
+
+  static TD_SIMD_TARGET("avx512f,avx512bw") void gf256_add(void *a, const void *b, size_t size) {
+    DCHECK(is_aligned_pointer(a));
+    DCHECK(is_aligned_pointer(b));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), _mm512_loadu_si512(bp + idx)));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_add(ap + idx, bp + idx, size - idx);
+    }
+  }
+
+  static TD_SIMD_TARGET("avx512f,avx512bw") void gf256_from_gf2(void *a, const void *b, size_t size) {
+    DCHECK(is_aligned_pointer(a));
+    DCHECK(size % 4 == 0);
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+    const __m512i one = _mm512_set1_epi8(1);
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8, ap += 64) {
+      uint64 mask;
+      std::memcpy(&mask, bp + idx, 8);
+      _mm512_storeu_si512(ap, _mm512_maskz_mov_epi8(mask, one));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_from_gf2(ap, bp + idx, size - idx);
+    }
+  }
+
+  // Unmasked _mm512_broadcast_i32x4 and _mm512_srli_epi64 merge into _mm512_undefined_epi32(), which GCC reports
+  // as an uninitialized use; the zero-masking variants with a full mask compute the same values without it
+  static TD_SIMD_TARGET("avx512f") __m512i broadcast_row(const uint8 *row) {
+    return _mm512_maskz_broadcast_i32x4(0xffff, _mm_loadu_si128(reinterpret_cast<const __m128i *>(row)));
+  }
+  static TD_SIMD_TARGET("avx512f") __m512i high_nibbles(__m512i x, __m512i mask) {
+    return _mm512_and_si512(_mm512_maskz_srli_epi64(0xff, x, 4), mask);
+  }
+
+  static TD_SIMD_TARGET("avx512f,avx512bw") void gf256_mul(void *a, uint8 u, size_t size) {
+    const __m512i urow_hi = broadcast_row(Octet::OctMulHi[u]);
+    const __m512i urow_lo = broadcast_row(Octet::OctMulLo[u]);
+    const __m512i mask = _mm512_set1_epi8(0x0f);
+
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      __m512i ax = _mm512_loadu_si512(ap + idx);
+      __m512i lo = _mm512_and_si512(ax, mask);
+      __m512i hi = high_nibbles(ax, mask);
+      lo = _mm512_shuffle_epi8(urow_lo, lo);
+      hi = _mm512_shuffle_epi8(urow_hi, hi);
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(lo, hi));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_mul(ap + idx, u, size - idx);
+    }
+  }
+
+  static TD_SIMD_TARGET("avx512f,avx512bw") void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+    const __m512i urow_hi = broadcast_row(Octet::OctMulHi[u]);
+    const __m512i urow_lo = broadcast_row(Octet::OctMulLo[u]);
+    const __m512i mask = _mm512_set1_epi8(0x0f);
+
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      __m512i bx = _mm512_loadu_si512(bp + idx);
+      __m512i lo = _mm512_and_si512(bx, mask);
+      __m512i hi = high_nibbles(bx, mask);
+      lo = _mm512_shuffle_epi8(urow_lo, lo);
+      hi = _mm512_shuffle_epi8(urow_hi, hi);
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), _mm512_xor_si512(lo, hi)));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_add_mul(ap + idx, bp + idx, u, size - idx);
+    }
+  }
+};
+#endif  // AVX512
+
+#if TD_GFNI
+// RaptorQ uses the 0x11D polynomial, while gf2p8mulb is hardwired to 0x11B,
+// so multiplication by a constant is done with gf2p8affineqb and a precalculated bit matrix
+class Simd_gfni : public Simd_avx512 {
+ public:
+  static std::string get_name() {
+    return "With GFNI";
+  }
+  static bool is_supported() {
+    return get_simd_cpu_features().avx512bw && get_simd_cpu_features().gfni;
+  }
+
+  static TD_SIMD_TARGET("avx512f,avx512bw,gfni") void gf256_mul(void *a, uint8 u, size_t size) {
+    const __m512i matrix = _mm512_set1_epi64(static_cast<int64>(Octet::OctMulAffine[u]));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      _mm512_storeu_si512(ap + idx, _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(ap + idx), matrix, 0));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_mul(ap + idx, u, size - idx);
+    }
+  }
+
+  static TD_SIMD_TARGET("avx512f,avx512bw,gfni") void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+    const __m512i matrix = _mm512_set1_epi64(static_cast<int64>(Octet::OctMulAffine[u]));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      __m512i bx = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(bp + idx), matrix, 0);
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), bx));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_add_mul(ap + idx, bp + idx, u, size - idx);
+    }
+  }
+};
+#endif  // GFNI
+
+// Chooses the best kernel supported by the CPU at runtime
+class Simd {
+ public:
+  enum class Kernel : int32 { Null, Sse, Avx, Avx512, Gfni };
+
+  static constexpr size_t alignment() {
+    return Simd_null::alignment();
+  }
+  static bool is_aligned_pointer(const void *ptr) {
+    return ::td::is_aligned_pointer<alignment()>(ptr);
+  }
+
+  static std::string get_name() {
+    return kernels_->name;
+  }
+  static bool is_supported(Kernel kernel);
+  static Kernel get_kernel() {
+    return kernels_->kernel;
+  }
+  // Must not be called concurrently with any other operations. Intended for tests and benchmarks.
+  static void set_kernel(Kernel kernel);
+
+  static void gf256_add(void *a, const void *b, size_t size) {
+    kernels_->gf256_add(a, b, size);
+  }
+  static void gf256_mul(void *a, uint8 u, size_t size) {
+    kernels_->gf256_mul(a, u, size);
+  }
+  static void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+    kernels_->gf256_add_mul(a, b, u, size);
+  }
+  static void gf256_from_gf2(void *a, const void *b, size_t size) {
+    kernels_->gf256_from_gf2(a, b, size);
+  }
+
+  struct Kernels {
+    Kernel kernel;
+    const char *name;
+    void (*gf256_add)(void *a, const void *b, size_t size);
+    void (*gf256_mul)(void *a, uint8 u, size_t size);
+    void (*gf256_add_mul)(void *a, const void *b, uint8 u, size_t size);
+    void (*gf256_from_gf2)(void *a, const void *b, size_t size);
+  };
+
+ private:
+  static const Kernels *kernels_;
+};
 
 }  // namespace td
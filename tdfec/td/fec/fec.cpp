@@ -129,7 +129,7 @@ std::unique_ptr<RaptorQDecoder> RaptorQDecoder::create(RaptorQEncoder::Parameter
   p.symbol_size = parameters.symbol_size;
   p.data_size = parameters.data_size;
   p.symbols_count = parameters.symbols_count;
-  return std::make_unique<RaptorQDecoder>(raptorq::Decoder::create(p).move_as_ok());
+  return std::make_unique<RaptorQDecoder>(raptorq::Decoder::create(p).move_as_ok(), parameters.symbols_count);
 }
 
 bool RaptorQDecoder::may_try_decode() const {
@@ -147,7 +147,14 @@ Result<DataWithEncoder> RaptorQDecoder::try_decode(bool need_encoder) {
 Status RaptorQDecoder::add_symbol(Symbol symbol) {
   return decoder_->add_symbol({symbol.id, symbol.data.as_slice()});
 }
-RaptorQDecoder::RaptorQDecoder(std::unique_ptr<raptorq::Decoder> decoder) : decoder_(std::move(decoder)) {
+
+void RaptorQDecoder::set_online() {
+  // every symbol after the first K - lookahead ones costs a pass over the intermediate symbols
+  decoder_->set_online(td::min(symbols_count_ / 10 + 1, static_cast<size_t>(16)));
+}
+
+RaptorQDecoder::RaptorQDecoder(std::unique_ptr<raptorq::Decoder> decoder, size_t symbols_count)
+    : decoder_(std::move(decoder)), symbols_count_(symbols_count) {
 }
 RaptorQDecoder::~RaptorQDecoder() = default;
 
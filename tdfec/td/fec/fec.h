@@ -78,6 +78,11 @@ class Decoder {
   virtual bool may_try_decode() const = 0;
   virtual Result<DataWithEncoder> try_decode(bool need_encoder) = 0;
   virtual Status add_symbol(Symbol symbol) = 0;
+
+  // Decodes while symbols arrive, so try_decode after the last symbol is cheap; ignored by codes without such mode.
+  // Must be called before the first symbol is added
+  virtual void set_online() {
+  }
 };
 
 class RoundRobinEncoder : public Encoder {
@@ -149,11 +154,13 @@ class RaptorQDecoder : public Decoder {
   bool may_try_decode() const override;
   Result<DataWithEncoder> try_decode(bool need_encoder) override;
   Status add_symbol(Symbol symbol) override;
-  RaptorQDecoder(std::unique_ptr<raptorq::Decoder> decoder);
+  void set_online() override;
+  RaptorQDecoder(std::unique_ptr<raptorq::Decoder> decoder, size_t symbols_count);
   ~RaptorQDecoder();
 
  private:
   std::unique_ptr<raptorq::Decoder> decoder_;
+  size_t symbols_count_;
   BufferSlice res_;
 };
 
@@ -36,6 +36,12 @@ bool Decoder::may_try_decode() const {
   return may_decode_;
 }
 
+void Decoder::set_online(size_t lookahead) {
+  online_ = true;
+  online_lookahead_ = lookahead;
+  update_may_decode();
+}
+
 Status Decoder::add_symbol(SymbolRef symbol) {
   if (symbol.data.size() != symbol_size_) {
     return Status::Error("Symbol has invalid length");
@@ -44,6 +50,14 @@ Status Decoder::add_symbol(SymbolRef symbol) {
     add_small_symbol(symbol);
     return Status::OK();
   }
+  if (partial_) {
+    auto id = symbol.id + (p_.K_padded - p_.K);
+    if (slow_symbols_set_.insert(id).second) {
+      add_equation(id, symbol.data);
+      update_may_decode();
+    }
+    return Status::OK();
+  }
   if (mask_size_ + slow_symbols_set_.size() >= p_.K + 10) {
     return Status::OK();
   }
@@ -58,10 +72,16 @@ Result<Decoder::DataWithEncoder> Decoder::try_decode(bool need_encoder) {
 
   optional<RawEncoder> raw_encoder;
   if (mask_size_ < p_.K) {
-    flush_symbols();
-    may_decode_ = false;
-    TRY_RESULT(C, Solver::run(p_, symbols_));
-    raw_encoder = RawEncoder(p_, std::move(C));
+    if (partial_) {
+      CHECK(free_count_ == 0);
+      raw_encoder = RawEncoder(p_, std::move(partial_.value().C));
+      partial_ = {};
+    } else {
+      flush_symbols();
+      may_decode_ = false;
+      TRY_RESULT(C, Solver::run(p_, symbols_));
+      raw_encoder = RawEncoder(p_, std::move(C));
+    }
     for (uint32 i = 0; i < p_.K; i++) {
       if (!mask_[i]) {
         (*raw_encoder).gen_symbol(i, data_.as_slice().substr(i * symbol_size_, symbol_size_));
@@ -93,6 +113,9 @@ void Decoder::add_small_symbol(SymbolRef symbol) {
   if (flush_symbols_) {
     symbols_.push_back({symbol.id, slice});
   }
+  if (partial_) {
+    add_equation(symbol.id, slice);
+  }
   update_may_decode();
 }
 
@@ -118,6 +141,13 @@ void Decoder::add_big_symbol(SymbolRef symbol) {
 
 void Decoder::update_may_decode() {
   size_t total_symbols = mask_size_ + slow_symbols_set_.size();
+  if (online_) {
+    if (!partial_ && mask_size_ < p_.K && total_symbols + online_lookahead_ >= p_.K) {
+      start_online_decoding();
+    }
+    may_decode_ = mask_size_ == p_.K || (partial_ && free_count_ == 0);
+    return;
+  }
   if (total_symbols < p_.K) {
     return;
   }
@@ -147,5 +177,60 @@ void Decoder::flush_symbols() {
     }
   }
 }
+
+void Decoder::start_online_decoding() {
+  flush_symbols();
+  partial_ = Solver::run_partial(p_, symbols_);
+  free_count_ = partial_.value().V.cols();
+  equation_ = MatrixGF256(1, symbol_size_);
+  equation_coefs_.resize(free_count_);
+}
+
+// Substitutes the general solution C + V * t into the equation of the new symbol. The result is a linear
+// equation on the free variables t, which is used to express one of them through the others.
+void Decoder::add_equation(uint32 id, Slice data) {
+  if (free_count_ == 0) {
+    return;
+  }
+  auto &C = partial_.value().C;
+  auto &V = partial_.value().V;
+  equation_.row(0).copy_from(data);
+  std::fill(equation_coefs_.begin(), equation_coefs_.begin() + free_count_, Octet(0));
+  p_.encoding_row_for_each(p_.get_encoding_row(id), [&](auto row) {
+    equation_.row_add(0, C.row(row));
+    for (size_t i = 0; i < free_count_; i++) {
+      equation_coefs_[i] += V.get(row, i);
+    }
+  });
+
+  size_t k = 0;
+  while (k < free_count_ && equation_coefs_[k].is_zero()) {
+    k++;
+  }
+  if (k == free_count_) {
+    // linearly dependent symbol
+    return;
+  }
+  auto inv = equation_coefs_[k].inverse();
+  equation_.row_multiply(0, inv);
+  for (size_t i = 0; i < free_count_; i++) {
+    equation_coefs_[i] = equation_coefs_[i] * inv;
+  }
+
+  free_count_--;
+  for (uint32 row = 0; row < C.rows(); row++) {
+    auto v = V.get(row, k);
+    if (!v.is_zero()) {
+      C.row_add_mul(row, equation_.row(0), v);
+      for (size_t i = 0; i <= free_count_; i++) {
+        if (i != k) {
+          V.set(row, i, V.get(row, i) + v * equation_coefs_[i]);
+        }
+      }
+    }
+    // the last free variable takes the place of the eliminated one
+    V.set(row, k, V.get(row, free_count_));
+  }
+}
 }  // namespace raptorq
 }  // namespace td
@@ -39,6 +39,11 @@ class Decoder {
   Result<DataWithEncoder> try_decode(bool need_encoder);
   bool may_try_decode() const;
 
+  // In online mode the system is solved as soon as K - lookahead symbols are received, leaving a few free
+  // variables, and each following symbol eliminates one of them with a single pass over the intermediate
+  // symbols. So most of the work is done while symbols arrive and try_decode after the last one is cheap.
+  void set_online(size_t lookahead);
+
  private:
   Rfc::Parameters p_;
   size_t symbol_size_;
@@ -57,6 +62,13 @@ class Decoder {
   std::set<uint32> slow_symbols_set_;
   std::string zero_symbol_;
 
+  bool online_{false};
+  size_t online_lookahead_{0};
+  optional<Solver::PartialSolution> partial_;
+  size_t free_count_{0};
+  MatrixGF256 equation_{0, 0};
+  std::vector<Octet> equation_coefs_;
+
   void add_small_symbol(SymbolRef symbol);
   void add_big_symbol(SymbolRef symbol);
 
@@ -65,6 +77,9 @@ class Decoder {
   void on_first_slow_path();
 
   void flush_symbols();
+
+  void start_online_decoding();
+  void add_equation(uint32 id, Slice data);
 };
 
 }  // namespace raptorq
@@ -71,7 +71,7 @@ void Encoder::precalc() {
   if (has_precalc()) {
     return;
   }
-  auto r_C = Solver::run(p_, first_symbols_.symbols());
+  auto r_C = Solver::run_precode(p_, first_symbols_.symbols());
   LOG_IF(FATAL, r_C.is_error()) << r_C.error();
   raw_encoder_ = RawEncoder(p_, r_C.move_as_ok());
   has_encoder_ = true;
@@ -21,14 +21,16 @@
 #include "td/fec/algebra/InactivationDecoding.h"
 
 #include "td/utils/Timer.h"
+
 #include <map>
+#include <mutex>
 
 namespace td {
 namespace raptorq {
 
-MatrixGF256 create_D(const Rfc::Parameters &p, Span<SymbolRef> symbols) {
+MatrixGF256 create_D(const Rfc::Parameters &p, Span<SymbolRef> symbols, size_t extra_cols = 0) {
   auto symbol_size = symbols[0].data.size();
-  MatrixGF256 D(p.S + p.H + symbols.size(), symbol_size);
+  MatrixGF256 D(p.S + p.H + symbols.size(), symbol_size + extra_cols);
   D.set_zero();
 
   auto offset = p.S;
@@ -41,35 +43,102 @@ MatrixGF256 create_D(const Rfc::Parameters &p, Span<SymbolRef> symbols) {
   return D;
 }
 
-Result<MatrixGF256> Solver::run(const Rfc::Parameters &p, Span<SymbolRef> symbols) {
-  if (0) {  // turns out gauss is slower even for small symbols count
-    auto encoding_rows = transform(symbols, [&p](auto &symbol) { return p.get_encoding_row(symbol.id); });
-    MatrixGF256 A(p.S + p.H + symbols.size(), p.L);
-    A.set_zero();
-    auto A_upper = p.get_A_upper(encoding_rows);
-    A_upper.block_for_each(0, 0, A_upper.rows(), A_upper.cols(), [&](auto x, auto y) { A.set(x, y, Octet(1)); });
+namespace {
+// Row operations applied to the right-hand side D of A * C = D while A is eliminated.
+// A depends only on ids of the symbols, so the same schedule solves the system for any data.
+struct Schedule {
+  struct GaussOp {
+    uint32 row;
+    uint32 other_row;  // equals row for multiplication
+    uint8 mul;
+  };
 
-    MatrixGF256 tmp(A.cols() - p.H, A.cols() - p.H);
-    tmp.set_zero();
-    for (size_t i = 0; i < tmp.cols(); i++) {
-      tmp.set(i, i, Octet(1));
-    }
-    auto HDCP = p.HDPC_multiply(std::move(tmp));
-    MatrixGF256 HDCP2(p.H, p.L - p.H);
+  uint32 U_size{0};
+  uint32 A_upper_rows{0};
+  std::vector<uint32> row_permutation;
+  std::vector<uint32> col_permutation;
+  // D.row_add(row, i) which make U an identity matrix
+  std::vector<std::pair<uint32, uint32>> triangular_ops;
+  // non-zero elements of G_left
+  std::vector<std::pair<uint32, uint32>> G_left;
+  std::vector<GaussOp> gauss_ops;
+  std::vector<uint32> gauss_row_permutation;
+  // columns of the small system without a pivot and their coefficients in each pivot row
+  std::vector<uint32> free_cols;
+  std::vector<uint8> free_coefs;
+  // C.row_add(row, col) which restore the first U_size rows of C
+  std::vector<std::pair<uint32, uint32>> result_ops;
+
+  size_t memory_usage() const {
+    return sizeof(*this) + (row_permutation.size() + col_permutation.size() + gauss_row_permutation.size()) * 4 +
+           (triangular_ops.size() + G_left.size() + result_ops.size()) * 8 + gauss_ops.size() * sizeof(GaussOp) +
+           free_cols.size() * 4 + free_coefs.size();
+  }
+};
 
-    MatrixGF256 IH(p.H, p.H);
-    IH.set_zero();
-    for (size_t i = 0; i < p.H; i++) {
-      IH.set(i, i, Octet(1));
-    }
+MatrixGF256 HDPC_left_multiply(const Rfc::Parameters &p, Span<uint32> col_permutation, const MatrixGF256 &m) {
+  MatrixGF256 T(p.K_padded + p.S, m.cols());
+  T.set_zero();
+  for (uint32 i = 0; i < m.rows(); i++) {
+    T.row_set(col_permutation[i], m.row(i));
+  }
+  return p.HDPC_multiply(std::move(T));
+}
 
-    A.set_from(HDCP, A_upper.rows(), 0);
-    A.set_from(IH, A_upper.rows(), HDCP.cols());
+// Same as GaussianElimination::run, but only records operations which should be applied to D.
+// If allow_free is set, columns without a pivot become free variables instead of an error.
+Result<std::vector<uint32>> gaussian_elimination(MatrixGF256 A, Schedule &schedule, bool allow_free) {
+  const size_t cols = A.cols();
+  const size_t rows = A.rows();
 
-    auto D = create_D(p, symbols);
-    auto C = GaussianElimination::run(std::move(A), std::move(D));
-    return C;
+  CHECK(allow_free || cols <= rows);
+
+  auto &ops = schedule.gauss_ops;
+  std::vector<uint32> row_perm(rows);
+  for (uint32 i = 0; i < rows; i++) {
+    row_perm[i] = i;
   }
+  size_t row = 0;
+  for (size_t col = 0; col < cols; col++) {
+    size_t non_zero_row = row;
+    for (; non_zero_row < rows && A.get(row_perm[non_zero_row], col).is_zero(); non_zero_row++) {
+    }
+    if (non_zero_row == rows) {
+      if (!allow_free) {
+        return Status::Error("Non solvable");
+      }
+      schedule.free_cols.push_back(narrow_cast<uint32>(col));
+      continue;
+    }
+    if (non_zero_row != row) {
+      std::swap(row_perm[non_zero_row], row_perm[row]);
+    }
+    auto mul = A.get(row_perm[row], col).inverse();
+    A.row_multiply(row_perm[row], mul);
+    ops.push_back({row_perm[row], row_perm[row], mul.value()});
+    CHECK(A.get(row_perm[row], col).value() == 1);
+    for (size_t zero_row = 0; zero_row < rows; zero_row++) {
+      if (zero_row == row) {
+        continue;
+      }
+      auto x = A.get(row_perm[zero_row], col);
+      if (!x.is_zero()) {
+        A.row_add_mul(row_perm[zero_row], row_perm[row], x);
+        ops.push_back({row_perm[zero_row], row_perm[row], x.value()});
+      }
+    }
+    row++;
+  }
+
+  for (size_t i = 0; i < row; i++) {
+    for (auto col : schedule.free_cols) {
+      schedule.free_coefs.push_back(A.get(row_perm[i], col).value());
+    }
+  }
+  return std::move(row_perm);
+}
+
+Result<Schedule> create_schedule(const Rfc::Parameters &p, Span<SymbolRef> symbols, bool allow_free) {
   PerfWarningTimer x("solve");
   Timer timer;
   auto perf_log = [&](Slice message) {
@@ -96,12 +165,14 @@ Result<MatrixGF256> Solver::run(const Rfc::Parameters &p, Span<SymbolRef> symbol
   // +---------------+------+
   // | HDCP          | I_H  |
   // +---------------+------+
-  CHECK(p.K_padded <= symbols.size());
+  //
+  // Only A is processed here, operations on D are recorded into the schedule.
+  CHECK(allow_free || p.K_padded <= symbols.size());
+  Schedule schedule;
   auto encoding_rows = transform(symbols, [&p](auto &symbol) { return p.get_encoding_row(symbol.id); });
 
   // Generate matrix A_upper: sparse part of A, first S + K_padded rows.
   SparseMatrixGF2 A_upper = p.get_A_upper(encoding_rows);
-  auto D = create_D(p, symbols);
   perf_log("Generate sparse matrix");
 
   // Run indactivation decoding.
@@ -109,12 +180,15 @@ Result<MatrixGF256> Solver::run(const Rfc::Parameters &p, Span<SymbolRef> symbol
   auto decoding_result = InactivationDecoding(A_upper, p.P).run();
   perf_log("Inactivation decoding");
   uint32 U_size = decoding_result.size;
+  schedule.U_size = U_size;
 
-  auto row_permutation = std::move(decoding_result.p_rows);
-  while (row_permutation.size() < D.rows()) {
+  auto &row_permutation = schedule.row_permutation;
+  row_permutation = std::move(decoding_result.p_rows);
+  while (row_permutation.size() < p.S + p.H + symbols.size()) {
     row_permutation.push_back(narrow_cast<uint32>(row_permutation.size()));
   }
-  auto col_permutation = std::move(decoding_result.p_cols);
+  auto &col_permutation = schedule.col_permutation;
+  col_permutation = std::move(decoding_result.p_cols);
 
   // +--------+---------+        +---------+
   // | U      | E       |        | D_upper |
@@ -124,16 +198,13 @@ Result<MatrixGF256> Solver::run(const Rfc::Parameters &p, Span<SymbolRef> symbol
   // |HDCP       | I_H  |        |         |
   // +-----------+------+        +---------+
 
-  D = D.apply_row_permutation(row_permutation);
-  perf_log("D: apply permutation");
   A_upper = A_upper.apply_row_permutation(row_permutation).apply_col_permutation(col_permutation);
+  schedule.A_upper_rows = A_upper.rows();
   perf_log("A_upper: apply permutation");
 
   auto E = A_upper.block_dense(0, U_size, U_size, p.L - U_size);
   perf_log("Calc E");
 
-  MatrixGF256 C(A_upper.cols(), D.cols());
-  C.set_from(D.block_view(0, 0, U_size, D.cols()), 0, 0);
   // Make U Identity matrix and calculate E and D_upper.
   for (uint32 i = 0; i < U_size; i++) {
     for (auto row : A_upper.col(i)) {
@@ -144,21 +215,13 @@ Result<MatrixGF256> Solver::run(const Rfc::Parameters &p, Span<SymbolRef> symbol
         break;
       }
       E.row_add(row, i);
-      D.row_add(row, i);  // this is SLOW
+      schedule.triangular_ops.emplace_back(row, i);
     }
   }
   perf_log("Triangular -> Identity");
 
-  auto HDPC_left_multiply = [&](const MatrixGF256 &m) {
-    MatrixGF256 T(p.K_padded + p.S, m.cols());
-    T.set_zero();
-    for (uint32 i = 0; i < m.rows(); i++) {
-      T.row_set(col_permutation[i], m.row(i));
-    }
-    return p.HDPC_multiply(std::move(T));
-  };
-
   SparseMatrixGF2 G_left = A_upper.block_sparse(U_size, 0, A_upper.rows() - U_size, U_size);
+  G_left.generate([&](auto row, auto col) { schedule.G_left.emplace_back(row, col); });
   perf_log("G_left");
 
   // Calculate small_A_upper
@@ -190,55 +253,238 @@ Result<MatrixGF256> Solver::run(const Rfc::Parameters &p, Span<SymbolRef> symbol
   // small_A_lower += HDPC_left * E
   auto t = E.to_gf256();
   perf_log("t");
-  small_A_lower.add(HDPC_left_multiply(std::move(t)));
+  small_A_lower.add(HDPC_left_multiply(p, col_permutation, std::move(t)));
   perf_log("small_A_lower += HDPC_left * E");
 
+  // Combine small_A from small_A_lower and small_A_upper
+  MatrixGF256 small_A(small_A_upper.rows() + small_A_lower.rows(), small_A_upper.cols());
+  small_A.set_from(small_A_upper, 0, 0);
+  small_A.set_from(small_A_lower, small_A_upper.rows(), 0);
+
+  TRY_RESULT_ASSIGN(schedule.gauss_row_permutation, gaussian_elimination(std::move(small_A), schedule, allow_free));
+  perf_log("gauss");
+
+  SparseMatrixGF2 A_upper_t = A_upper.transpose();
+  for (uint32 row = 0; row < U_size; row++) {
+    for (auto col : A_upper_t.col(row)) {
+      if (col == row) {
+        continue;
+      }
+      schedule.result_ops.emplace_back(row, col);
+    }
+  }
+  perf_log("Calc result");
+  return std::move(schedule);
+}
+
+// Returns C with symbol_size + free_cols.size() columns. The last columns hold coefficients of free variables.
+MatrixGF256 apply_schedule(const Rfc::Parameters &p, const Schedule &schedule, Span<SymbolRef> symbols) {
+  auto U_size = schedule.U_size;
+  auto free_count = schedule.free_cols.size();
+  auto D = create_D(p, symbols, free_count);
+  auto symbol_size = D.cols() - free_count;
+  CHECK(D.rows() == schedule.row_permutation.size());
+  D = D.apply_row_permutation(schedule.row_permutation);
+
+  MatrixGF256 C(p.L, D.cols());
+  C.set_from(D.block_view(0, 0, U_size, D.cols()), 0, 0);
+  for (auto &op : schedule.triangular_ops) {
+    D.row_add(op.first, op.second);  // this is SLOW
+  }
+
   MatrixGF256 D_upper(U_size, D.cols());
   D_upper.set_from(D.block_view(0, 0, D_upper.rows(), D_upper.cols()), 0, 0);
 
-  // small_D_upper
-  MatrixGF256 small_D_upper(A_upper.rows() - U_size, D.cols());
+  // small_D_upper += G_left * D_upper
+  MatrixGF256 small_D_upper(schedule.A_upper_rows - U_size, D.cols());
   small_D_upper.set_from(D.block_view(U_size, 0, small_D_upper.rows(), small_D_upper.cols()), 0, 0);
-  small_D_upper.add(G_left * D_upper);
-  perf_log("small_D_upper");
+  for (auto &op : schedule.G_left) {
+    small_D_upper.row_add(op.first, D_upper.row(op.second));
+  }
 
-  // small_D_lower
+  // small_D_lower += HDPC_left * D_upper
   MatrixGF256 small_D_lower(p.H, D.cols());
-  small_D_lower.set_from(D.block_view(A_upper.rows(), 0, small_D_lower.rows(), small_D_lower.cols()), 0, 0);
-  perf_log("small_D_lower");
-
-  small_D_lower.add(HDPC_left_multiply(D_upper));
-  perf_log("small_D_lower += HDPC_left * D_upper");
-
-  // Combine small_A from small_A_lower and small_A_upper
-  MatrixGF256 small_A(small_A_upper.rows() + small_A_lower.rows(), small_A_upper.cols());
-  small_A.set_from(small_A_upper, 0, 0);
-  small_A.set_from(small_A_lower, small_A_upper.rows(), 0);
+  small_D_lower.set_from(D.block_view(schedule.A_upper_rows, 0, small_D_lower.rows(), small_D_lower.cols()), 0, 0);
+  small_D_lower.add(HDPC_left_multiply(p, schedule.col_permutation, D_upper));
 
   // Combine small_D from small_D_lower and small_D_upper
   MatrixGF256 small_D(small_D_upper.rows() + small_D_lower.rows(), small_D_upper.cols());
   small_D.set_from(small_D_upper, 0, 0);
   small_D.set_from(small_D_lower, small_D_upper.rows(), 0);
 
-  TRY_RESULT(small_C, GaussianElimination::run(std::move(small_A), std::move(small_D)));
-  perf_log("gauss");
+  for (auto &op : schedule.gauss_ops) {
+    if (op.row == op.other_row) {
+      small_D.row_multiply(op.row, Octet(op.mul));
+    } else {
+      small_D.row_add_mul(op.row, op.other_row, Octet(op.mul));
+    }
+  }
+  MatrixGF256 small_C(p.L - U_size, D.cols());
+  small_C.set_zero();
+  size_t pivot = 0;
+  size_t free_i = 0;
+  for (uint32 col = 0; col < small_C.rows(); col++) {
+    if (free_i < free_count && schedule.free_cols[free_i] == col) {
+      small_C.set(col, symbol_size + free_i, Octet(1));
+      free_i++;
+      continue;
+    }
+    small_C.row_set(col, small_D.row(schedule.gauss_row_permutation[pivot]));
+    for (size_t i = 0; i < free_count; i++) {
+      small_C.set(col, symbol_size + i, Octet(schedule.free_coefs[pivot * free_count + i]));
+    }
+    pivot++;
+  }
 
   C.set_from(small_C.block_view(0, 0, C.rows() - U_size, C.cols()), U_size, 0);
+  for (auto &op : schedule.result_ops) {
+    C.row_add(op.first, op.second);
+  }
+  return C.apply_row_permutation(inverse_permutation(schedule.col_permutation));
+}
 
-  SparseMatrixGF2 A_upper_t = A_upper.transpose();
-  for (uint32 row = 0; row < U_size; row++) {
-    for (auto col : A_upper_t.col(row)) {
-      if (col == row) {
-        continue;
+// Process-wide cache of schedules for the first K' symbols. Evicts least recently used schedules
+// when their total size exceeds the limit.
+class ScheduleCache {
+ public:
+  std::shared_ptr<const Schedule> get(uint32 K_padded) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = entries_.find(K_padded);
+    if (it == entries_.end()) {
+      misses_++;
+      return nullptr;
+    }
+    hits_++;
+    it->second.last_used = ++generation_;
+    return it->second.schedule;
+  }
+
+  void add(uint32 K_padded, std::shared_ptr<const Schedule> schedule) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto &entry = entries_[K_padded];
+    if (entry.schedule) {
+      return;
+    }
+    memory_ += schedule->memory_usage();
+    entry.schedule = std::move(schedule);
+    entry.last_used = ++generation_;
+    while (memory_ > MAX_MEMORY && entries_.size() > 1) {
+      auto oldest = entries_.begin();
+      for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second.last_used < oldest->second.last_used) {
+          oldest = it;
+        }
       }
-      C.row_add(row, col);
+      memory_ -= oldest->second.schedule->memory_usage();
+      entries_.erase(oldest);
     }
   }
-  perf_log("Calc result");
 
-  auto res = C.apply_row_permutation(inverse_permutation(col_permutation));
-  perf_log("Apply permutation");
-  return std::move(res);
+  Solver::PrecodeCacheStats get_stats() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    Solver::PrecodeCacheStats res;
+    res.hits = hits_;
+    res.misses = misses_;
+    res.entries = entries_.size();
+    res.memory = memory_;
+    return res;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    entries_.clear();
+    memory_ = 0;
+  }
+
+ private:
+  static constexpr size_t MAX_MEMORY = 256 << 20;
+
+  struct Entry {
+    std::shared_ptr<const Schedule> schedule;
+    uint64 last_used{0};
+  };
+  std::mutex mutex_;
+  std::map<uint32, Entry> entries_;
+  uint64 generation_{0};
+  size_t memory_{0};
+  uint64 hits_{0};
+  uint64 misses_{0};
+};
+
+ScheduleCache &get_schedule_cache() {
+  static ScheduleCache cache;
+  return cache;
+}
+}  // namespace
+
+Result<MatrixGF256> Solver::run(const Rfc::Parameters &p, Span<SymbolRef> symbols) {
+  if (0) {  // turns out gauss is slower even for small symbols count
+    auto encoding_rows = transform(symbols, [&p](auto &symbol) { return p.get_encoding_row(symbol.id); });
+    MatrixGF256 A(p.S + p.H + symbols.size(), p.L);
+    A.set_zero();
+    auto A_upper = p.get_A_upper(encoding_rows);
+    A_upper.block_for_each(0, 0, A_upper.rows(), A_upper.cols(), [&](auto x, auto y) { A.set(x, y, Octet(1)); });
+
+    MatrixGF256 tmp(A.cols() - p.H, A.cols() - p.H);
+    tmp.set_zero();
+    for (size_t i = 0; i < tmp.cols(); i++) {
+      tmp.set(i, i, Octet(1));
+    }
+    auto HDCP = p.HDPC_multiply(std::move(tmp));
+    MatrixGF256 HDCP2(p.H, p.L - p.H);
+
+    MatrixGF256 IH(p.H, p.H);
+    IH.set_zero();
+    for (size_t i = 0; i < p.H; i++) {
+      IH.set(i, i, Octet(1));
+    }
+
+    A.set_from(HDCP, A_upper.rows(), 0);
+    A.set_from(IH, A_upper.rows(), HDCP.cols());
+
+    auto D = create_D(p, symbols);
+    auto C = GaussianElimination::run(std::move(A), std::move(D));
+    return C;
+  }
+  TRY_RESULT(schedule, create_schedule(p, symbols, false));
+  return apply_schedule(p, schedule, symbols);
+}
+
+Solver::PartialSolution Solver::run_partial(const Rfc::Parameters &p, Span<SymbolRef> symbols) {
+  auto schedule = create_schedule(p, symbols, true).move_as_ok();
+  auto free_count = schedule.free_cols.size();
+  auto C = apply_schedule(p, schedule, symbols);
+  auto symbol_size = C.cols() - free_count;
+
+  PartialSolution res{MatrixGF256(C.rows(), symbol_size), MatrixGF256(C.rows(), free_count)};
+  for (uint32 row = 0; row < C.rows(); row++) {
+    res.C.row(row).copy_from(C.row(row).truncate(symbol_size));
+    res.V.row(row).copy_from(C.row(row).substr(symbol_size));
+  }
+  return res;
+}
+
+Result<MatrixGF256> Solver::run_precode(const Rfc::Parameters &p, Span<SymbolRef> symbols) {
+  CHECK(symbols.size() == p.K_padded);
+  for (uint32 i = 0; i < symbols.size(); i++) {
+    DCHECK(symbols[i].id == i);
+  }
+  auto &cache = get_schedule_cache();
+  auto schedule = cache.get(p.K_padded);
+  if (!schedule) {
+    TRY_RESULT(new_schedule, create_schedule(p, symbols, false));
+    schedule = std::make_shared<const Schedule>(std::move(new_schedule));
+    cache.add(p.K_padded, schedule);
+  }
+  return apply_schedule(p, *schedule, symbols);
+}
+
+Solver::PrecodeCacheStats Solver::get_precode_cache_stats() {
+  return get_schedule_cache().get_stats();
+}
+
+void Solver::clear_precode_cache() {
+  get_schedule_cache().clear();
 }
 }  // namespace raptorq
 }  // namespace td
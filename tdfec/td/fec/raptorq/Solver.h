@@ -29,6 +29,27 @@ namespace raptorq {
 class Solver {
  public:
   static Result<MatrixGF256> run(const Rfc::Parameters &p, Span<SymbolRef> symbols);
+
+  // Solves the system for the first K' source symbols. Elimination of the constraint matrix
+  // depends only on K', so it is done once per K' and is shared by all encoders in the process.
+  static Result<MatrixGF256> run_precode(const Rfc::Parameters &p, Span<SymbolRef> symbols);
+
+  // Solves the system which may have fewer independent rows than unknowns. The general solution is
+  // C + V * t, where t is a vector of arbitrary free symbols; V has one column per free variable.
+  struct PartialSolution {
+    MatrixGF256 C;
+    MatrixGF256 V;
+  };
+  static PartialSolution run_partial(const Rfc::Parameters &p, Span<SymbolRef> symbols);
+
+  struct PrecodeCacheStats {
+    uint64 hits{0};
+    uint64 misses{0};
+    size_t entries{0};
+    size_t memory{0};
+  };
+  static PrecodeCacheStats get_precode_cache_stats();
+  static void clear_precode_cache();
 };
 
 }  // namespace raptorq
@@ -21,6 +21,8 @@
 #include "td/fec/fec.h"
 #include "td/fec/raptorq/Encoder.h"
 #include "td/fec/raptorq/Decoder.h"
+#include "td/fec/raptorq/Solver.h"
+#include "td/fec/common/SymbolsView.h"
 #if USE_LIBRAPTORQ
 #include "LibRaptorQ.h"
 #endif
@@ -91,10 +93,24 @@ TEST(Fec, Simd) {
     };
     run(td::Simd_null());
 #if TD_SSE3
-    run(td::Simd_sse());
+    if (td::Simd_sse::is_supported()) {
+      run(td::Simd_sse());
+    }
 #endif
 #if TD_AVX2
-    run(td::Simd_avx());
+    if (td::Simd_avx::is_supported()) {
+      run(td::Simd_avx());
+    }
+#endif
+#if TD_AVX512
+    if (td::Simd_avx512::is_supported()) {
+      run(td::Simd_avx512());
+    }
+#endif
+#if TD_GFNI
+    if (td::Simd_gfni::is_supported()) {
+      run(td::Simd_gfni());
+    }
 #endif
     run(td::Simd());
   }
@@ -167,6 +183,86 @@ TEST(Fec, RaptorQRandomSymbols) {
   UNREACHABLE();
 }
 
+TEST(Fec, RaptorQOnlineDecoder) {
+  for (td::uint32 K : {10, 100, 1000}) {
+    const size_t symbol_size = 64;
+    auto data = td::rand_string('a', 'z', td::narrow_cast<int>(K * symbol_size - 7));
+    auto encoder = td::raptorq::Encoder::create(symbol_size, td::BufferSlice(data)).move_as_ok();
+    encoder->precalc();
+
+    auto parameters = encoder->get_parameters();
+    auto decoder = td::raptorq::Decoder::create(parameters).move_as_ok();
+    decoder->set_online(K / 10 + 1);
+    std::string symbol(symbol_size, '\0');
+    bool ok = false;
+    for (size_t i = 0; i < K + 100 && !ok; i++) {
+      auto id = td::Random::fast(0, 1) == 0 ? td::narrow_cast<td::uint32>(i) : td::Random::fast_uint32();
+      encoder->gen_symbol(id, symbol);
+      decoder->add_symbol({id, td::Slice(symbol)});
+      if (decoder->may_try_decode()) {
+        auto r = decoder->try_decode(false);
+        ASSERT_TRUE(r.is_ok());
+        ASSERT_EQ(r.ok().data, data);
+        ok = true;
+      }
+    }
+    ASSERT_TRUE(ok);
+  }
+}
+
+TEST(Fec, RaptorQDecoderSetOnline) {
+  // the generic decoder interface, as used by rldp and overlay broadcasts, with a third of the symbols lost
+  for (td::uint32 K : {1, 10, 100, 1000}) {
+    const size_t symbol_size = 64;
+    auto data = td::rand_string('a', 'z', td::narrow_cast<int>(K * symbol_size - (K > 1 ? 7 : 0)));
+    auto encoder = td::fec::RaptorQEncoder::create(td::BufferSlice(data), symbol_size);
+    auto parameters = encoder->get_parameters();
+    ASSERT_EQ(K, parameters.symbols_count);
+    std::unique_ptr<td::fec::Decoder> decoder = td::fec::RaptorQDecoder::create(parameters);
+    decoder->set_online();
+    bool ok = false;
+    for (td::uint32 id = 0; id < 2 * K + 100 && !ok; id++) {
+      if (id % 3 == 1) {
+        continue;
+      }
+      if (encoder->get_info().ready_symbol_count <= id) {
+        encoder->prepare_more_symbols();
+      }
+      decoder->add_symbol(encoder->gen_symbol(id)).ensure();
+      if (decoder->may_try_decode()) {
+        auto r = decoder->try_decode(false);
+        ASSERT_TRUE(r.is_ok());
+        ASSERT_EQ(r.ok().data.as_slice(), data);
+        ok = true;
+      }
+    }
+    ASSERT_TRUE(ok);
+  }
+}
+
+TEST(Fec, RaptorQPrecodeCache) {
+  td::raptorq::Solver::clear_precode_cache();
+  auto stats = td::raptorq::Solver::get_precode_cache_stats();
+  const size_t symbol_size = 64;
+  for (td::uint32 K : {10, 100, 1000}) {
+    auto p = td::raptorq::Rfc::get_parameters(K).move_as_ok();
+    for (int i = 0; i < 3; i++) {
+      auto data = td::rand_string('a', 'z', td::narrow_cast<int>(K * symbol_size));
+      td::raptorq::SymbolsView view(p.K_padded, symbol_size, data);
+      auto expected = td::raptorq::Solver::run(p, view.symbols()).move_as_ok();
+      auto C = td::raptorq::Solver::run_precode(p, view.symbols()).move_as_ok();
+      ASSERT_EQ(expected.rows(), C.rows());
+      for (size_t row = 0; row < C.rows(); row++) {
+        ASSERT_EQ(expected.row(row), C.row(row));
+      }
+    }
+  }
+  auto new_stats = td::raptorq::Solver::get_precode_cache_stats();
+  ASSERT_EQ(3u, new_stats.misses - stats.misses);
+  ASSERT_EQ(6u, new_stats.hits - stats.hits);
+  ASSERT_EQ(3u, new_stats.entries);
+}
+
 template <class Encoder, class Decoder>
 void fec_test(td::Slice data, size_t max_symbol_size) {
   LOG(ERROR) << "!";
@@ -22,6 +22,8 @@ char disable_linker_warning_about_empty_file_gzip_cpp TD_UNUSED;
 
 #if TD_HAVE_ZLIB
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/ScopeGuard.h"
 
 #include <cstring>
 #include <limits>
@@ -216,5 +218,71 @@ BufferSlice gzencode(Slice s, double max_compression_ratio) {
   return message.as_buffer_slice();
 }
 
+BufferSlice deflate_with_dictionary(Slice s, Slice dictionary, int level, double max_compression_ratio) {
+  CHECK(s.size() <= std::numeric_limits<uInt>::max());
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return BufferSlice();
+  }
+  SCOPE_EXIT {
+    deflateEnd(&stream);
+  };
+  if (!dictionary.empty()) {
+    if (dictionary.size() > (1u << MAX_WBITS)) {
+      dictionary = dictionary.substr(dictionary.size() - (1u << MAX_WBITS));
+    }
+    auto ret = deflateSetDictionary(&stream, dictionary.ubegin(), narrow_cast<uInt>(dictionary.size()));
+    if (ret != Z_OK) {
+      return BufferSlice();
+    }
+  }
+
+  size_t max_size = static_cast<size_t>(static_cast<double>(s.size()) * max_compression_ratio);
+  BufferSlice res{max_size};
+  stream.next_in = const_cast<Bytef *>(s.ubegin());
+  stream.avail_in = static_cast<uInt>(s.size());
+  stream.next_out = res.as_slice().ubegin();
+  stream.avail_out = narrow_cast<uInt>(max_size);
+  if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+    return BufferSlice();
+  }
+  res.truncate(stream.total_out);
+  return res;
+}
+
+Result<BufferSlice> inflate_with_dictionary(Slice s, Slice dictionary, size_t size) {
+  CHECK(s.size() <= std::numeric_limits<uInt>::max());
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  auto ret = inflateInit2(&stream, -MAX_WBITS);
+  if (ret != Z_OK) {
+    return Status::Error(PSLICE() << "zlib inflate init failed: " << ret);
+  }
+  SCOPE_EXIT {
+    inflateEnd(&stream);
+  };
+  if (!dictionary.empty()) {
+    if (dictionary.size() > (1u << MAX_WBITS)) {
+      dictionary = dictionary.substr(dictionary.size() - (1u << MAX_WBITS));
+    }
+    ret = inflateSetDictionary(&stream, dictionary.ubegin(), narrow_cast<uInt>(dictionary.size()));
+    if (ret != Z_OK) {
+      return Status::Error(PSLICE() << "zlib inflate dictionary failed: " << ret);
+    }
+  }
+
+  BufferSlice res{size};
+  stream.next_in = const_cast<Bytef *>(s.ubegin());
+  stream.avail_in = static_cast<uInt>(s.size());
+  stream.next_out = res.as_slice().ubegin();
+  stream.avail_out = narrow_cast<uInt>(size);
+  ret = inflate(&stream, Z_FINISH);
+  if (ret != Z_STREAM_END || stream.total_out != size || stream.avail_in != 0) {
+    return Status::Error(PSLICE() << "zlib inflate failed: " << ret);
+  }
+  return std::move(res);
+}
+
 }  // namespace td
 #endif
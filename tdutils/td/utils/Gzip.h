@@ -113,6 +113,13 @@ BufferSlice gzdecode(Slice s);
 
 BufferSlice gzencode(Slice s, double max_compression_ratio);
 
+// Raw deflate stream of s compressed with a preset dictionary, of which only the last 32KB are used.
+// Returns an empty slice if the result would be larger than s.size() * max_compression_ratio
+BufferSlice deflate_with_dictionary(Slice s, Slice dictionary, int level, double max_compression_ratio);
+
+// Decodes the result of deflate_with_dictionary, which must decompress to exactly size bytes
+Result<BufferSlice> inflate_with_dictionary(Slice s, Slice dictionary, size_t size);
+
 }  // namespace td
 
 #endif
@@ -40,6 +40,37 @@ class MpscLinkQueueImpl {
     head_.store(node, std::memory_order_relaxed);
   }
 
+  // Nodes linked outside of the queue, which can be pushed with a single atomic operation
+  class List {
+   public:
+    void push(Node *node) {
+      node->next_ = head_;
+      if (!tail_) {
+        tail_ = node;
+      }
+      head_ = node;
+    }
+    bool empty() const {
+      return head_ == nullptr;
+    }
+
+   private:
+    friend class MpscLinkQueueImpl;
+    Node *head_{nullptr};
+    Node *tail_{nullptr};
+  };
+
+  void push_list(List &list) {
+    if (list.empty()) {
+      return;
+    }
+    list.tail_->next_ = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_strong(list.tail_->next_, list.head_, std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+    }
+    list = List();
+  }
+
   void pop_all(Reader &reader) {
     return reader.add(head_.exchange(nullptr, std::memory_order_acquire));
   }
@@ -117,6 +148,31 @@ class MpscLinkQueue {
   void push_unsafe(Node node) {
     impl_.push_unsafe(node.to_mpsc_link_queue_node());
   }
+
+  // Nodes are read in the order they were added to the list
+  class List {
+   public:
+    List() = default;
+    List(const List &) = delete;
+    List &operator=(const List &) = delete;
+    ~List() {
+      CHECK(impl_.empty());
+    }
+    void push(Node node) {
+      impl_.push(node.to_mpsc_link_queue_node());
+    }
+    bool empty() const {
+      return impl_.empty();
+    }
+
+   private:
+    friend class MpscLinkQueue;
+    MpscLinkQueueImpl::List impl_;
+  };
+  void push_list(List &list) {
+    impl_.push_list(list.impl_);
+  }
+
   class Reader {
    public:
     ~Reader() {
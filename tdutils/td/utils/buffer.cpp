@@ -18,8 +18,11 @@
 */
 #include "td/utils/buffer.h"
 
+#include "td/utils/misc.h"
+#include "td/utils/MpscLinkQueue.h"
 #include "td/utils/port/thread_local.h"
 
+#include <array>
 #include <cstddef>
 #include <new>
 
@@ -32,6 +35,217 @@
 
 namespace td {
 
+namespace {
+class BufferRawPool {
+ public:
+  static constexpr size_t MIN_CLASS_SIZE = 512;
+  static constexpr int CLASS_COUNT = 8;
+  static constexpr size_t MAX_SHARED_MEM = 64 << 20;
+
+  // returns -1 if buffers of such size are not pooled
+  static int get_class(size_t size) {
+    int res = 0;
+    while ((MIN_CLASS_SIZE << res) < size) {
+      if (++res == CLASS_COUNT) {
+        return -1;
+      }
+    }
+    return res;
+  }
+  static size_t get_block_size(int class_id) {
+    return TD_OFFSETOF(BufferRaw, data_) + (MIN_CLASS_SIZE << class_id);
+  }
+
+  static void *alloc(int class_id) {
+    init_thread_local<ThreadCache>(thread_cache);
+    auto &cache = *thread_cache;
+    auto &list = cache.lists[class_id];
+    if (list.head == nullptr) {
+      list.head = pop_shared_batch(class_id);
+      list.size = list.head == nullptr ? 0 : list.head->batch_size;
+    }
+    cache.allocs++;
+    void *res = nullptr;
+    if (list.head != nullptr) {
+      cache.pool_hits++;
+      cache.pooled_mem -= static_cast<int64>(get_block_size(class_id));
+      res = list.head;
+      list.head = list.head->next_in_batch;
+      list.size--;
+    } else {
+      res = new char[get_block_size(class_id)];
+    }
+    cache.maybe_flush_stats();
+    return res;
+  }
+
+  static void free(int class_id, void *ptr) {
+    auto *block = new (ptr) FreeBlock();
+    if (thread_cache == nullptr) {
+      // thread cache is already destroyed or was never created
+      block->batch_size = 1;
+      push_shared_batch(class_id, block);
+      return;
+    }
+    auto &cache = *thread_cache;
+    auto &list = cache.lists[class_id];
+    block->next_in_batch = list.head;
+    list.head = block;
+    list.size++;
+    cache.pooled_mem += static_cast<int64>(get_block_size(class_id));
+    auto max_size = get_max_cached(class_id);
+    if (list.size > max_size) {
+      cache.pooled_mem -= static_cast<int64>(get_block_size(class_id) * (max_size / 2));
+      push_shared_batch(class_id, list.cut(max_size / 2));
+    }
+  }
+
+  static void clear_thread_local() {
+    if (thread_cache != nullptr) {
+      thread_cache->clear();
+    }
+  }
+
+  static BufferAllocator::PoolStats get_stats() {
+    BufferAllocator::PoolStats res;
+    res.allocs = stats.allocs.load(std::memory_order_relaxed);
+    res.pool_hits = stats.pool_hits.load(std::memory_order_relaxed);
+    res.pooled_mem = stats.pooled_mem.load(std::memory_order_relaxed);
+    return res;
+  }
+
+ private:
+  struct FreeBlock : public MpscLinkQueueImpl::Node {
+    FreeBlock *next_in_batch{nullptr};
+    size_t batch_size{0};
+  };
+
+  struct FreeList {
+    FreeBlock *head{nullptr};
+    size_t size{0};
+
+    // detaches first n blocks as one batch
+    FreeBlock *cut(size_t n) {
+      CHECK(0 < n && n <= size);
+      auto *batch = head;
+      auto *last = head;
+      for (size_t i = 1; i < n; i++) {
+        last = last->next_in_batch;
+      }
+      head = last->next_in_batch;
+      size -= n;
+      last->next_in_batch = nullptr;
+      batch->batch_size = n;
+      return batch;
+    }
+  };
+
+  struct Stats {
+    std::atomic<int64> allocs{0};
+    std::atomic<int64> pool_hits{0};
+    std::atomic<int64> pooled_mem{0};
+  };
+  static Stats stats;
+
+  struct ThreadCache {
+    std::array<FreeList, CLASS_COUNT> lists;
+    int64 allocs{0};
+    int64 pool_hits{0};
+    int64 pooled_mem{0};
+
+    ThreadCache() = default;
+    ThreadCache(const ThreadCache &) = delete;
+    ThreadCache &operator=(const ThreadCache &) = delete;
+    ThreadCache(ThreadCache &&) = delete;
+    ThreadCache &operator=(ThreadCache &&) = delete;
+    ~ThreadCache() {
+      clear();
+    }
+
+    void clear() {
+      for (int class_id = 0; class_id < CLASS_COUNT; class_id++) {
+        auto &list = lists[class_id];
+        if (list.size != 0) {
+          pooled_mem -= static_cast<int64>(get_block_size(class_id) * list.size);
+          push_shared_batch(class_id, list.cut(list.size));
+        }
+      }
+      flush_stats();
+    }
+    void maybe_flush_stats() {
+      if ((allocs & 255) == 0) {
+        flush_stats();
+      }
+    }
+    void flush_stats() {
+      stats.allocs.fetch_add(allocs, std::memory_order_relaxed);
+      stats.pool_hits.fetch_add(pool_hits, std::memory_order_relaxed);
+      stats.pooled_mem.fetch_add(pooled_mem, std::memory_order_relaxed);
+      allocs = 0;
+      pool_hits = 0;
+      pooled_mem = 0;
+    }
+  };
+  static TD_THREAD_LOCAL ThreadCache *thread_cache;
+
+  // Batches are never popped one by one, so there is no ABA problem:
+  // a consumer takes the whole stack and returns all batches it doesn't need with a single push
+  struct SharedStack {
+    MpscLinkQueueImpl batches;
+    char pad[TD_CONCURRENCY_PAD - sizeof(MpscLinkQueueImpl)];
+  };
+  static std::array<SharedStack, CLASS_COUNT> shared_stacks;
+  static std::atomic<size_t> shared_mem;
+
+  // keeps about 256KB of buffers of each size class in every thread
+  static size_t get_max_cached(int class_id) {
+    return clamp<size_t>((256 << 10) / (MIN_CLASS_SIZE << class_id), 8, 128);
+  }
+
+  static void push_shared_batch(int class_id, FreeBlock *batch) {
+    auto batch_mem = get_block_size(class_id) * batch->batch_size;
+    if (shared_mem.fetch_add(batch_mem, std::memory_order_relaxed) + batch_mem > MAX_SHARED_MEM) {
+      shared_mem.fetch_sub(batch_mem, std::memory_order_relaxed);
+      while (batch != nullptr) {
+        auto *next = batch->next_in_batch;
+        batch->~FreeBlock();
+        delete[] reinterpret_cast<char *>(batch);
+        batch = next;
+      }
+      return;
+    }
+    stats.pooled_mem.fetch_add(static_cast<int64>(batch_mem), std::memory_order_relaxed);
+    shared_stacks[class_id].batches.push(batch);
+  }
+
+  static FreeBlock *pop_shared_batch(int class_id) {
+    auto &stack = shared_stacks[class_id].batches;
+    MpscLinkQueueImpl::Reader reader;
+    stack.pop_all(reader);
+    auto *batch = static_cast<FreeBlock *>(reader.read());
+    if (batch == nullptr) {
+      return nullptr;
+    }
+    MpscLinkQueueImpl::List other_batches;
+    while (auto *node = reader.read()) {
+      other_batches.push(node);
+    }
+    stack.push_list(other_batches);
+
+    auto batch_mem = get_block_size(class_id) * batch->batch_size;
+    shared_mem.fetch_sub(batch_mem, std::memory_order_relaxed);
+    stats.pooled_mem.fetch_sub(static_cast<int64>(batch_mem), std::memory_order_relaxed);
+    thread_cache->pooled_mem += static_cast<int64>(batch_mem);
+    return batch;
+  }
+};
+
+BufferRawPool::Stats BufferRawPool::stats;
+TD_THREAD_LOCAL BufferRawPool::ThreadCache *BufferRawPool::thread_cache;  // static zero-initialized
+std::array<BufferRawPool::SharedStack, BufferRawPool::CLASS_COUNT> BufferRawPool::shared_stacks;
+std::atomic<size_t> BufferRawPool::shared_mem;
+}  // namespace
+
 TD_THREAD_LOCAL BufferAllocator::BufferRawTls *BufferAllocator::buffer_raw_tls;  // static zero-initialized
 
 std::atomic<size_t> BufferAllocator::buffer_mem;
@@ -40,6 +254,17 @@ size_t BufferAllocator::get_buffer_mem() {
   return buffer_mem;
 }
 
+BufferAllocator::PoolStats BufferAllocator::get_pool_stats() {
+  return BufferRawPool::get_stats();
+}
+
+void BufferAllocator::clear_thread_local() {
+  if (buffer_raw_tls != nullptr) {
+    buffer_raw_tls->buffer_raw = nullptr;
+  }
+  BufferRawPool::clear_thread_local();
+}
+
 BufferAllocator::WriterPtr BufferAllocator::create_writer(size_t size) {
   if (size < 512) {
     size = 512;
@@ -98,8 +323,13 @@ void BufferAllocator::dec_ref_cnt(BufferRaw *ptr) {
   if (left == 1) {
     auto buf_size = max(sizeof(BufferRaw), TD_OFFSETOF(BufferRaw, data_) + ptr->data_size_);
     buffer_mem -= buf_size;
+    auto class_id = BufferRawPool::get_class(ptr->data_size_);
     ptr->~BufferRaw();
-    delete[] ptr;
+    if (class_id >= 0) {
+      BufferRawPool::free(class_id, ptr);
+    } else {
+      delete[] reinterpret_cast<char *>(ptr);
+    }
   }
 }
 
@@ -111,7 +341,8 @@ BufferRaw *BufferAllocator::create_buffer_raw(size_t size) {
     buf_size = sizeof(BufferRaw);
   }
   buffer_mem += buf_size;
-  auto *buffer_raw = reinterpret_cast<BufferRaw *>(new char[buf_size]);
+  auto class_id = BufferRawPool::get_class(size);
+  void *buffer_raw = class_id >= 0 ? BufferRawPool::alloc(class_id) : new char[buf_size];
   return new (buffer_raw) BufferRaw(size);
 }
 
@@ -80,6 +80,17 @@ class BufferAllocator {
 
   static size_t get_buffer_mem();
 
+  // Buffers up to 64KB are taken from size-classed pools: a small per-thread cache in front of
+  // a lock-free stack of batches shared between threads, so a buffer freed by another thread is reused too.
+  // Counters are flushed from thread caches lazily, so they may lag behind a bit.
+  struct PoolStats {
+    int64 allocs{0};  // allocations of pooled sizes only
+    int64 pool_hits{0};
+    int64 pooled_mem{0};
+  };
+  static PoolStats get_pool_stats();
+
+  // Returns buffers cached by the current thread to the shared pool
   static void clear_thread_local();
 
  private:
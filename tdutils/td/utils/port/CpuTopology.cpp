@@ -0,0 +1,98 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/port/CpuTopology.h"
+
+#include "td/utils/filesystem.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
+
+namespace td {
+
+Result<vector<int32>> parse_cpu_list(Slice list) {
+  // checked before expanding ranges, so that "0-2000000000" can't allocate gigabytes
+  auto check_cpu = [](int32 cpu) -> Status {
+    if (cpu < 0 || cpu >= 4096) {
+      return Status::Error(PSLICE() << "Invalid cpu " << cpu);
+    }
+    return Status::OK();
+  };
+  vector<int32> res;
+  for (auto part : full_split(trim(list), ',')) {
+    part = trim(part);
+    if (part.empty()) {
+      continue;
+    }
+    auto pos = part.find('-');
+    if (pos == Slice::npos) {
+      TRY_RESULT(cpu, to_integer_safe<int32>(part));
+      TRY_STATUS(check_cpu(cpu));
+      res.push_back(cpu);
+      continue;
+    }
+    TRY_RESULT(from, to_integer_safe<int32>(part.substr(0, pos)));
+    TRY_RESULT(to, to_integer_safe<int32>(part.substr(pos + 1)));
+    TRY_STATUS(check_cpu(from));
+    TRY_STATUS(check_cpu(to));
+    if (from > to) {
+      return Status::Error(PSLICE() << "Invalid cpu range \"" << part << '"');
+    }
+    for (auto cpu = from; cpu <= to; cpu++) {
+      res.push_back(cpu);
+    }
+  }
+  return std::move(res);
+}
+
+int32 CpuTopology::get_numa_node(int32 cpu) const {
+  for (size_t i = 0; i < numa_nodes.size(); i++) {
+    for (auto node_cpu : numa_nodes[i]) {
+      if (node_cpu == cpu) {
+        return narrow_cast<int32>(i);
+      }
+    }
+  }
+  return -1;
+}
+
+CpuTopology CpuTopology::get() {
+  CpuTopology res;
+#if TD_LINUX
+  for (int node = 0;; node++) {
+    auto r_list = read_file_str(PSLICE() << "/sys/devices/system/node/node" << node << "/cpulist", 1 << 16);
+    if (r_list.is_error()) {
+      break;
+    }
+    auto r_cpus = parse_cpu_list(r_list.ok());
+    if (r_cpus.is_error()) {
+      res.numa_nodes.clear();
+      break;
+    }
+    res.numa_nodes.push_back(r_cpus.move_as_ok());
+  }
+#endif
+  if (res.numa_nodes.empty()) {
+    res.numa_nodes.emplace_back();
+    for (unsigned cpu = 0; cpu < thread::hardware_concurrency(); cpu++) {
+      res.numa_nodes.back().push_back(static_cast<int32>(cpu));
+    }
+  }
+  return res;
+}
+
+}  // namespace td
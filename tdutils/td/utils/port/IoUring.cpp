@@ -0,0 +1,356 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/port/IoUring.h"
+
+#include "td/utils/logging.h"
+
+#if TD_HAS_IO_URING
+
+#include "td/utils/misc.h"
+#include "td/utils/port/detail/skip_eintr.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace td {
+
+#if TD_HAS_IO_URING && defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+
+namespace {
+int sys_io_uring_setup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+template <class T>
+T load_acquire(const T *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+template <class T>
+void store_release(T *ptr, T value) {
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+class Mmap {
+ public:
+  Mmap() = default;
+  Mmap(const Mmap &) = delete;
+  Mmap &operator=(const Mmap &) = delete;
+  ~Mmap() {
+    if (ptr_ != nullptr) {
+      munmap(ptr_, size_);
+    }
+  }
+
+  Status init(int fd, size_t size, off_t offset) {
+    auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (ptr == MAP_FAILED) {
+      return OS_ERROR("io_uring mmap failed");
+    }
+    ptr_ = static_cast<char *>(ptr);
+    size_ = size;
+    return Status::OK();
+  }
+
+  template <class T>
+  T *at(uint32 offset) const {
+    return reinterpret_cast<T *>(ptr_ + offset);
+  }
+
+ private:
+  char *ptr_{nullptr};
+  size_t size_{0};
+};
+}  // namespace
+
+class IoUring::Impl {
+ public:
+  Status init(uint32 entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    NativeFd fd(sys_io_uring_setup(entries, &params));
+    if (!fd) {
+      return OS_ERROR("io_uring_setup failed");
+    }
+    // IORING_OP_READ and IORING_OP_WRITE are supported since the same kernel version (5.6)
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return Status::Error("io_uring is too old");
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      sq_size = cq_size = max(sq_size, cq_size);
+    }
+    TRY_STATUS(sq_ring_.init(fd.fd(), sq_size, IORING_OFF_SQ_RING));
+    Mmap *cq_ring = &sq_ring_;
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+      TRY_STATUS(cq_ring_.init(fd.fd(), cq_size, IORING_OFF_CQ_RING));
+      cq_ring = &cq_ring_;
+    }
+    TRY_STATUS(sqes_.init(fd.fd(), params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+
+    sq_head_ = sq_ring_.at<uint32>(params.sq_off.head);
+    sq_tail_ = sq_ring_.at<uint32>(params.sq_off.tail);
+    sq_mask_ = *sq_ring_.at<uint32>(params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_array_ = sq_ring_.at<uint32>(params.sq_off.array);
+    sqe_ = sqes_.at<io_uring_sqe>(0);
+    cq_head_ = cq_ring->at<uint32>(params.cq_off.head);
+    cq_tail_ = cq_ring->at<uint32>(params.cq_off.tail);
+    cq_mask_ = *cq_ring->at<uint32>(params.cq_off.ring_mask);
+    cqe_ = cq_ring->at<io_uring_cqe>(params.cq_off.cqes);
+
+    sq_local_tail_ = *sq_tail_;
+    sq_submitted_tail_ = sq_local_tail_;
+    fd_ = std::move(fd);
+    return Status::OK();
+  }
+
+  Status register_event_fd(const NativeFd &event_fd) {
+    int native_fd = event_fd.fd();
+    if (sys_io_uring_register(fd_.fd(), IORING_REGISTER_EVENTFD, &native_fd, 1) < 0) {
+      return OS_ERROR("io_uring_register failed");
+    }
+    return Status::OK();
+  }
+
+  uint32 get_capacity() const {
+    return sq_entries_;
+  }
+
+  bool prepare(uint8 opcode, int fd, const char *ptr, size_t size, uint64 offset, uint64 user_data) {
+    if (sq_local_tail_ - load_acquire(sq_head_) >= sq_entries_) {
+      return false;
+    }
+    auto index = sq_local_tail_ & sq_mask_;
+    auto &sqe = sqe_[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.off = offset;
+    sqe.addr = reinterpret_cast<uint64>(ptr);
+    sqe.len = static_cast<uint32>(min(size, max_request_size()));
+    sqe.user_data = user_data;
+    sq_array_[index] = index;
+    sq_local_tail_++;
+    store_release(sq_tail_, sq_local_tail_);
+    return true;
+  }
+
+  Result<size_t> submit() {
+    size_t total = 0;
+    while (sq_submitted_tail_ != sq_local_tail_) {
+      auto res = detail::skip_eintr(
+          [&] { return sys_io_uring_enter(fd_.fd(), sq_local_tail_ - sq_submitted_tail_, 0, 0); });
+      if (res < 0) {
+        if (errno == EAGAIN || errno == EBUSY) {
+          // kernel is out of resources or completion queue is full, retry after completions are popped
+          break;
+        }
+        return OS_ERROR("io_uring_enter failed");
+      }
+      if (res == 0) {
+        break;
+      }
+      sq_submitted_tail_ += static_cast<uint32>(res);
+      total += static_cast<size_t>(res);
+    }
+    return total;
+  }
+
+  std::vector<uint64> drop_unsubmitted() {
+    std::vector<uint64> res;
+    for (auto tail = sq_submitted_tail_; tail != sq_local_tail_; tail++) {
+      res.push_back(sqe_[tail & sq_mask_].user_data);
+    }
+    sq_local_tail_ = sq_submitted_tail_;
+    store_release(sq_tail_, sq_local_tail_);
+    return res;
+  }
+
+  size_t pop_completions(Completion *completions, size_t max_count) {
+    auto head = *cq_head_;
+    auto tail = load_acquire(cq_tail_);
+    size_t count = 0;
+    while (head != tail && count < max_count) {
+      auto &cqe = cqe_[head & cq_mask_];
+      completions[count].user_data = cqe.user_data;
+      completions[count].result = cqe.res;
+      count++;
+      head++;
+    }
+    store_release(cq_head_, head);
+    return count;
+  }
+
+  Status wait_completions(size_t min_count) {
+    auto res = detail::skip_eintr(
+        [&] { return sys_io_uring_enter(fd_.fd(), 0, narrow_cast<unsigned>(min_count), IORING_ENTER_GETEVENTS); });
+    if (res < 0) {
+      return OS_ERROR("io_uring_enter failed");
+    }
+    return Status::OK();
+  }
+
+ private:
+  NativeFd fd_;
+  Mmap sq_ring_;
+  Mmap cq_ring_;
+  Mmap sqes_;
+
+  uint32 *sq_head_{nullptr};
+  uint32 *sq_tail_{nullptr};
+  uint32 sq_mask_{0};
+  uint32 sq_entries_{0};
+  uint32 *sq_array_{nullptr};
+  io_uring_sqe *sqe_{nullptr};
+  uint32 sq_local_tail_{0};
+  uint32 sq_submitted_tail_{0};
+
+  uint32 *cq_head_{nullptr};
+  uint32 *cq_tail_{nullptr};
+  uint32 cq_mask_{0};
+  io_uring_cqe *cqe_{nullptr};
+};
+
+bool IoUring::is_supported() {
+  static bool is_supported = [] {
+    IoUring ring;
+    auto status = ring.init(1);
+    LOG_IF(INFO, status.is_error()) << "io_uring is not available: " << status;
+    return status.is_ok();
+  }();
+  return is_supported;
+}
+
+Status IoUring::init(uint32 entries) {
+  auto impl = make_unique<Impl>();
+  TRY_STATUS(impl->init(entries));
+  impl_ = std::move(impl);
+  return Status::OK();
+}
+
+Status IoUring::register_event_fd(const NativeFd &event_fd) {
+  return impl_->register_event_fd(event_fd);
+}
+
+uint32 IoUring::get_capacity() const {
+  return impl_->get_capacity();
+}
+
+bool IoUring::prepare_read(const NativeFd &fd, MutableSlice dest, uint64 offset, uint64 user_data) {
+  return impl_->prepare(IORING_OP_READ, fd.fd(), dest.data(), dest.size(), offset, user_data);
+}
+
+bool IoUring::prepare_write(const NativeFd &fd, Slice data, uint64 offset, uint64 user_data) {
+  return impl_->prepare(IORING_OP_WRITE, fd.fd(), data.data(), data.size(), offset, user_data);
+}
+
+Result<size_t> IoUring::submit() {
+  return impl_->submit();
+}
+
+std::vector<uint64> IoUring::drop_unsubmitted() {
+  return impl_->drop_unsubmitted();
+}
+
+size_t IoUring::pop_completions(Completion *completions, size_t max_count) {
+  return impl_->pop_completions(completions, max_count);
+}
+
+Status IoUring::wait_completions(size_t min_count) {
+  return impl_->wait_completions(min_count);
+}
+
+#else
+
+class IoUring::Impl {};
+
+bool IoUring::is_supported() {
+  return false;
+}
+
+Status IoUring::init(uint32 entries) {
+  return Status::Error("io_uring is not supported");
+}
+
+Status IoUring::register_event_fd(const NativeFd &event_fd) {
+  UNREACHABLE();
+}
+
+uint32 IoUring::get_capacity() const {
+  UNREACHABLE();
+}
+
+bool IoUring::prepare_read(const NativeFd &fd, MutableSlice dest, uint64 offset, uint64 user_data) {
+  UNREACHABLE();
+}
+
+bool IoUring::prepare_write(const NativeFd &fd, Slice data, uint64 offset, uint64 user_data) {
+  UNREACHABLE();
+}
+
+Result<size_t> IoUring::submit() {
+  UNREACHABLE();
+}
+
+std::vector<uint64> IoUring::drop_unsubmitted() {
+  UNREACHABLE();
+}
+
+size_t IoUring::pop_completions(Completion *completions, size_t max_count) {
+  UNREACHABLE();
+}
+
+Status IoUring::wait_completions(size_t min_count) {
+  UNREACHABLE();
+}
+
+#endif
+
+IoUring::IoUring() = default;
+IoUring::IoUring(IoUring &&) = default;
+IoUring &IoUring::operator=(IoUring &&) = default;
+IoUring::~IoUring() = default;
+
+bool IoUring::empty() const {
+  return !impl_;
+}
+
+void IoUring::close() {
+  impl_.reset();
+}
+
+}  // namespace td
@@ -0,0 +1,85 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/port/config.h"
+
+#include "td/utils/common.h"
+#include "td/utils/port/detail/NativeFd.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// Minimal io_uring wrapper for positioned file reads and writes.
+// Not thread-safe: requests must be prepared, submitted and completed by one thread.
+class IoUring {
+ public:
+  struct Completion {
+    uint64 user_data{0};
+    // number of bytes transferred or -errno
+    int32 result{0};
+  };
+
+  IoUring();
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+  IoUring(IoUring &&);
+  IoUring &operator=(IoUring &&);
+  ~IoUring();
+
+  static bool is_supported();
+
+  // Fails if io_uring is not available: old kernel, disabled by seccomp or not Linux
+  Status init(uint32 entries);
+  bool empty() const;
+  void close();
+
+  // eventfd which is signaled on every completion
+  Status register_event_fd(const NativeFd &event_fd);
+
+  uint32 get_capacity() const;
+
+  // Return false if the submission queue is full.
+  // A request transfers at most max_request_size() bytes, the caller must submit the rest as after a short transfer.
+  bool prepare_read(const NativeFd &fd, MutableSlice dest, uint64 offset, uint64 user_data);
+  bool prepare_write(const NativeFd &fd, Slice data, uint64 offset, uint64 user_data);
+
+  static constexpr size_t max_request_size() {
+    return 1 << 30;
+  }
+
+  // Passes all prepared requests to the kernel with one system call
+  Result<size_t> submit();
+
+  // Removes prepared requests, which were not passed to the kernel, returns their user_data.
+  // Used after submit() failed.
+  std::vector<uint64> drop_unsubmitted();
+
+  size_t pop_completions(Completion *completions, size_t max_count);
+
+  // Blocks till at least min_count requests are completed
+  Status wait_completions(size_t min_count);
+
+ private:
+  class Impl;
+  unique_ptr<Impl> impl_;
+};
+
+}  // namespace td
@@ -62,4 +62,10 @@
   #define TD_HAS_MMSG 1
 #endif
 
+#if TD_LINUX && defined(__has_include)
+  #if __has_include(<linux/io_uring.h>)
+    #define TD_HAS_IO_URING 1
+  #endif
+#endif
+
 // clang-format on
@@ -27,6 +27,7 @@
 #include "td/utils/port/detail/ThreadIdGuard.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Status.h"
 
 #include <thread>
 #include <tuple>
@@ -67,6 +68,9 @@ class ThreadStl {
   }
   void set_name(CSlice name) {
   }
+  Status set_affinity(const vector<int32> &cpus) {
+    return Status::Error("Thread affinity is not supported");
+  }
 
   static unsigned hardware_concurrency() {
     return std::thread::hardware_concurrency();
@@ -85,6 +85,25 @@ TEST(MpscLinkQueue, one_thread) {
     }
     LOG_CHECK((v == std::vector<int>{3, 2, 1, 0})) << td::format::as_array(v);
   }
+
+  {
+    queue.push(create_node(1));
+    td::MpscLinkQueue<QueueNode>::List list;
+    list.push(create_node(2));
+    list.push(create_node(3));
+    list.push(create_node(4));
+    queue.push_list(list);
+    CHECK(list.empty());
+    queue.push_list(list);
+    queue.push(create_node(5));
+    td::MpscLinkQueue<QueueNode>::Reader reader;
+    queue.pop_all(reader);
+    std::vector<int> v;
+    while (auto node = reader.read()) {
+      v.push_back(node.value().value());
+    }
+    LOG_CHECK((v == std::vector<int>{1, 2, 3, 4, 5})) << td::format::as_array(v);
+  }
 }
 
 #if !TD_THREAD_UNSUPPORTED
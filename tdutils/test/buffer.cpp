@@ -19,8 +19,12 @@
 #include "td/utils/tests.h"
 
 #include "td/utils/buffer.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 
+#include <algorithm>
+#include <vector>
+
 using namespace td;
 
 TEST(Buffer, buffer_builder) {
@@ -68,3 +72,44 @@ TEST(Buffer, buffer_builder) {
     ASSERT_EQ(builder.extract().as_slice(), str);
   }
 }
+
+TEST(Buffer, pool) {
+  constexpr size_t n = 1000;
+  auto create_buffers = [&] {
+    std::vector<BufferSlice> buffers;
+    for (size_t i = 0; i < n; i++) {
+      buffers.emplace_back(1500 + i);
+      std::fill(buffers.back().as_slice().begin(), buffers.back().as_slice().end(), static_cast<char>(i));
+    }
+    return buffers;
+  };
+  auto check_buffers = [&](const std::vector<BufferSlice> &buffers) {
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_EQ(1500 + i, buffers[i].size());
+      for (auto c : buffers[i].as_slice()) {
+        ASSERT_EQ(static_cast<char>(i), c);
+      }
+    }
+  };
+
+  BufferAllocator::clear_thread_local();
+  auto before = BufferAllocator::get_pool_stats();
+
+  // buffers are freed by another thread, so they can be reused only through the shared pool
+  auto buffers = create_buffers();
+  td::thread([&] {
+    check_buffers(buffers);
+    buffers.clear();
+  }).join();
+
+  buffers = create_buffers();
+  check_buffers(buffers);
+  BufferAllocator::clear_thread_local();
+  auto after = BufferAllocator::get_pool_stats();
+  ASSERT_EQ(static_cast<int64>(2 * n), after.allocs - before.allocs);
+  ASSERT_TRUE(after.pool_hits - before.pool_hits >= static_cast<int64>(n));
+
+  buffers.clear();
+  BufferAllocator::clear_thread_local();
+  ASSERT_TRUE(BufferAllocator::get_pool_stats().pooled_mem >= static_cast<int64>(n * 1500));
+}
@@ -54,6 +54,20 @@ TEST(Gzip, gzencode) {
   }
 }
 
+TEST(Gzip, deflate_with_dictionary) {
+  auto dictionary = td::rand_string('a', 'z', 1000);
+  auto s = td::rand_string('a', 'z', 100) + dictionary.substr(100, 500) + td::rand_string('a', 'z', 100);
+  auto without = td::deflate_with_dictionary(s, td::Slice(), 6, 2);
+  auto with = td::deflate_with_dictionary(s, dictionary, 6, 2);
+  ASSERT_TRUE(!with.empty());
+  ASSERT_TRUE(with.size() * 2 < without.size());
+  ASSERT_EQ(s, td::inflate_with_dictionary(with.as_slice(), dictionary, s.size()).move_as_ok().as_slice().str());
+  ASSERT_EQ(s, td::inflate_with_dictionary(without.as_slice(), td::Slice(), s.size()).move_as_ok().as_slice().str());
+  ASSERT_TRUE(td::inflate_with_dictionary(with.as_slice(), td::Slice(), s.size()).is_error());
+  ASSERT_TRUE(td::inflate_with_dictionary(with.as_slice(), dictionary, s.size() + 1).is_error());
+  ASSERT_TRUE(td::deflate_with_dictionary(td::rand_string(0, 255, 1000), dictionary, 6, 0.9).empty());
+}
+
 TEST(Gzip, flow) {
   auto str = td::rand_string('a', 'z', 1000000);
   auto parts = td::rand_split(str);
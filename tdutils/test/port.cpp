@@ -19,8 +19,10 @@
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/CpuTopology.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/IoSlice.h"
+#include "td/utils/port/IoUring.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/thread.h"
@@ -146,6 +148,87 @@ TEST(Port, Writev) {
   ASSERT_EQ(expected_content, content);
 }
 
+TEST(Port, CpuTopology) {
+  ASSERT_EQ(vector<int32>({0, 1, 2, 3, 8, 10, 11}), parse_cpu_list("0-3,8,10-11\n").move_as_ok());
+  ASSERT_TRUE(parse_cpu_list("").move_as_ok().empty());
+  ASSERT_TRUE(parse_cpu_list("3-1").is_error());
+  ASSERT_TRUE(parse_cpu_list("a").is_error());
+  ASSERT_TRUE(parse_cpu_list("4096").is_error());
+  ASSERT_TRUE(parse_cpu_list("0-2147483647").is_error());
+  ASSERT_TRUE(parse_cpu_list("-5-3").is_error());
+
+  auto topology = CpuTopology::get();
+  ASSERT_TRUE(!topology.numa_nodes.empty());
+  ASSERT_TRUE(!topology.numa_nodes[0].empty());
+  ASSERT_EQ(0, topology.get_numa_node(topology.numa_nodes[0][0]));
+  ASSERT_EQ(-1, topology.get_numa_node(100000));
+}
+
+TEST(Port, IoUring) {
+  if (!IoUring::is_supported()) {
+    LOG(ERROR) << "io_uring is not supported, skip the test";
+    return;
+  }
+  CSlice path = "io_uring.txt";
+  unlink(path).ignore();
+  auto fd = FileFd::open(path, FileFd::Read | FileFd::Write | FileFd::CreateNew).move_as_ok();
+  auto &native_fd = fd.get_native_fd();
+
+  IoUring ring;
+  ring.init(4).ensure();
+  ASSERT_EQ(4u, ring.get_capacity());
+  ASSERT_TRUE(ring.prepare_write(native_fd, "hello", 0, 1));
+  ASSERT_TRUE(ring.prepare_write(native_fd, "world", 5, 2));
+  ASSERT_EQ(2u, ring.submit().move_as_ok());
+  ring.wait_completions(2).ensure();
+  IoUring::Completion completions[4];
+  ASSERT_EQ(2u, ring.pop_completions(completions, 4));
+  ASSERT_EQ(3u, completions[0].user_data + completions[1].user_data);
+  ASSERT_EQ(5, completions[0].result);
+  ASSERT_EQ(5, completions[1].result);
+
+  std::string buf(20, '\0');
+  ASSERT_TRUE(ring.prepare_read(native_fd, buf, 3, 3));
+  ASSERT_TRUE(ring.prepare_read(NativeFd(), buf, 0, 4));
+  ASSERT_EQ(2u, ring.submit().move_as_ok());
+  ring.wait_completions(2).ensure();
+  ASSERT_EQ(2u, ring.pop_completions(completions, 4));
+  for (auto &completion : completions) {
+    if (completion.user_data == 3) {
+      ASSERT_EQ(7, completion.result);
+      ASSERT_EQ("loworld", buf.substr(0, 7));
+    } else if (completion.user_data == 4) {
+      ASSERT_TRUE(completion.result < 0);
+    }
+  }
+
+  if (sizeof(size_t) == 8) {
+    // a request is truncated to max_request_size() bytes, the file has only 10 bytes to read anyway
+    ASSERT_TRUE(ring.prepare_read(native_fd, MutableSlice(&buf[0], static_cast<size_t>(5) << 30), 0, 5));
+    ASSERT_EQ(1u, ring.submit().move_as_ok());
+    ring.wait_completions(1).ensure();
+    ASSERT_EQ(1u, ring.pop_completions(completions, 4));
+    ASSERT_EQ(10, completions[0].result);
+    ASSERT_EQ("helloworld", buf.substr(0, 10));
+  }
+
+  ASSERT_TRUE(ring.prepare_read(native_fd, buf, 0, 6));
+  ASSERT_TRUE(ring.prepare_read(native_fd, buf, 0, 7));
+  auto dropped = ring.drop_unsubmitted();
+  ASSERT_EQ(2u, dropped.size());
+  ASSERT_EQ(6u, dropped[0]);
+  ASSERT_EQ(7u, dropped[1]);
+  ASSERT_EQ(0u, ring.submit().move_as_ok());
+  ASSERT_TRUE(ring.prepare_read(native_fd, buf, 0, 8));
+  ASSERT_EQ(1u, ring.submit().move_as_ok());
+  ring.wait_completions(1).ensure();
+  ASSERT_EQ(1u, ring.pop_completions(completions, 4));
+  ASSERT_EQ(8u, completions[0].user_data);
+
+  fd.close();
+  unlink(path).ensure();
+}
+
 #if TD_PORT_POSIX && !TD_THREAD_UNSUPPORTED
 #include <signal.h>
 #include <sys/syscall.h>
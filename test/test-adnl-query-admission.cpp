@@ -0,0 +1,191 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "adnl/adnl-query-admission.h"
+
+#include "auto/tl/ton_api.h"
+#include "auto/tl/lite_api.h"
+#include "tl-utils/tl-utils.hpp"
+#include "tl-utils/lite-utils.hpp"
+#include "td/utils/logging.h"
+#include "td/utils/Random.h"
+
+using ton::adnl::AdnlNodeIdShort;
+using ton::adnl::AdnlQueryAdmission;
+using ton::adnl::AdnlQueryAdmissionOptions;
+
+static AdnlNodeIdShort random_peer() {
+  td::Bits256 id;
+  td::Random::secure_bytes(id.as_slice());
+  return AdnlNodeIdShort{id};
+}
+
+static AdnlQueryAdmissionOptions small_options() {
+  AdnlQueryAdmissionOptions opts;
+  opts.peer_max_inflight = 4;
+  opts.peer_queries_rate = 10;
+  opts.peer_queries_burst = 10;
+  opts.peer_bytes_rate = 1000;
+  opts.peer_bytes_burst = 1000;
+  opts.category_queries_rate = 5;
+  opts.category_queries_burst = 5;
+  opts.category_bytes_rate = 1000;
+  opts.category_bytes_burst = 1000;
+  return opts;
+}
+
+static void run_category_test() {
+  auto capabilities = ton::create_serialize_tl_object<ton::ton_api::tonNode_getCapabilities>();
+  LOG_CHECK(AdnlQueryAdmission::query_category(capabilities) == ton::ton_api::tonNode_getCapabilities::ID);
+
+  // overlay.query prefix is skipped
+  auto in_overlay =
+      ton::create_serialize_tl_object_suffix<ton::ton_api::overlay_query>(capabilities.as_slice(), td::Bits256::zero());
+  LOG_CHECK(AdnlQueryAdmission::query_category(in_overlay) == ton::ton_api::tonNode_getCapabilities::ID);
+
+  // liteServer.query and liteServer.waitMasterchainSeqno prefixes are skipped
+  auto get_time = ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getTime>(), true);
+  auto wait = ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_waitMasterchainSeqno>(1, 1000),
+                                       true, std::move(get_time));
+  auto lite = ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_query>(std::move(wait)), true);
+  LOG_CHECK(AdnlQueryAdmission::query_category(lite) == ton::lite_api::liteServer_getTime::ID);
+
+  // unknown and short queries share one category, so arbitrary ids can not create new entries
+  for (td::uint32 i = 0; i < 1000; i++) {
+    td::BufferSlice junk(8);
+    td::Random::secure_bytes(junk.as_slice());
+    LOG_CHECK(AdnlQueryAdmission::query_category(junk) == AdnlQueryAdmission::other_category());
+  }
+  LOG_CHECK(AdnlQueryAdmission::query_category(td::Slice("ab")) == AdnlQueryAdmission::other_category());
+
+  CHECK(AdnlQueryAdmission::is_exempt(ton::ton_api::catchain_getBlocks::ID));
+  CHECK(AdnlQueryAdmission::is_exempt(ton::ton_api::overlay_getRandomPeers::ID));
+  CHECK(!AdnlQueryAdmission::is_exempt(ton::ton_api::tonNode_getCapabilities::ID));
+  CHECK(!AdnlQueryAdmission::is_exempt(AdnlQueryAdmission::other_category()));
+}
+
+static void run_bucket_test() {
+  AdnlQueryAdmission admission{small_options()};
+  auto peer = random_peer();
+  double now = 1000;
+  AdnlQueryAdmission::Category a = ton::ton_api::tonNode_getCapabilities::ID;
+  AdnlQueryAdmission::Category b = ton::ton_api::tonNode_getArchiveInfo::ID;
+
+  // the category bucket runs out before the peer bucket
+  for (td::uint32 i = 0; i < 5; i++) {
+    CHECK(admission.admit(peer, a, 10, now));
+    admission.finished(peer, a, 10, now);
+  }
+  CHECK(!admission.admit(peer, a, 10, now));
+  // another category of the same peer still has its budget, until the peer bucket is empty too
+  for (td::uint32 i = 0; i < 5; i++) {
+    CHECK(admission.admit(peer, b, 10, now));
+    admission.finished(peer, b, 10, now);
+  }
+  CHECK(!admission.admit(peer, b, 10, now));
+  // other peers are not affected
+  CHECK(admission.admit(random_peer(), a, 10, now));
+
+  // buckets refill with time
+  now += 0.5;
+  CHECK(admission.admit(peer, a, 10, now));
+  admission.finished(peer, a, 10, now);
+  LOG_CHECK(admission.total_rejected() == 2) << admission.total_rejected();
+
+  // a big answer drives the bytes buckets negative and blocks the peer until they refill
+  AdnlQueryAdmission big{small_options()};
+  CHECK(big.admit(peer, a, 10, now));
+  big.finished(peer, a, 2500, now);
+  CHECK(!big.admit(peer, a, 10, now + 1));
+  CHECK(!big.admit(peer, b, 10, now + 1));
+  CHECK(big.admit(peer, b, 10, now + 3));
+}
+
+static void run_inflight_test() {
+  AdnlQueryAdmission admission{small_options()};
+  auto peer = random_peer();
+  double now = 1000;
+  AdnlQueryAdmission::Category a = ton::lite_api::liteServer_getTime::ID;
+  AdnlQueryAdmission::Category b = ton::ton_api::tonNode_getCapabilities::ID;
+
+  // long running queries take a slot each but do not use up the budget while they wait
+  for (td::uint32 i = 0; i < 4; i++) {
+    CHECK(admission.admit(peer, i % 2 ? a : b, 10, now));
+  }
+  CHECK(!admission.admit(peer, a, 10, now + 100));
+  admission.finished(peer, a, 10, now + 100);
+  CHECK(admission.admit(peer, a, 10, now + 100));
+
+  // consensus queries bypass all limits
+  for (td::uint32 i = 0; i < 100; i++) {
+    CHECK(admission.admit(peer, ton::ton_api::catchain_getDifference::ID, 1000, now + 100));
+  }
+  LOG_CHECK(admission.total_rejected() == 1) << admission.total_rejected();
+
+  // zero disables the limits
+  AdnlQueryAdmission unlimited{AdnlQueryAdmissionOptions{0, 0, 0, 0, 0, 0, 0, 0, 0}};
+  for (td::uint32 i = 0; i < 1000; i++) {
+    CHECK(unlimited.admit(peer, a, 1 << 20, now));
+  }
+}
+
+static void run_gc_test() {
+  AdnlQueryAdmission admission{small_options()};
+  double now = 1000;
+  AdnlQueryAdmission::Category a = ton::ton_api::tonNode_getCapabilities::ID;
+  auto busy = random_peer();
+  CHECK(admission.admit(busy, a, 10, now));
+  for (td::uint32 i = 0; i < 100; i++) {
+    auto peer = random_peer();
+    CHECK(admission.admit(peer, a, 10, now));
+    admission.finished(peer, a, 10, now);
+  }
+  LOG_CHECK(admission.tracked_peers() == 101) << admission.tracked_peers();
+  CHECK(admission.gc(now));
+  // buckets are not full yet
+  LOG_CHECK(admission.tracked_peers() == 101) << admission.tracked_peers();
+  CHECK(!admission.gc(now + 1));
+  now += 100;
+  CHECK(admission.gc(now));
+  // the peer with a query in flight is kept
+  LOG_CHECK(admission.tracked_peers() == 1) << admission.tracked_peers();
+  admission.finished(busy, a, 10, now);
+  CHECK(admission.gc(now + 100));
+  LOG_CHECK(admission.tracked_peers() == 0) << admission.tracked_peers();
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+
+  run_category_test();
+  run_bucket_test();
+  run_inflight_test();
+  run_gc_test();
+
+  LOG(INFO) << "OK";
+  return 0;
+}
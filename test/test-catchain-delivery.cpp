@@ -0,0 +1,243 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "adnl/adnl.h"
+#include "overlay/overlays.h"
+#include "keyring/keyring.h"
+#include "catchain/catchain-receiver.hpp"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/signals.h"
+
+#include <iostream>
+
+// Delivery of a catchain DAG of many validators by CatChainReceiverImpl, with blocks arriving in different orders.
+// Blocks are passed to the receiver directly, bypassing network, signatures and db.
+
+struct BlockDesc {
+  td::uint32 src;
+  td::uint32 height;
+  td::int32 prev;
+  std::vector<td::uint32> deps;
+  std::string payload;
+  ton::catchain::CatChainBlockHash hash;
+};
+
+class DeliveryCounter : public ton::catchain::CatChainReceiverInterface::Callback {
+ public:
+  explicit DeliveryCounter(td::uint32 *delivered) : delivered_(delivered) {
+  }
+  void new_block(td::uint32 src_id, td::uint32 fork_id, ton::catchain::CatChainBlockHash hash,
+                 ton::catchain::CatChainBlockHeight height, ton::catchain::CatChainBlockHash prev,
+                 std::vector<ton::catchain::CatChainBlockHash> deps, std::vector<ton::catchain::CatChainBlockHeight> vt,
+                 td::SharedSlice data) override {
+    (*delivered_)++;
+  }
+  void blame(td::uint32 src_id) override {
+    UNREACHABLE();
+  }
+  void on_custom_message(ton::PublicKeyHash src, td::BufferSlice data) override {
+  }
+  void on_custom_query(ton::PublicKeyHash src, td::BufferSlice data, td::Promise<td::BufferSlice> promise) override {
+  }
+  void on_broadcast(ton::PublicKeyHash src, td::BufferSlice data) override {
+  }
+  void start() override {
+  }
+
+ private:
+  td::uint32 *delivered_;
+};
+
+// every validator creates one block per round with up to max_deps deps on blocks of the previous rounds,
+// which are newer than the ones already known to its previous block
+std::vector<BlockDesc> generate_blocks(ton::catchain::CatChainReceiver *chain, td::uint32 rounds,
+                                       td::Random::Xorshift128plus &rnd) {
+  td::uint32 n = chain->get_sources_cnt();
+  std::vector<BlockDesc> blocks;
+  std::vector<std::vector<td::uint32>> vt;
+  std::vector<td::int32> last(n, -1);
+  for (td::uint32 round = 0; round < rounds; round++) {
+    auto visible = last;
+    for (td::uint32 src = 0; src < n; src++) {
+      BlockDesc b;
+      b.src = src;
+      b.height = round + 1;
+      b.prev = last[src];
+      std::vector<td::uint32> v = b.prev >= 0 ? vt[b.prev] : std::vector<td::uint32>(n, 0);
+
+      std::vector<td::uint32> candidates;
+      for (td::uint32 i = 0; i < n; i++) {
+        if (i != src && visible[i] >= 0 && blocks[visible[i]].height > v[i]) {
+          candidates.push_back(i);
+        }
+      }
+      td::random_shuffle(td::as_mutable_span(candidates), rnd);
+      for (size_t i = 0; i < candidates.size() && i < chain->opts().max_deps; i++) {
+        auto dep = static_cast<td::uint32>(visible[candidates[i]]);
+        b.deps.push_back(dep);
+        for (td::uint32 j = 0; j < n; j++) {
+          v[j] = std::max(v[j], vt[dep][j]);
+        }
+      }
+      v[src] = b.height;
+
+      b.payload.resize(32);
+      for (auto &c : b.payload) {
+        c = static_cast<char>(rnd.fast('a', 'z'));
+      }
+      auto dep = ton::create_tl_object<ton::ton_api::catchain_block_dep>(
+          src, b.height, td::sha256_bits256(b.payload), td::BufferSlice());
+      b.hash = ton::catchain::CatChainReceivedBlock::block_hash(chain, dep);
+      last[src] = static_cast<td::int32>(blocks.size());
+      blocks.push_back(std::move(b));
+      vt.push_back(std::move(v));
+    }
+  }
+  return blocks;
+}
+
+ton::tl_object_ptr<ton::ton_api::catchain_block_dep> export_dep(ton::catchain::CatChainReceiver *chain,
+                                                                const std::vector<BlockDesc> &blocks, td::int32 idx) {
+  if (idx < 0) {
+    return ton::create_tl_object<ton::ton_api::catchain_block_dep>(chain->get_sources_cnt(), 0,
+                                                                   chain->get_incarnation(), td::BufferSlice());
+  }
+  auto &b = blocks[idx];
+  return ton::create_tl_object<ton::ton_api::catchain_block_dep>(b.src, b.height, td::sha256_bits256(b.payload),
+                                                                 td::BufferSlice());
+}
+
+void run_delivery(std::vector<ton::catchain::CatChainNode> nodes, td::uint32 rounds, std::string order,
+                  td::actor::ActorId<ton::keyring::Keyring> keyring, td::actor::ActorId<ton::adnl::Adnl> adnl,
+                  td::actor::ActorId<ton::overlay::Overlays> overlay_manager) {
+  td::uint32 delivered = 0;
+  ton::catchain::CatChainOptions opts;
+  opts.debug_disable_db = true;
+  ton::catchain::CatChainSessionId unique_hash;
+  td::Random::secure_bytes(unique_hash.as_slice());
+  auto local_id = nodes[0].pub_key.compute_short_id();
+  auto validators = nodes.size();
+  ton::catchain::CatChainReceiverImpl chain(std::make_unique<DeliveryCounter>(&delivered), opts, keyring, adnl,
+                                            overlay_manager, std::move(nodes), local_id, unique_hash, "", "", false);
+
+  td::Random::Xorshift128plus rnd(123);
+  auto blocks = generate_blocks(&chain, rounds, rnd);
+
+  std::vector<td::uint32> arrival(blocks.size());
+  for (td::uint32 i = 0; i < arrival.size(); i++) {
+    arrival[i] = i;
+  }
+  if (order == "shuffled") {
+    // blocks of ~4 consecutive rounds arrive in random order
+    auto window = validators * 4;
+    for (size_t i = 0; i < arrival.size(); i += window) {
+      td::random_shuffle(td::MutableSpan<td::uint32>(arrival.data() + i, std::min(window, arrival.size() - i)), rnd);
+    }
+  } else if (order == "random") {
+    td::random_shuffle(td::as_mutable_span(arrival), rnd);
+  } else {
+    CHECK(order == "ordered");
+  }
+
+  std::vector<ton::tl_object_ptr<ton::ton_api::catchain_block>> tl_blocks(blocks.size());
+  for (td::uint32 i = 0; i < blocks.size(); i++) {
+    auto &b = blocks[i];
+    std::vector<ton::tl_object_ptr<ton::ton_api::catchain_block_dep>> deps;
+    for (auto dep : b.deps) {
+      deps.push_back(export_dep(&chain, blocks, dep));
+    }
+    tl_blocks[i] = ton::create_tl_object<ton::ton_api::catchain_block>(
+        chain.get_incarnation(), b.src, b.height,
+        ton::create_tl_object<ton::ton_api::catchain_block_data>(export_dep(&chain, blocks, b.prev), std::move(deps)),
+        td::BufferSlice());
+  }
+
+  double start = td::Time::now();
+  for (auto i : arrival) {
+    chain.create_block(std::move(tl_blocks[i]), td::SharedSlice{blocks[i].payload});
+    chain.block_written_to_db(blocks[i].hash);
+  }
+  double elapsed = td::Time::now() - start;
+  CHECK(delivered == blocks.size());
+
+  std::cout << "validators=" << validators << " blocks=" << blocks.size() << " order=" << order
+            << ": delivered in " << elapsed << "s, " << static_cast<double>(blocks.size()) / elapsed << " blocks/s"
+            << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(verbosity_WARNING);
+  td::set_default_failure_signal_handler().ensure();
+
+  std::string db_root_ = "tmp-catchain-delivery";
+  td::rmrf(db_root_).ignore();
+  td::mkdir(db_root_).ensure();
+
+  td::actor::ActorOwn<ton::keyring::Keyring> keyring;
+  td::actor::ActorOwn<ton::adnl::Adnl> adnl;
+  td::actor::ActorOwn<ton::overlay::Overlays> overlay_manager;
+
+  td::actor::Scheduler scheduler({1});
+  scheduler.run_in_context([&] {
+    keyring = ton::keyring::Keyring::create(db_root_);
+    adnl = ton::adnl::Adnl::create(db_root_, keyring.get());
+    overlay_manager =
+        ton::overlay::Overlays::create(db_root_, keyring.get(), adnl.get(), td::actor::ActorId<ton::dht::Dht>{});
+  });
+
+  for (td::uint32 validators : {100, 200}) {
+    std::vector<ton::catchain::CatChainNode> nodes;
+    for (td::uint32 i = 0; i < validators; i++) {
+      auto pub = ton::PrivateKey{ton::privkeys::Ed25519::random()}.compute_public_key();
+      nodes.push_back(ton::catchain::CatChainNode{ton::adnl::AdnlNodeIdShort{pub.compute_short_id()}, pub});
+    }
+    for (std::string order : {"ordered", "shuffled", "random"}) {
+      scheduler.run_in_context([&] {
+        run_delivery(nodes, 50, order, keyring.get(), adnl.get(), overlay_manager.get());
+      });
+      // drop messages sent by the receivers to the overlay manager
+      auto t = td::Timestamp::in(0.1);
+      while (scheduler.run(0.1)) {
+        if (t.is_in_past()) {
+          break;
+        }
+      }
+    }
+  }
+
+  scheduler.run_in_context([&] {
+    overlay_manager.reset();
+    adnl.reset();
+    keyring.reset();
+  });
+  td::rmrf(db_root_).ensure();
+  std::_Exit(0);
+  return 0;
+}
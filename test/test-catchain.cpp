@@ -45,6 +45,7 @@
 #if TD_DARWIN || TD_LINUX
 #include <unistd.h>
 #endif
+#include <atomic>
 #include <iostream>
 #include <sstream>
 
@@ -90,6 +91,12 @@ class CatChainInst : public td::actor::Actor {
   void finished_processing() {
   }
   void preprocess_block(ton::catchain::CatChainBlock *block) {
+    block->set_extra(std::make_unique<PayloadExtra>(compute_sum(block)));
+    delivered(block);
+    preprocessed_cnt_++;
+  }
+
+  td::uint64 compute_sum(ton::catchain::CatChainBlock *block) {
     td::uint64 sum = 0;
     auto prev = block->prev();
     if (prev) {
@@ -113,7 +120,48 @@ class CatChainInst : public td::actor::Actor {
     } else {
       CHECK(!block->deps().size());
     }
-    block->set_extra(std::make_unique<PayloadExtra>(sum));
+    return sum;
+  }
+
+  void delivered(ton::catchain::CatChainBlock *block) {
+    LOG_CHECK(delivered_.insert(block->hash()).second) << "block " << block->hash() << " is delivered twice";
+    blocks_cnt_++;
+    if (blocks_cnt_ >= replay_blocks_ && on_replayed_) {
+      on_replayed_.set_value(td::Time::now() - created_at_);
+    }
+  }
+
+  void get_snapshot(std::vector<ton::catchain::CatChainBlock *> blocks, td::Promise<td::BufferSlice> promise) {
+    td::BufferSlice data{blocks.size() * 40};
+    auto ptr = data.as_slice();
+    for (auto &B : blocks) {
+      auto E = dynamic_cast<const PayloadExtra *>(B->extra());
+      CHECK(E);
+      ptr.copy_from(B->hash().as_slice());
+      ptr.remove_prefix(32);
+      ptr.copy_from(td::Slice{reinterpret_cast<const char *>(&E->sum), 8});
+      ptr.remove_prefix(8);
+    }
+    promise.set_value(std::move(data));
+  }
+
+  void restore_blocks(std::vector<ton::catchain::CatChainBlock *> blocks, td::BufferSlice snapshot) {
+    CHECK(snapshot.size() % 40 == 0);
+    std::map<ton::catchain::CatChainBlockHash, td::uint64> sums;
+    for (auto ptr = snapshot.as_slice(); !ptr.empty(); ptr.remove_prefix(40)) {
+      ton::catchain::CatChainBlockHash hash;
+      hash.as_slice().copy_from(ptr.substr(0, 32));
+      td::uint64 sum;
+      td::MutableSlice{reinterpret_cast<char *>(&sum), 8}.copy_from(ptr.substr(32, 8));
+      sums[hash] = sum;
+    }
+    for (auto &B : blocks) {
+      auto it = sums.find(B->hash());
+      CHECK(it != sums.end());
+      B->set_extra(std::make_unique<PayloadExtra>(it->second));
+      delivered(B);
+      restored_cnt_++;
+    }
   }
 
   void alarm() override {
@@ -122,8 +170,10 @@ class CatChainInst : public td::actor::Actor {
 
   void start_up() override {
     alarm_timestamp() = td::Timestamp::in(0.1);
+    created_at_ = td::Time::now();
     ton::catchain::CatChainOptions opts;
-    opts.debug_disable_db = true;
+    opts.debug_disable_db = db_root_.empty();
+    opts.checkpoint_period = checkpoint_period_;
 
     std::vector<ton::catchain::CatChainNode> nodes;
     for (auto &n : nodes_) {
@@ -131,18 +181,23 @@ class CatChainInst : public td::actor::Actor {
     }
     catchain_ =
         ton::catchain::CatChain::create(make_callback(), opts, keyring_, adnl_, overlay_manager_, std::move(nodes),
-                                        nodes_[idx_].id, unique_hash_, std::string(""), "", false);
+                                        nodes_[idx_].id, unique_hash_, db_root_, PSTRING() << idx_ << "_", false);
   }
 
   CatChainInst(td::actor::ActorId<ton::keyring::Keyring> keyring, td::actor::ActorId<ton::adnl::Adnl> adnl,
                td::actor::ActorId<ton::overlay::Overlays> overlay_manager, std::vector<Node> nodes, td::uint32 idx,
-               ton::catchain::CatChainSessionId unique_hash)
+               ton::catchain::CatChainSessionId unique_hash, std::string db_root = "",
+               double checkpoint_period = 0.0, td::uint32 replay_blocks = 0, td::Promise<double> on_replayed = {})
       : keyring_(keyring)
       , adnl_(adnl)
       , overlay_manager_(overlay_manager)
       , nodes_(std::move(nodes))
       , idx_(idx)
-      , unique_hash_(unique_hash) {
+      , unique_hash_(unique_hash)
+      , db_root_(std::move(db_root))
+      , checkpoint_period_(checkpoint_period)
+      , replay_blocks_(replay_blocks)
+      , on_replayed_(std::move(on_replayed)) {
   }
 
   std::unique_ptr<ton::catchain::CatChain::Callback> make_callback() {
@@ -168,6 +223,13 @@ class CatChainInst : public td::actor::Actor {
       }
       void started() override {
       }
+      void get_snapshot(std::vector<ton::catchain::CatChainBlock *> blocks,
+                        td::Promise<td::BufferSlice> promise) override {
+        td::actor::send_closure(id_, &CatChainInst::get_snapshot, std::move(blocks), std::move(promise));
+      }
+      void restore_blocks(std::vector<ton::catchain::CatChainBlock *> blocks, td::BufferSlice snapshot) override {
+        td::actor::send_closure(id_, &CatChainInst::restore_blocks, std::move(blocks), std::move(snapshot));
+      }
       Callback(td::actor::ActorId<CatChainInst> id) : id_(std::move(id)) {
       }
 
@@ -182,6 +244,17 @@ class CatChainInst : public td::actor::Actor {
     return sum_;
   }
 
+  void get_blocks_cnt(td::Promise<td::uint32> promise) {
+    promise.set_value(td::uint32{blocks_cnt_});
+  }
+
+  td::uint32 preprocessed_cnt() const {
+    return preprocessed_cnt_;
+  }
+  td::uint32 restored_cnt() const {
+    return restored_cnt_;
+  }
+
   void create_fork() {
     auto height = height_ - 1;  //td::Random::fast(0, height_ - 1);
 
@@ -203,11 +276,22 @@ class CatChainInst : public td::actor::Actor {
   td::uint32 idx_;
 
   ton::catchain::CatChainSessionId unique_hash_;
+  std::string db_root_;
+  double checkpoint_period_;
+  td::uint32 replay_blocks_;
+  // gets the time from start until replay_blocks blocks were processed
+  td::Promise<double> on_replayed_;
 
   td::actor::ActorOwn<ton::catchain::CatChain> catchain_;
   td::uint64 sum_ = 0;
   td::uint32 height_ = 0;
   std::vector<td::uint64> prev_values_;
+
+  double created_at_ = 0;
+  td::uint32 blocks_cnt_ = 0;
+  td::uint32 preprocessed_cnt_ = 0;
+  td::uint32 restored_cnt_ = 0;
+  std::set<ton::catchain::CatChainBlockHash> delivered_;
 };
 
 static std::vector<Node> nodes;
@@ -239,9 +323,8 @@ int main(int argc, char *argv[]) {
     td::actor::send_closure(adnl, &ton::adnl::Adnl::register_network_manager, network_manager.get());
   });
 
-  for (td::uint32 att = 0; att < 10; att++) {
+  auto create_nodes = [&] {
     nodes.resize(total_nodes);
-
     scheduler.run_in_context([&] {
       auto addr = ton::adnl::TestLoopbackNetworkManager::generate_dummy_addr_list();
 
@@ -271,6 +354,10 @@ int main(int argc, char *argv[]) {
         }
       }
     });
+  };
+
+  for (td::uint32 att = 0; att < 10; att++) {
+    create_nodes();
 
     auto t = td::Timestamp::in(1.0);
 
@@ -315,6 +402,95 @@ int main(int argc, char *argv[]) {
     });
   }
 
+  // restart of nodes with a long catchain in db: node 0 writes checkpoints, node 1 replays the whole db
+  {
+    create_nodes();
+
+    ton::catchain::CatChainSessionId unique_id;
+    td::Random::secure_bytes(unique_id.as_slice());
+
+    std::vector<td::actor::ActorOwn<CatChainInst>> inst;
+    scheduler.run_in_context([&] {
+      for (td::uint32 idx = 0; idx < total_nodes; idx++) {
+        inst.push_back(td::actor::create_actor<CatChainInst>("inst", keyring.get(), adnl.get(), overlay_manager.get(),
+                                                             nodes, idx, unique_id, db_root_, idx == 1 ? 0.0 : 1.0));
+      }
+    });
+
+    auto t = td::Timestamp::in(30.0);
+    while (scheduler.run(1)) {
+      if (t.is_in_past()) {
+        break;
+      }
+    }
+
+    td::uint32 blocks[2];
+    std::atomic<td::uint32> remaining{2};
+    scheduler.run_in_context([&] {
+      for (td::uint32 idx = 0; idx < 2; idx++) {
+        td::actor::send_closure(inst[idx], &CatChainInst::get_blocks_cnt,
+                                td::PromiseCreator::lambda([&, idx](td::Result<td::uint32> R) {
+                                  blocks[idx] = R.move_as_ok();
+                                  remaining--;
+                                }));
+      }
+    });
+    while (remaining > 0) {
+      scheduler.run(1);
+    }
+    LOG_CHECK(blocks[0] > 0 && blocks[1] > 0) << blocks[0] << " " << blocks[1];
+    scheduler.run_in_context([&] {
+      for (td::uint32 idx = 0; idx < 2; idx++) {
+        inst[idx].reset();
+      }
+    });
+    t = td::Timestamp::in(1.0);
+    while (scheduler.run(1)) {
+      if (t.is_in_past()) {
+        break;
+      }
+    }
+
+    double replayed_in[2];
+    remaining = 2;
+    scheduler.run_in_context([&] {
+      for (td::uint32 idx = 0; idx < 2; idx++) {
+        inst[idx] = td::actor::create_actor<CatChainInst>(
+            "inst", keyring.get(), adnl.get(), overlay_manager.get(), nodes, idx, unique_id, db_root_,
+            idx == 1 ? 0.0 : 1.0, blocks[idx], td::PromiseCreator::lambda([&, idx](td::Result<double> R) {
+              replayed_in[idx] = R.move_as_ok();
+              remaining--;
+            }));
+      }
+    });
+    t = td::Timestamp::in(30.0);
+    while (scheduler.run(1)) {
+      if (remaining == 0) {
+        break;
+      }
+      if (t.is_in_past()) {
+        LOG(FATAL) << "failed to replay catchain db: remaining=" << remaining;
+      }
+    }
+
+    auto &restarted = inst[0].get_actor_unsafe();
+    auto &replayed = inst[1].get_actor_unsafe();
+    std::cout << "restart from checkpoint: " << blocks[0] << " blocks in " << replayed_in[0] << "s, "
+              << restarted.restored_cnt() << " restored, " << restarted.preprocessed_cnt() << " preprocessed"
+              << std::endl;
+    std::cout << "restart with full db replay: " << blocks[1] << " blocks in " << replayed_in[1] << "s, "
+              << replayed.preprocessed_cnt() << " preprocessed" << std::endl;
+    // blocks covered by the checkpoint snapshot are not preprocessed again, only the tail after the last one is
+    LOG_CHECK(replayed.restored_cnt() == 0) << replayed.restored_cnt();
+    LOG_CHECK(restarted.restored_cnt() * 2 > blocks[0]) << restarted.restored_cnt() << " " << blocks[0];
+    LOG_CHECK(replayed_in[0] * 2 < replayed_in[1]) << replayed_in[0] << " " << replayed_in[1];
+
+    scheduler.run_in_context([&] {
+      nodes.clear();
+      inst.clear();
+    });
+  }
+
   td::rmrf(db_root_).ensure();
   std::_Exit(0);
   return 0;
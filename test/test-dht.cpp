@@ -30,6 +30,7 @@
 #include "adnl/adnl.h"
 #include "dht/dht.h"
 #include "dht/dht.hpp"
+#include "dht/dht-query.hpp"
 
 #include "td/utils/port/signals.h"
 #include "td/utils/port/path.h"
@@ -38,6 +39,53 @@
 #include <memory>
 #include <set>
 
+// DhtQuery with scripted answers: the k closest nodes answer, a farther node never does
+class TestQuery : public ton::dht::DhtQuery {
+ public:
+  TestQuery(ton::dht::DhtKeyId key, ton::adnl::AdnlNodeIdShort src, ton::dht::DhtNodesList list, td::uint32 k,
+            td::actor::ActorId<ton::dht::DhtMember> node, td::actor::ActorId<ton::adnl::Adnl> adnl,
+            std::map<ton::dht::DhtKeyId, ton::dht::DhtNodesList> answers, std::set<ton::dht::DhtKeyId> failing,
+            td::Promise<ton::dht::DhtNodesList> promise)
+      : DhtQuery(key, ton::dht::DhtMember::PrintId{src}, src, std::move(list), k, k, ton::dht::DhtNode{}, false,
+                 node, adnl)
+      , answers_(std::move(answers))
+      , failing_(std::move(failing))
+      , promise_(std::move(promise)) {
+  }
+  void send_one_query(ton::adnl::AdnlNodeIdShort id) override {
+    td::actor::send_closure(actor_id(this), &TestQuery::answer, id);
+  }
+  void answer(ton::adnl::AdnlNodeIdShort id) {
+    auto key = ton::dht::DhtKeyId{id};
+    if (failing_.count(key)) {
+      finish_query(id, false);
+      return;
+    }
+    auto it = answers_.find(key);
+    if (it == answers_.end()) {
+      // does not answer at all
+      return;
+    }
+    ton::dht::DhtNodesList list;
+    for (auto &node : it->second.list()) {
+      list.push_back(node.clone());
+    }
+    add_nodes(std::move(list));
+    finish_query(id, true);
+  }
+  void finish(ton::dht::DhtNodesList list) override {
+    promise_.set_value(std::move(list));
+  }
+  std::string get_name() const override {
+    return "test";
+  }
+
+ private:
+  std::map<ton::dht::DhtKeyId, ton::dht::DhtNodesList> answers_;
+  std::set<ton::dht::DhtKeyId> failing_;
+  td::Promise<ton::dht::DhtNodesList> promise_;
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(verbosity_INFO);
 
@@ -403,6 +451,145 @@ int main() {
   }
   LOG(ERROR) << "success";
 
+  LOG(ERROR) << "cached gets";
+  {
+    // a value found once is served from the cache even when the node is cut off from the network
+    auto idx = td::Random::fast(0, total_nodes - 1);
+    auto src = dht_ids[idx].compute_short_id();
+    auto make_key = [&](td::uint32 x) {
+      return ton::dht::DhtKey{key_short_id, PSTRING() << "cache-" << x, 0};
+    };
+    auto set = [&](td::uint32 node, td::uint32 x, std::string value, td::uint32 ttl) {
+      ton::dht::DhtKeyDescription dht_key_description{make_key(x), key_pub,
+                                                      ton::dht::DhtUpdateRuleSignature::create().move_as_ok(),
+                                                      td::BufferSlice()};
+      dht_key_description.update_signature(key_dec->sign(dht_key_description.to_sign()).move_as_ok());
+      ton::dht::DhtValue dht_value{std::move(dht_key_description), td::BufferSlice(value),
+                                   static_cast<td::uint32>(td::Clocks::system() + ttl), td::BufferSlice("")};
+      dht_value.update_signature(key_dec->sign(dht_value.to_sign()).move_as_ok());
+      remaining++;
+      scheduler.run_in_context([&] {
+        td::actor::send_closure(dht[node], &ton::dht::Dht::set_value, std::move(dht_value),
+                                [&](td::Result<td::Unit> R) {
+                                  R.ensure();
+                                  remaining--;
+                                });
+      });
+      t = td::Timestamp::in(60.0);
+      while (remaining) {
+        scheduler.run(1);
+        LOG_CHECK(!t.is_in_past()) << "failed: remaining = " << remaining;
+      }
+    };
+    for (td::uint32 x = 0; x < 2; x++) {
+      set((idx + 1) % total_nodes, x, PSTRING() << "value-" << x, 3600);
+    }
+
+    std::atomic<bool> done{false};
+    bool found = false;
+    std::string found_value;
+    auto get = [&](td::uint32 x) {
+      done = false;
+      scheduler.run_in_context([&] {
+        td::actor::send_closure(dht[idx], &ton::dht::Dht::get_value, make_key(x),
+                                [&](td::Result<ton::dht::DhtValue> R) {
+                                  found = R.is_ok();
+                                  if (found) {
+                                    found_value = R.ok().value().as_slice().str();
+                                  }
+                                  done = true;
+                                });
+      });
+      t = td::Timestamp::in(60.0);
+      while (!done) {
+        scheduler.run(1);
+        LOG_CHECK(!t.is_in_past()) << "get_value timed out";
+      }
+    };
+    get(0);
+    CHECK(found && found_value == "value-0");
+    scheduler.run_in_context([&] {
+      td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::add_node_id, src, false, false);
+    });
+    get(0);
+    CHECK(found && found_value == "value-0");
+    get(1);
+    CHECK(!found);
+    scheduler.run_in_context([&] {
+      td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::add_node_id, src, true, true);
+    });
+    // storing a new value of the key drops the cached one
+    set(idx, 0, "value-0-updated", 3700);
+    get(0);
+    CHECK(found && found_value == "value-0-updated");
+  }
+  LOG(ERROR) << "success";
+
+  LOG(ERROR) << "lookup finish";
+  {
+    td::Bits256 key_bits;
+    td::Random::secure_bytes(key_bits.as_slice());
+    ton::dht::DhtKeyId key{key_bits};
+    auto addr = ton::adnl::TestLoopbackNetworkManager::generate_dummy_addr_list();
+    // nodes ordered by distance to the key
+    std::map<ton::dht::DhtKeyId, ton::dht::DhtNode> nodes;
+    for (td::uint32 i = 0; i < 5; i++) {
+      auto pub = ton::PrivateKey{ton::privkeys::Ed25519::random()}.compute_public_key();
+      ton::dht::DhtNode node{ton::adnl::AdnlNodeIdFull{pub}, addr, 1, td::BufferSlice{}};
+      nodes.emplace(node.get_key() ^ key, std::move(node));
+    }
+    std::vector<ton::dht::DhtNode> sorted;
+    for (auto &node : nodes) {
+      sorted.push_back(node.second.clone());
+    }
+    auto &far = sorted[4];
+    auto &first = sorted[3];
+
+    for (bool fail_one : {false, true}) {
+      ton::dht::DhtNodesList list;
+      list.push_back(first.clone());
+      list.push_back(far.clone());
+      // the first node knows the three closest ones, they only know each other
+      std::map<ton::dht::DhtKeyId, ton::dht::DhtNodesList> answers;
+      for (td::uint32 i = 0; i < 3; i++) {
+        answers[sorted[i].get_key()].push_back(sorted[i].clone());
+        answers[first.get_key()].push_back(sorted[i].clone());
+      }
+      std::set<ton::dht::DhtKeyId> failing;
+      if (fail_one) {
+        failing.insert(sorted[2].get_key());
+      }
+
+      std::atomic<bool> done{false};
+      std::vector<ton::dht::DhtKeyId> result;
+      scheduler.run_in_context([&] {
+        td::actor::create_actor<TestQuery>(
+            "testquery", key, dht_ids[0].compute_short_id(), std::move(list), 3,
+            td::actor::actor_dynamic_cast<ton::dht::DhtMember>(dht[0].get()), adnl.get(), std::move(answers),
+            std::move(failing),
+            [&](td::Result<ton::dht::DhtNodesList> R) {
+              auto nodes_list = R.move_as_ok();
+              for (auto &node : nodes_list.list()) {
+                result.push_back(node.get_key());
+              }
+              done = true;
+            })
+            .release();
+      });
+      // the query to the far node is still in flight, but it was displaced by closer nodes and is not waited for
+      t = td::Timestamp::in(10.0);
+      while (!done) {
+        scheduler.run(1);
+        LOG_CHECK(!t.is_in_past()) << "lookup did not finish";
+      }
+      LOG_CHECK(result.size() == (fail_one ? 2u : 3u)) << result.size();
+      for (size_t i = 0; i < result.size(); i++) {
+        CHECK(result[i] == sorted[i].get_key());
+      }
+    }
+  }
+  LOG(ERROR) << "success";
+
   td::rmrf(db_root_).ensure();
   std::_Exit(0);
   return 0;
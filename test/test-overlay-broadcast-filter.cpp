@@ -0,0 +1,132 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "overlay/overlay-broadcast-filter.hpp"
+
+#include "td/utils/logging.h"
+#include "td/utils/Random.h"
+#include "td/utils/port/sleep.h"
+
+#include <vector>
+
+using ton::overlay::BroadcastDeliveredFilter;
+using ton::overlay::Overlay;
+
+static Overlay::BroadcastHash random_hash() {
+  Overlay::BroadcastHash hash;
+  td::Random::secure_bytes(hash.as_slice());
+  return hash;
+}
+
+static void wait_rotation(BroadcastDeliveredFilter &filter) {
+  while (!filter.rotate()) {
+    td::usleep_for(1000);
+  }
+}
+
+static void run_growth_test() {
+  BroadcastDeliveredFilter filter{3600.0, 4};
+  std::vector<Overlay::BroadcastHash> hashes;
+  for (td::uint32 i = 0; i < 10000; i++) {
+    hashes.push_back(random_hash());
+    filter.insert(hashes.back());
+    // inserting a known hash again must not take a new slot
+    filter.insert(hashes.back());
+  }
+  LOG_CHECK(filter.size() == hashes.size()) << filter.size();
+  // a bucket is kept at most half full
+  LOG_CHECK(filter.memory_usage() >= 2 * hashes.size() * sizeof(td::uint64)) << filter.memory_usage();
+  for (auto &hash : hashes) {
+    CHECK(filter.contains(hash));
+  }
+  for (td::uint32 i = 0; i < 10000; i++) {
+    CHECK(!filter.contains(random_hash()));
+  }
+}
+
+static void run_zero_fingerprint_test() {
+  BroadcastDeliveredFilter filter{3600.0, 4};
+  // zero marks an empty slot, so a hash with a zero prefix must still be stored
+  Overlay::BroadcastHash zero_prefix = random_hash();
+  zero_prefix.as_slice().truncate(8).fill_zero();
+  CHECK(!filter.contains(zero_prefix));
+  filter.insert(zero_prefix);
+  CHECK(filter.contains(zero_prefix));
+  LOG_CHECK(filter.size() == 1) << filter.size();
+
+  Overlay::BroadcastHash zero_hash = Overlay::BroadcastHash::zero();
+  CHECK(filter.contains(zero_hash));
+  filter.insert(zero_hash);
+  LOG_CHECK(filter.size() == 1) << filter.size();
+}
+
+static void run_rotation_test() {
+  const td::uint32 buckets = 3;
+  BroadcastDeliveredFilter filter{0.05, buckets};
+  CHECK(!filter.rotate());
+
+  auto first = random_hash();
+  filter.insert(first);
+  std::vector<Overlay::BroadcastHash> later;
+  for (td::uint32 i = 1; i < buckets; i++) {
+    wait_rotation(filter);
+    CHECK(!filter.rotate());
+    CHECK(filter.contains(first));
+    later.push_back(random_hash());
+    filter.insert(later.back());
+  }
+  LOG_CHECK(filter.size() == buckets) << filter.size();
+
+  // the bucket of the first hash is the oldest one and is reused by the next rotation
+  auto memory = filter.memory_usage();
+  wait_rotation(filter);
+  CHECK(!filter.contains(first));
+  for (auto &hash : later) {
+    CHECK(filter.contains(hash));
+  }
+  LOG_CHECK(filter.size() == buckets - 1) << filter.size();
+  LOG_CHECK(filter.memory_usage() == memory) << filter.memory_usage() << " " << memory;
+
+  for (td::uint32 i = 1; i < buckets; i++) {
+    wait_rotation(filter);
+  }
+  for (auto &hash : later) {
+    CHECK(!filter.contains(hash));
+  }
+  LOG_CHECK(filter.size() == 0) << filter.size();
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+
+  run_growth_test();
+  run_zero_fingerprint_test();
+  run_rotation_test();
+
+  LOG(INFO) << "OK";
+  return 0;
+}
@@ -0,0 +1,265 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "adnl/adnl.h"
+#include "adnl/utils.hpp"
+#include "adnl/adnl-test-loopback-implementation.h"
+#include "dht/dht.h"
+#include "overlay/overlays.h"
+#include "keyring/keyring.h"
+#include "td/utils/Time.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Random.h"
+#include "td/utils/port/signals.h"
+#include "td/utils/as.h"
+#include "common/errorlog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+// Broadcast completion time in a private overlay where part of the nodes have a slow uplink, with random and
+// bandwidth-aware neighbour selection. All broadcasts must complete, and ranking the neighbours must not be slower
+// than picking them at random.
+
+struct Node {
+  ton::PublicKeyHash id;
+  ton::adnl::AdnlNodeIdShort adnl_id;
+  ton::adnl::AdnlNodeIdFull adnl_id_full;
+  bool slow = false;
+};
+
+class Collector : public td::actor::Actor {
+ public:
+  Collector(td::uint32 nodes, td::uint32 broadcasts)
+      : nodes_(nodes), sent_at_(broadcasts, -1.0), received_(broadcasts, 0), all_at_(broadcasts, -1.0) {
+  }
+
+  void sent(td::uint32 idx) {
+    sent_at_[idx] = td::Time::now();
+  }
+  void received(td::uint32 idx) {
+    CHECK(idx < received_.size());
+    // the source delivers its own broadcast too
+    if (++received_[idx] == nodes_) {
+      all_at_[idx] = td::Time::now();
+    }
+  }
+
+  // completion times (all nodes received) of broadcasts in [from, to), -1 for incomplete ones
+  void get_completion_times(td::uint32 from, td::uint32 to, td::Promise<std::vector<double>> promise) {
+    std::vector<double> res;
+    for (td::uint32 i = from; i < to; i++) {
+      res.push_back(all_at_[i] >= 0 ? all_at_[i] - sent_at_[i] : -1.0);
+    }
+    promise.set_value(std::move(res));
+  }
+
+ private:
+  td::uint32 nodes_;
+  std::vector<double> sent_at_;
+  std::vector<td::uint32> received_;
+  std::vector<double> all_at_;
+};
+
+class OverlayCallback : public ton::overlay::Overlays::Callback {
+ public:
+  explicit OverlayCallback(td::actor::ActorId<Collector> collector) : collector_(collector) {
+  }
+  void receive_message(ton::adnl::AdnlNodeIdShort src, ton::overlay::OverlayIdShort overlay_id,
+                       td::BufferSlice data) override {
+  }
+  void receive_query(ton::adnl::AdnlNodeIdShort src, ton::overlay::OverlayIdShort overlay_id, td::BufferSlice data,
+                     td::Promise<td::BufferSlice> promise) override {
+    promise.set_error(td::Status::Error("unexpected query"));
+  }
+  void receive_broadcast(ton::PublicKeyHash src, ton::overlay::OverlayIdShort overlay_id,
+                         td::BufferSlice data) override {
+    CHECK(data.size() >= 4);
+    td::uint32 idx = td::as<td::uint32>(data.data());
+    td::actor::send_closure(collector_, &Collector::received, idx);
+  }
+
+ private:
+  td::actor::ActorId<Collector> collector_;
+};
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(verbosity_ERROR);
+  td::set_default_failure_signal_handler().ensure();
+
+  std::string db_root_ = "tmp-overlay-broadcast";
+  td::rmrf(db_root_).ignore();
+  td::mkdir(db_root_).ensure();
+
+  const td::uint32 total_nodes = 10;
+  const td::uint32 slow_nodes = 3;
+  const td::uint32 broadcasts = 30;
+  const td::uint32 warmup_broadcasts = 10;
+  const size_t broadcast_size = 8 << 10;
+  const double broadcast_period = 1.0;
+
+  td::actor::ActorOwn<ton::keyring::Keyring> keyring;
+  td::actor::ActorOwn<ton::adnl::TestLoopbackNetworkManager> network_manager;
+  td::actor::ActorOwn<ton::adnl::Adnl> adnl;
+  td::actor::ActorOwn<ton::overlay::Overlays> overlay_manager;
+
+  td::actor::Scheduler scheduler({7});
+  scheduler.run_in_context([&] {
+    ton::errorlog::ErrorLog::create(db_root_);
+    keyring = ton::keyring::Keyring::create(db_root_);
+    network_manager = td::actor::create_actor<ton::adnl::TestLoopbackNetworkManager>("test net");
+    adnl = ton::adnl::Adnl::create(db_root_, keyring.get());
+    overlay_manager =
+        ton::overlay::Overlays::create(db_root_, keyring.get(), adnl.get(), td::actor::ActorId<ton::dht::Dht>{});
+    td::actor::send_closure(adnl, &ton::adnl::Adnl::register_network_manager, network_manager.get());
+  });
+
+  auto run_for = [&](double seconds) {
+    auto t = td::Timestamp::in(seconds);
+    while (scheduler.run(1)) {
+      if (t.is_in_past()) {
+        break;
+      }
+    }
+  };
+
+  double avg_time[2] = {-1.0, -1.0};
+  for (bool prefer_fast_peers : {false, true}) {
+    std::vector<Node> nodes(total_nodes);
+    td::actor::ActorOwn<Collector> collector;
+    ton::overlay::OverlayIdFull overlay_id{td::BufferSlice{PSLICE() << "test-overlay-broadcast " << prefer_fast_peers}};
+    auto overlay_id_short = overlay_id.compute_short_id();
+
+    scheduler.run_in_context([&] {
+      collector = td::actor::create_actor<Collector>("collector", total_nodes, broadcasts);
+      auto addr = ton::adnl::TestLoopbackNetworkManager::generate_dummy_addr_list();
+
+      for (td::uint32 i = 0; i < total_nodes; i++) {
+        auto &n = nodes[i];
+        auto pk = ton::PrivateKey{ton::privkeys::Ed25519::random()};
+        auto pub = pk.compute_public_key();
+        n.id = pub.compute_short_id();
+        n.adnl_id_full = ton::adnl::AdnlNodeIdFull{pub};
+        n.adnl_id = ton::adnl::AdnlNodeIdShort{n.id};
+        // the source (node 0) is always fast
+        n.slow = i > 0 && i <= slow_nodes;
+        td::actor::send_closure(keyring, &ton::keyring::Keyring::add_key, std::move(pk), true, [](td::Unit) {});
+        td::actor::send_closure(adnl, &ton::adnl::Adnl::add_id, n.adnl_id_full, addr, static_cast<td::uint8>(0));
+        td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::add_node_id, n.adnl_id, true,
+                                true);
+        if (n.slow) {
+          td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::set_node_link, n.adnl_id,
+                                  0.1, 256.0 * 1024);
+        } else {
+          td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::set_node_link, n.adnl_id,
+                                  0.01, 16.0 * 1024 * 1024);
+        }
+      }
+
+      std::vector<ton::adnl::AdnlNodeIdShort> ids;
+      for (auto &n1 : nodes) {
+        ids.push_back(n1.adnl_id);
+        for (auto &n2 : nodes) {
+          td::actor::send_closure(adnl, &ton::adnl::Adnl::add_peer, n1.adnl_id, n2.adnl_id_full, addr);
+        }
+      }
+
+      ton::overlay::OverlayBroadcastOptions opts;
+      opts.prefer_fast_peers = prefer_fast_peers;
+      opts.neighbours_update_period = 1.0;
+      for (auto &n : nodes) {
+        td::actor::send_closure(overlay_manager, &ton::overlay::Overlays::create_private_overlay, n.adnl_id,
+                                overlay_id.clone(), ids, std::make_unique<OverlayCallback>(collector.get()),
+                                ton::overlay::OverlayPrivacyRules{ton::overlay::Overlays::max_fec_broadcast_size()});
+        td::actor::send_closure(overlay_manager, &ton::overlay::Overlays::set_broadcast_options, n.adnl_id,
+                                overlay_id_short, opts);
+      }
+    });
+    run_for(1.0);
+
+    for (td::uint32 idx = 0; idx < broadcasts; idx++) {
+      scheduler.run_in_context([&] {
+        td::BufferSlice data{broadcast_size};
+        td::Random::secure_bytes(data.as_slice());
+        td::as<td::uint32>(data.data()) = idx;
+        td::actor::send_closure(collector, &Collector::sent, idx);
+        td::actor::send_closure(overlay_manager, &ton::overlay::Overlays::send_broadcast_fec_ex, nodes[0].adnl_id,
+                                overlay_id_short, nodes[0].id, 0, std::move(data));
+      });
+      run_for(broadcast_period);
+    }
+    run_for(10.0);
+
+    std::atomic<bool> done{false};
+    std::vector<double> times;
+    td::uint32 incomplete = 0;
+    scheduler.run_in_context([&] {
+      td::actor::send_closure(collector, &Collector::get_completion_times, warmup_broadcasts, broadcasts,
+                              [&](td::Result<std::vector<double>> R) {
+                                for (auto t : R.move_as_ok()) {
+                                  if (t < 0) {
+                                    incomplete++;
+                                  } else {
+                                    times.push_back(t);
+                                  }
+                                }
+                                done = true;
+                              });
+    });
+    while (!done) {
+      scheduler.run(1);
+    }
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for (auto t : times) {
+      sum += t;
+    }
+    std::cout << (prefer_fast_peers ? "bandwidth-aware" : "random") << " neighbours: " << total_nodes << " nodes ("
+              << slow_nodes << " slow), " << (broadcast_size >> 10) << "KB broadcasts: completion time avg "
+              << (times.empty() ? -1.0 : sum / static_cast<double>(times.size())) << "s, p90 "
+              << (times.empty() ? -1.0 : times[times.size() * 9 / 10]) << "s, incomplete " << incomplete << std::endl;
+    LOG_CHECK(incomplete == 0) << incomplete << " broadcasts did not reach all nodes";
+    avg_time[prefer_fast_peers] = sum / static_cast<double>(times.size());
+
+    scheduler.run_in_context([&] {
+      for (auto &n : nodes) {
+        td::actor::send_closure(overlay_manager, &ton::overlay::Overlays::delete_overlay, n.adnl_id, overlay_id_short);
+      }
+      collector.reset();
+    });
+    run_for(1.0);
+  }
+
+  LOG_CHECK(avg_time[1] <= avg_time[0]) << "bandwidth-aware neighbours are slower than random ones: " << avg_time[1]
+                                          << "s vs " << avg_time[0] << "s";
+
+  td::rmrf(db_root_).ignore();
+  std::_Exit(0);
+  return 0;
+}
@@ -0,0 +1,175 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "validator/db/package.hpp"
+#include "td/actor/actor.h"
+#include "td/actor/MultiPromise.h"
+#include "td/utils/OptionParser.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/signals.h"
+#include "td/utils/Random.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
+
+#include <iostream>
+
+// Measures random reads of package entries by concurrent actors, with io_uring or with blocking threads.
+// The package should be larger than the RAM to measure the disk rather than the page cache.
+
+std::string path = "test-package-io.pack";
+int entries_n = 100000;
+int entry_size = 4096;
+int reads_n = 1000000;
+int concurrency = 64;
+int threads_n = 4;
+int blocking_threads_n = 16;
+bool use_blocking = false;
+
+std::vector<td::uint64> create_package() {
+  td::unlink(path).ignore();
+  auto package = ton::Package::open(path, false, true).move_as_ok();
+  std::vector<td::uint64> offsets;
+  std::string data(entry_size, 'a');
+  for (int i = 0; i < entries_n; i++) {
+    offsets.push_back(package.append(PSTRING() << "entry" << i, data, false));
+  }
+  package.sync();
+  return offsets;
+}
+
+class Reader : public td::actor::Actor {
+ public:
+  Reader(std::shared_ptr<ton::Package> package, const std::vector<td::uint64> &offsets, int reads,
+         td::Promise<td::Unit> promise)
+      : package_(std::move(package)), offsets_(offsets), reads_(reads), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    for (int i = 0; i < concurrency; i++) {
+      read_next();
+    }
+  }
+
+ private:
+  std::shared_ptr<ton::Package> package_;
+  const std::vector<td::uint64> &offsets_;
+  int reads_;
+  td::Promise<td::Unit> promise_;
+  int started_ = 0;
+  int finished_ = 0;
+
+  void read_next() {
+    if (started_ == reads_) {
+      return;
+    }
+    started_++;
+    auto offset = offsets_[td::Random::fast(0, static_cast<int>(offsets_.size()) - 1)];
+    auto P = [self = this](td::Result<std::pair<std::string, td::BufferSlice>> R) {
+      CHECK(R.move_as_ok().second.size() == static_cast<size_t>(entry_size));
+      self->on_read();
+    };
+    if (use_blocking) {
+      td::actor::run_blocking([package = package_, offset] { return package->read(offset); }, std::move(P));
+    } else {
+      package_->read_async(offset, std::move(P));
+    }
+  }
+
+  void on_read() {
+    if (++finished_ == reads_) {
+      promise_.set_value(td::Unit());
+      stop();
+      return;
+    }
+    read_next();
+  }
+};
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+  td::set_default_failure_signal_handler().ensure();
+
+  td::OptionParser p;
+  p.set_description("benchmark of concurrent random reads from a package");
+  p.add_option('h', "help", "prints_help", [&]() {
+    char b[10240];
+    td::StringBuilder sb(td::MutableSlice{b, 10000});
+    sb << p;
+    std::cout << sb.as_cslice().c_str();
+    std::exit(2);
+  });
+  p.add_option('f', "file", "path to the test package", [&](td::Slice arg) { path = arg.str(); });
+  p.add_option('n', "entries", "number of entries in the package", [&](td::Slice arg) {
+    entries_n = td::to_integer<int>(arg);
+  });
+  p.add_option('s', "entry-size", "size of an entry", [&](td::Slice arg) { entry_size = td::to_integer<int>(arg); });
+  p.add_option('r', "reads", "total number of reads", [&](td::Slice arg) { reads_n = td::to_integer<int>(arg); });
+  p.add_option('c', "concurrency", "reads in flight per reader actor", [&](td::Slice arg) {
+    concurrency = td::to_integer<int>(arg);
+  });
+  p.add_option('t', "threads", "number of cpu threads and reader actors", [&](td::Slice arg) {
+    threads_n = td::to_integer<int>(arg);
+  });
+  p.add_option('B', "blocking-threads", "number of blocking threads", [&](td::Slice arg) {
+    blocking_threads_n = td::to_integer<int>(arg);
+  });
+  p.add_option('b', "blocking", "read on blocking threads instead of io_uring", [&] { use_blocking = true; });
+
+  auto res = p.run(argc, argv);
+  LOG_IF(FATAL, res.is_error()) << res.error();
+
+  auto offsets = create_package();
+  auto package = std::make_shared<ton::Package>(ton::Package::open(path, true).move_as_ok());
+
+  td::actor::Scheduler scheduler(
+      {td::actor::Scheduler::NodeInfo{static_cast<size_t>(threads_n)}.with_blocking_threads(blocking_threads_n)});
+  double started_at = 0;
+  scheduler.run_in_context([&] {
+    started_at = td::Time::now();
+    td::MultiPromise mp;
+    auto ig = mp.init_guard();
+    ig.add_promise([&](td::Result<td::Unit> R) {
+      R.ensure();
+      auto elapsed = td::Time::now() - started_at;
+      auto stats = td::actor::get_file_io_stats();
+      LOG(INFO) << reads_n << " reads in " << elapsed << "s: " << static_cast<td::int64>(reads_n / elapsed)
+                << " IOPS, io_uring tasks " << stats.tasks << " submits " << stats.submits << " max in flight "
+                << stats.max_in_flight;
+      td::actor::SchedulerContext::get()->stop();
+    });
+    for (int i = 0; i < threads_n; i++) {
+      auto reads = reads_n / threads_n + (i < reads_n % threads_n ? 1 : 0);
+      td::actor::create_actor<Reader>(PSLICE() << "Reader" << i, package, offsets, reads, ig.get_promise()).release();
+    }
+  });
+  scheduler.run();
+
+  package.reset();
+  td::unlink(path).ignore();
+  return 0;
+}
@@ -0,0 +1,395 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "validator/db/package.hpp"
+#include "td/actor/actor.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Random.h"
+#include "td/utils/ThreadSafeCounter.h"
+
+#include <atomic>
+#include <functional>
+
+static std::string dir;
+
+static td::int64 counter(td::Slice name) {
+  return td::NamedThreadSafeCounter::get_default().get_counter(name).sum();
+}
+
+static std::string random_data(size_t size) {
+  std::string res(size, '\0');
+  td::Random::secure_bytes(res);
+  return res;
+}
+
+static ton::Package create_package(std::string name) {
+  auto path = dir + TD_DIR_SLASH + name;
+  td::unlink(path).ignore();
+  return ton::Package::open(path, false, true).move_as_ok();
+}
+
+static void check_entry(const ton::Package &package, td::uint64 offset, td::Slice filename, td::Slice data) {
+  auto entry = package.read(offset).move_as_ok();
+  CHECK(entry.first == filename);
+  CHECK(entry.second.as_slice() == data);
+}
+
+static void run_cache_test() {
+  auto package = create_package("cache.pack");
+  std::vector<std::string> entries;
+  std::vector<td::uint64> offsets;
+  for (int i = 0; i < 100; i++) {
+    entries.push_back(random_data(16 << 10));
+    offsets.push_back(package.append(PSTRING() << "entry" << i, entries.back(), false));
+  }
+
+  auto miss = counter("package.cache.miss");
+  auto readahead = counter("package.cache.readahead");
+  for (size_t i = 0; i < entries.size(); i++) {
+    check_entry(package, offsets[i], PSLICE() << "entry" << i, entries[i]);
+  }
+  auto first_misses = counter("package.cache.miss") - miss;
+  CHECK(first_misses > 0);
+  // sequential reads read ahead, so there are fewer misses than blocks
+  LOG_CHECK(first_misses < 100 * 16 / 64) << first_misses;
+  CHECK(counter("package.cache.readahead") > readahead);
+
+  // the first half of the package consists of complete blocks, which are cached now
+  auto hit = counter("package.cache.hit");
+  miss = counter("package.cache.miss");
+  for (size_t i = 0; i < entries.size() / 2; i++) {
+    check_entry(package, offsets[i], PSLICE() << "entry" << i, entries[i]);
+  }
+  CHECK(counter("package.cache.miss") == miss);
+  CHECK(counter("package.cache.hit") > hit);
+
+  // another package with the same offsets doesn't see these blocks
+  auto other = create_package("cache-other.pack");
+  auto other_data = random_data(16 << 10);
+  CHECK(other.append("entry0", other_data, false) == offsets[0]);
+  check_entry(other, offsets[0], "entry0", other_data);
+  check_entry(package, offsets[0], "entry0", entries[0]);
+}
+
+static void run_truncate_test() {
+  auto package = create_package("truncate.pack");
+  std::vector<td::uint64> offsets;
+  for (int i = 0; i < 50; i++) {
+    offsets.push_back(package.append(PSTRING() << "entry" << i, random_data(16 << 10), false));
+  }
+  for (auto offset : offsets) {
+    package.read(offset).ensure();
+  }
+  package.truncate(offsets[10]).ensure();
+  for (int i = 10; i < 50; i++) {
+    auto data = random_data(16 << 10);
+    CHECK(package.append(PSTRING() << "fresh" << i, data, false) == offsets[i]);
+    check_entry(package, offsets[i], PSLICE() << "fresh" << i, data);
+  }
+  package.truncate(0).ensure();
+  CHECK(package.size() == 0);
+  CHECK(package.read(offsets[0]).is_error());
+}
+
+// Reads of the whole package race with truncate and rewrite of it. A read, which started before truncate,
+// must not put old blocks into the cache, otherwise reads after the rewrite return old data.
+static void run_truncate_race_test() {
+  auto package = create_package("race.pack");
+  auto path = dir + TD_DIR_SLASH + "race.pack";
+  constexpr int versions_n = 1000;
+  constexpr int readers_n = 4;
+  std::vector<std::string> versions(versions_n);
+  // odd while the package is being rewritten, 2 * version otherwise
+  std::atomic<int> seq{1};
+  std::atomic<bool> stop{false};
+  std::atomic<int> checked{0};
+
+  auto write_version = [&](int version) {
+    package.truncate(0).ensure();
+    for (int i = 0; i < 10; i++) {
+      package.append(PSTRING() << "entry" << i, std::string(20000, static_cast<char>('a' + version % 26)), false);
+    }
+    versions[version] = td::read_file_str(path).move_as_ok();
+  };
+  write_version(0);
+  seq = 0;
+  auto size = versions[0].size();
+
+  auto read_loop = [&] {
+    while (!stop.load()) {
+      auto s1 = seq.load();
+      if (s1 % 2 != 0) {
+        continue;
+      }
+      auto R = package.read_raw(0, size);
+      if (seq.load() != s1) {
+        continue;
+      }
+      auto data = R.move_as_ok();
+      LOG_CHECK(data.as_slice() == versions[s1 / 2]) << "stale data of version " << s1 / 2;
+      checked++;
+    }
+  };
+  std::vector<td::thread> readers;
+  for (int i = 0; i < readers_n; i++) {
+    readers.emplace_back(read_loop);
+  }
+  for (int version = 1; version < versions_n; version++) {
+    seq = 2 * version - 1;
+    write_version(version);
+    seq = 2 * version;
+    auto start = checked.load();
+    while (checked.load() < start + readers_n) {
+      td::this_thread::yield();
+    }
+  }
+  stop = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+// Reads all entries with read_async, the given number of times
+class AsyncReader : public td::actor::Actor {
+ public:
+  using OnPass = std::function<void(int pass, td::int64 misses)>;
+
+  AsyncReader(std::shared_ptr<ton::Package> package, std::vector<std::string> entries, std::vector<td::uint64> offsets,
+              int passes, OnPass on_pass)
+      : package_(std::move(package))
+      , entries_(std::move(entries))
+      , offsets_(std::move(offsets))
+      , passes_(passes)
+      , on_pass_(std::move(on_pass)) {
+  }
+  void start_up() override {
+    read_all();
+  }
+
+  static void run(std::shared_ptr<ton::Package> package, std::vector<std::string> entries,
+                  std::vector<td::uint64> offsets, int passes, OnPass on_pass) {
+    td::actor::Scheduler scheduler({td::actor::Scheduler::NodeInfo{2}.with_blocking_threads(2)});
+    scheduler.run_in_context([&] {
+      td::actor::create_actor<AsyncReader>("AsyncReader", std::move(package), std::move(entries), std::move(offsets),
+                                           passes, std::move(on_pass))
+          .release();
+    });
+    scheduler.run();
+  }
+
+ private:
+  std::shared_ptr<ton::Package> package_;
+  std::vector<std::string> entries_;
+  std::vector<td::uint64> offsets_;
+  int passes_;
+  OnPass on_pass_;
+  size_t pending_ = 0;
+  int pass_ = 0;
+  td::int64 miss_ = 0;
+
+  void read_all() {
+    miss_ = counter("package.cache.miss");
+    pending_ = entries_.size();
+    for (size_t i = 0; i < entries_.size(); i++) {
+      package_->read_async(offsets_[i], [self = this, i](td::Result<std::pair<std::string, td::BufferSlice>> R) {
+        auto entry = R.move_as_ok();
+        CHECK(entry.second.as_slice() == self->entries_[i]);
+        if (--self->pending_ == 0) {
+          self->on_pass_finished();
+        }
+      });
+    }
+  }
+  void on_pass_finished() {
+    auto misses = counter("package.cache.miss") - miss_;
+    LOG(INFO) << "pass " << pass_ << ": " << misses << " misses";
+    on_pass_(pass_, misses);
+    if (++pass_ < passes_) {
+      read_all();
+      return;
+    }
+    td::actor::SchedulerContext::get()->stop();
+    stop();
+  }
+};
+
+// read_async shares the cache with read: the second pass is served from the cache
+static void run_read_async_test() {
+  auto package = std::make_shared<ton::Package>(create_package("async.pack"));
+  std::vector<std::string> entries;
+  std::vector<td::uint64> offsets;
+  for (int i = 0; i < 100; i++) {
+    // small entries, entries crossing blocks and entries larger than the first read
+    entries.push_back(random_data(i % 10 == 0 ? 100000 + i : 1 + i * 311 % 30000));
+    offsets.push_back(package->append(PSTRING() << "entry" << i, entries.back(), false));
+  }
+  entries.push_back(random_data(3 << 20));
+  offsets.push_back(package->append("large", entries.back(), false));
+
+  AsyncReader::run(package, std::move(entries), std::move(offsets), 2, [](int pass, td::int64 misses) {
+    if (pass == 0) {
+      CHECK(misses > 0);
+    } else {
+      // only the last block of the package is incomplete, so it is not cached
+      LOG_CHECK(misses <= 1) << misses;
+    }
+  });
+}
+
+// similar entries, which compress well with a dictionary
+static std::string block_like_data(td::Random::Xorshift128plus &rnd) {
+  std::string res;
+  auto n = rnd.fast(20, 200);
+  for (int i = 0; i < n; i++) {
+    res += PSTRING() << "account " << rnd.fast(0, 1000) << " balance " << rnd.fast(0, 1000000) << " state "
+                     << (rnd.fast(0, 1) ? "active" : "frozen") << ";";
+  }
+  return res;
+}
+
+static void run_compression_test() {
+  td::Random::Xorshift128plus rnd(123);
+  std::vector<std::string> samples;
+  for (int i = 0; i < 100; i++) {
+    samples.push_back(block_like_data(rnd));
+  }
+  std::vector<td::Slice> sample_slices(samples.begin(), samples.end());
+  auto compression = std::make_shared<ton::PackageCompression>();
+  compression->level = 6;
+  compression->dictionary = ton::Package::train_dictionary(sample_slices, 4096);
+  CHECK(!compression->dictionary.empty());
+
+  auto path = dir + TD_DIR_SLASH + "compressed.pack";
+  auto package = std::make_shared<ton::Package>(create_package("compressed.pack"));
+  package->set_compression(compression);
+  CHECK(!package->has_compressed_entries().move_as_ok());
+
+  std::vector<std::string> names;
+  std::vector<std::string> entries;
+  std::vector<td::uint64> offsets;
+  size_t raw_size = 0;
+  auto append = [&](std::string data) {
+    names.push_back(PSTRING() << "entry" << 1000 + names.size());
+    entries.push_back(std::move(data));
+    offsets.push_back(package->append(names.back(), entries.back(), false));
+    raw_size += entries.back().size();
+  };
+  // the first entry is too small to be compressed, random data doesn't compress
+  append("small");
+  append(random_data(10000));
+  CHECK(!package->has_compressed_entries().move_as_ok());
+  for (int i = 0; i < 50; i++) {
+    append(block_like_data(rnd));
+  }
+  CHECK(package->has_compressed_entries().move_as_ok());
+  LOG(INFO) << "compressed " << raw_size << " bytes to " << package->size();
+  LOG_CHECK(package->size() * 3 < raw_size) << package->size() << " " << raw_size;
+
+  auto check_all = [&] {
+    for (size_t i = 0; i < entries.size(); i++) {
+      check_entry(*package, offsets[i], names[i], entries[i]);
+    }
+    // the dictionary entry is skipped
+    size_t i = 0;
+    package->iterate([&](std::string filename, td::BufferSlice data, td::uint64 offset) {
+      CHECK(i < entries.size());
+      CHECK(filename == names[i]);
+      CHECK(data.as_slice() == entries[i]);
+      CHECK(offset == offsets[i]);
+      i++;
+      return true;
+    });
+    CHECK(i == entries.size());
+    AsyncReader::run(package, entries, offsets, 1, [](int pass, td::int64 misses) {});
+  };
+  check_all();
+
+  // truncate after the dictionary, it is still used by new entries
+  package->truncate(offsets[20]).ensure();
+  names.resize(20);
+  entries.resize(20);
+  offsets.resize(20);
+  for (int i = 0; i < 10; i++) {
+    append(block_like_data(rnd));
+  }
+  check_all();
+
+  // the dictionary is found after reopen instead of being written again
+  auto size = package->size();
+  package = std::make_shared<ton::Package>(ton::Package::open(path).move_as_ok());
+  package->set_compression(compression);
+  append(block_like_data(rnd));
+  LOG_CHECK(package->size() - size < compression->dictionary.size()) << package->size() - size;
+  check_all();
+
+  // truncate before the dictionary, which precedes the first compressed entry, it is written again
+  package->truncate(package->advance(offsets[1]).move_as_ok()).ensure();
+  names.resize(2);
+  entries.resize(2);
+  offsets.resize(2);
+  CHECK(!package->has_compressed_entries().move_as_ok());
+  size = package->size();
+  append(block_like_data(rnd));
+  LOG_CHECK(package->size() - size > compression->dictionary.size()) << package->size() - size;
+  CHECK(package->has_compressed_entries().move_as_ok());
+  check_all();
+}
+
+static void run_read_raw_test() {
+  auto package = create_package("raw.pack");
+  auto data = random_data(1000);
+  package.append("entry", data, false);
+  auto file_size = package.size() + 4;
+
+  auto head = package.read_raw(0, 4).move_as_ok();
+  CHECK(head.size() == 4);
+  auto tail = package.read_raw(file_size - 1000, 2000).move_as_ok();
+  CHECK(tail.as_slice() == data);
+  CHECK(package.read_raw(file_size, 100).move_as_ok().empty());
+  CHECK(package.read_raw(file_size + 1, 100).is_error());
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+  dir = "test-package-dir";
+  td::rmrf(dir).ignore();
+  td::mkdir(dir).ensure();
+
+  run_cache_test();
+  run_truncate_test();
+  run_truncate_race_test();
+  run_read_async_test();
+  run_compression_test();
+  run_read_raw_test();
+
+  td::rmrf(dir).ensure();
+  LOG(INFO) << "OK";
+  return 0;
+}
@@ -34,6 +34,7 @@
 #include "td/utils/port/path.h"
 #include "td/utils/Random.h"
 
+#include <ctime>
 #include <memory>
 #include <set>
 
@@ -138,10 +139,17 @@ int main() {
 
   std::vector<td::uint32> sizes{1, 1024, 1 << 20, 2 << 20, 3 << 20, 10 << 20, 16 << 20};
 
+  auto report = [](td::uint32 size, double time, std::clock_t cpu_ticks) {
+    auto cpu_time = static_cast<double>(cpu_ticks) / CLOCKS_PER_SEC;
+    LOG(ERROR) << "success. Time=" << time << " speed=" << static_cast<double>(size) * 8 / time / 1e9 << "Gbps"
+               << " cpu=" << cpu_time * 1e9 / size << "ns/byte";
+  };
+
   for (auto &size : sizes) {
     LOG(ERROR) << "testing delivering of packet of size " << size;
 
     auto f = td::Clocks::system();
+    auto cpu_f = std::clock();
     scheduler.run_in_context([&] {
       remaining++;
       td::actor::send_closure(rldp, &ton::rldp2::Rldp::send_query_ex, src, dst, std::string("t"),
@@ -162,7 +170,7 @@ int main() {
       }
     }
 
-    LOG(ERROR) << "success. Time=" << (td::Clocks::system() - f);
+    report(size, td::Clocks::system() - f, std::clock() - cpu_f);
   }
 
   scheduler.run_in_context([&] {
@@ -174,6 +182,7 @@ int main() {
     LOG(ERROR) << "testing delivering of packet of size " << size;
 
     auto f = td::Clocks::system();
+    auto cpu_f = std::clock();
     scheduler.run_in_context([&] {
       remaining++;
       td::actor::send_closure(rldp, &ton::rldp2::Rldp::send_query_ex, src, dst, std::string("t"),
@@ -194,7 +203,7 @@ int main() {
       }
     }
 
-    LOG(ERROR) << "success. Time=" << (td::Clocks::system() - f);
+    report(size, td::Clocks::system() - f, std::clock() - cpu_f);
   }
 
   td::rmrf(db_root_).ensure();
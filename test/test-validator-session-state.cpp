@@ -32,10 +32,12 @@
 #include "td/utils/port/path.h"
 #include "td/utils/Random.h"
 
+#include "keys/keys.hpp"
 #include "validator-session/validator-session-description.h"
 #include "validator-session/validator-session-state.h"
 
 #include <limits>
+#include <map>
 #include <memory>
 #include <set>
 
@@ -59,6 +61,24 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   void clear_temp_memory() override {
     pdata_cur_[1] = 0;
   }
+  // compaction is tested with the real description in run_compaction_test
+  bool need_compaction() const override {
+    return false;
+  }
+  void start_compaction() override {
+    UNREACHABLE();
+  }
+  void finish_compaction() override {
+    UNREACHABLE();
+  }
+  const RootObject *get_moved(const RootObject *obj) const override {
+    return nullptr;
+  }
+  void set_moved(const RootObject *from, const RootObject *to) override {
+  }
+  MemoryStats get_memory_stats() const override {
+    return MemoryStats{pdata_cur_[0], pdata_cur_[0], pdata_cur_[0], 0, 0, 0};
+  }
 
   ton::PublicKeyHash get_source_id(td::uint32 idx) const override {
     CHECK(idx < total_nodes_);
@@ -228,6 +248,110 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   size_t pdata_size_[2];
 };
 
+// Runs the same random session on two real descriptions and compacts the persistent memory of the first one
+// from time to time, the states of both sessions must stay equal
+void run_compaction_test(td::uint32 total_nodes) {
+  using ton::validatorsession::ValidatorSessionState;
+  ton::validatorsession::ValidatorSessionOptions opts;
+  std::vector<ton::validatorsession::ValidatorSessionNode> nodes;
+  for (td::uint32 i = 0; i < total_nodes; i++) {
+    auto pub_key = ton::PrivateKey{ton::privkeys::Ed25519::random()}.compute_public_key();
+    nodes.push_back(ton::validatorsession::ValidatorSessionNode{
+        pub_key, ton::adnl::AdnlNodeIdShort{pub_key.compute_short_id()}, 1});
+  }
+  auto local_id = nodes[0].pub_key.compute_short_id();
+  auto desc = ton::validatorsession::ValidatorSessionDescription::create(opts, nodes, local_id);
+  auto ref_desc = ton::validatorsession::ValidatorSessionDescription::create(opts, nodes, local_id);
+
+  // the last state of each node is a live root, older states become garbage
+  std::vector<const ValidatorSessionState *> states(total_nodes);
+  std::vector<const ValidatorSessionState *> ref_states(total_nodes);
+  for (td::uint32 i = 0; i < total_nodes; i++) {
+    states[i] = ValidatorSessionState::move_to_persistent(*desc, ValidatorSessionState::create(*desc));
+    ref_states[i] = ValidatorSessionState::move_to_persistent(*ref_desc, ValidatorSessionState::create(*ref_desc));
+  }
+
+  td::uint32 att = 1000000000;
+  td::uint32 compactions = 0;
+  for (td::uint32 step = 0; step < 20000; step++) {
+    auto x = td::Random::fast(0, static_cast<td::int32>(total_nodes - 1));
+    auto y = td::Random::fast(0, static_cast<td::int32>(total_nodes - 1));
+    auto s = ValidatorSessionState::merge(*desc, states[x], states[y]);
+    auto r = ValidatorSessionState::merge(*ref_desc, ref_states[x], ref_states[y]);
+    auto apply = [&](ton::ton_api::validatorSession_round_Message *act) {
+      s = ValidatorSessionState::action(*desc, s, x, att, act);
+      r = ValidatorSessionState::action(*ref_desc, r, x, att, act);
+    };
+
+    auto round = s->cur_round_seqno();
+    if (desc->get_node_priority(x, round) >= 0 && !s->check_block_is_sent_by(*desc, x)) {
+      auto act = ton::create_tl_object<ton::ton_api::validatorSession_message_submittedBlock>(
+          round, ton::Bits256::zero(), ton::Bits256::zero(), ton::Bits256::zero());
+      apply(act.get());
+    }
+    auto vec = s->choose_blocks_to_approve(*desc, x);
+    if (vec.size() > 0) {
+      auto B = vec[td::Random::fast(0, static_cast<td::int32>(vec.size() - 1))];
+      td::BufferSlice sig{B ? 1u : 0u};
+      if (B) {
+        sig.as_slice()[0] = 127;
+      }
+      auto act = ton::create_tl_object<ton::ton_api::validatorSession_message_approvedBlock>(
+          round, ton::validatorsession::SentBlock::get_block_id(B), std::move(sig));
+      apply(act.get());
+    }
+    bool found;
+    auto to_sign = s->choose_block_to_sign(*desc, x, found);
+    if (found) {
+      td::BufferSlice sig{to_sign ? 1u : 0u};
+      if (to_sign) {
+        sig.as_slice()[0] = 126;
+      }
+      auto act = ton::create_tl_object<ton::ton_api::validatorSession_message_commit>(
+          round, ton::validatorsession::SentBlock::get_block_id(to_sign), std::move(sig));
+      apply(act.get());
+    }
+    while (true) {
+      auto act = s->create_action(*desc, x, att);
+      apply(act.get());
+      if (act->get_id() == ton::ton_api::validatorSession_message_empty::ID) {
+        break;
+      }
+    }
+
+    states[x] = ValidatorSessionState::move_to_persistent(*desc, s);
+    ref_states[x] = ValidatorSessionState::move_to_persistent(*ref_desc, r);
+    CHECK(states[x]->get_hash(*desc) == ref_states[x]->get_hash(*ref_desc));
+    desc->clear_temp_memory();
+    ref_desc->clear_temp_memory();
+    if (step % 100 == 99) {
+      att++;
+    }
+
+    if (step % 1000 == 999) {
+      auto before = desc->get_memory_stats();
+      desc->start_compaction();
+      for (auto &st : states) {
+        st = ValidatorSessionState::move_to_persistent(*desc, st);
+      }
+      desc->finish_compaction();
+      auto after = desc->get_memory_stats();
+      LOG_CHECK(after.arena_bytes < before.arena_bytes) << before.arena_bytes << " " << after.arena_bytes;
+      CHECK(after.compactions == before.compactions + 1);
+      for (td::uint32 i = 0; i < total_nodes; i++) {
+        CHECK(desc->is_persistent(states[i]));
+        CHECK(states[i]->get_hash(*desc) == ref_states[i]->get_hash(*ref_desc));
+      }
+      compactions++;
+    }
+  }
+  auto stats = desc->get_memory_stats();
+  auto ref_stats = ref_desc->get_memory_stats();
+  LOG(ERROR) << "compacted " << compactions << " times: arena " << stats.arena_bytes << " bytes, without compaction "
+             << ref_stats.arena_bytes << " bytes";
+  CHECK(stats.arena_bytes < ref_stats.arena_bytes);
+}
+
 double myrand() {
   return td::Random::fast(0, 100) * 0.01;
 }
@@ -994,6 +1118,8 @@ int main() {
     delete descptr;
   }
 
+  run_compaction_test(20);
+
   std::_Exit(0);
   return 0;
 }
@@ -73,6 +73,9 @@ class TestNode : public td::actor::Actor {
       void on_generate_slot(td::uint32 round, td::Promise<ton::BlockCandidate> promise) override {
         td::actor::send_closure(id_, &TestNode::on_generate_slot, round, std::move(promise));
       }
+      void on_precollate_slot(td::uint32 round, ton::validatorsession::ValidatorSessionRootHash prev_root_hash,
+                              ton::validatorsession::ValidatorSessionFileHash prev_file_hash) override {
+      }
       void on_block_committed(td::uint32 round, ton::PublicKeyHash src,
                               ton::validatorsession::ValidatorSessionRootHash root_hash,
                               ton::validatorsession::ValidatorSessionFileHash file_hash, td::BufferSlice data,
@@ -0,0 +1,325 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "td/utils/filesystem.h"
+#include "td/utils/misc.h"
+#include "td/utils/OptionParser.h"
+#include "td/utils/PathView.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Random.h"
+#include "td/db/RocksDb.h"
+
+#include "validator/db/package.hpp"
+#include "validator/db/fileref.hpp"
+
+namespace {
+
+td::Result<ton::Package> open_package(const std::string &path) {
+  auto R = ton::Package::open(path, true, false);
+  if (R.is_error()) {
+    return R.move_as_error_prefix(PSTRING() << "failed to open archive '" << path << "': ");
+  }
+  return R.move_as_ok();
+}
+
+// Samples blocks of the packages uniformly and trains a dictionary on them
+td::Status train(const std::vector<std::string> &packages, size_t max_samples, size_t dictionary_size,
+                 const std::string &output) {
+  std::vector<td::BufferSlice> samples;
+  size_t seen = 0;
+  td::Random::Xorshift128plus rnd(123);
+  for (auto &path : packages) {
+    TRY_RESULT(p, open_package(path));
+    p.iterate([&](std::string filename, td::BufferSlice data, td::uint64 offset) -> bool {
+      if (!td::begins_with(filename, "block_")) {
+        return true;
+      }
+      seen++;
+      if (samples.size() < max_samples) {
+        samples.push_back(std::move(data));
+      } else {
+        auto i = static_cast<size_t>(rnd.fast64(0, static_cast<td::int64>(seen) - 1));
+        if (i < max_samples) {
+          samples[i] = std::move(data);
+        }
+      }
+      return true;
+    });
+  }
+  if (samples.empty()) {
+    return td::Status::Error("no blocks found");
+  }
+  std::vector<td::Slice> slices;
+  for (auto &sample : samples) {
+    slices.push_back(sample.as_slice());
+  }
+  auto dictionary = ton::Package::train_dictionary(slices, dictionary_size);
+  TRY_STATUS(td::write_file(output, dictionary));
+  std::cout << "trained dictionary of " << dictionary.size() << " bytes on " << samples.size() << " of " << seen
+            << " blocks\n";
+  return td::Status::OK();
+}
+
+// Packages of a sliced archive slice are numbered archive_id + slice_size * i, with the size of slice i
+// stored under "status.<i>"
+td::Result<td::uint32> archive_seqno(td::Slice path) {
+  auto parts = td::full_split(td::PathView(path).file_name(), '.');
+  if (parts.size() != 3 || parts[0] != "archive") {
+    return td::Status::Error(PSLICE() << "unexpected name of a sliced package '" << path << "'");
+  }
+  return td::to_integer_safe<td::uint32>(parts[1]);
+}
+
+td::Result<std::string> status_key(td::RocksDb &index, td::Slice package, td::Slice index_path) {
+  std::string value;
+  TRY_RESULT(R, index.get("status", value));
+  if (R == td::KeyValue::GetStatus::NotFound) {
+    return td::Status::Error("index has no status");
+  }
+  if (value != "sliced") {
+    return "status";
+  }
+  TRY_RESULT(R2, index.get("slice_size", value));
+  if (R2 == td::KeyValue::GetStatus::NotFound) {
+    return td::Status::Error("index has no slice size");
+  }
+  TRY_RESULT(slice_size, td::to_integer_safe<td::uint32>(value));
+  TRY_RESULT(archive_id, archive_seqno(index_path));
+  TRY_RESULT(seqno, archive_seqno(package));
+  if (slice_size == 0 || seqno < archive_id || (seqno - archive_id) % slice_size != 0) {
+    return td::Status::Error(PSLICE() << "package '" << package << "' doesn't belong to the index");
+  }
+  return PSTRING() << "status." << (seqno - archive_id) / slice_size;
+}
+
+using EntryOffsets = std::vector<std::pair<std::string, td::uint64>>;
+
+td::Status add_entry_offset(EntryOffsets &offsets, const std::string &filename, td::uint64 offset) {
+  auto R = ton::validator::FileReference::create(filename);
+  if (R.is_error()) {
+    return R.move_as_error_prefix(PSLICE() << "bad filename '" << filename << "': ");
+  }
+  offsets.emplace_back(R.move_as_ok().hash().to_hex(), offset);
+  return td::Status::OK();
+}
+
+td::Status update_index(td::RocksDb &index, const std::string &key, const EntryOffsets &offsets, td::uint64 size) {
+  TRY_STATUS(index.begin_transaction());
+  for (auto &x : offsets) {
+    std::string value;
+    TRY_RESULT(R, index.get(x.first, value));
+    // entries which are not in the index were lost by the node and stay unreachable
+    if (R == td::KeyValue::GetStatus::Ok) {
+      TRY_STATUS(index.set(x.first, td::to_string(x.second)));
+    }
+  }
+  TRY_STATUS(index.set(key, td::to_string(size)));
+  return index.commit_transaction();
+}
+
+// The package is replaced by the rewritten one before the index is updated. The marker file exists while they may
+// disagree, its content is the path of the index
+std::string migration_marker_path(const std::string &path) {
+  return path + ".migrating";
+}
+
+// Finishes the migration, which was interrupted. Returns false if the package wasn't replaced yet,
+// then the migration must be started again
+td::Result<bool> recover(const std::string &path, const std::string &tmp_path, td::RocksDb *index,
+                         const std::string &key) {
+  auto marker_path = migration_marker_path(path);
+  TRY_RESULT(marker, td::read_file_str(marker_path));
+  if (td::stat(tmp_path).is_ok()) {
+    TRY_STATUS(td::unlink(tmp_path));
+    TRY_STATUS(td::unlink(marker_path));
+    return false;
+  }
+  if (!marker.empty()) {
+    if (!index) {
+      return td::Status::Error(PSLICE() << "migration was interrupted, the index '" << marker << "' must be given");
+    }
+    TRY_RESULT(package, open_package(path));
+    EntryOffsets offsets;
+    td::Status error;
+    package.iterate([&](std::string filename, td::BufferSlice data, td::uint64 offset) -> bool {
+      error = add_entry_offset(offsets, filename, offset);
+      return error.is_ok();
+    });
+    TRY_STATUS(std::move(error));
+    TRY_STATUS(update_index(*index, key, offsets, package.size()));
+  }
+  TRY_STATUS(td::unlink(marker_path));
+  std::cout << path << ": finished interrupted migration\n";
+  return true;
+}
+
+// Rewrites the package with the given compression, level 0 stores all entries raw.
+// Offsets of the entries in the index of the archive slice are updated, if it is given
+td::Status migrate(const std::string &path, const std::string &index_path,
+                   std::shared_ptr<const ton::PackageCompression> compression) {
+  std::unique_ptr<td::RocksDb> index;
+  std::string key;
+  if (!index_path.empty()) {
+    TRY_RESULT(db, td::RocksDb::open(index_path));
+    index = std::make_unique<td::RocksDb>(std::move(db));
+    TRY_RESULT_ASSIGN(key, status_key(*index, path, index_path));
+  }
+
+  auto tmp_path = path + ".tmp";
+  auto marker_path = migration_marker_path(path);
+  if (td::stat(marker_path).is_ok()) {
+    TRY_RESULT(recovered, recover(path, tmp_path, index.get(), key));
+    if (recovered) {
+      return td::Status::OK();
+    }
+  }
+
+  TRY_RESULT(old_package, open_package(path));
+  auto old_size = old_package.size();
+  if (index) {
+    std::string value;
+    TRY_RESULT(R, index->get(key, value));
+    if (R == td::KeyValue::GetStatus::NotFound) {
+      return td::Status::Error(PSLICE() << "index has no " << key);
+    }
+    // the tail after the stored size is truncated by the archive slice on open
+    TRY_RESULT_ASSIGN(old_size, td::to_integer_safe<td::uint64>(value));
+  }
+
+  td::unlink(tmp_path).ignore();
+  TRY_RESULT(new_package, ton::Package::open(tmp_path, false, true));
+  new_package.set_compression(std::move(compression));
+
+  EntryOffsets offsets;
+  td::Status error;
+  old_package.iterate([&](std::string filename, td::BufferSlice data, td::uint64 offset) -> bool {
+    if (offset >= old_size) {
+      return false;
+    }
+    auto offset2 = new_package.append(filename, data.as_slice(), false);
+    if (index) {
+      error = add_entry_offset(offsets, filename, offset2);
+    }
+    return error.is_ok();
+  });
+  TRY_STATUS(std::move(error));
+  new_package.sync();
+
+  TRY_STATUS(td::atomic_write_file(marker_path, index_path));
+  TRY_STATUS(td::rename(tmp_path, path));
+  if (index) {
+    TRY_STATUS(update_index(*index, key, offsets, new_package.size()));
+  }
+  TRY_STATUS(td::unlink(marker_path));
+  std::cout << path << ": " << old_size << " -> " << new_package.size() << " bytes\n";
+  return td::Status::OK();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string train_output;
+  std::string index_path;
+  size_t max_samples = 2000;
+  size_t dictionary_size = 1 << 15;
+  auto compression = std::make_shared<ton::PackageCompression>();
+  compression->level = 6;
+
+  td::OptionParser p;
+  p.set_description(
+      "compresses entries of archive packages or trains a dictionary for them. "
+      "The node must be stopped while packages are migrated, keep a backup of the archive");
+  p.add_option('h', "help", "prints help", [&]() {
+    char b[10240];
+    td::StringBuilder sb(td::MutableSlice{b, 10000});
+    sb << p;
+    std::cout << sb.as_cslice().c_str();
+    std::exit(2);
+  });
+  p.add_option('t', "train", "train a dictionary on blocks of the packages and save it to the file",
+               [&](td::Slice arg) { train_output = arg.str(); });
+  p.add_checked_option('S', "samples", PSTRING() << "maximum number of sampled blocks (default=" << max_samples << ")",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(max_samples, td::to_integer_safe<size_t>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('s', "dictionary-size",
+                       PSTRING() << "maximum size of a trained dictionary (default=" << dictionary_size << ")",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(dictionary_size, td::to_integer_safe<size_t>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('d', "dictionary", "dictionary for compression", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(compression->dictionary, td::read_file_str(arg.str()));
+    return td::Status::OK();
+  });
+  p.add_checked_option('l', "level", "compression level in range [0..9], 0 decompresses (default=6)",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(compression->level, td::to_integer_safe<td::int32>(arg));
+                         if (compression->level < 0 || compression->level > 9) {
+                           return td::Status::Error("level should be in range [0..9]");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_option('i', "index", "index db of the archive slice of the packages, whose offsets are updated",
+               [&](td::Slice arg) { index_path = arg.str(); });
+  auto S = p.run(argc, argv);
+  if (S.is_error()) {
+    std::cerr << "failed to parse options: " << S.move_as_error().to_string() << "\n";
+    std::_Exit(2);
+  }
+  std::vector<std::string> packages;
+  for (auto arg : S.move_as_ok()) {
+    packages.emplace_back(arg);
+  }
+  if (packages.empty()) {
+    std::cerr << "no packages given\n";
+    std::_Exit(2);
+  }
+
+  if (!train_output.empty()) {
+    auto R = train(packages, max_samples, dictionary_size, train_output);
+    if (R.is_error()) {
+      std::cerr << "failed to train dictionary: " << R.to_string() << "\n";
+      std::_Exit(2);
+    }
+    return 0;
+  }
+  for (auto &path : packages) {
+    auto R = migrate(path, index_path, compression);
+    if (R.is_error()) {
+      std::cerr << "failed to migrate '" << path << "': " << R.to_string() << "\n";
+      std::_Exit(2);
+    }
+  }
+  return 0;
+}
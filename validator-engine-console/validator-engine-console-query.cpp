@@ -579,6 +579,89 @@ td::Status GetStatsQuery::receive(td::BufferSlice data) {
   return td::Status::OK();
 }
 
+td::Status GetActorProfileQuery::run() {
+  if (!tokenizer_.endl()) {
+    TRY_RESULT_ASSIGN(limit_, tokenizer_.get_token<td::int32>());
+  }
+  if (!tokenizer_.endl()) {
+    TRY_RESULT(reset, tokenizer_.get_token<std::string>());
+    if (reset != "reset") {
+      return td::Status::Error("expected 'reset'");
+    }
+    reset_ = true;
+  }
+  TRY_STATUS(tokenizer_.check_endl());
+  return td::Status::OK();
+}
+
+td::Status GetActorProfileQuery::send() {
+  auto b = ton::create_serialize_tl_object<ton::ton_api::engine_validator_getActorProfile>(limit_, reset_);
+  td::actor::send_closure(console_, &ValidatorEngineConsole::envelope_send_query, std::move(b), create_promise());
+  return td::Status::OK();
+}
+
+td::Status GetActorProfileQuery::receive(td::BufferSlice data) {
+  TRY_RESULT_PREFIX(f, ton::fetch_tl_object<ton::ton_api::engine_validator_actorProfile>(data.as_slice(), true),
+                    "received incorrect answer: ");
+  td::TerminalIO::out() << "total(s)\tcount\tavg(ms)\tmax(ms)\tqueue avg(ms)\tactor\tmessage\n";
+  for (auto &e : f->entries_) {
+    auto count = static_cast<double>(std::max<td::int64>(e->count_, 1));
+    td::TerminalIO::out() << td::StringBuilder::FixedDouble(e->total_time_, 3) << "\t" << e->count_ << "\t"
+                          << td::StringBuilder::FixedDouble(e->total_time_ / count * 1e3, 3) << "\t"
+                          << td::StringBuilder::FixedDouble(e->max_time_ * 1e3, 3) << "\t"
+                          << td::StringBuilder::FixedDouble(e->queue_delay_ / count * 1e3, 3) << "\t" << e->actor_
+                          << "\t" << e->message_ << "\n";
+  }
+  return td::Status::OK();
+}
+
+td::Status SetActorProfilingQuery::run() {
+  TRY_RESULT(enabled, tokenizer_.get_token<td::int32>());
+  if (enabled != 0 && enabled != 1) {
+    return td::Status::Error("expected 0 or 1");
+  }
+  enabled_ = enabled == 1;
+  TRY_STATUS(tokenizer_.check_endl());
+  return td::Status::OK();
+}
+
+td::Status SetActorProfilingQuery::send() {
+  auto b = ton::create_serialize_tl_object<ton::ton_api::engine_validator_setActorProfiling>(enabled_);
+  td::actor::send_closure(console_, &ValidatorEngineConsole::envelope_send_query, std::move(b), create_promise());
+  return td::Status::OK();
+}
+
+td::Status SetActorProfilingQuery::receive(td::BufferSlice data) {
+  TRY_RESULT_PREFIX(f, ton::fetch_tl_object<ton::ton_api::engine_validator_success>(data.as_slice(), true),
+                    "received incorrect answer: ");
+  td::TerminalIO::out() << "success\n";
+  return td::Status::OK();
+}
+
+td::Status GetHeapProfileQuery::run() {
+  TRY_RESULT_ASSIGN(file_name_, tokenizer_.get_token<std::string>());
+  TRY_STATUS(tokenizer_.check_endl());
+  return td::Status::OK();
+}
+
+td::Status GetHeapProfileQuery::send() {
+  auto b = ton::create_serialize_tl_object<ton::ton_api::engine_validator_getHeapProfile>();
+  td::actor::send_closure(console_, &ValidatorEngineConsole::envelope_send_query, std::move(b), create_promise());
+  return td::Status::OK();
+}
+
+td::Status GetHeapProfileQuery::receive(td::BufferSlice data) {
+  TRY_RESULT_PREFIX(f, ton::fetch_tl_object<ton::ton_api::engine_validator_heapProfile>(data.as_slice(), true),
+                    "received incorrect answer: ");
+  TRY_STATUS(td::write_file(file_name_, f->data_.as_slice()));
+  td::TerminalIO::out() << "saved heap profile to " << file_name_;
+  if (f->sample_rate_ > 0) {
+    td::TerminalIO::out() << " (one sample per " << f->sample_rate_ << " bytes)";
+  }
+  td::TerminalIO::out() << "\n";
+  return td::Status::OK();
+}
+
 td::Status QuitQuery::send() {
   td::actor::send_closure(console_, &ValidatorEngineConsole::close);
   return td::Status::OK();
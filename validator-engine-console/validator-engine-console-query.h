@@ -734,6 +734,73 @@ class GetStatsQuery : public Query {
   }
 };
 
+class GetActorProfileQuery : public Query {
+ public:
+  GetActorProfileQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
+      : Query(console, std::move(tokenizer)) {
+  }
+  td::Status run() override;
+  td::Status send() override;
+  td::Status receive(td::BufferSlice data) override;
+  static std::string get_name() {
+    return "getactorprofile";
+  }
+  static std::string get_help() {
+    return "getactorprofile [<limit> [reset]]\tprints time spent per actor and message type, most expensive first";
+  }
+  std::string name() const override {
+    return get_name();
+  }
+
+ private:
+  td::int32 limit_ = 50;
+  bool reset_ = false;
+};
+
+class SetActorProfilingQuery : public Query {
+ public:
+  SetActorProfilingQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
+      : Query(console, std::move(tokenizer)) {
+  }
+  td::Status run() override;
+  td::Status send() override;
+  td::Status receive(td::BufferSlice data) override;
+  static std::string get_name() {
+    return "setactorprofiling";
+  }
+  static std::string get_help() {
+    return "setactorprofiling <0|1>\tturns the collection of time spent per actor and message type off or on";
+  }
+  std::string name() const override {
+    return get_name();
+  }
+
+ private:
+  bool enabled_;
+};
+
+class GetHeapProfileQuery : public Query {
+ public:
+  GetHeapProfileQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
+      : Query(console, std::move(tokenizer)) {
+  }
+  td::Status run() override;
+  td::Status send() override;
+  td::Status receive(td::BufferSlice data) override;
+  static std::string get_name() {
+    return "heapprofile";
+  }
+  static std::string get_help() {
+    return "heapprofile <filename>\tsaves heap profile of a node built with memprof, view it with pprof";
+  }
+  std::string name() const override {
+    return get_name();
+  }
+
+ private:
+  std::string file_name_;
+};
+
 class QuitQuery : public Query {
  public:
   QuitQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
@@ -126,6 +126,9 @@ void ValidatorEngineConsole::run() {
   add_query_runner(std::make_unique<QueryRunnerImpl<GetConfigQuery>>());
   add_query_runner(std::make_unique<QueryRunnerImpl<SetVerbosityQuery>>());
   add_query_runner(std::make_unique<QueryRunnerImpl<GetStatsQuery>>());
+  add_query_runner(std::make_unique<QueryRunnerImpl<GetActorProfileQuery>>());
+  add_query_runner(std::make_unique<QueryRunnerImpl<SetActorProfilingQuery>>());
+  add_query_runner(std::make_unique<QueryRunnerImpl<GetHeapProfileQuery>>());
   add_query_runner(std::make_unique<QueryRunnerImpl<QuitQuery>>());
   add_query_runner(std::make_unique<QueryRunnerImpl<AddNetworkAddressQuery>>());
   add_query_runner(std::make_unique<QueryRunnerImpl<AddNetworkProxyAddressQuery>>());
@@ -42,6 +42,7 @@
 #include "td/utils/OptionParser.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/signals.h"
+#include "td/utils/port/CpuTopology.h"
 #include "td/utils/port/user.h"
 #include "td/utils/port/rlimit.h"
 #include "td/utils/ThreadSafeCounter.h"
@@ -54,6 +55,8 @@
 
 #include "dht/dht.hpp"
 
+#include "validator/db/package.hpp"
+
 #if TD_DARWIN || TD_LINUX
 #include <unistd.h>
 #endif
@@ -1639,6 +1642,7 @@ void ValidatorEngine::start_adnl() {
   adnl_network_manager_ = ton::adnl::AdnlNetworkManager::create(config_.out_port);
   adnl_ = ton::adnl::Adnl::create(db_root_, keyring_.get());
   td::actor::send_closure(adnl_, &ton::adnl::Adnl::register_network_manager, adnl_network_manager_.get());
+  td::actor::send_closure(adnl_, &ton::adnl::Adnl::set_query_admission_options, adnl_query_admission_);
 
   for (auto &addr : config_.addrs) {
     add_addr(addr.first, addr.second);
@@ -2994,6 +2998,64 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_setVerbos
   promise.set_value(ton::serialize_tl_object(ton::create_tl_object<ton::ton_api::engine_validator_success>(), true));
 }
 
+void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getActorProfile &query, td::BufferSlice data,
+                                        ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
+  if (!(perm & ValidatorEnginePermissions::vep_default)) {
+    promise.set_value(create_control_query_error(td::Status::Error(ton::ErrorCode::error, "not authorized")));
+    return;
+  }
+
+  if (!td::actor::core::ActorProfiler::is_enabled()) {
+    promise.set_value(create_control_query_error(
+        td::Status::Error(ton::ErrorCode::notready, "actor profiler is off, turn it on with setactorprofiling 1")));
+    return;
+  }
+  auto entries = td::actor::core::ActorProfiler::dump(query.reset_);
+  if (query.limit_ > 0 && entries.size() > static_cast<size_t>(query.limit_)) {
+    entries.resize(query.limit_);
+  }
+  std::vector<ton::tl_object_ptr<ton::ton_api::engine_validator_actorProfileEntry>> vec;
+  for (auto &e : entries) {
+    vec.push_back(ton::create_tl_object<ton::ton_api::engine_validator_actorProfileEntry>(
+        e.actor, e.message, e.count, e.total_time, e.total_queue_delay, e.max_time));
+  }
+  promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_actorProfile>(std::move(vec)));
+}
+
+void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_setActorProfiling &query, td::BufferSlice data,
+                                        ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
+  if (!(perm & ValidatorEnginePermissions::vep_default)) {
+    promise.set_value(create_control_query_error(td::Status::Error(ton::ErrorCode::error, "not authorized")));
+    return;
+  }
+
+  td::actor::core::ActorProfiler::set_enabled(query.enabled_);
+  promise.set_value(ton::serialize_tl_object(ton::create_tl_object<ton::ton_api::engine_validator_success>(), true));
+}
+
+void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getHeapProfile &query, td::BufferSlice data,
+                                        ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
+  if (!(perm & ValidatorEnginePermissions::vep_default)) {
+    promise.set_value(create_control_query_error(td::Status::Error(ton::ErrorCode::error, "not authorized")));
+    return;
+  }
+  if (!is_memprof_on()) {
+    promise.set_value(create_control_query_error(
+        td::Status::Error(ton::ErrorCode::notready, "memprof is off, build with -DMEMPROF=SAMPLE")));
+    return;
+  }
+
+  auto profile = get_pprof_heap_profile();
+  // leave some space for the envelope, answers are limited by the size of an ext message
+  if (profile.size() > (1 << 23)) {
+    promise.set_value(create_control_query_error(
+        td::Status::Error(ton::ErrorCode::error, PSTRING() << "heap profile is too big: " << profile.size())));
+    return;
+  }
+  promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_heapProfile>(
+      static_cast<td::int64>(get_memprof_sample_rate()), td::BufferSlice(profile)));
+}
+
 void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getStats &query, td::BufferSlice data,
                                         ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
   if (!(perm & ValidatorEnginePermissions::vep_default)) {
@@ -3007,12 +3069,28 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getStats
     return;
   }
 
+  std::vector<std::pair<std::string, std::string>> engine_stats;
+  auto blocking = td::actor::get_blocking_stats();
+  auto avg = [&](double total) { return blocking.tasks ? total / static_cast<double>(blocking.tasks) : 0.0; };
+  engine_stats.emplace_back("blocking.threads", PSTRING() << blocking.threads);
+  engine_stats.emplace_back("blocking.queue_size", PSTRING() << blocking.queue_size);
+  engine_stats.emplace_back("blocking.max_queue_size", PSTRING() << blocking.max_queue_size);
+  engine_stats.emplace_back("blocking.tasks", PSTRING() << blocking.tasks);
+  engine_stats.emplace_back("blocking.avg_wait", PSTRING() << avg(blocking.total_wait_time));
+  engine_stats.emplace_back("blocking.max_wait", PSTRING() << blocking.max_wait_time);
+  engine_stats.emplace_back("blocking.avg_run", PSTRING() << avg(blocking.total_run_time));
+  engine_stats.emplace_back("blocking.max_run", PSTRING() << blocking.max_run_time);
+
   auto P = td::PromiseCreator::lambda(
-      [promise = std::move(promise)](td::Result<std::vector<std::pair<std::string, std::string>>> R) mutable {
+      [promise = std::move(promise), engine_stats = std::move(engine_stats)](
+          td::Result<std::vector<std::pair<std::string, std::string>>> R) mutable {
         if (R.is_error()) {
           promise.set_value(create_control_query_error(R.move_as_error()));
         } else {
           auto r = R.move_as_ok();
+          for (auto &s : engine_stats) {
+            r.push_back(std::move(s));
+          }
           std::vector<ton::tl_object_ptr<ton::ton_api::engine_validator_oneStat>> vec;
           for (auto &s : r) {
             vec.push_back(ton::create_tl_object<ton::ton_api::engine_validator_oneStat>(s.first, s.second));
@@ -3020,7 +3098,25 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getStats
           promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_stats>(std::move(vec)));
         }
       });
-  td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::prepare_stats, std::move(P));
+  auto Q = td::PromiseCreator::lambda(
+      [adnl = adnl_.get(), P = std::move(P)](td::Result<std::vector<std::pair<std::string, std::string>>> R) mutable {
+        if (R.is_error()) {
+          P.set_error(R.move_as_error());
+          return;
+        }
+        td::actor::send_closure(
+            adnl, &ton::adnl::Adnl::get_stats,
+            [stats = R.move_as_ok(), P = std::move(P)](
+                td::Result<std::vector<std::pair<std::string, std::string>>> R) mutable {
+              if (R.is_ok()) {
+                for (auto &s : R.move_as_ok()) {
+                  stats.push_back(std::move(s));
+                }
+              }
+              P.set_value(std::move(stats));
+            });
+      });
+  td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::prepare_stats, std::move(Q));
 }
 
 void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_createElectionBid &query, td::BufferSlice data,
@@ -3258,10 +3354,20 @@ void dump_memory_stats() {
   LOG(WARNING) << td::tag("total", td::format::as_size(total_size));
   LOG(WARNING) << td::tag("total traces", get_ht_size());
   LOG(WARNING) << td::tag("fast_backtrace_success_rate", get_fast_backtrace_success_rate());
+  LOG(WARNING) << td::tag("sample_rate", get_memprof_sample_rate());
+}
+
+void dump_buffer_stats() {
+  auto stats = td::BufferAllocator::get_pool_stats();
+  auto pooled_mem = static_cast<td::uint64>(td::max<td::int64>(stats.pooled_mem, 0));
+  LOG(WARNING) << "buffers" << td::tag("mem", td::format::as_size(td::BufferAllocator::get_buffer_mem()))
+               << td::tag("pooled", td::format::as_size(pooled_mem)) << td::tag("allocs", stats.allocs)
+               << td::tag("pool_hits", stats.pool_hits);
 }
 
 void dump_stats() {
   dump_memory_stats();
+  dump_buffer_stats();
   LOG(WARNING) << td::NamedThreadSafeCounter::get_default();
 }
 
@@ -3374,6 +3480,96 @@ int main(int argc, char *argv[]) {
         threads = v;
         return td::Status::OK();
       });
+  td::uint32 blocking_threads = 4;
+  p.add_checked_option(
+      'B', "blocking-threads",
+      PSTRING() << "number of threads for blocking disk reads (default=" << blocking_threads << ")",
+      [&](td::Slice fname) {
+        td::int32 v;
+        try {
+          v = std::stoi(fname.str());
+        } catch (...) {
+          return td::Status::Error(ton::ErrorCode::error, "bad value for --blocking-threads: not a number");
+        }
+        if (v < 0 || v > 64) {
+          return td::Status::Error(ton::ErrorCode::error,
+                                   "bad value for --blocking-threads: should be in range [0..64]");
+        }
+        blocking_threads = v;
+        return td::Status::OK();
+      });
+  td::uint32 message_budget = 0;
+  p.add_checked_option('M', "message-budget",
+                       "run at most this many messages of an actor at once on the worker threads, so that a flooded "
+                       "actor doesn't hold a thread (default=0, no limit)",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(message_budget, td::to_integer_safe<td::uint32>(arg));
+                         return td::Status::OK();
+                       });
+  std::vector<td::int32> cpu_affinity;
+  p.add_checked_option('a', "cpu-affinity", "pin worker threads to the given cpus, e.g. 0-7,16-23",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(cpu_affinity, td::parse_cpu_list(arg));
+                         return td::Status::OK();
+                       });
+  std::vector<td::int32> consensus_cores;
+  p.add_checked_option('e', "consensus-cores", "run catchain and validator sessions on dedicated cpus",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(consensus_cores, td::parse_cpu_list(arg));
+                         return td::Status::OK();
+                       });
+  std::vector<td::int32> adnl_cores;
+  p.add_checked_option('n', "adnl-cores", "run adnl network manager on dedicated cpus", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(adnl_cores, td::parse_cpu_list(arg));
+    return td::Status::OK();
+  });
+  p.add_checked_option(
+      'z', "archive-compression",
+      "compress new entries of archive packages, <level>[:<dictionary file>] with level in range [1..9]; "
+      "nodes of older versions can't read compressed packages, so they are not served to other nodes",
+      [&](td::Slice arg) {
+        auto parts = td::split(arg, ':');
+        ton::PackageCompression compression;
+        TRY_RESULT_ASSIGN(compression.level, td::to_integer_safe<td::int32>(parts.first));
+        if (compression.level < 1 || compression.level > 9) {
+          return td::Status::Error(ton::ErrorCode::error,
+                                   "bad value for --archive-compression: level should be in range [1..9]");
+        }
+        if (!parts.second.empty()) {
+          TRY_RESULT_ASSIGN(compression.dictionary, td::read_file_str(parts.second.str()));
+        }
+        ton::Package::set_default_compression(std::move(compression));
+        return td::Status::OK();
+      });
+  p.add_option('\0', "no-profile-actors",
+               "do not collect time spent per actor class and message type at start, see setactorprofiling",
+               [&]() { td::actor::core::ActorProfiler::set_enabled(false); });
+  p.add_checked_option(
+      'Q', "adnl-query-limits",
+      "limits for inbound queries of one peer, <max in flight>:<queries per second>:<MB per second>; "
+      "0 disables a limit, consensus queries are not limited",
+      [&](td::Slice arg) {
+        auto parts = td::full_split(arg, ':');
+        if (parts.size() != 3) {
+          return td::Status::Error(ton::ErrorCode::error, "bad value for --adnl-query-limits: expected three numbers");
+        }
+        ton::adnl::AdnlQueryAdmissionOptions opts;
+        TRY_RESULT(inflight, td::to_integer_safe<td::uint32>(parts[0]));
+        TRY_RESULT(queries, td::to_integer_safe<td::uint32>(parts[1]));
+        TRY_RESULT(mbytes, td::to_integer_safe<td::uint32>(parts[2]));
+        // bursts are four seconds of the rate, a single category gets half of the peer's rate
+        opts.peer_max_inflight = inflight;
+        opts.peer_queries_rate = queries;
+        opts.peer_queries_burst = opts.peer_queries_rate * 4;
+        opts.peer_bytes_rate = static_cast<double>(mbytes) * (1 << 20);
+        opts.peer_bytes_burst = opts.peer_bytes_rate * 4;
+        opts.category_queries_rate = queries / 2.0;
+        opts.category_queries_burst = opts.category_queries_rate * 4;
+        opts.category_bytes_rate = opts.peer_bytes_rate / 2;
+        opts.category_bytes_burst = opts.category_bytes_rate * 4;
+        acts.push_back([&x, opts]() { td::actor::send_closure(x, &ValidatorEngine::set_adnl_query_admission, opts); });
+        return td::Status::OK();
+      });
   p.add_checked_option('u', "user", "change user", [&](td::Slice user) { return td::change_user(user.str()); });
   auto S = p.run(argc, argv);
   if (S.is_error()) {
@@ -3385,7 +3581,22 @@ int main(int argc, char *argv[]) {
   td::set_runtime_signal_handler(2, need_scheduler_status).ensure();
 
   td::actor::set_debug(true);
-  td::actor::Scheduler scheduler({threads});
+  std::vector<td::actor::Scheduler::NodeInfo> nodes;
+  nodes.push_back(td::actor::Scheduler::NodeInfo{threads}
+                      .with_blocking_threads(blocking_threads)
+                      .with_cpu_affinity(std::move(cpu_affinity))
+                      .with_message_budget(message_budget));
+  if (!consensus_cores.empty()) {
+    auto count = consensus_cores.size();
+    nodes.push_back(td::actor::Scheduler::NodeInfo{count}
+                        .with_cpu_affinity(std::move(consensus_cores))
+                        .with_dedicated_role("consensus"));
+  }
+  if (!adnl_cores.empty()) {
+    nodes.push_back(
+        td::actor::Scheduler::NodeInfo{1}.with_cpu_affinity(std::move(adnl_cores)).with_dedicated_role("adnl"));
+  }
+  td::actor::Scheduler scheduler(std::move(nodes));
 
   scheduler.run_in_context([&] {
     CHECK(vm::init_op_cp0());
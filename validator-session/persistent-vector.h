@@ -195,6 +195,9 @@ class CntVector : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const CntVector*>(r);
+    }
     std::vector<T> v;
     v.resize(b->size());
     for (td::uint32 i = 0; i < b->size(); i++) {
@@ -202,14 +205,14 @@ class CntVector : public ValidatorSessionDescription::RootObject {
     }
     auto r = lookup(desc, v, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
     auto data = static_cast<T*>(desc.alloc(sizeof(T) * b->size(), 8, false));
     for (td::uint32 i = 0; i < b->size(); i++) {
       data[i] = v[i];
     }
 
-    return new (desc, false) CntVector{desc, b->size(), data, b->hash_};
+    return desc.moved(b, new (desc, false) CntVector{desc, b->size(), data, b->hash_});
   }
   static const CntVector* merge(ValidatorSessionDescription& desc, const CntVector* l, const CntVector* r,
                                 std::function<T(T, T)> merge_f, bool merge_all = false) {
@@ -444,14 +447,17 @@ class CntVector<bool> : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const CntVector*>(r);
+    }
     auto r = lookup(desc, b->max_size(), b->data_, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
     auto data = static_cast<td::uint32*>(desc.alloc(b->data_size_, 8, false));
     std::memcpy(data, b->data_, b->data_size_);
 
-    return new (desc, false) CntVector{desc, b->max_size(), data, b->hash_};
+    return desc.moved(b, new (desc, false) CntVector{desc, b->max_size(), data, b->hash_});
   }
   static const CntVector* merge(ValidatorSessionDescription& desc, const CntVector* l, const CntVector* r) {
     if (!l) {
@@ -647,6 +653,9 @@ class CntSortedVector : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const CntSortedVector*>(r);
+    }
     std::vector<T> v;
     v.resize(b->size());
     for (td::uint32 i = 0; i < v.size(); i++) {
@@ -654,14 +663,14 @@ class CntSortedVector : public ValidatorSessionDescription::RootObject {
     }
     auto r = lookup(desc, v, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
     auto data = static_cast<T*>(desc.alloc(sizeof(T) * v.size(), 8, false));
     for (td::uint32 i = 0; i < v.size(); i++) {
       data[i] = v[i];
     }
 
-    return new (desc, false) CntSortedVector{desc, b->size(), data, b->hash_};
+    return desc.moved(b, new (desc, false) CntSortedVector{desc, b->size(), data, b->hash_});
   }
   static const CntSortedVector* merge(ValidatorSessionDescription& desc, const CntSortedVector* l,
                                       const CntSortedVector* r, std::function<T(T, T)> merge_f) {
@@ -144,6 +144,7 @@ td::uint32 ValidatorSessionDescriptionImpl::get_vote_for_author(td::uint32 attem
 const ValidatorSessionDescription::RootObject *ValidatorSessionDescriptionImpl::get_by_hash(HashType hash,
                                                                                             bool allow_temp) const {
   auto x = hash % cache_size;
+  lookups_.fetch_add(1, std::memory_order_relaxed);
 
   return cache_[x].load(std::memory_order_relaxed).ptr;
 }
@@ -168,6 +169,7 @@ void *ValidatorSessionDescriptionImpl::alloc(size_t size, size_t align, bool tem
     CHECK(s + size <= pdata_temp_size_);
     return static_cast<void *>(pdata_temp_ + s);
   } else {
+    pdata_perm_allocated_ += size;
     while (true) {
       auto s = pdata_perm_ptr_;
       pdata_perm_ptr_ += size;
@@ -193,6 +195,37 @@ bool ValidatorSessionDescriptionImpl::is_persistent(const void *ptr) const {
   return false;
 }
 
+bool ValidatorSessionDescriptionImpl::need_compaction() const {
+  // compact only when at least a whole arena chunk can be released and the arena doubled since the last compaction,
+  // so that copying live objects is amortized over the allocations
+  return pdata_perm_ptr_ >= pdata_perm_size_ && pdata_perm_ptr_ >= 2 * pdata_perm_live_;
+}
+
+void ValidatorSessionDescriptionImpl::start_compaction() {
+  CHECK(!compacting_);
+  CHECK(pdata_temp_ptr_ == 0);
+  compacting_ = true;
+  pdata_perm_old_ = std::move(pdata_perm_);
+  pdata_perm_.clear();
+  pdata_perm_ptr_ = 0;
+  for (auto &el : cache_) {
+    Cached v{nullptr};
+    el.store(v, std::memory_order_relaxed);
+  }
+}
+
+void ValidatorSessionDescriptionImpl::finish_compaction() {
+  CHECK(compacting_);
+  compacting_ = false;
+  moved_.clear();
+  for (auto &x : pdata_perm_old_) {
+    delete[] x;
+  }
+  pdata_perm_old_.clear();
+  pdata_perm_live_ = pdata_perm_ptr_;
+  compactions_++;
+}
+
 std::unique_ptr<ValidatorSessionDescription> ValidatorSessionDescription::create(
     ValidatorSessionOptions opts, std::vector<ValidatorSessionNode> &nodes, PublicKeyHash local_id) {
   return std::make_unique<ValidatorSessionDescriptionImpl>(std::move(opts), nodes, local_id);
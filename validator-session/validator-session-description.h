@@ -73,6 +73,30 @@ class ValidatorSessionDescription {
   }
   virtual void clear_temp_memory() = 0;
 
+  // Compaction of persistent memory: after start_compaction() the old arena is no longer persistent, so
+  // move_to_persistent() copies every object reachable from the live roots to a fresh arena.
+  // finish_compaction() releases the old arena, invalidating all pointers into it.
+  virtual bool need_compaction() const = 0;
+  virtual void start_compaction() = 0;
+  virtual void finish_compaction() = 0;
+  virtual const RootObject *get_moved(const RootObject *obj) const = 0;
+  virtual void set_moved(const RootObject *from, const RootObject *to) = 0;
+  template <typename T>
+  const T *moved(const T *from, const T *to) {
+    set_moved(from, to);
+    return to;
+  }
+
+  struct MemoryStats {
+    td::uint64 arena_bytes;
+    td::uint64 live_bytes;
+    td::uint64 allocated_bytes;
+    td::uint64 compactions;
+    td::uint64 cache_lookups;
+    td::uint64 cache_hits;
+  };
+  virtual MemoryStats get_memory_stats() const = 0;
+
   virtual ~ValidatorSessionDescription() = default;
 
   virtual PublicKeyHash get_source_id(td::uint32 idx) const = 0;
@@ -20,6 +20,7 @@
 
 #include <set>
 #include <map>
+#include <unordered_map>
 
 #include "validator-session.h"
 #include "validator-session-state.h"
@@ -65,6 +66,14 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
   std::vector<td::uint8 *> pdata_perm_;
   size_t pdata_perm_ptr_;
   std::atomic<td::uint64> reuse_{0};
+  mutable std::atomic<td::uint64> lookups_{0};
+
+  bool compacting_ = false;
+  std::vector<td::uint8 *> pdata_perm_old_;
+  std::unordered_map<const RootObject *, const RootObject *> moved_;
+  size_t pdata_perm_live_ = 0;
+  td::uint64 pdata_perm_allocated_ = 0;
+  td::uint64 compactions_ = 0;
 
  public:
   ValidatorSessionDescriptionImpl(ValidatorSessionOptions opts, std::vector<ValidatorSessionNode> &nodes,
@@ -119,6 +128,25 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
     pdata_temp_ptr_ = 0;
   }
   bool is_persistent(const void *ptr) const override;
+  bool need_compaction() const override;
+  void start_compaction() override;
+  void finish_compaction() override;
+  const RootObject *get_moved(const RootObject *obj) const override {
+    if (!compacting_) {
+      return nullptr;
+    }
+    auto it = moved_.find(obj);
+    return it == moved_.end() ? nullptr : it->second;
+  }
+  void set_moved(const RootObject *from, const RootObject *to) override {
+    if (compacting_) {
+      moved_[from] = to;
+    }
+  }
+  MemoryStats get_memory_stats() const override {
+    return MemoryStats{pdata_perm_ptr_, pdata_perm_live_, pdata_perm_allocated_, compactions_, lookups_.load(),
+                       reuse_.load()};
+  }
   HashType compute_hash(td::Slice data) const override;
   td::Timestamp attempt_start_at(td::uint32 att) const override {
     return td::Timestamp::at_unix(att * opts_.round_attempt_duration);
@@ -157,6 +185,9 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
     for (auto &x : pdata_perm_) {
       delete[] x;
     }
+    for (auto &x : pdata_perm_old_) {
+      delete[] x;
+    }
   }
 };
 
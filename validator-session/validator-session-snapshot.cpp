@@ -0,0 +1,359 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "validator-session-snapshot.h"
+#include "auto/tl/ton_api.hpp"
+
+namespace ton {
+
+namespace validatorsession {
+
+template <class T>
+td::int32 ValidatorSessionStateSnapshot::store(const T* obj) {
+  if (!obj) {
+    return -1;
+  }
+  auto it = stored_.find(obj);
+  if (it != stored_.end()) {
+    return it->second;
+  }
+  // children are stored first, so every node references only nodes before it
+  auto node = encode(obj);
+  auto idx = static_cast<td::int32>(nodes_.size());
+  nodes_.push_back(std::move(node));
+  stored_.emplace(obj, idx);
+  return idx;
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const SessionBlockCandidateSignature* obj) {
+  return create_tl_object<ton_api::validatorSession_snapshot_signature>(obj->value());
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const SentBlock* obj) {
+  if (SentBlock::get_block_id(obj).is_zero()) {
+    return create_tl_object<ton_api::validatorSession_snapshot_sentBlockEmpty>();
+  }
+  return create_tl_object<ton_api::validatorSession_snapshot_sentBlock>(
+      obj->get_src_idx(), obj->get_root_hash(), obj->get_file_hash(), obj->get_collated_data_file_hash());
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const CntVector<bool>* obj) {
+  std::vector<td::int32> data;
+  for (td::uint32 i = 0; i < obj->max_size() / 32; i++) {
+    data.push_back(obj->data()[i]);
+  }
+  return create_tl_object<ton_api::validatorSession_snapshot_vector>(std::move(data));
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const CntVector<td::uint32>* obj) {
+  std::vector<td::int32> data;
+  for (td::uint32 i = 0; i < obj->size(); i++) {
+    data.push_back(obj->at(i));
+  }
+  return create_tl_object<ton_api::validatorSession_snapshot_vector>(std::move(data));
+}
+
+template <class T>
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const CntVector<const T*>* obj) {
+  std::vector<td::int32> data;
+  for (td::uint32 i = 0; i < obj->size(); i++) {
+    data.push_back(store(obj->at(i)));
+  }
+  return create_tl_object<ton_api::validatorSession_snapshot_vector>(std::move(data));
+}
+
+template <class T, class Compare>
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(
+    const CntSortedVector<const T*, Compare>* obj) {
+  std::vector<td::int32> data;
+  for (td::uint32 i = 0; i < obj->size(); i++) {
+    data.push_back(store(obj->at(i)));
+  }
+  return create_tl_object<ton_api::validatorSession_snapshot_vector>(std::move(data));
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const SessionBlockCandidate* obj) {
+  auto block = store(obj->get_block());
+  auto approved = store(obj->get_approvers_list());
+  return create_tl_object<ton_api::validatorSession_snapshot_blockCandidate>(block, approved);
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const SessionVoteCandidate* obj) {
+  auto block = store(obj->get_block());
+  auto voted = store(obj->get_voters_list());
+  return create_tl_object<ton_api::validatorSession_snapshot_voteCandidate>(block, voted);
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const ValidatorSessionOldRoundState* obj) {
+  auto block = store(obj->get_block());
+  auto signatures = store(obj->get_signatures());
+  auto approve_signatures = store(obj->get_approve_signatures());
+  return create_tl_object<ton_api::validatorSession_snapshot_oldRound>(obj->get_seqno(), block, signatures,
+                                                                       approve_signatures);
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(
+    const ValidatorSessionRoundAttemptState* obj) {
+  bool vote_for_inited;
+  auto vote_for = store(obj->get_vote_for_block(desc_, vote_for_inited));
+  auto votes = store(obj->get_votes());
+  auto precommitted = store(obj->get_precommits());
+  return create_tl_object<ton_api::validatorSession_snapshot_roundAttempt>(obj->get_seqno(), votes, precommitted,
+                                                                           vote_for_inited, vote_for);
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const ValidatorSessionRoundState* obj) {
+  auto precommitted_block = store(obj->precommitted_block_);
+  auto first_attempt = store(obj->first_attempt_);
+  auto last_precommit = store(obj->last_precommit_);
+  auto sent_blocks = store(obj->sent_blocks_);
+  auto signatures = store(obj->signatures_);
+  auto attempts = store(obj->attempts_);
+  return create_tl_object<ton_api::validatorSession_snapshot_round>(precommitted_block, obj->seqno_,
+                                                                    obj->precommitted_, first_attempt, last_precommit,
+                                                                    sent_blocks, signatures, attempts);
+}
+
+ValidatorSessionStateSnapshot::Node ValidatorSessionStateSnapshot::encode(const ValidatorSessionState* obj) {
+  auto att = store(obj->att_);
+  auto old_rounds = store(obj->old_rounds_);
+  auto cur_round = store(obj->cur_round_);
+  return create_tl_object<ton_api::validatorSession_snapshot_state>(att, old_rounds, cur_round);
+}
+
+template <class T>
+td::Result<T*> ValidatorSessionStateSnapshot::get_node(td::int32 idx) {
+  auto node = nodes_[idx].get();
+  if (!node || node->get_id() != T::ID) {
+    return td::Status::Error(PSTRING() << "unexpected type of snapshot node " << idx);
+  }
+  return static_cast<T*>(node);
+}
+
+template <class T>
+td::Status ValidatorSessionStateSnapshot::fetch(td::int32 idx, td::int32 parent, const T*& obj) {
+  obj = nullptr;
+  if (idx == -1) {
+    return td::Status::OK();
+  }
+  if (idx < 0 || idx >= parent) {
+    return td::Status::Error(PSTRING() << "bad reference to snapshot node " << idx << " from " << parent);
+  }
+  auto& fetched = fetched_[idx];
+  if (fetched.first) {
+    if (*fetched.first != typeid(T)) {
+      return td::Status::Error(PSTRING() << "snapshot node " << idx << " is referenced with different types");
+    }
+    obj = static_cast<const T*>(fetched.second);
+    return td::Status::OK();
+  }
+  TRY_STATUS(decode(idx, obj));
+  fetched = {&typeid(T), obj};
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const SessionBlockCandidateSignature*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_signature>(idx));
+  obj = SessionBlockCandidateSignature::create(desc_, node->data_.clone());
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const SentBlock*& obj) {
+  if (nodes_[idx] && nodes_[idx]->get_id() == ton_api::validatorSession_snapshot_sentBlockEmpty::ID) {
+    obj = SentBlock::create(desc_, ValidatorSessionCandidateId::zero());
+    return td::Status::OK();
+  }
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_sentBlock>(idx));
+  if (static_cast<td::uint32>(node->src_) >= desc_.get_total_nodes()) {
+    return td::Status::Error(PSTRING() << "bad source " << node->src_ << " of snapshot node " << idx);
+  }
+  obj = SentBlock::create(desc_, node->src_, node->root_hash_, node->file_hash_, node->collated_data_file_hash_);
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const CntVector<bool>*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_vector>(idx));
+  auto size = static_cast<td::uint32>(node->data_.size());
+  auto data = static_cast<td::uint32*>(desc_.alloc(sizeof(td::uint32) * size, 8, true));
+  for (td::uint32 i = 0; i < size; i++) {
+    data[i] = node->data_[i];
+  }
+  obj = CntVector<bool>::create(desc_, size * 32, data);
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const CntVector<td::uint32>*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_vector>(idx));
+  std::vector<td::uint32> v;
+  for (auto x : node->data_) {
+    v.push_back(x);
+  }
+  obj = CntVector<td::uint32>::create(desc_, std::move(v));
+  return td::Status::OK();
+}
+
+template <class T>
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const CntVector<const T*>*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_vector>(idx));
+  std::vector<const T*> v(node->data_.size());
+  for (size_t i = 0; i < v.size(); i++) {
+    TRY_STATUS(fetch(node->data_[i], idx, v[i]));
+  }
+  obj = CntVector<const T*>::create(desc_, std::move(v));
+  return td::Status::OK();
+}
+
+template <class T, class Compare>
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const CntSortedVector<const T*, Compare>*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_vector>(idx));
+  std::vector<const T*> v(node->data_.size());
+  for (size_t i = 0; i < v.size(); i++) {
+    TRY_STATUS(fetch(node->data_[i], idx, v[i]));
+    if (!v[i] || (i > 0 && !Compare()(v[i - 1], v[i]))) {
+      return td::Status::Error(PSTRING() << "snapshot node " << idx << " is not a sorted vector");
+    }
+  }
+  obj = CntSortedVector<const T*, Compare>::create(desc_, std::move(v));
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const SessionBlockCandidate*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_blockCandidate>(idx));
+  const SentBlock* block;
+  const SessionBlockCandidateSignatureVector* approved;
+  TRY_STATUS(fetch(node->block_, idx, block));
+  TRY_STATUS(fetch(node->approved_, idx, approved));
+  obj = SessionBlockCandidate::create(desc_, block, approved);
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const SessionVoteCandidate*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_voteCandidate>(idx));
+  const SentBlock* block;
+  const CntVector<bool>* voted;
+  TRY_STATUS(fetch(node->block_, idx, block));
+  TRY_STATUS(fetch(node->voted_, idx, voted));
+  obj = SessionVoteCandidate::create(desc_, block, voted);
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const ValidatorSessionOldRoundState*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_oldRound>(idx));
+  const SentBlock* block;
+  const SessionBlockCandidateSignatureVector* signatures;
+  const SessionBlockCandidateSignatureVector* approve_signatures;
+  TRY_STATUS(fetch(node->block_, idx, block));
+  TRY_STATUS(fetch(node->signatures_, idx, signatures));
+  TRY_STATUS(fetch(node->approve_signatures_, idx, approve_signatures));
+  obj = ValidatorSessionOldRoundState::create(desc_, node->seqno_, block, signatures, approve_signatures);
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const ValidatorSessionRoundAttemptState*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_roundAttempt>(idx));
+  const VoteVector* votes;
+  const CntVector<bool>* precommitted;
+  const SentBlock* vote_for;
+  TRY_STATUS(fetch(node->votes_, idx, votes));
+  TRY_STATUS(fetch(node->precommitted_, idx, precommitted));
+  TRY_STATUS(fetch(node->vote_for_, idx, vote_for));
+  obj = ValidatorSessionRoundAttemptState::create(desc_, node->seqno_, votes, precommitted, vote_for,
+                                                  node->vote_for_inited_);
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const ValidatorSessionRoundState*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_round>(idx));
+  const SentBlock* precommitted_block;
+  const CntVector<td::uint32>* first_attempt;
+  const CntVector<td::uint32>* last_precommit;
+  const ApproveVector* sent_blocks;
+  const SessionBlockCandidateSignatureVector* signatures;
+  const AttemptVector* attempts;
+  TRY_STATUS(fetch(node->precommitted_block_, idx, precommitted_block));
+  TRY_STATUS(fetch(node->first_attempt_, idx, first_attempt));
+  TRY_STATUS(fetch(node->last_precommit_, idx, last_precommit));
+  TRY_STATUS(fetch(node->sent_blocks_, idx, sent_blocks));
+  TRY_STATUS(fetch(node->signatures_, idx, signatures));
+  TRY_STATUS(fetch(node->attempts_, idx, attempts));
+  obj = ValidatorSessionRoundState::create(desc_, precommitted_block, node->seqno_, node->precommitted_,
+                                           first_attempt, last_precommit, sent_blocks, signatures, attempts);
+  return td::Status::OK();
+}
+
+td::Status ValidatorSessionStateSnapshot::decode(td::int32 idx, const ValidatorSessionState*& obj) {
+  TRY_RESULT(node, get_node<ton_api::validatorSession_snapshot_state>(idx));
+  const CntVector<td::uint32>* att;
+  const CntVector<const ValidatorSessionOldRoundState*>* old_rounds;
+  const ValidatorSessionRoundState* cur_round;
+  TRY_STATUS(fetch(node->att_, idx, att));
+  TRY_STATUS(fetch(node->old_rounds_, idx, old_rounds));
+  TRY_STATUS(fetch(node->cur_round_, idx, cur_round));
+  if (!att || !cur_round) {
+    return td::Status::Error(PSTRING() << "incomplete state in snapshot node " << idx);
+  }
+  obj = ValidatorSessionState::create(desc_, att, old_rounds, cur_round);
+  return td::Status::OK();
+}
+
+td::BufferSlice ValidatorSessionStateSnapshot::serialize(ValidatorSessionDescription& desc,
+                                                         const BlockStates& states) {
+  ValidatorSessionStateSnapshot snapshot{desc};
+  std::vector<tl_object_ptr<ton_api::validatorSession_snapshot_block>> blocks;
+  for (auto& x : states) {
+    auto idx = snapshot.store(x.second);
+    blocks.push_back(
+        create_tl_object<ton_api::validatorSession_snapshot_block>(x.first, idx, x.second->get_hash(desc)));
+  }
+  return create_serialize_tl_object<ton_api::validatorSession_snapshot>(std::move(snapshot.nodes_),
+                                                                        std::move(blocks));
+}
+
+td::Result<std::map<catchain::CatChainBlockHash, const ValidatorSessionState*>>
+ValidatorSessionStateSnapshot::deserialize(ValidatorSessionDescription& desc, td::Slice data) {
+  TRY_RESULT(obj, fetch_tl_object<ton_api::validatorSession_snapshot>(data, true));
+  ValidatorSessionStateSnapshot snapshot{desc};
+  snapshot.nodes_ = std::move(obj->nodes_);
+  snapshot.fetched_.resize(snapshot.nodes_.size(), {nullptr, nullptr});
+  auto size = static_cast<td::int32>(snapshot.nodes_.size());
+
+  std::vector<std::pair<catchain::CatChainBlockHash, const ValidatorSessionState*>> states;
+  for (auto& block : obj->blocks_) {
+    const ValidatorSessionState* state;
+    TRY_STATUS(snapshot.fetch(block->state_, size, state));
+    if (!state) {
+      return td::Status::Error(PSTRING() << "no state for block " << block->hash_);
+    }
+    // objects are recreated with create(), so the hash is recomputed from the restored contents
+    if (state->get_hash(desc) != static_cast<HashType>(block->state_hash_)) {
+      return td::Status::Error(PSTRING() << "state hash mismatch for block " << block->hash_);
+    }
+    states.emplace_back(block->hash_, state);
+  }
+
+  std::map<catchain::CatChainBlockHash, const ValidatorSessionState*> result;
+  for (auto& x : states) {
+    result.emplace(x.first, ValidatorSessionState::move_to_persistent(desc, x.second));
+  }
+  desc.clear_temp_memory();
+  return std::move(result);
+}
+
+}  // namespace validatorsession
+
+}  // namespace ton
@@ -0,0 +1,92 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "validator-session-state.h"
+#include "catchain/catchain-types.h"
+
+#include <map>
+#include <typeinfo>
+
+namespace ton {
+
+namespace validatorsession {
+
+// States of catchain blocks stored in the catchain checkpoint, so that after a restart the blocks are not
+// preprocessed again. States share most of their objects, so every object is stored once and referenced by index.
+class ValidatorSessionStateSnapshot {
+ public:
+  using BlockStates = std::vector<std::pair<catchain::CatChainBlockHash, const ValidatorSessionState*>>;
+
+  static td::BufferSlice serialize(ValidatorSessionDescription& desc, const BlockStates& states);
+  // states are persistent and have the same hashes as the serialized ones
+  static td::Result<std::map<catchain::CatChainBlockHash, const ValidatorSessionState*>> deserialize(
+      ValidatorSessionDescription& desc, td::Slice data);
+
+ private:
+  using Node = tl_object_ptr<ton_api::validatorSession_snapshot_Node>;
+
+  explicit ValidatorSessionStateSnapshot(ValidatorSessionDescription& desc) : desc_(desc) {
+  }
+
+  template <class T>
+  td::int32 store(const T* obj);
+  Node encode(const SessionBlockCandidateSignature* obj);
+  Node encode(const SentBlock* obj);
+  Node encode(const CntVector<bool>* obj);
+  Node encode(const CntVector<td::uint32>* obj);
+  template <class T>
+  Node encode(const CntVector<const T*>* obj);
+  template <class T, class Compare>
+  Node encode(const CntSortedVector<const T*, Compare>* obj);
+  Node encode(const SessionBlockCandidate* obj);
+  Node encode(const SessionVoteCandidate* obj);
+  Node encode(const ValidatorSessionOldRoundState* obj);
+  Node encode(const ValidatorSessionRoundAttemptState* obj);
+  Node encode(const ValidatorSessionRoundState* obj);
+  Node encode(const ValidatorSessionState* obj);
+
+  template <class T>
+  td::Status fetch(td::int32 idx, td::int32 parent, const T*& obj);
+  td::Status decode(td::int32 idx, const SessionBlockCandidateSignature*& obj);
+  td::Status decode(td::int32 idx, const SentBlock*& obj);
+  td::Status decode(td::int32 idx, const CntVector<bool>*& obj);
+  td::Status decode(td::int32 idx, const CntVector<td::uint32>*& obj);
+  template <class T>
+  td::Status decode(td::int32 idx, const CntVector<const T*>*& obj);
+  template <class T, class Compare>
+  td::Status decode(td::int32 idx, const CntSortedVector<const T*, Compare>*& obj);
+  td::Status decode(td::int32 idx, const SessionBlockCandidate*& obj);
+  td::Status decode(td::int32 idx, const SessionVoteCandidate*& obj);
+  td::Status decode(td::int32 idx, const ValidatorSessionOldRoundState*& obj);
+  td::Status decode(td::int32 idx, const ValidatorSessionRoundAttemptState*& obj);
+  td::Status decode(td::int32 idx, const ValidatorSessionRoundState*& obj);
+  td::Status decode(td::int32 idx, const ValidatorSessionState*& obj);
+  template <class T>
+  td::Result<T*> get_node(td::int32 idx);
+
+  ValidatorSessionDescription& desc_;
+  std::vector<Node> nodes_;
+  std::map<const void*, td::int32> stored_;
+  std::vector<std::pair<const std::type_info*, const void*>> fetched_;
+};
+
+}  // namespace validatorsession
+
+}  // namespace ton
@@ -1331,6 +1331,34 @@ const SessionBlockCandidate* ValidatorSessionRoundState::get_block(ValidatorSess
   return get_candidate(sent_blocks_, block_hash);
 }
 
+const SentBlock* ValidatorSessionRoundState::choose_block_to_precollate(ValidatorSessionDescription& desc,
+                                                                        bool& found) const {
+  found = false;
+  if (precommitted_) {
+    found = true;
+    return precommitted_block_;
+  }
+  if (!sent_blocks_) {
+    return nullptr;
+  }
+  // the approved block with the best priority is the one most nodes will vote for
+  td::int32 min_priority = desc.get_max_priority() + 2;
+  const SentBlock* block = nullptr;
+  for (td::uint32 i = 0; i < sent_blocks_->size(); i++) {
+    auto B = sent_blocks_->at(i);
+    if (!B->check_block_is_approved(desc)) {
+      continue;
+    }
+    td::int32 e = B->get_block() ? desc.get_node_priority(B->get_src_idx(), seqno_) : desc.get_max_priority() + 1;
+    if (e < min_priority) {
+      min_priority = e;
+      block = B->get_block();
+    }
+  }
+  found = min_priority < static_cast<td::int32>(desc.get_max_priority() + 2);
+  return block;
+}
+
 std::vector<const SentBlock*> ValidatorSessionRoundState::get_blocks_approved_by(ValidatorSessionDescription& desc,
                                                                                  td::uint32 src_idx) const {
   if (!sent_blocks_) {
@@ -84,12 +84,22 @@ struct SessionBlockCandidateSignature : public ValidatorSessionDescription::Root
     if (desc.is_persistent(b)) {
       return b;
     }
-    CHECK(desc.is_persistent(b->data_.ubegin()));
-    auto r = lookup(desc, b->data_, b->hash_, false);
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const SessionBlockCandidateSignature*>(r);
+    }
+    td::Slice data = b->data_;
+    if (!desc.is_persistent(data.ubegin())) {
+      // signature bytes are in the old arena during compaction
+      auto d = static_cast<td::uint8*>(desc.alloc(data.size(), 8, false));
+      td::MutableSlice s{d, data.size()};
+      s.copy_from(data);
+      data = s;
+    }
+    auto r = lookup(desc, data, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
-    return new (desc, false) SessionBlockCandidateSignature{desc, b->data_, b->hash_};
+    return desc.moved(b, new (desc, false) SessionBlockCandidateSignature{desc, data, b->hash_});
   }
   static const SessionBlockCandidateSignature* merge(ValidatorSessionDescription& desc,
                                                      const SessionBlockCandidateSignature* l,
@@ -175,13 +185,16 @@ class SentBlock : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const SentBlock*>(r);
+    }
     auto r = lookup(desc, b->src_idx_, b->root_hash_, b->file_hash_, b->collated_data_file_hash_, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
 
-    return new (desc, false) SentBlock{
-        desc, b->src_idx_, b->root_hash_, b->file_hash_, b->collated_data_file_hash_, b->candidate_id_, b->hash_};
+    return desc.moved(b, new (desc, false) SentBlock{desc, b->src_idx_, b->root_hash_, b->file_hash_,
+                                                     b->collated_data_file_hash_, b->candidate_id_, b->hash_});
   }
   SentBlock(ValidatorSessionDescription& desc, td::uint32 src_idx, ValidatorSessionRootHash root_hash,
             ValidatorSessionFileHash file_hash, ValidatorSessionCollatedDataFileHash collated_data_file_hash,
@@ -285,14 +298,17 @@ class SessionBlockCandidate : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const SessionBlockCandidate*>(r);
+    }
     auto block = SentBlock::move_to_persistent(desc, b->block_);
     auto approved = SessionBlockCandidateSignatureVector::move_to_persistent(desc, b->approved_by_);
     auto r = lookup(desc, block, approved, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
 
-    return new (desc, false) SessionBlockCandidate{desc, block, approved, b->hash_};
+    return desc.moved(b, new (desc, false) SessionBlockCandidate{desc, block, approved, b->hash_});
   }
   SessionBlockCandidate(ValidatorSessionDescription& desc, const SentBlock* block,
                         const SessionBlockCandidateSignatureVector* approved, HashType hash)
@@ -386,14 +402,17 @@ class SessionVoteCandidate : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const SessionVoteCandidate*>(r);
+    }
     auto block = SentBlock::move_to_persistent(desc, b->block_);
     auto voted = CntVector<bool>::move_to_persistent(desc, b->voted_by_);
     auto r = lookup(desc, block, voted, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
 
-    return new (desc, false) SessionVoteCandidate{desc, block, voted, b->hash_};
+    return desc.moved(b, new (desc, false) SessionVoteCandidate{desc, block, voted, b->hash_});
   }
   SessionVoteCandidate(ValidatorSessionDescription& desc, const SentBlock* block, const CntVector<bool>* voted,
                        HashType hash)
@@ -478,16 +497,19 @@ class ValidatorSessionOldRoundState : public ValidatorSessionDescription::RootOb
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const ValidatorSessionOldRoundState*>(r);
+    }
     auto signatures = SessionBlockCandidateSignatureVector::move_to_persistent(desc, b->signatures_);
     auto approve_signatures = SessionBlockCandidateSignatureVector::move_to_persistent(desc, b->approve_signatures_);
     auto block = SentBlock::move_to_persistent(desc, b->block_);
     auto r = lookup(desc, b->seqno_, block, signatures, approve_signatures, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
 
-    return new (desc, false)
-        ValidatorSessionOldRoundState{desc, b->seqno_, block, signatures, approve_signatures, b->hash_};
+    return desc.moved(b, new (desc, false) ValidatorSessionOldRoundState{desc, b->seqno_, block, signatures,
+                                                                         approve_signatures, b->hash_});
   }
   static const ValidatorSessionOldRoundState* create(ValidatorSessionDescription& desc, td::uint32 seqno,
                                                      const SentBlock* block,
@@ -618,17 +640,20 @@ class ValidatorSessionRoundAttemptState : public ValidatorSessionDescription::Ro
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const ValidatorSessionRoundAttemptState*>(r);
+    }
     auto votes = VoteVector::move_to_persistent(desc, b->votes_);
     auto precommitted = CntVector<bool>::move_to_persistent(desc, b->precommitted_);
     auto vote_for = SentBlock::move_to_persistent(desc, b->vote_for_);
 
     auto r = lookup(desc, b->seqno_, votes, precommitted, vote_for, b->vote_for_inited_, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
 
-    return new (desc, false) ValidatorSessionRoundAttemptState{desc,     b->seqno_,           votes,   precommitted,
-                                                               vote_for, b->vote_for_inited_, b->hash_};
+    return desc.moved(b, new (desc, false) ValidatorSessionRoundAttemptState{
+                             desc, b->seqno_, votes, precommitted, vote_for, b->vote_for_inited_, b->hash_});
   }
 
   static const ValidatorSessionRoundAttemptState* create(ValidatorSessionDescription& desc, td::uint32 seqno,
@@ -842,6 +867,9 @@ class ValidatorSessionRoundState : public ValidatorSessionDescription::RootObjec
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const ValidatorSessionRoundState*>(r);
+    }
     auto precommitted_block = SentBlock::move_to_persistent(desc, b->precommitted_block_);
     auto first_attempt = CntVector<td::uint32>::move_to_persistent(desc, b->first_attempt_);
     auto last_precommit = CntVector<td::uint32>::move_to_persistent(desc, b->last_precommit_);
@@ -851,11 +879,11 @@ class ValidatorSessionRoundState : public ValidatorSessionDescription::RootObjec
     auto r = lookup(desc, precommitted_block, b->seqno_, b->precommitted_, first_attempt, last_precommit, sent,
                     signatures, attempts, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
-    return new (desc, false)
-        ValidatorSessionRoundState{desc, precommitted_block, b->seqno_, b->precommitted_, first_attempt, last_precommit,
-                                   sent, signatures,         attempts,  b->hash_};
+    return desc.moved(b, new (desc, false) ValidatorSessionRoundState{desc, precommitted_block, b->seqno_,
+                                                                      b->precommitted_, first_attempt, last_precommit,
+                                                                      sent, signatures, attempts, b->hash_});
   }
   ValidatorSessionRoundState(ValidatorSessionDescription& desc, const SentBlock* precommitted_block, td::uint32 seqno,
                              bool precommitted, const CntVector<td::uint32>* first_attempt,
@@ -956,6 +984,7 @@ class ValidatorSessionRoundState : public ValidatorSessionDescription::RootObjec
   std::vector<const SentBlock*> choose_blocks_to_approve(ValidatorSessionDescription& desc, td::uint32 src_idx) const;
   const SentBlock* choose_block_to_vote(ValidatorSessionDescription& desc, td::uint32 src_idx, td::uint32 att,
                                         const SentBlock* vote_for, bool vote_for_inited, bool& found) const;
+  const SentBlock* choose_block_to_precollate(ValidatorSessionDescription& desc, bool& found) const;
 
   tl_object_ptr<ton_api::validatorSession_round_Message> create_action(ValidatorSessionDescription& desc,
                                                                        td::uint32 src_idx, td::uint32 att) const;
@@ -963,6 +992,8 @@ class ValidatorSessionRoundState : public ValidatorSessionDescription::RootObjec
   void dump_cur_attempt(ValidatorSessionDescription& desc, td::StringBuilder& sb) const;
 
  private:
+  friend class ValidatorSessionStateSnapshot;
+
   const SentBlock* precommitted_block_;
   const td::uint32 seqno_;
   const bool precommitted_;
@@ -1025,14 +1056,17 @@ class ValidatorSessionState : public ValidatorSessionDescription::RootObject {
     if (desc.is_persistent(b)) {
       return b;
     }
+    if (auto r = desc.get_moved(b)) {
+      return static_cast<const ValidatorSessionState*>(r);
+    }
     auto ts = CntVector<td::uint32>::move_to_persistent(desc, b->att_);
     auto old_rounds = CntVector<const ValidatorSessionOldRoundState*>::move_to_persistent(desc, b->old_rounds_);
     auto cur_round = ValidatorSessionRoundState::move_to_persistent(desc, b->cur_round_);
     auto r = lookup(desc, ts, old_rounds, cur_round, b->hash_, false);
     if (r) {
-      return r;
+      return desc.moved(b, r);
     }
-    return new (desc, false) ValidatorSessionState{desc, ts, old_rounds, cur_round, b->hash_};
+    return desc.moved(b, new (desc, false) ValidatorSessionState{desc, ts, old_rounds, cur_round, b->hash_});
   }
   ValidatorSessionState(ValidatorSessionDescription& desc, const CntVector<td::uint32>* att,
                         const CntVector<const ValidatorSessionOldRoundState*>* old_rounds,
@@ -1093,6 +1127,9 @@ class ValidatorSessionState : public ValidatorSessionDescription::RootObject {
                                               ValidatorSessionCandidateId block) const {
     return cur_round_->get_block_approvers(desc, block);
   }
+  const SentBlock* choose_block_to_precollate(ValidatorSessionDescription& desc, bool& found) const {
+    return cur_round_->choose_block_to_precollate(desc, found);
+  }
 
   tl_object_ptr<ton_api::validatorSession_round_Message> create_action(ValidatorSessionDescription& desc,
                                                                        td::uint32 src_idx, td::uint32 att) const;
@@ -1121,6 +1158,8 @@ class ValidatorSessionState : public ValidatorSessionDescription::RootObject {
                                              const ton_api::validatorSession_round_Message* action);
 
  private:
+  friend class ValidatorSessionStateSnapshot;
+
   const CntVector<td::uint32>* att_;
   const CntVector<const ValidatorSessionOldRoundState*>* old_rounds_;
   const ValidatorSessionRoundState* cur_round_;
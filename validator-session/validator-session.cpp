@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "validator-session.hpp"
+#include "validator-session-snapshot.h"
 #include "td/utils/Random.h"
 #include "td/utils/crypto.h"
 
@@ -30,9 +31,7 @@ void ValidatorSessionImpl::process_blocks(std::vector<catchain::CatChainBlock *>
   requested_new_block_now_ = false;
 
   for (auto block : blocks) {
-    auto e = dynamic_cast<const BlockExtra *>(block->extra());
-    CHECK(e != nullptr);
-    real_state_ = ValidatorSessionState::merge(description(), real_state_, e->get_ref());
+    real_state_ = ValidatorSessionState::merge(description(), real_state_, get_block_state(block));
   }
 
   if (real_state_->cur_round_seqno() != cur_round_) {
@@ -127,6 +126,7 @@ void ValidatorSessionImpl::process_blocks(std::vector<catchain::CatChainBlock *>
   virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, real_state_);
   virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
   description().clear_temp_memory();
+  check_compaction();
 }
 
 void ValidatorSessionImpl::finished_processing() {
@@ -142,20 +142,94 @@ void ValidatorSessionImpl::preprocess_block(catchain::CatChainBlock *block) {
   td::PerfWarningTimer p_timer{"Loong block preprocess", 0.1};
   td::PerfWarningTimer q_timer{"Looong block preprocess", 0.1};
 
+  auto state = compute_block_state(block);
+  q_timer.reset();
+  auto extra = std::make_unique<BlockExtra>(state);
+  block_extras_[state->cur_round_seqno()].push_back(extra.get());
+  block->set_extra(std::move(extra));
+  if (block->source() == local_idx() && !catchain_started_) {
+    real_state_ = state;
+  }
+  virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, state);
+  virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
+  description().clear_temp_memory();
+  if (real_state_->cur_round_seqno() != cur_round_) {
+    on_new_round(real_state_->cur_round_seqno());
+  }
+  check_all();
+  VLOG(VALIDATOR_SESSION_DEBUG) << this << ": preprocessed block " << block->hash() << " in "
+                                << static_cast<td::uint32>(1000 * (td::Timestamp::now().at() - start_time.at()))
+                                << "ms: state=" << state->get_hash(description());
+  check_compaction();
+}
+
+void ValidatorSessionImpl::get_snapshot(std::vector<catchain::CatChainBlock *> blocks,
+                                        td::Promise<td::BufferSlice> promise) {
+  ValidatorSessionStateSnapshot::BlockStates states;
+  for (auto block : blocks) {
+    auto e = dynamic_cast<BlockExtra *>(block->extra());
+    CHECK(e != nullptr);
+    // pruned states are not stored, they are recomputed from the dependencies if needed
+    if (e->get_ref()) {
+      states.emplace_back(block->hash(), e->get_ref());
+    }
+  }
+  promise.set_value(ValidatorSessionStateSnapshot::serialize(description(), states));
+}
+
+void ValidatorSessionImpl::restore_blocks(std::vector<catchain::CatChainBlock *> blocks, td::BufferSlice snapshot) {
+  auto start_time = td::Timestamp::now();
+  std::map<catchain::CatChainBlockHash, const ValidatorSessionState *> states;
+  auto R = ValidatorSessionStateSnapshot::deserialize(description(), snapshot.as_slice());
+  if (R.is_error()) {
+    VLOG(VALIDATOR_SESSION_WARNING) << this << ": failed to restore block states from checkpoint: "
+                                    << R.move_as_error();
+  } else {
+    states = R.move_as_ok();
+  }
+
+  // blocks without a state get a pruned extra, see get_block_state()
+  catchain::CatChainBlock *last_local_block = nullptr;
+  for (auto block : blocks) {
+    auto it = states.find(block->hash());
+    auto extra = std::make_unique<BlockExtra>(it == states.end() ? nullptr : it->second);
+    if (extra->get_ref()) {
+      block_extras_[extra->get_ref()->cur_round_seqno()].push_back(extra.get());
+      virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, extra->get_ref());
+    }
+    block->set_extra(std::move(extra));
+    if (block->source() == local_idx()) {
+      last_local_block = block;
+    }
+  }
+  if (last_local_block && !catchain_started_) {
+    real_state_ = get_block_state(last_local_block);
+    virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, real_state_);
+  }
+  virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
+  description().clear_temp_memory();
+  if (real_state_->cur_round_seqno() != cur_round_) {
+    on_new_round(real_state_->cur_round_seqno());
+  }
+  check_all();
+  VLOG(VALIDATOR_SESSION_INFO) << this << ": restored " << states.size() << " states of " << blocks.size()
+                               << " blocks in "
+                               << static_cast<td::uint32>(1000 * (td::Timestamp::now().at() - start_time.at()))
+                               << "ms";
+  check_compaction();
+}
+
+const ValidatorSessionState *ValidatorSessionImpl::compute_block_state(catchain::CatChainBlock *block) {
   auto prev = block->prev();
   const ValidatorSessionState *state;
   if (prev) {
-    auto e = dynamic_cast<const BlockExtra *>(prev->extra());
-    CHECK(e != nullptr);
-    state = e->get_ref();
+    state = get_block_state(prev);
   } else {
     state = ValidatorSessionState::create(description());
   }
   auto deps = block->deps();
   for (auto b : deps) {
-    auto e = dynamic_cast<const BlockExtra *>(b->extra());
-    CHECK(e != nullptr);
-    state = ValidatorSessionState::merge(description(), state, e->get_ref());
+    state = ValidatorSessionState::merge(description(), state, get_block_state(b));
   }
 
   if (block->payload().size() != 0 || deps.size() != 0) {
@@ -185,22 +259,47 @@ void ValidatorSessionImpl::preprocess_block(catchain::CatChainBlock *block) {
       state = ValidatorSessionState::make_all(description(), state, block->source(), state->get_ts(block->source()));
     }
   }
-  q_timer.reset();
-  state = ValidatorSessionState::move_to_persistent(description(), state);
-  block->set_extra(std::make_unique<BlockExtra>(state));
-  if (block->source() == local_idx() && !catchain_started_) {
-    real_state_ = state;
-  }
-  virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, state);
-  virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
-  description().clear_temp_memory();
-  if (real_state_->cur_round_seqno() != cur_round_) {
-    on_new_round(real_state_->cur_round_seqno());
+  return ValidatorSessionState::move_to_persistent(description(), state);
+}
+
+const ValidatorSessionState *ValidatorSessionImpl::get_block_state(catchain::CatChainBlock *block) {
+  auto e = dynamic_cast<BlockExtra *>(block->extra());
+  CHECK(e != nullptr);
+  if (e->get_ref()) {
+    return e->get_ref();
+  }
+  // the state was pruned, recompute it together with the pruned states it depends on
+  std::vector<catchain::CatChainBlock *> stack{block};
+  while (!stack.empty()) {
+    auto b = stack.back();
+    auto b_extra = static_cast<BlockExtra *>(b->extra());
+    if (b_extra->get_ref()) {
+      stack.pop_back();
+      continue;
+    }
+    bool ready = true;
+    auto add_dep = [&](catchain::CatChainBlock *dep) {
+      auto dep_extra = dynamic_cast<BlockExtra *>(dep->extra());
+      CHECK(dep_extra != nullptr);
+      if (!dep_extra->get_ref()) {
+        stack.push_back(dep);
+        ready = false;
+      }
+    };
+    if (b->prev()) {
+      add_dep(b->prev());
+    }
+    for (auto dep : b->deps()) {
+      add_dep(dep);
+    }
+    if (ready) {
+      auto state = compute_block_state(b);
+      b_extra->set_ref(state);
+      block_extras_[state->cur_round_seqno()].push_back(b_extra);
+      stack.pop_back();
+    }
   }
-  check_all();
-  VLOG(VALIDATOR_SESSION_DEBUG) << this << ": preprocessed block " << block->hash() << " in "
-                                << static_cast<td::uint32>(1000 * (td::Timestamp::now().at() - start_time.at()))
-                                << "ms: state=" << state->get_hash(description());
+  return e->get_ref();
 }
 
 void ValidatorSessionImpl::process_broadcast(PublicKeyHash src, td::BufferSlice data) {
@@ -583,6 +682,26 @@ void ValidatorSessionImpl::get_broadcast_p2p(PublicKeyHash node, ValidatorSessio
                           rldp_);
 }
 
+void ValidatorSessionImpl::check_precollate_slot() {
+  if (!started_ || precollate_round_ > cur_round_) {
+    return;
+  }
+  if (description().get_node_priority(local_idx(), cur_round_ + 1) < 0) {
+    return;
+  }
+  bool found;
+  auto B = real_state_->choose_block_to_precollate(description(), found);
+  if (!found || !B) {
+    return;
+  }
+  // the candidate is approved by enough weight, so it is likely to be committed:
+  // collation of the next round on top of it can run while the current round is being finished
+  precollate_round_ = cur_round_ + 1;
+  VLOG(VALIDATOR_SESSION_INFO) << this << ": precollating round " << precollate_round_ << " on top of "
+                               << SentBlock::get_block_id(B);
+  callback_->on_precollate_slot(precollate_round_, B->get_root_hash(), B->get_file_hash());
+}
+
 void ValidatorSessionImpl::check_sign_slot() {
   if (!catchain_started_) {
     return;
@@ -687,6 +806,7 @@ void ValidatorSessionImpl::check_all() {
   check_sign_slot();
   check_approve();
   check_generate_slot();
+  check_precollate_slot();
   check_action(att);
   check_vote_for_slot(att);
   alarm_timestamp().relax(round_debug_at_);
@@ -786,6 +906,39 @@ void ValidatorSessionImpl::on_new_round(td::uint32 round) {
   check_all();
 }
 
+void ValidatorSessionImpl::check_compaction() {
+  if (compaction_checked_round_ == cur_round_) {
+    return;
+  }
+  compaction_checked_round_ = cur_round_;
+  // new blocks rarely refer to blocks of old rounds, so their states are dropped
+  // and recomputed from the catchain blocks if they are needed again
+  while (!block_extras_.empty() && block_extras_.begin()->first + block_states_keep_rounds() < cur_round_) {
+    for (auto e : block_extras_.begin()->second) {
+      e->set_ref(nullptr);
+    }
+    block_extras_.erase(block_extras_.begin());
+  }
+  if (!description().need_compaction()) {
+    return;
+  }
+  td::PerfWarningTimer timer{"too long validator session memory compaction", 0.1};
+  auto before = description().get_memory_stats().arena_bytes;
+  // temporary objects can't be moved to the new arena
+  description().clear_temp_memory();
+  description().start_compaction();
+  real_state_ = ValidatorSessionState::move_to_persistent(description(), real_state_);
+  virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
+  for (auto &x : block_extras_) {
+    for (auto e : x.second) {
+      e->move_to_persistent(description());
+    }
+  }
+  description().finish_compaction();
+  VLOG(VALIDATOR_SESSION_NOTICE) << this << ": compacted persistent memory: " << before << " -> "
+                                 << description().get_memory_stats().arena_bytes << " bytes";
+}
+
 void ValidatorSessionImpl::on_catchain_started() {
   catchain_started_ = true;
 
@@ -856,6 +1009,19 @@ void ValidatorSessionImpl::destroy() {
   stop();
 }
 
+void ValidatorSessionImpl::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  auto stats = description().get_memory_stats();
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("round", td::to_string(cur_round_));
+  vec.emplace_back("persistentarenabytes", td::to_string(stats.arena_bytes));
+  vec.emplace_back("persistentlivebytes", td::to_string(stats.live_bytes));
+  vec.emplace_back("persistentallocatedbytes", td::to_string(stats.allocated_bytes));
+  vec.emplace_back("persistentcompactions", td::to_string(stats.compactions));
+  vec.emplace_back("hashcachelookups", td::to_string(stats.cache_lookups));
+  vec.emplace_back("hashcachehits", td::to_string(stats.cache_hits));
+  promise.set_value(std::move(vec));
+}
+
 void ValidatorSessionImpl::start_up() {
   CHECK(!rldp_.empty());
   cur_round_ = 0;
@@ -875,9 +1041,14 @@ td::actor::ActorOwn<ValidatorSession> ValidatorSession::create(
     td::actor::ActorId<keyring::Keyring> keyring, td::actor::ActorId<adnl::Adnl> adnl,
     td::actor::ActorId<rldp::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays, std::string db_root,
     std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
-  return td::actor::create_actor<ValidatorSessionImpl>("session", session_id, std::move(opts), local_id,
-                                                       std::move(nodes), std::move(callback), keyring, adnl, rldp,
-                                                       overlays, db_root, db_suffix, allow_unsafe_self_blocks_resync);
+  return td::actor::create_actor<ValidatorSessionImpl>(
+      td::actor::ActorOptions()
+          .with_name("session")
+          .with_priority(td::actor::ActorPriority::High)
+          .on_scheduler(td::actor::dedicated_scheduler("consensus")),
+      session_id,
+      std::move(opts), local_id, std::move(nodes), std::move(callback), keyring, adnl, rldp, overlays, db_root,
+      db_suffix, allow_unsafe_self_blocks_resync);
 }
 
 td::Bits256 ValidatorSessionOptions::get_hash() const {
@@ -76,6 +76,9 @@ class ValidatorSession : public td::actor::Actor {
                               td::BufferSlice data, td::BufferSlice collated_data,
                               td::Promise<CandidateDecision> promise) = 0;
     virtual void on_generate_slot(td::uint32 round, td::Promise<BlockCandidate> promise) = 0;
+    // a candidate of round - 1 with given hashes is likely to be committed and the local node generates in round
+    virtual void on_precollate_slot(td::uint32 round, ValidatorSessionRootHash prev_root_hash,
+                                    ValidatorSessionFileHash prev_file_hash) = 0;
     virtual void on_block_committed(td::uint32 round, PublicKey source, ValidatorSessionRootHash root_hash,
                                     ValidatorSessionFileHash file_hash, td::BufferSlice data,
                                     std::vector<std::pair<PublicKeyHash, td::BufferSlice>> signatures,
@@ -90,6 +93,7 @@ class ValidatorSession : public td::actor::Actor {
 
   virtual void start() = 0;
   virtual void destroy() = 0;
+  virtual void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
 
   static td::actor::ActorOwn<ValidatorSession> create(
       catchain::CatChainSessionId session_id, ValidatorSessionOptions opts, PublicKeyHash local_id,
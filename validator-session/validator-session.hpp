@@ -38,11 +38,18 @@ class ValidatorSessionImpl : public ValidatorSession {
  private:
   class BlockExtra : public catchain::CatChainBlock::Extra {
    public:
+    // nullptr if the state was pruned, see get_block_state()
     const ValidatorSessionState *get_ref() const {
       return state_;
     }
+    void set_ref(const ValidatorSessionState *state) {
+      state_ = state;
+    }
     BlockExtra(const ValidatorSessionState *state) : state_(std::move(state)) {
     }
+    void move_to_persistent(ValidatorSessionDescription &desc) {
+      state_ = ValidatorSessionState::move_to_persistent(desc, state_);
+    }
 
    private:
     const ValidatorSessionState *state_;
@@ -52,6 +59,9 @@ class ValidatorSessionImpl : public ValidatorSession {
   bool requested_new_block_now_ = false;
   const ValidatorSessionState *real_state_ = nullptr;
   const ValidatorSessionState *virtual_state_ = nullptr;
+  // states of preprocessed catchain blocks by round, they are roots for persistent memory compaction
+  std::map<td::uint32, std::vector<BlockExtra *>> block_extras_;
+  td::uint32 compaction_checked_round_ = 0;
 
   td::uint32 cur_round_ = 0;
   td::Timestamp round_started_at_ = td::Timestamp::never();
@@ -63,6 +73,8 @@ class ValidatorSessionImpl : public ValidatorSession {
 
   std::set<ValidatorSessionCandidateId> active_requests_;
 
+  td::uint32 precollate_round_ = 0;
+
   bool pending_generate_ = false;
   bool generated_ = false;
   bool sent_generated_ = false;
@@ -92,10 +104,17 @@ class ValidatorSessionImpl : public ValidatorSession {
   void on_catchain_started();
   void check_vote_for_slot(td::uint32 att);
   void check_generate_slot();
+  void check_precollate_slot();
   void check_sign_slot();
   void check_approve();
   void check_action(td::uint32 att);
   void check_all();
+  void check_compaction();
+  static constexpr td::uint32 block_states_keep_rounds() {
+    return 4;
+  }
+  const ValidatorSessionState *compute_block_state(catchain::CatChainBlock *block);
+  const ValidatorSessionState *get_block_state(catchain::CatChainBlock *block);
 
   std::unique_ptr<catchain::CatChain::Callback> make_catchain_callback() {
     class cb : public catchain::CatChain::Callback {
@@ -121,6 +140,12 @@ class ValidatorSessionImpl : public ValidatorSession {
       void started() override {
         td::actor::send_closure(id_, &ValidatorSessionImpl::on_catchain_started);
       }
+      void get_snapshot(std::vector<catchain::CatChainBlock *> blocks, td::Promise<td::BufferSlice> promise) override {
+        td::actor::send_closure(id_, &ValidatorSessionImpl::get_snapshot, std::move(blocks), std::move(promise));
+      }
+      void restore_blocks(std::vector<catchain::CatChainBlock *> blocks, td::BufferSlice snapshot) override {
+        td::actor::send_closure(id_, &ValidatorSessionImpl::restore_blocks, std::move(blocks), std::move(snapshot));
+      }
 
       cb(td::actor::ActorId<ValidatorSessionImpl> id) : id_(id) {
       }
@@ -164,10 +189,13 @@ class ValidatorSessionImpl : public ValidatorSession {
 
   void start() override;
   void destroy() override;
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
 
   void process_blocks(std::vector<catchain::CatChainBlock *> blocks);
   void finished_processing();
   void preprocess_block(catchain::CatChainBlock *block);
+  void get_snapshot(std::vector<catchain::CatChainBlock *> blocks, td::Promise<td::BufferSlice> promise);
+  void restore_blocks(std::vector<catchain::CatChainBlock *> blocks, td::BufferSlice snapshot);
   void process_broadcast(PublicKeyHash src, td::BufferSlice data);
   void process_message(PublicKeyHash src, td::BufferSlice data);
   void process_query(PublicKeyHash src, td::BufferSlice data, td::Promise<td::BufferSlice> promise);
@@ -22,6 +22,7 @@
 #include "files-async.hpp"
 #include "td/db/RocksDb.h"
 #include "common/delay.h"
+#include "td/utils/port/Stat.h"
 
 namespace ton {
 
@@ -366,7 +367,7 @@ void ArchiveManager::get_zero_state(BlockIdExt block_id, td::Promise<td::BufferS
   }
 
   auto path = db_root_ + "/archive/states/" + id.filename_short();
-  td::actor::create_actor<db::ReadFile>("readfile", path, 0, -1, 0, std::move(promise)).release();
+  db::read_file(path, 0, -1, 0, std::move(promise));
 }
 
 void ArchiveManager::check_zero_state(BlockIdExt block_id, td::Promise<bool> promise) {
@@ -389,7 +390,7 @@ void ArchiveManager::get_persistent_state(BlockIdExt block_id, BlockIdExt master
   }
 
   auto path = db_root_ + "/archive/states/" + id.filename_short();
-  td::actor::create_actor<db::ReadFile>("readfile", path, 0, -1, 0, std::move(promise)).release();
+  db::read_file(path, 0, -1, 0, std::move(promise));
 }
 
 void ArchiveManager::get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
@@ -402,7 +403,25 @@ void ArchiveManager::get_persistent_state_slice(BlockIdExt block_id, BlockIdExt
   }
 
   auto path = db_root_ + "/archive/states/" + id.filename_short();
-  td::actor::create_actor<db::ReadFile>("readfile", path, offset, max_size, 0, std::move(promise)).release();
+  db::read_file(path, offset, max_size, 0, std::move(promise));
+}
+
+void ArchiveManager::get_persistent_state_size(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                               td::Promise<td::uint64> promise) {
+  auto id = FileReference{fileref::PersistentState{block_id, masterchain_block_id}};
+  auto hash = id.hash();
+  if (perm_states_.find(hash) == perm_states_.end()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "state file not in db"));
+    return;
+  }
+
+  auto path = db_root_ + "/archive/states/" + id.filename_short();
+  td::actor::run_blocking(
+      [path = std::move(path)]() -> td::Result<td::uint64> {
+        TRY_RESULT(stat, td::stat(path));
+        return static_cast<td::uint64>(stat.size_);
+      },
+      std::move(promise));
 }
 
 void ArchiveManager::check_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id,
@@ -1076,6 +1095,17 @@ void ArchiveManager::get_archive_slice(td::uint64 archive_id, td::uint64 offset,
   td::actor::send_closure(F->file_actor_id(), &ArchiveSlice::get_slice, archive_id, offset, limit, std::move(promise));
 }
 
+void ArchiveManager::get_archive_size(td::uint64 archive_id, td::Promise<td::uint64> promise) {
+  auto arch = static_cast<BlockSeqno>(archive_id);
+  auto F = get_file_desc(ShardIdFull{masterchainId}, PackageId{arch, false, false}, 0, 0, 0, false);
+  if (!F) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "archive not found"));
+    return;
+  }
+
+  td::actor::send_closure(F->file_actor_id(), &ArchiveSlice::get_slice_size, archive_id, std::move(promise));
+}
+
 void ArchiveManager::commit_transaction() {
   if (!async_mode_ || huge_transaction_size_++ >= 100) {
     index_->commit_transaction().ensure();
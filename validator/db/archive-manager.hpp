@@ -49,6 +49,7 @@ class ArchiveManager : public td::actor::Actor {
   void get_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<td::BufferSlice> promise);
   void get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
                                   td::int64 max_size, td::Promise<td::BufferSlice> promise);
+  void get_persistent_state_size(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<td::uint64> promise);
   void check_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<bool> promise);
   void check_zero_state(BlockIdExt block_id, td::Promise<bool> promise);
 
@@ -65,6 +66,7 @@ class ArchiveManager : public td::actor::Actor {
   void get_archive_id(BlockSeqno masterchain_seqno, td::Promise<td::uint64> promise);
   void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
                          td::Promise<td::BufferSlice> promise);
+  void get_archive_size(td::uint64 archive_id, td::Promise<td::uint64> promise);
 
   void start_up() override;
 
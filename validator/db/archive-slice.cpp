@@ -24,7 +24,6 @@
 #include "ton/ton-io.hpp"
 #include "td/utils/port/path.h"
 #include "common/delay.h"
-#include "files-async.hpp"
 
 namespace ton {
 
@@ -32,28 +31,71 @@ namespace validator {
 
 void PackageWriter::append(std::string filename, td::BufferSlice data,
                            td::Promise<std::pair<td::uint64, td::uint64>> promise) {
-  auto offset = package_->append(std::move(filename), std::move(data), !async_mode_);
-  auto size = package_->size();
+  if (!async_mode_) {
+    // synced in flush_pending, after all previous async appends are written
+    auto offset = package_->append(std::move(filename), std::move(data), false);
+    auto size = package_->size();
+    pending_.push_back(PendingAppend{offset, size, true, true, std::move(promise)});
+    flush_pending();
+    return;
+  }
 
-  promise.set_value(std::pair<td::uint64, td::uint64>{offset, size});
+  auto id = first_pending_id_ + pending_.size();
+  pending_.push_back(PendingAppend{0, 0, false, false, std::move(promise)});
+  // the package is kept alive by the promise till the write is finished
+  package_->append_async(std::move(filename), data.as_slice(),
+                         [SelfId = actor_id(this), id, package = package_](
+                             td::Result<std::pair<td::uint64, td::uint64>> R) mutable {
+                           td::actor::send_closure(SelfId, &PackageWriter::on_written, id, std::move(R));
+                         });
 }
 
-class PackageReader : public td::actor::Actor {
- public:
-  PackageReader(std::shared_ptr<Package> package, td::uint64 offset,
-                td::Promise<std::pair<std::string, td::BufferSlice>> promise)
-      : package_(std::move(package)), offset_(offset), promise_(std::move(promise)) {
+void PackageWriter::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
+  async_mode_ = mode;
+  if (async_mode_) {
+    promise.set_value(td::Unit());
+    return;
   }
-  void start_up() {
-    promise_.set_result(package_->read(offset_));
-    stop();
+  // the package is synced when all pending appends are written
+  auto P = [promise = std::move(promise)](td::Result<std::pair<td::uint64, td::uint64>> R) mutable {
+    promise.set_value(td::Unit());
+  };
+  pending_.push_back(PendingAppend{0, 0, true, true, std::move(P)});
+  flush_pending();
+}
+
+void PackageWriter::on_written(td::uint64 id, td::Result<std::pair<td::uint64, td::uint64>> R) {
+  if (R.is_error()) {
+    LOG(FATAL) << "failed to write to package: " << R.move_as_error();
   }
+  CHECK(id >= first_pending_id_ && id - first_pending_id_ < pending_.size());
+  auto &entry = pending_[static_cast<size_t>(id - first_pending_id_)];
+  entry.offset = R.ok().first;
+  entry.size = R.ok().second;
+  entry.done = true;
+  flush_pending();
+}
 
- private:
-  std::shared_ptr<Package> package_;
-  td::uint64 offset_;
-  td::Promise<std::pair<std::string, td::BufferSlice>> promise_;
-};
+void PackageWriter::flush_pending() {
+  size_t ready = 0;
+  bool sync = false;
+  while (ready < pending_.size() && pending_[ready].done) {
+    sync |= pending_[ready].sync;
+    ready++;
+  }
+  if (ready == 0) {
+    return;
+  }
+  if (sync) {
+    package_->sync();
+  }
+  for (size_t i = 0; i < ready; i++) {
+    auto entry = std::move(pending_.front());
+    pending_.pop_front();
+    first_pending_id_++;
+    entry.promise.set_value(std::pair<td::uint64, td::uint64>{entry.offset, entry.size});
+  }
+}
 
 void ArchiveSlice::add_handle(BlockHandle handle, td::Promise<td::Unit> promise) {
   if (destroyed_) {
@@ -179,6 +221,9 @@ void ArchiveSlice::add_file(BlockHandle handle, FileReference ref_id, td::Buffer
     promise.set_value(td::Unit());
     return;
   }
+  if (p->package->compresses()) {
+    p->compressed = PackageInfo::Compressed::Yes;
+  }
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), idx = p->idx, ref_id, promise = std::move(promise)](
                                           td::Result<std::pair<td::uint64, td::uint64>> R) mutable {
     if (R.is_error()) {
@@ -273,15 +318,12 @@ void ArchiveSlice::get_file(ConstBlockHandle handle, FileReference ref_id, td::P
       promise, p,
       choose_package(
           handle ? handle->id().is_masterchain() ? handle->id().seqno() : handle->masterchain_ref_block() : 0, false));
-  auto P = td::PromiseCreator::lambda(
-      [promise = std::move(promise)](td::Result<std::pair<std::string, td::BufferSlice>> R) mutable {
-        if (R.is_error()) {
-          promise.set_error(R.move_as_error());
-        } else {
-          promise.set_value(std::move(R.move_as_ok().second));
-        }
-      });
-  td::actor::create_actor<PackageReader>("reader", p->package, offset, std::move(P)).release();
+  auto &package = p->package;
+  package->read_async(offset, [package, promise = std::move(promise)](
+                                  td::Result<std::pair<std::string, td::BufferSlice>> R) mutable {
+    TRY_RESULT_PROMISE(promise, entry, std::move(R));
+    promise.set_value(std::move(entry.second));
+  });
 }
 
 void ArchiveSlice::get_block_common(AccountIdPrefixFull account_id,
@@ -424,6 +466,96 @@ td::BufferSlice ArchiveSlice::get_db_key_block_info(BlockIdExt block_id) {
   return create_serialize_tl_object<ton_api::db_blockdb_key_value>(create_tl_block_id(block_id));
 }
 
+void ArchiveSlice::detect_compression(PackageInfo *p, td::Promise<td::Unit> promise) {
+  td::actor::run_blocking([package = p->package]() { return package->has_compressed_entries(); },
+                          [self = this, idx = p->idx, promise = std::move(promise)](td::Result<bool> R) mutable {
+                            TRY_RESULT_PROMISE(promise, compressed, std::move(R));
+                            auto &info = self->packages_.at(idx);
+                            if (info.compressed == PackageInfo::Compressed::Unknown) {
+                              info.compressed = compressed ? PackageInfo::Compressed::Yes : PackageInfo::Compressed::No;
+                            }
+                            promise.set_value(td::Unit());
+                          });
+}
+
+void ArchiveSlice::get_served_package(PackageInfo *p, td::Promise<std::shared_ptr<Package>> promise) {
+  if (p->compressed == PackageInfo::Compressed::Unknown) {
+    detect_compression(p, [self = this, idx = p->idx, promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+      if (R.is_error()) {
+        promise.set_error(R.move_as_error());
+        return;
+      }
+      if (idx >= self->packages_.size()) {
+        promise.set_error(td::Status::Error(ErrorCode::notready, "package truncated"));
+        return;
+      }
+      self->get_served_package(&self->packages_[idx], std::move(promise));
+    });
+    return;
+  }
+  if (p->compressed == PackageInfo::Compressed::No) {
+    promise.set_value(std::shared_ptr<Package>(p->package));
+    return;
+  }
+  if (p->uncompressed && p->uncompressed_source_size == p->package->size()) {
+    promise.set_value(std::shared_ptr<Package>(p->uncompressed));
+    return;
+  }
+  p->uncompressed_waiters.push_back(std::move(promise));
+  if (p->uncompressed_waiters.size() > 1) {
+    return;
+  }
+  // entries are copied in order, so offsets in an older copy stay valid in a newer one
+  td::actor::run_blocking(
+      [package = p->package, path = p->path + ".raw"]() -> td::Result<std::pair<std::shared_ptr<Package>, td::uint64>> {
+        auto source_size = package->size();
+        TRY_RESULT(raw, Package::open(path + ".new", false, true));
+        raw.set_compression(nullptr);
+        TRY_STATUS(raw.truncate(0));
+        package->iterate([&](std::string filename, td::BufferSlice data, td::uint64) {
+          raw.append(std::move(filename), data.as_slice(), false);
+          return true;
+        });
+        raw.sync();
+        TRY_STATUS(td::rename(path + ".new", path));
+        return std::make_pair(std::make_shared<Package>(std::move(raw)), source_size);
+      },
+      [self = this, idx = p->idx,
+       package = p->package](td::Result<std::pair<std::shared_ptr<Package>, td::uint64>> R) mutable {
+        self->got_uncompressed_package(idx, std::move(package), std::move(R));
+      });
+}
+
+void ArchiveSlice::got_uncompressed_package(td::uint32 idx, std::shared_ptr<Package> source,
+                                            td::Result<std::pair<std::shared_ptr<Package>, td::uint64>> R) {
+  if (idx >= packages_.size()) {
+    return;
+  }
+  auto &p = packages_[idx];
+  auto waiters = std::move(p.uncompressed_waiters);
+  p.uncompressed_waiters.clear();
+  if (p.package != source) {
+    // the package was truncated while the copy was made
+    for (auto &promise : waiters) {
+      get_served_package(&p, std::move(promise));
+    }
+    return;
+  }
+  if (R.is_error()) {
+    LOG(WARNING) << "failed to make uncompressed copy of " << p.path << ": " << R.error();
+    for (auto &promise : waiters) {
+      promise.set_error(R.error().clone());
+    }
+    return;
+  }
+  auto v = R.move_as_ok();
+  p.uncompressed = std::move(v.first);
+  p.uncompressed_source_size = v.second;
+  for (auto &promise : waiters) {
+    promise.set_value(std::shared_ptr<Package>(p.uncompressed));
+  }
+}
+
 void ArchiveSlice::get_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
                              td::Promise<td::BufferSlice> promise) {
   if (static_cast<td::uint32>(archive_id) != archive_id_) {
@@ -432,7 +564,28 @@ void ArchiveSlice::get_slice(td::uint64 archive_id, td::uint64 offset, td::uint3
   }
   auto value = static_cast<td::uint32>(archive_id >> 32);
   TRY_RESULT_PROMISE(promise, p, choose_package(value, false));
-  td::actor::create_actor<db::ReadFile>("readfile", p->path, offset, limit, 0, std::move(promise)).release();
+  get_served_package(p, [offset, limit, promise = std::move(promise)](
+                            td::Result<std::shared_ptr<Package>> R) mutable {
+    TRY_RESULT_PROMISE(promise, package, std::move(R));
+    td::actor::run_blocking(
+        [package = std::move(package), offset, limit]() -> td::Result<td::BufferSlice> {
+          return package->read_raw(offset, limit);
+        },
+        std::move(promise));
+  });
+}
+
+void ArchiveSlice::get_slice_size(td::uint64 archive_id, td::Promise<td::uint64> promise) {
+  if (static_cast<td::uint32>(archive_id) != archive_id_) {
+    promise.set_error(td::Status::Error(ErrorCode::error, "bad archive id"));
+    return;
+  }
+  auto value = static_cast<td::uint32>(archive_id >> 32);
+  TRY_RESULT_PROMISE(promise, p, choose_package(value, false));
+  get_served_package(p, [promise = std::move(promise)](td::Result<std::shared_ptr<Package>> R) mutable {
+    TRY_RESULT_PROMISE(promise, package, std::move(R));
+    promise.set_result(package->raw_size());
+  });
 }
 
 void ArchiveSlice::get_archive_id(BlockSeqno masterchain_seqno, td::Promise<td::uint64> promise) {
@@ -618,6 +771,9 @@ void ArchiveSlice::destroy(td::Promise<td::Unit> promise) {
 
   for (auto &p : packages_) {
     td::unlink(p.path).ensure();
+    if (p.uncompressed) {
+      td::unlink(p.path + ".raw").ignore();
+    }
   }
 
   packages_.clear();
@@ -816,6 +972,8 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle handl
   }
 
   pack->package = new_package;
+  pack->uncompressed = nullptr;
+  pack->uncompressed_source_size = 0;
   pack->writer.reset();
   td::unlink(pack->path).ensure();
   td::rename(pack->path + ".new", pack->path).ensure();
@@ -823,6 +981,9 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle handl
 
   for (auto idx = pack->idx + 1; idx < packages_.size(); idx++) {
     td::unlink(packages_[idx].path).ensure();
+    if (packages_[idx].uncompressed) {
+      td::unlink(packages_[idx].path + ".raw").ignore();
+    }
   }
   packages_.erase(packages_.begin() + pack->idx + 1);
 
@@ -22,6 +22,8 @@
 #include "package.hpp"
 #include "fileref.hpp"
 
+#include <deque>
+
 namespace ton {
 
 namespace validator {
@@ -58,17 +60,26 @@ class PackageWriter : public td::actor::Actor {
   }
 
   void append(std::string filename, td::BufferSlice data, td::Promise<std::pair<td::uint64, td::uint64>> promise);
-  void set_async_mode(bool mode, td::Promise<td::Unit> promise) {
-    async_mode_ = mode;
-    if (!async_mode_) {
-      package_->sync();
-    }
-    promise.set_value(td::Unit());
-  }
+  void set_async_mode(bool mode, td::Promise<td::Unit> promise);
 
  private:
+  // In async mode entries are written by io_uring and may complete out of order, but the results are
+  // returned in the order of appends, so the package size stored in the db never covers an unwritten entry
+  struct PendingAppend {
+    td::uint64 offset{0};
+    td::uint64 size{0};
+    bool done{false};
+    bool sync{false};
+    td::Promise<std::pair<td::uint64, td::uint64>> promise;
+  };
+
   std::shared_ptr<Package> package_;
   bool async_mode_ = false;
+  std::deque<PendingAppend> pending_;
+  td::uint64 first_pending_id_ = 0;
+
+  void on_written(td::uint64 id, td::Result<std::pair<td::uint64, td::uint64>> R);
+  void flush_pending();
 };
 
 class ArchiveSlice : public td::actor::Actor {
@@ -94,6 +105,7 @@ class ArchiveSlice : public td::actor::Actor {
                         td::Promise<ConstBlockHandle> promise);
 
   void get_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, td::Promise<td::BufferSlice> promise);
+  void get_slice_size(td::uint64 archive_id, td::Promise<td::uint64> promise);
 
   void start_up() override;
   void destroy(td::Promise<td::Unit> promise);
@@ -146,10 +158,23 @@ class ArchiveSlice : public td::actor::Actor {
     std::string path;
     td::uint32 idx;
     td::uint32 version;
+    // nodes of older versions can't read compressed entries, so an uncompressed copy of such packages
+    // (at path + ".raw") is served to other nodes instead
+    enum class Compressed { Unknown, No, Yes } compressed = Compressed::Unknown;
+    std::shared_ptr<Package> uncompressed;
+    // size of the package when the uncompressed copy was made, the copy is remade after the package grows
+    td::uint64 uncompressed_source_size = 0;
+    std::vector<td::Promise<std::shared_ptr<Package>>> uncompressed_waiters;
   };
   std::vector<PackageInfo> packages_;
 
   td::Result<PackageInfo *> choose_package(BlockSeqno masterchain_seqno, bool force);
+  // scans entry headers of the package on the blocking pool and sets its compressed flag
+  void detect_compression(PackageInfo *p, td::Promise<td::Unit> promise);
+  // the package itself if it has no compressed entries, otherwise its uncompressed copy, made on the blocking pool
+  void get_served_package(PackageInfo *p, td::Promise<std::shared_ptr<Package>> promise);
+  void got_uncompressed_package(td::uint32 idx, std::shared_ptr<Package> source,
+                                td::Result<std::pair<std::shared_ptr<Package>, td::uint64>> R);
   void add_package(BlockSeqno masterchain_seqno, td::uint64 size, td::uint32 version);
   void truncate_shard(BlockSeqno masterchain_seqno, ShardIdFull shard, td::uint32 cutoff_idx, Package *pack);
   bool truncate_block(BlockSeqno masterchain_seqno, BlockIdExt block_id, td::uint32 cutoff_idx, Package *pack);
@@ -250,14 +250,23 @@ void CellDbIn::set_block(KeyHash key_hash, DbEntry e) {
 void CellDb::load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise) {
   if (!started_) {
     td::actor::send_closure(cell_db_, &CellDbIn::load_cell, hash, std::move(promise));
-  } else {
-    auto R = boc_->load_cell(hash.as_slice());
-    if (R.is_error()) {
-      td::actor::send_closure(cell_db_, &CellDbIn::load_cell, hash, std::move(promise));
-    } else {
-      promise.set_result(R.move_as_ok());
-    }
+    return;
   }
+  td::actor::run_blocking(
+      [reader = reader_, hash]() -> td::Result<td::Ref<vm::DataCell>> { return reader->load_cell(hash.as_slice()); },
+      [cell_db = cell_db_.get(), hash, promise = std::move(promise)](td::Result<td::Ref<vm::DataCell>> R) mutable {
+        if (R.is_error()) {
+          td::actor::send_closure(cell_db, &CellDbIn::load_cell, hash, std::move(promise));
+        } else {
+          promise.set_result(R.move_as_ok());
+        }
+      });
+}
+
+void CellDb::update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot) {
+  started_ = true;
+  boc_->set_loader(std::make_unique<vm::CellLoader>(std::move(snapshot))).ensure();
+  reader_ = boc_->get_cell_db_reader();
 }
 
 void CellDb::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise) {
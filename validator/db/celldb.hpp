@@ -92,10 +92,7 @@ class CellDb : public td::actor::Actor {
  public:
   void load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise);
   void store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
-  void update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot) {
-    started_ = true;
-    boc_->set_loader(std::make_unique<vm::CellLoader>(std::move(snapshot))).ensure();
-  }
+  void update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot);
 
   CellDb(td::actor::ActorId<RootDb> root_db, std::string path) : root_db_(root_db), path_(path) {
   }
@@ -109,6 +106,8 @@ class CellDb : public td::actor::Actor {
   td::actor::ActorOwn<CellDbIn> cell_db_;
 
   std::unique_ptr<vm::DynamicBagOfCellsDb> boc_;
+  // reader of the last snapshot, shared with loads running on blocking threads
+  std::shared_ptr<vm::CellDbReader> reader_;
   bool started_ = false;
 };
 
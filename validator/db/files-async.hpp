@@ -19,12 +19,15 @@
 #pragma once
 
 #include "td/utils/port/path.h"
+#include "td/utils/port/FileFd.h"
 #include "td/utils/filesystem.h"
 #include "td/actor/actor.h"
 #include "td/utils/buffer.h"
 
 #include "common/errorcode.h"
 
+#include <memory>
+
 namespace ton {
 
 namespace validator {
@@ -50,24 +53,46 @@ class WriteFile : public td::actor::Actor {
       return;
     }
     auto res = R.move_as_ok();
-    auto file = std::move(res.first);
-    auto old_name = res.second;
-    td::uint64 offset = 0;
-    while (data_.size() > 0) {
-      auto R = file.pwrite(data_.as_slice(), offset);
-      auto s = R.move_as_ok();
-      offset += s;
-      data_.confirm_read(s);
-    }
-    file.sync().ensure();
-    if (new_name_.length() > 0) {
-      td::rename(old_name, new_name_).ensure();
-      promise_.set_value(std::move(new_name_));
-    } else {
-      promise_.set_value(std::move(old_name));
-    }
+    file_ = std::move(res.first);
+    old_name_ = std::move(res.second);
+    // the actor must stay alive till the write is finished, because the file is owned by it
+    td::actor::file_pwrite(file_, std::move(data_), 0, [self = this](td::Result<td::Unit> R) {
+      if (R.is_error()) {
+        self->on_error(R.move_as_error());
+        return;
+      }
+      self->on_written();
+    });
+  }
+  void on_error(td::Status error) {
+    file_.close();
+    td::unlink(old_name_).ignore();
+    promise_.set_error(std::move(error));
     stop();
   }
+  void on_written() {
+    td::actor::run_blocking(
+        [file = std::move(file_), old_name = std::move(old_name_),
+         new_name = std::move(new_name_)]() mutable -> td::Result<std::string> {
+          auto S = file.sync();
+          file.close();
+          if (S.is_ok() && new_name.length() > 0) {
+            S = td::rename(old_name, new_name);
+            if (S.is_ok()) {
+              return std::move(new_name);
+            }
+          }
+          if (S.is_error()) {
+            td::unlink(old_name).ignore();
+            return std::move(S);
+          }
+          return std::move(old_name);
+        },
+        [self = this](td::Result<std::string> R) {
+          self->promise_.set_result(std::move(R));
+          self->stop();
+        });
+  }
   WriteFile(std::string tmp_dir, std::string new_name, td::BufferSlice data, td::Promise<std::string> promise)
       : tmp_dir_(tmp_dir), new_name_(new_name), data_(std::move(data)), promise_(std::move(promise)) {
   }
@@ -77,39 +102,58 @@ class WriteFile : public td::actor::Actor {
   std::string new_name_;
   td::BufferSlice data_;
   td::Promise<std::string> promise_;
+  td::FileFd file_;
+  std::string old_name_;
 };
 
-class ReadFile : public td::actor::Actor {
- public:
-  enum Flags : td::uint32 { f_disable_log = 1 };
-  void start_up() override {
-    auto S = td::read_file(file_name_, max_length_, offset_);
-    if (S.is_ok()) {
-      promise_.set_result(S.move_as_ok());
-    } else {
-      // TODO check error code
-      if (flags_ & Flags::f_disable_log) {
-        LOG(DEBUG) << "missing file " << file_name_;
-      } else {
-        LOG(ERROR) << "missing file " << file_name_;
-      }
-      promise_.set_error(td::Status::Error(ErrorCode::notready, "file does not exist"));
-    }
-    stop();
-  }
-  ReadFile(std::string file_name, td::int64 offset, td::int64 max_length, td::uint32 flags,
-           td::Promise<td::BufferSlice> promise)
-      : file_name_(file_name), offset_(offset), max_length_(max_length), flags_(flags), promise_(std::move(promise)) {
-  }
-
- private:
-  std::string file_name_;
-  td::int64 offset_;
-  td::int64 max_length_;
-  td::uint32 flags_;
-  td::Promise<td::BufferSlice> promise_;
+struct ReadFileFlags {
+  enum : td::uint32 { f_disable_log = 1 };
 };
 
+// Reads the file with file io of the scheduler (io_uring when available); must be called from an actor.
+// The file is opened on a blocking thread.
+inline void read_file(std::string file_name, td::int64 offset, td::int64 max_length, td::uint32 flags,
+                      td::Promise<td::BufferSlice> promise) {
+  td::actor::run_blocking(
+      [file_name, offset, max_length]() -> td::Result<std::pair<std::shared_ptr<td::FileFd>, td::int64>> {
+        TRY_RESULT(fd, td::FileFd::open(file_name, td::FileFd::Read));
+        TRY_RESULT(file_size, fd.get_size());
+        if (offset < 0 || offset > file_size) {
+          return td::Status::Error("invalid offset");
+        }
+        auto size = file_size - offset;
+        if (max_length >= 0 && max_length < size) {
+          size = max_length;
+        }
+        return std::make_pair(std::make_shared<td::FileFd>(std::move(fd)), size);
+      },
+      [file_name, offset, flags, promise = std::move(promise)](
+          td::Result<std::pair<std::shared_ptr<td::FileFd>, td::int64>> R) mutable {
+        if (R.is_error()) {
+          // TODO check error code
+          if (flags & ReadFileFlags::f_disable_log) {
+            LOG(DEBUG) << "missing file " << file_name << ": " << R.error();
+          } else {
+            LOG(ERROR) << "missing file " << file_name << ": " << R.error();
+          }
+          promise.set_error(td::Status::Error(ErrorCode::notready, "file does not exist"));
+          return;
+        }
+        auto fd = std::move(R.ok_ref().first);
+        auto size = R.ok().second;
+        // the file is kept open by the promise till the read is finished
+        td::actor::file_pread(*fd, td::narrow_cast<size_t>(size), offset,
+                              [fd, size, promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+                                TRY_RESULT_PROMISE(promise, data, std::move(R));
+                                if (data.size() != static_cast<size_t>(size)) {
+                                  promise.set_error(td::Status::Error(ErrorCode::notready, "too short read"));
+                                  return;
+                                }
+                                promise.set_value(std::move(data));
+                              });
+      });
+}
+
 }  // namespace db
 
 }  // namespace validator
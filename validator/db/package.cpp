@@ -18,6 +18,20 @@
 */
 #include "package.hpp"
 #include "common/errorcode.h"
+#include "td/utils/Gzip.h"
+#include "td/utils/ThreadSafeCounter.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ton {
 
@@ -39,26 +53,620 @@ constexpr td::uint16 entry_header_magic() {
   return 0x1e8b;
 }
 
+// data of a compressed entry starts with the uncompressed size and the offset of the dictionary entry
+constexpr td::uint16 compressed_entry_header_magic() {
+  return 0x1e8c;
+}
+
+// dictionary of compressed entries, which is not a file
+constexpr td::uint16 dictionary_entry_header_magic() {
+  return 0x1e8d;
+}
+
+constexpr size_t compressed_prefix_size() {
+  return 12;
+}
+
+constexpr td::uint64 no_dictionary() {
+  return std::numeric_limits<td::uint64>::max();
+}
+
+// the dictionary may be already stored in the package, which is checked before the next compressed append
+constexpr td::uint64 unknown_dictionary() {
+  return std::numeric_limits<td::uint64>::max() - 1;
+}
+
+// smaller entries are stored as is
+constexpr size_t min_compressed_size() {
+  return 256;
+}
+
+// compressed entry must be smaller than the original by at least 1/8 to be worth decompression
+constexpr double max_compression_ratio() {
+  return 0.875;
+}
+
 constexpr td::uint32 package_header_magic() {
   return 0xae8fdd01;
 }
+
+struct ReadCacheCounters {
+  td::NamedThreadSafeCounter::CounterRef hit =
+      td::NamedThreadSafeCounter::get_default().get_counter("package.cache.hit");
+  td::NamedThreadSafeCounter::CounterRef miss =
+      td::NamedThreadSafeCounter::get_default().get_counter("package.cache.miss");
+  td::NamedThreadSafeCounter::CounterRef readahead =
+      td::NamedThreadSafeCounter::get_default().get_counter("package.cache.readahead");
+
+  static ReadCacheCounters &get() {
+    static ReadCacheCounters res;
+    return res;
+  }
+};
+
+// read_async reads this much at first, so most entries need only one request
+constexpr size_t first_read_size() {
+  return 1 << 14;
+}
+
+struct EntryHeader {
+  td::uint16 magic;
+  td::uint32 filename_size;
+  td::uint32 data_size;
+
+  td::uint64 size() const {
+    return 8 + static_cast<td::uint64>(filename_size) + data_size;
+  }
+};
+
+td::Result<EntryHeader> parse_entry_header(td::Slice data, td::uint64 offset) {
+  if (data.size() < 8) {
+    return td::Status::Error(ErrorCode::notready, "too short read");
+  }
+  td::uint32 header[2];
+  std::memcpy(header, data.data(), 8);
+  auto magic = static_cast<td::uint16>(header[0] & 0xffff);
+  if (magic != entry_header_magic() && magic != compressed_entry_header_magic() &&
+      magic != dictionary_entry_header_magic()) {
+    return td::Status::Error(ErrorCode::notready, PSTRING() << "bad entry magic " << magic << " offset=" << offset);
+  }
+  return EntryHeader{magic, header[0] >> 16, header[1]};
+}
+
+// Calls f(offset, header) for entries till the end of file or till f returns false. An incomplete entry at the end,
+// which is being written, is skipped. Reads bypass the read cache, because only the headers are needed
+template <class F>
+td::Status for_each_entry_header(const td::FileFd &fd, F &&f) {
+  TRY_RESULT(file_size, fd.get_size());
+  td::uint64 offset = header_size();
+  while (offset + 8 <= static_cast<td::uint64>(file_size)) {
+    td::uint8 header_data[8];
+    TRY_RESULT(s, fd.pread(td::MutableSlice(header_data, 8), offset));
+    TRY_RESULT(header, parse_entry_header(td::Slice(header_data, s), offset));
+    if (offset + header.size() > static_cast<td::uint64>(file_size) || !f(offset - header_size(), header)) {
+      break;
+    }
+    offset += header.size();
+  }
+  return td::Status::OK();
+}
+
+struct DefaultCompression {
+  std::mutex mutex;
+  std::shared_ptr<const PackageCompression> compression;
+
+  static DefaultCompression &get() {
+    static DefaultCompression res;
+    return res;
+  }
+};
+
+constexpr size_t block_cache_shards() {
+  return 16;
+}
+
+// LRU of 64KB file blocks shared by all packages, so that 256MB are spent on the blocks read last in any package.
+// The blocks are split into shards by hash to keep lock contention low, each shard is an LRU of its own.
+class BlockCache {
+ public:
+  static constexpr td::uint64 block_size() {
+    return 1 << 16;
+  }
+
+  static BlockCache &get() {
+    static BlockCache *res = new BlockCache();
+    return *res;
+  }
+
+  td::BufferSlice find(td::uint64 package_id, td::uint64 block_id) {
+    auto &shard = get_shard(package_id, block_id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto it = shard.blocks.find(Key{package_id, block_id});
+    if (it == shard.blocks.end()) {
+      return td::BufferSlice();
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+    return it->second.data.clone();
+  }
+
+  // adds the block only if the generation of the package didn't change since the block was read
+  void add(td::uint64 package_id, td::uint64 block_id, td::BufferSlice data, const std::atomic<td::uint64> &generation,
+           td::uint64 read_generation) {
+    auto &shard = get_shard(package_id, block_id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    if (generation.load(std::memory_order_acquire) != read_generation) {
+      return;
+    }
+    Key key{package_id, block_id};
+    if (shard.blocks.count(key) != 0) {
+      return;
+    }
+    while (shard.blocks.size() >= max_shard_blocks()) {
+      shard.blocks.erase(shard.lru.back());
+      shard.lru.pop_back();
+    }
+    shard.lru.push_front(key);
+    shard.blocks.emplace(key, Block{std::move(data), shard.lru.begin()});
+  }
+
+  void erase(td::uint64 package_id, td::uint64 block_id) {
+    auto &shard = get_shard(package_id, block_id);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto it = shard.blocks.find(Key{package_id, block_id});
+    if (it != shard.blocks.end()) {
+      shard.lru.erase(it->second.lru_it);
+      shard.blocks.erase(it);
+    }
+  }
+
+  void erase_package(td::uint64 package_id) {
+    for (auto &shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      for (auto it = shard.lru.begin(); it != shard.lru.end();) {
+        if (it->package_id == package_id) {
+          shard.blocks.erase(*it);
+          it = shard.lru.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t max_shard_blocks() {
+    // 256MB in total
+    return 4096 / block_cache_shards();
+  }
+
+  struct Key {
+    td::uint64 package_id;
+    td::uint64 block_id;
+
+    bool operator==(const Key &other) const {
+      return package_id == other.package_id && block_id == other.block_id;
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return std::hash<td::uint64>()(key.package_id * 0x9e3779b97f4a7c15ull + key.block_id);
+    }
+  };
+  struct Block {
+    td::BufferSlice data;
+    std::list<Key>::iterator lru_it;
+  };
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<Key, Block, KeyHash> blocks;
+    std::list<Key> lru;
+  };
+
+  std::array<Shard, block_cache_shards()> shards_;
+
+  Shard &get_shard(td::uint64 package_id, td::uint64 block_id) {
+    return shards_[KeyHash()(Key{package_id, block_id}) % block_cache_shards()];
+  }
+};
 }  // namespace
 
-Package::Package(td::FileFd fd) : fd_(std::move(fd)) {
+// Reads of a package through BlockCache.
+// Only complete blocks are cached: package is append-only, so they can change only after truncate.
+// Misses following a sequential access pattern read ahead up to 1MB at once.
+class Package::ReadCache {
+ public:
+  static constexpr td::uint64 block_size() {
+    return BlockCache::block_size();
+  }
+
+  ReadCache() = default;
+  ReadCache(const ReadCache &) = delete;
+  ReadCache &operator=(const ReadCache &) = delete;
+  ReadCache(ReadCache &&) = delete;
+  ReadCache &operator=(ReadCache &&) = delete;
+  ~ReadCache() {
+    BlockCache::get().erase_package(id_);
+  }
+
+  td::Result<size_t> pread(const td::FileFd &fd, td::MutableSlice dest, td::uint64 offset) {
+    if (dest.size() > max_cached_read()) {
+      return fd.pread(dest, offset);
+    }
+    size_t res = 0;
+    while (!dest.empty()) {
+      TRY_RESULT(block, get_block(fd, offset / block_size()));
+      auto block_offset = static_cast<size_t>(offset % block_size());
+      if (block_offset >= block.size()) {
+        break;
+      }
+      auto part = block.as_slice().substr(block_offset).truncate(dest.size());
+      dest.copy_from(part);
+      dest.remove_prefix(part.size());
+      offset += part.size();
+      res += part.size();
+      if (block.size() < block_size()) {
+        break;
+      }
+    }
+    return res;
+  }
+
+  // Same as pread, but the missing blocks are read with file io of the scheduler; must be called from an actor.
+  // Async reads are random, so they don't read ahead.
+  void pread_async(const td::FileFd &fd, size_t size, td::uint64 offset, td::Promise<td::BufferSlice> promise) {
+    if (size > max_cached_read() || size == 0) {
+      td::actor::file_pread(fd, size, offset, std::move(promise));
+      return;
+    }
+    auto &counters = ReadCacheCounters::get();
+    auto &cache = BlockCache::get();
+    auto generation = generation_.load(std::memory_order_acquire);
+    auto first_block_id = offset / block_size();
+    auto end_block_id = (offset + size - 1) / block_size() + 1;
+    std::vector<td::BufferSlice> blocks;
+    for (auto block_id = first_block_id; block_id < end_block_id; block_id++) {
+      auto block = cache.find(id_, block_id);
+      if (block.empty()) {
+        break;
+      }
+      blocks.push_back(std::move(block));
+    }
+    counters.hit.add(static_cast<td::int64>(blocks.size()));
+    auto read_block_id = first_block_id + blocks.size();
+    if (read_block_id == end_block_id) {
+      promise.set_value(concat_blocks(blocks, td::BufferSlice(), offset - first_block_id * block_size(), size));
+      return;
+    }
+    counters.miss.add(static_cast<td::int64>(end_block_id - read_block_id));
+    td::actor::file_pread(
+        fd, static_cast<size_t>((end_block_id - read_block_id) * block_size()), read_block_id * block_size(),
+        [this, blocks = std::move(blocks), read_block_id, generation, skip = offset - first_block_id * block_size(),
+         size, promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+          TRY_RESULT_PROMISE(promise, data, std::move(R));
+          for (size_t i = 0; (i + 1) * block_size() <= data.size(); i++) {
+            td::BufferSlice block(data.as_slice().substr(i * block_size()).truncate(block_size()));
+            BlockCache::get().add(id_, read_block_id + i, std::move(block), generation_, generation);
+          }
+          promise.set_value(concat_blocks(blocks, std::move(data), skip, size));
+        });
+  }
+
+  void clear() {
+    // reads in flight won't add their blocks
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    BlockCache::get().erase_package(id_);
+  }
+
+  // Drops blocks, which were read before an async append to them was finished
+  void invalidate(td::uint64 offset, td::uint64 size) {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    for (auto block_id = offset / block_size(); block_id * block_size() < offset + size; block_id++) {
+      BlockCache::get().erase(id_, block_id);
+    }
+  }
+
+ private:
+  static constexpr size_t max_cached_read() {
+    return 1 << 20;
+  }
+  static constexpr size_t max_readahead_blocks() {
+    return 16;
+  }
+
+  static td::uint64 next_id() {
+    static std::atomic<td::uint64> id{0};
+    return id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  const td::uint64 id_ = next_id();
+  std::atomic<td::uint64> generation_{0};
+  std::mutex mutex_;
+  td::uint64 last_block_id_ = std::numeric_limits<td::uint64>::max();
+  size_t readahead_blocks_ = 1;
+
+  // size bytes from skip of complete blocks followed by the rest of data, or less at the end of file
+  static td::BufferSlice concat_blocks(const std::vector<td::BufferSlice> &blocks, td::BufferSlice rest, td::uint64 skip,
+                                       size_t size) {
+    auto available = blocks.size() * block_size() + rest.size();
+    if (available <= skip) {
+      return td::BufferSlice();
+    }
+    td::BufferSlice res(static_cast<size_t>(std::min<td::uint64>(size, available - skip)));
+    auto dest = res.as_slice();
+    auto copy = [&](td::Slice part) {
+      if (skip >= part.size()) {
+        skip -= part.size();
+        return;
+      }
+      part.remove_prefix(static_cast<size_t>(skip));
+      skip = 0;
+      part.truncate(dest.size());
+      dest.copy_from(part);
+      dest.remove_prefix(part.size());
+    };
+    for (auto &block : blocks) {
+      copy(block.as_slice());
+    }
+    copy(rest.as_slice());
+    return res;
+  }
+
+  td::Result<td::BufferSlice> get_block(const td::FileFd &fd, td::uint64 block_id) {
+    auto &counters = ReadCacheCounters::get();
+    auto &cache = BlockCache::get();
+    size_t blocks_count;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (block_id != last_block_id_) {
+        if (block_id == last_block_id_ + 1) {
+          readahead_blocks_ = std::min(readahead_blocks_ * 2, max_readahead_blocks());
+        } else {
+          readahead_blocks_ = 1;
+        }
+        last_block_id_ = block_id;
+      }
+      blocks_count = readahead_blocks_;
+    }
+    auto generation = generation_.load(std::memory_order_acquire);
+    auto cached = cache.find(id_, block_id);
+    if (!cached.empty()) {
+      counters.hit.add(1);
+      return std::move(cached);
+    }
+    counters.miss.add(1);
+
+    td::BufferSlice data(blocks_count * block_size());
+    TRY_RESULT(size, fd.pread(data.as_slice(), block_id * block_size()));
+    data.truncate(size);
+    if (size > block_size()) {
+      counters.readahead.add(static_cast<td::int64>((size - 1) / block_size()));
+    }
+
+    // each block gets its own buffer, so that a cached block doesn't keep the whole readahead buffer alive
+    td::BufferSlice res;
+    for (size_t i = 0; i < blocks_count && i * block_size() < size; i++) {
+      td::BufferSlice block(data.as_slice().substr(i * block_size()).truncate(block_size()));
+      if (i == 0) {
+        res = block.clone();
+      }
+      if (block.size() == block_size()) {
+        cache.add(id_, block_id + i, std::move(block), generation_, generation);
+      }
+    }
+    return std::move(res);
+  }
+};
+
+// Dictionaries of compressed entries by offsets of their entries
+class Package::DictionaryCache {
+ public:
+  std::shared_ptr<const std::string> get(td::uint64 offset) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = dictionaries_.find(offset);
+    if (it == dictionaries_.end()) {
+      return nullptr;
+    }
+    return it->second;
+  }
+
+  void add(td::uint64 offset, std::shared_ptr<const std::string> dictionary) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    dictionaries_.emplace(offset, std::move(dictionary));
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    dictionaries_.clear();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<td::uint64, std::shared_ptr<const std::string>> dictionaries_;
+};
+
+Package::Package(td::FileFd fd)
+    : fd_(std::move(fd))
+    , cache_(std::make_unique<ReadCache>())
+    , append_offset_(fd_.get_size().move_as_ok())
+    , dictionary_offset_(unknown_dictionary())
+    , dictionaries_(std::make_unique<DictionaryCache>()) {
+  auto &default_compression = DefaultCompression::get();
+  std::lock_guard<std::mutex> guard(default_compression.mutex);
+  compression_ = default_compression.compression;
+}
+
+Package::Package(Package &&p) = default;
+
+void Package::set_default_compression(PackageCompression compression) {
+  auto &default_compression = DefaultCompression::get();
+  std::lock_guard<std::mutex> guard(default_compression.mutex);
+  default_compression.compression = std::make_shared<const PackageCompression>(std::move(compression));
+}
+
+void Package::set_compression(std::shared_ptr<const PackageCompression> compression) {
+  compression_ = std::move(compression);
+  dictionary_offset_ = unknown_dictionary();
+}
+
+bool Package::compresses() const {
+  return compression_ && compression_->level != 0;
+}
+
+td::Result<bool> Package::has_compressed_entries() const {
+  bool res = false;
+  TRY_STATUS(for_each_entry_header(fd_, [&](td::uint64 offset, const EntryHeader &header) {
+    res = header.magic != entry_header_magic();
+    return !res;
+  }));
+  return res;
+}
+
+td::Result<td::uint64> Package::find_dictionary(td::Slice dictionary) const {
+  std::vector<td::uint64> offsets;
+  TRY_STATUS(for_each_entry_header(fd_, [&](td::uint64 offset, const EntryHeader &header) {
+    if (header.magic == dictionary_entry_header_magic() && header.filename_size == 0 &&
+        header.data_size == dictionary.size()) {
+      offsets.push_back(offset);
+    }
+    return true;
+  }));
+  for (auto offset : offsets) {
+    TRY_RESULT(stored, get_dictionary(offset));
+    if (*stored == dictionary) {
+      return offset;
+    }
+  }
+  return no_dictionary();
+}
+
+std::string Package::train_dictionary(const std::vector<td::Slice> &samples, size_t max_size) {
+  // A segment is scored by the number of samples containing each of its 8-byte substrings. Segments are chosen
+  // greedily and substrings of a chosen segment do not count any more, so the dictionary has little repetitions
+  constexpr size_t kmer_size = 8;
+  constexpr size_t segment_size = 64;
+  auto get_kmer = [](const char *ptr) {
+    td::uint64 res;
+    std::memcpy(&res, ptr, kmer_size);
+    return res;
+  };
+
+  std::unordered_map<td::uint64, td::uint32> frequency;
+  for (auto &sample : samples) {
+    std::unordered_set<td::uint64> seen;
+    for (size_t i = 0; i + kmer_size <= sample.size(); i++) {
+      auto kmer = get_kmer(sample.data() + i);
+      if (seen.insert(kmer).second) {
+        frequency[kmer]++;
+      }
+    }
+  }
+
+  std::vector<td::uint64> kmers;
+  auto get_kmers = [&](td::Slice segment) {
+    kmers.clear();
+    for (size_t i = 0; i + kmer_size <= segment.size(); i++) {
+      kmers.push_back(get_kmer(segment.data() + i));
+    }
+    std::sort(kmers.begin(), kmers.end());
+    kmers.erase(std::unique(kmers.begin(), kmers.end()), kmers.end());
+  };
+  auto get_score = [&](td::Slice segment) {
+    get_kmers(segment);
+    td::uint64 score = 0;
+    for (auto kmer : kmers) {
+      auto it = frequency.find(kmer);
+      // substrings of a single sample are useless
+      if (it != frequency.end() && it->second > 1) {
+        score += it->second;
+      }
+    }
+    return score;
+  };
+
+  struct Segment {
+    td::uint64 score;
+    td::Slice data;
+
+    bool operator<(const Segment &other) const {
+      return score < other.score;
+    }
+  };
+  std::priority_queue<Segment> queue;
+  for (auto &sample : samples) {
+    for (size_t i = 0; i + kmer_size <= sample.size(); i += segment_size / 2) {
+      auto data = sample.substr(i).truncate(segment_size);
+      auto score = get_score(data);
+      if (score != 0) {
+        queue.push(Segment{score, data});
+      }
+    }
+  }
+
+  // scores only decrease, so a segment is chosen once its updated score is still the best one
+  std::vector<td::Slice> chosen;
+  size_t size = 0;
+  while (!queue.empty() && size < max_size) {
+    auto segment = queue.top();
+    queue.pop();
+    segment.score = get_score(segment.data);
+    if (segment.score == 0) {
+      continue;
+    }
+    if (!queue.empty() && segment.score < queue.top().score) {
+      queue.push(segment);
+      continue;
+    }
+    chosen.push_back(segment.data);
+    size += segment.data.size();
+    for (auto kmer : kmers) {
+      frequency.erase(kmer);
+    }
+  }
+
+  // the best segments are placed at the end, because zlib encodes closer matches with fewer bits
+  std::string res;
+  for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+    res += it->str();
+  }
+  if (res.size() > max_size) {
+    res = res.substr(res.size() - max_size);
+  }
+  return res;
 }
 
 td::Status Package::truncate(td::uint64 size) {
-  TRY_STATUS(fd_.seek(size + header_size()));
-  return fd_.truncate_to_current_position(size + header_size());
+  if (dictionary_offset_ != no_dictionary() && dictionary_offset_ >= size) {
+    dictionary_offset_ = unknown_dictionary();
+  }
+  auto S = fd_.seek(size + header_size());
+  if (S.is_ok()) {
+    S = fd_.truncate_to_current_position(size + header_size());
+  }
+  // after the file is truncated, so that reads in flight can't cache the old data again
+  cache_->clear();
+  dictionaries_->clear();
+  TRY_STATUS(std::move(S));
+  append_offset_ = size + header_size();
+  return td::Status::OK();
 }
 
 td::uint64 Package::append(std::string filename, td::Slice data, bool sync) {
   CHECK(data.size() <= max_data_size());
   CHECK(filename.size() <= max_filename_size());
-  auto size = fd_.get_size().move_as_ok();
+  td::BufferSlice storage;
+  auto magic = compress(data, storage);
+  auto offset = write_entry(magic, filename, data);
+  if (sync) {
+    fd_.sync().ensure();
+  }
+  return offset;
+}
+
+td::uint64 Package::write_entry(td::uint16 magic, td::Slice filename, td::Slice data) {
+  auto size = append_offset_;
   auto orig_size = size;
   td::uint32 header[2];
-  header[0] = entry_header_magic() + (td::narrow_cast<td::uint32>(filename.size()) << 16);
+  header[0] = magic + (td::narrow_cast<td::uint32>(filename.size()) << 16);
   header[1] = td::narrow_cast<td::uint32>(data.size());
   CHECK(fd_.pwrite(td::Slice(reinterpret_cast<const td::uint8*>(header), 8), size).move_as_ok() == 8);
   size += 8;
@@ -72,12 +680,77 @@ td::uint64 Package::append(std::string filename, td::Slice data, bool sync) {
     size += x;
     data.remove_prefix(x);
   }
-  if (sync) {
-    fd_.sync().ensure();
-  }
+  append_offset_ = size;
   return orig_size - header_size();
 }
 
+td::uint16 Package::compress(td::Slice &data, td::BufferSlice &storage) {
+  if (!compression_ || compression_->level == 0 || data.size() < min_compressed_size()) {
+    return entry_header_magic();
+  }
+  auto &dictionary = compression_->dictionary;
+  auto compressed = td::deflate_with_dictionary(data, dictionary, compression_->level, max_compression_ratio());
+  if (compressed.empty()) {
+    return entry_header_magic();
+  }
+  td::uint64 dictionary_offset = no_dictionary();
+  if (!dictionary.empty()) {
+    if (dictionary_offset_ == unknown_dictionary()) {
+      auto r_offset = find_dictionary(dictionary);
+      LOG_IF(WARNING, r_offset.is_error()) << "failed to find the dictionary in the package: " << r_offset.error();
+      dictionary_offset_ = r_offset.is_ok() ? r_offset.ok() : no_dictionary();
+    }
+    if (dictionary_offset_ == no_dictionary()) {
+      dictionary_offset_ = write_entry(dictionary_entry_header_magic(), td::Slice(), dictionary);
+    }
+    dictionary_offset = dictionary_offset_;
+  }
+
+  auto size = td::narrow_cast<td::uint32>(data.size());
+  storage = td::BufferSlice{compressed_prefix_size() + compressed.size()};
+  auto dest = storage.as_slice();
+  std::memcpy(dest.data(), &size, 4);
+  std::memcpy(dest.data() + 4, &dictionary_offset, 8);
+  dest.substr(compressed_prefix_size()).copy_from(compressed.as_slice());
+  data = storage.as_slice();
+  return compressed_entry_header_magic();
+}
+
+void Package::append_async(std::string filename, td::Slice data,
+                           td::Promise<std::pair<td::uint64, td::uint64>> promise) {
+  CHECK(data.size() <= max_data_size());
+  CHECK(filename.size() <= max_filename_size());
+  td::BufferSlice storage;
+  auto magic = compress(data, storage);
+  td::uint32 header[2];
+  header[0] = magic + (td::narrow_cast<td::uint32>(filename.size()) << 16);
+  header[1] = td::narrow_cast<td::uint32>(data.size());
+
+  // the whole entry is written with one request
+  td::BufferSlice entry{8 + filename.size() + data.size()};
+  auto dest = entry.as_slice();
+  dest.copy_from(td::Slice(reinterpret_cast<const td::uint8*>(header), 8));
+  dest.remove_prefix(8);
+  dest.copy_from(filename);
+  dest.remove_prefix(filename.size());
+  dest.copy_from(data);
+
+  auto offset = append_offset_;
+  auto entry_size = entry.size();
+  append_offset_ += entry_size;
+  // entries appended later may be written first, so a block of this entry may already be cached with a hole
+  td::actor::file_pwrite(fd_, std::move(entry), offset,
+                         [this, offset, entry_size, size = append_offset_ - header_size(),
+                          promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+                           if (R.is_error()) {
+                             promise.set_error(R.move_as_error());
+                             return;
+                           }
+                           cache_->invalidate(offset, entry_size);
+                           promise.set_value(std::pair<td::uint64, td::uint64>{offset - header_size(), size});
+                         });
+}
+
 void Package::sync() {
   fd_.sync().ensure();
 }
@@ -87,49 +760,168 @@ td::uint64 Package::size() const {
 }
 
 td::Result<std::pair<std::string, td::BufferSlice>> Package::read(td::uint64 offset) const {
+  TRY_RESULT(entry, read_entry(offset));
+  TRY_RESULT(data, decode(std::get<0>(entry), std::move(std::get<2>(entry))));
+  return std::pair<std::string, td::BufferSlice>{std::move(std::get<1>(entry)), std::move(data)};
+}
+
+td::Result<std::tuple<td::uint16, std::string, td::BufferSlice>> Package::read_entry(td::uint64 offset) const {
   offset += header_size();
 
-  td::uint32 header[2];
-  TRY_RESULT(s1, fd_.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), 8), offset));
-  if (s1 != 8) {
-    return td::Status::Error(ErrorCode::notready, "too short read");
-  }
-  if ((header[0] & 0xffff) != entry_header_magic()) {
-    return td::Status::Error(ErrorCode::notready,
-                             PSTRING() << "bad entry magic " << (header[0] & 0xffff) << " offset=" << offset);
-  }
+  td::uint8 header_data[8];
+  TRY_RESULT(s1, pread(td::MutableSlice(header_data, 8), offset));
+  TRY_RESULT(header, parse_entry_header(td::Slice(header_data, s1), offset));
   offset += 8;
-  auto fname_size = header[0] >> 16;
-  auto data_size = header[1];
+  auto fname_size = header.filename_size;
+  auto data_size = header.data_size;
 
   std::string fname(fname_size, '\0');
-  TRY_RESULT(s2, fd_.pread(fname, offset));
+  TRY_RESULT(s2, pread(fname, offset));
   if (s2 != fname_size) {
     return td::Status::Error(ErrorCode::notready, "too short read (filename)");
   }
   offset += fname_size;
 
   td::BufferSlice data{data_size};
-  TRY_RESULT(s3, fd_.pread(data.as_slice(), offset));
+  TRY_RESULT(s3, pread(data.as_slice(), offset));
   if (s3 != data_size) {
     return td::Status::Error(ErrorCode::notready, "too short read (data)");
   }
-  return std::pair<std::string, td::BufferSlice>{std::move(fname), std::move(data)};
+  return std::make_tuple(header.magic, std::move(fname), std::move(data));
 }
 
-td::Result<td::uint64> Package::advance(td::uint64 offset) {
+td::Result<td::BufferSlice> Package::decode(td::uint16 magic, td::BufferSlice data) const {
+  if (magic == entry_header_magic()) {
+    return std::move(data);
+  }
+  if (magic != compressed_entry_header_magic()) {
+    return td::Status::Error(ErrorCode::notready, "not a file entry");
+  }
+  if (data.size() < compressed_prefix_size()) {
+    return td::Status::Error(ErrorCode::notready, "too short compressed entry");
+  }
+  td::uint32 size;
+  td::uint64 dictionary_offset;
+  std::memcpy(&size, data.data(), 4);
+  std::memcpy(&dictionary_offset, data.data() + 4, 8);
+  std::shared_ptr<const std::string> dictionary;
+  if (dictionary_offset != no_dictionary()) {
+    TRY_RESULT_ASSIGN(dictionary, get_dictionary(dictionary_offset));
+  }
+  auto r_data = td::inflate_with_dictionary(data.as_slice().substr(compressed_prefix_size()),
+                                            dictionary ? td::Slice(*dictionary) : td::Slice(), size);
+  if (r_data.is_error()) {
+    return td::Status::Error(ErrorCode::notready, PSTRING() << "failed to decompress entry: " << r_data.error());
+  }
+  return r_data.move_as_ok();
+}
+
+td::Result<std::shared_ptr<const std::string>> Package::get_dictionary(td::uint64 offset) const {
+  auto dictionary = dictionaries_->get(offset);
+  if (dictionary) {
+    return std::move(dictionary);
+  }
+  TRY_RESULT(entry, read_entry(offset));
+  if (std::get<0>(entry) != dictionary_entry_header_magic()) {
+    return td::Status::Error(ErrorCode::notready, PSTRING() << "no dictionary at offset " << offset);
+  }
+  dictionary = std::make_shared<const std::string>(std::get<2>(entry).as_slice().str());
+  dictionaries_->add(offset, dictionary);
+  return std::move(dictionary);
+}
+
+void Package::read_async(td::uint64 offset, td::Promise<std::pair<std::string, td::BufferSlice>> promise) const {
   offset += header_size();
+  cache_->pread_async(
+      fd_, first_read_size(), offset,
+      [this, offset, promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+        TRY_RESULT_PROMISE(promise, head, std::move(R));
+        TRY_RESULT_PROMISE(promise, header, parse_entry_header(head.as_slice(), offset));
+        if (head.size() < header.size() && head.size() < first_read_size()) {
+          promise.set_error(td::Status::Error(ErrorCode::notready, "too short read (data)"));
+          return;
+        }
+        head.confirm_read(8);
+        if (head.size() >= header.size() - 8) {
+          std::string fname = head.as_slice().truncate(header.filename_size).str();
+          head.confirm_read(header.filename_size);
+          head.truncate(header.data_size);
+          decode_async(header.magic, std::move(fname), std::move(head), std::move(promise));
+          return;
+        }
 
-  td::uint32 header[2];
-  TRY_RESULT(s1, fd_.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), 8), offset));
-  if (s1 != 8) {
-    return td::Status::Error(ErrorCode::notready, "too short read");
+        // a large entry, its data is read again as a whole to avoid copying
+        std::string fname;
+        auto skip = header.filename_size;
+        if (head.size() >= header.filename_size) {
+          fname = head.as_slice().truncate(header.filename_size).str();
+          skip = 0;
+        }
+        auto size = static_cast<size_t>(skip + header.data_size);
+        cache_->pread_async(
+            fd_, size, offset + 8 + header.filename_size - skip,
+            [this, magic = header.magic, fname = std::move(fname), skip, size,
+             promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+              TRY_RESULT_PROMISE(promise, data, std::move(R));
+              if (data.size() != size) {
+                promise.set_error(td::Status::Error(ErrorCode::notready, "too short read (data)"));
+                return;
+              }
+              if (skip != 0) {
+                fname = data.as_slice().truncate(skip).str();
+                data.confirm_read(skip);
+              }
+              decode_async(magic, std::move(fname), std::move(data), std::move(promise));
+            });
+      });
+}
+
+void Package::decode_async(td::uint16 magic, std::string filename, td::BufferSlice data,
+                           td::Promise<std::pair<std::string, td::BufferSlice>> promise) const {
+  if (magic == entry_header_magic()) {
+    promise.set_value(std::pair<std::string, td::BufferSlice>{std::move(filename), std::move(data)});
+    return;
+  }
+  // inflate and the read of the dictionary don't block the calling actor
+  td::actor::run_blocking(
+      [this, magic, data = std::move(data)]() mutable { return decode(magic, std::move(data)); },
+      [filename = std::move(filename), promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+        TRY_RESULT_PROMISE(promise, data, std::move(R));
+        promise.set_value(std::pair<std::string, td::BufferSlice>{std::move(filename), std::move(data)});
+      });
+}
+
+td::Result<td::BufferSlice> Package::read_raw(td::uint64 offset, td::uint64 limit) const {
+  TRY_RESULT(file_size, fd_.get_size());
+  if (offset > static_cast<td::uint64>(file_size)) {
+    return td::Status::Error(ErrorCode::notready, "invalid offset");
   }
-  if ((header[0] & 0xffff) != entry_header_magic()) {
-    return td::Status::Error(ErrorCode::notready, "bad entry magic");
+  auto size = static_cast<size_t>(std::min(limit, static_cast<td::uint64>(file_size) - offset));
+  td::BufferSlice data{size};
+  TRY_RESULT(s, pread(data.as_slice(), offset));
+  if (s != size) {
+    return td::Status::Error(ErrorCode::notready, "too short read");
   }
+  return std::move(data);
+}
 
-  offset += 8 + (header[0] >> 16) + header[1];
+td::Result<td::uint64> Package::raw_size() const {
+  TRY_RESULT(file_size, fd_.get_size());
+  return static_cast<td::uint64>(file_size);
+}
+
+td::Result<size_t> Package::pread(td::MutableSlice dest, td::uint64 offset) const {
+  return cache_->pread(fd_, dest, offset);
+}
+
+td::Result<td::uint64> Package::advance(td::uint64 offset) {
+  offset += header_size();
+
+  td::uint8 header_data[8];
+  TRY_RESULT(s1, pread(td::MutableSlice(header_data, 8), offset));
+  TRY_RESULT(header, parse_entry_header(td::Slice(header_data, s1), offset));
+
+  offset += header.size();
   if (offset > static_cast<td::uint64>(fd_.get_size().move_as_ok())) {
     return td::Status::Error(ErrorCode::notready, "truncated read");
   }
@@ -181,14 +973,21 @@ void Package::iterate(std::function<bool(std::string, td::BufferSlice, td::uint6
   }
   size -= header_size();
   while (p != size) {
-    auto R = read(p);
+    auto R = read_entry(p);
     if (R.is_error()) {
       LOG(ERROR) << "broken archive: " << R.move_as_error();
       return;
     }
     auto q = R.move_as_ok();
-    if (!func(q.first, q.second.clone(), p)) {
-      break;
+    if (std::get<0>(q) != dictionary_entry_header_magic()) {
+      auto r_data = decode(std::get<0>(q), std::move(std::get<2>(q)));
+      if (r_data.is_error()) {
+        LOG(ERROR) << "broken archive: " << r_data.move_as_error();
+        return;
+      }
+      if (!func(std::move(std::get<1>(q)), r_data.move_as_ok(), p)) {
+        break;
+      }
     }
 
     p = advance(p).move_as_ok();
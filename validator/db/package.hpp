@@ -22,22 +22,45 @@
 #include "td/utils/port/FileFd.h"
 #include "td/utils/buffer.h"
 
+#include <memory>
+#include <tuple>
+#include <vector>
+
 namespace ton {
 
+// Compression of appended entries. Each entry is compressed separately with zlib, so entries are still read by
+// offset in O(1). The dictionary is stored in the package, so reading does not depend on this setting
+struct PackageCompression {
+  // zlib compression level, 0 disables compression
+  td::int32 level{0};
+  // preset dictionary, usually trained on block BoCs with Package::train_dictionary; only the last 32KB are used
+  std::string dictionary;
+};
+
 class Package {
  public:
   static td::Result<Package> open(std::string path, bool read_only = false, bool create = false);
 
   Package(td::FileFd fd);
-  Package(Package &&p) = default;
+  Package(Package &&p);
   ~Package();
 
   td::Status truncate(td::uint64 size);
 
   td::uint64 append(std::string filename, td::Slice data, bool sync = true);
+  // Same as append without sync, but the entry is written with file io of the scheduler (io_uring when available).
+  // Must be called from an actor, the package must stay alive till the promise is set. Space for the entry is reserved
+  // immediately, the promise gets the offset of the entry and the package size after it
+  void append_async(std::string filename, td::Slice data, td::Promise<std::pair<td::uint64, td::uint64>> promise);
   void sync();
   td::uint64 size() const;
   td::Result<std::pair<std::string, td::BufferSlice>> read(td::uint64 offset) const;
+  // Same as read, but with file io of the scheduler; same requirements as append_async
+  void read_async(td::uint64 offset, td::Promise<std::pair<std::string, td::BufferSlice>> promise) const;
+  // reads up to limit bytes at raw file offset (including package header)
+  td::Result<td::BufferSlice> read_raw(td::uint64 offset, td::uint64 limit) const;
+  // size of the file including package header, the upper bound of offsets of read_raw
+  td::Result<td::uint64> raw_size() const;
 
   td::Result<td::uint64> advance(td::uint64 offset);
   void iterate(std::function<bool(std::string, td::BufferSlice, td::uint64)> func);
@@ -46,8 +69,42 @@ class Package {
     return fd_;
   }
 
+  // Compression of entries appended to packages opened afterwards, none by default
+  static void set_default_compression(PackageCompression compression);
+  void set_compression(std::shared_ptr<const PackageCompression> compression);
+  // New entries may be compressed
+  bool compresses() const;
+  // Scans headers of all entries, nodes of older versions can't read packages with compressed entries
+  td::Result<bool> has_compressed_entries() const;
+
+  // Selects segments of the samples which are shared by most of them, the most common ones are at the end
+  static std::string train_dictionary(const std::vector<td::Slice> &samples, size_t max_size = 1 << 15);
+
  private:
+  class ReadCache;
+  class DictionaryCache;
+
   td::FileFd fd_;
+  std::unique_ptr<ReadCache> cache_;
+  // raw file offset of the next entry, ahead of the file size while async appends are in flight
+  td::uint64 append_offset_;
+
+  std::shared_ptr<const PackageCompression> compression_;
+  // offset of the entry with the dictionary of compression_, which is written before the first compressed entry;
+  // after open it is looked up in the package
+  td::uint64 dictionary_offset_;
+  std::unique_ptr<DictionaryCache> dictionaries_;
+
+  td::Result<size_t> pread(td::MutableSlice dest, td::uint64 offset) const;
+  td::uint64 write_entry(td::uint16 magic, td::Slice filename, td::Slice data);
+  td::uint16 compress(td::Slice &data, td::BufferSlice &storage);
+  td::Result<std::tuple<td::uint16, std::string, td::BufferSlice>> read_entry(td::uint64 offset) const;
+  td::Result<td::BufferSlice> decode(td::uint16 magic, td::BufferSlice data) const;
+  td::Result<std::shared_ptr<const std::string>> get_dictionary(td::uint64 offset) const;
+  td::Result<td::uint64> find_dictionary(td::Slice dictionary) const;
+  // decodes compressed entries on a blocking thread, must be called from an actor
+  void decode_async(td::uint16 magic, std::string filename, td::BufferSlice data,
+                    td::Promise<std::pair<std::string, td::BufferSlice>> promise) const;
 };
 
 }  // namespace ton
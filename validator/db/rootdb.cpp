@@ -288,6 +288,12 @@ void RootDb::get_persistent_state_file_slice(BlockIdExt block_id, BlockIdExt mas
                           offset, max_size, std::move(promise));
 }
 
+void RootDb::get_persistent_state_file_size(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                            td::Promise<td::uint64> promise) {
+  td::actor::send_closure(archive_db_, &ArchiveManager::get_persistent_state_size, block_id, masterchain_block_id,
+                          std::move(promise));
+}
+
 void RootDb::check_persistent_state_file_exists(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                                 td::Promise<bool> promise) {
   td::actor::send_closure(archive_db_, &ArchiveManager::check_persistent_state, block_id, masterchain_block_id,
@@ -482,6 +488,10 @@ void RootDb::get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uin
                           std::move(promise));
 }
 
+void RootDb::get_archive_size(td::uint64 archive_id, td::Promise<td::uint64> promise) {
+  td::actor::send_closure(archive_db_, &ArchiveManager::get_archive_size, archive_id, std::move(promise));
+}
+
 void RootDb::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
   td::actor::send_closure(archive_db_, &ArchiveManager::set_async_mode, mode, std::move(promise));
 }
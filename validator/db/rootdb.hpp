@@ -73,6 +73,8 @@ class RootDb : public Db {
                                  td::Promise<td::BufferSlice> promise) override;
   void get_persistent_state_file_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
                                        td::int64 max_length, td::Promise<td::BufferSlice> promise) override;
+  void get_persistent_state_file_size(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                      td::Promise<td::uint64> promise) override;
   void check_persistent_state_file_exists(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                           td::Promise<bool> promise) override;
   void store_zero_state_file(BlockIdExt block_id, td::BufferSlice state, td::Promise<td::Unit> promise) override;
@@ -126,6 +128,7 @@ class RootDb : public Db {
   void get_archive_id(BlockSeqno masterchain_seqno, td::Promise<td::uint64> promise) override;
   void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
                          td::Promise<td::BufferSlice> promise) override;
+  void get_archive_size(td::uint64 archive_id, td::Promise<td::uint64> promise) override;
   void set_async_mode(bool mode, td::Promise<td::Unit> promise) override;
 
   void run_gc(UnixTime ts, UnixTime archive_ttl) override;
@@ -25,9 +25,7 @@ namespace validator {
 
 void StaticFilesDb::load_file(FileHash file_hash, td::Promise<td::BufferSlice> promise) {
   auto path = path_ + "/" + file_hash.to_hex();
-  td::actor::create_actor<db::ReadFile>("read file", path, 0, -1, db::ReadFile::Flags::f_disable_log,
-                                        std::move(promise))
-      .release();
+  db::read_file(path, 0, -1, db::ReadFileFlags::f_disable_log, std::move(promise));
 }
 
 }  // namespace validator
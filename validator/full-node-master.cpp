@@ -394,6 +394,34 @@ void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNo
                           query.offset_, query.max_size_, std::move(promise));
 }
 
+void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_getPersistentStateSize &query,
+                                       td::Promise<td::BufferSlice> promise) {
+  auto P = td::PromiseCreator::lambda([promise = std::move(promise)](td::Result<td::uint64> R) mutable {
+    if (R.is_error()) {
+      promise.set_value(create_serialize_tl_object<ton_api::tonNode_persistentStateSizeNotFound>());
+    } else {
+      promise.set_value(create_serialize_tl_object<ton_api::tonNode_persistentStateSize>(R.move_as_ok()));
+    }
+  });
+  auto block_id = create_block_id(query.block_);
+  auto masterchain_block_id = create_block_id(query.masterchain_block_);
+  td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_persistent_state_size, block_id,
+                          masterchain_block_id, std::move(P));
+}
+
+void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_getArchiveSize &query,
+                                       td::Promise<td::BufferSlice> promise) {
+  auto P = td::PromiseCreator::lambda([promise = std::move(promise)](td::Result<td::uint64> R) mutable {
+    if (R.is_error()) {
+      promise.set_value(create_serialize_tl_object<ton_api::tonNode_archiveSizeNotFound>());
+    } else {
+      promise.set_value(create_serialize_tl_object<ton_api::tonNode_archiveSize>(R.move_as_ok()));
+    }
+  });
+  td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_archive_size, query.archive_id_,
+                          std::move(P));
+}
+
 void FullNodeMasterImpl::process_query(adnl::AdnlNodeIdShort src, ton_api::tonNode_slave_sendExtMessage &query,
                                        td::Promise<td::BufferSlice> promise) {
   td::actor::send_closure(
@@ -57,12 +57,16 @@ static inline bool dbg(int c) {
 Collator::Collator(ShardIdFull shard, bool is_hardfork, UnixTime min_ts, BlockIdExt min_masterchain_block_id,
                    std::vector<BlockIdExt> prev, td::Ref<ValidatorSet> validator_set, Ed25519_PublicKey collator_id,
                    td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
-                   td::Promise<BlockCandidate> promise)
+                   td::Promise<BlockCandidate> promise, std::vector<Ref<ShardState>> prev_states,
+                   std::vector<Ref<BlockData>> prev_block_data)
     : shard_(shard)
     , is_hardfork_(is_hardfork)
+    , speculative_(!prev_states.empty())
     , min_ts(min_ts)
     , min_mc_block_id{min_masterchain_block_id}
     , prev_blocks(std::move(prev))
+    , prev_states(std::move(prev_states))
+    , prev_block_data(std::move(prev_block_data))
     , created_by_(collator_id)
     , validator_set_(std::move(validator_set))
     , manager(manager)
@@ -109,6 +113,10 @@ void Collator::start_up() {
     fatal_error(-666, "cannot have more than two previous blocks");
     return;
   }
+  if (speculative_ && (prev_states.size() != prev_blocks.size() || prev_block_data.size() != prev_blocks.size())) {
+    fatal_error(-666, "previous states and blocks must be given for all previous blocks or for none");
+    return;
+  }
   if (!prev_blocks.size()) {
     fatal_error(-666, "must have one or two previous blocks to generate a next block");
     return;
@@ -191,6 +199,14 @@ void Collator::start_up() {
   prev_states.resize(prev_blocks.size());
   prev_block_data.resize(prev_blocks.size());
   for (int i = 0; (unsigned)i < prev_blocks.size(); i++) {
+    if (speculative_) {
+      // previous block is a validated but not yet committed candidate, its state and data are given by the caller
+      LOG(DEBUG) << "using given state and data of previous block #" << i << " " << prev_blocks[i].to_str();
+      pending += 2;
+      td::actor::send_closure_later(get_self(), &Collator::after_get_shard_state, i, prev_states[i]);
+      td::actor::send_closure_later(get_self(), &Collator::after_get_block_data, i, prev_block_data[i]);
+      continue;
+    }
     // 3.1. load state
     LOG(DEBUG) << "sending wait_block_state() query #" << i << " for " << prev_blocks[i].to_str() << " to Manager";
     ++pending;
@@ -3969,7 +3985,8 @@ bool Collator::create_block_candidate() {
                                                                 std::move(saved));
                                 });
   // 5. communicate about bad and delayed external messages
-  if (!bad_ext_msgs_.empty() || !delay_ext_msgs_.empty()) {
+  // (not for a speculative block: its previous block may still be replaced, and the verdicts with it)
+  if (!speculative_ && (!bad_ext_msgs_.empty() || !delay_ext_msgs_.empty())) {
     LOG(INFO) << "sending complete_external_messages() to Manager";
     td::actor::send_closure_later(manager, &ValidatorManager::complete_external_messages, std::move(delay_ext_msgs_),
                                   std::move(bad_ext_msgs_));
@@ -187,7 +187,8 @@ void run_check_proof_link_query(BlockIdExt id, td::Ref<ProofLink> proof, td::act
 void run_validate_query(ShardIdFull shard, UnixTime min_ts, BlockIdExt min_masterchain_block_id,
                         std::vector<BlockIdExt> prev, BlockCandidate candidate, td::Ref<ValidatorSet> validator_set,
                         td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
-                        td::Promise<ValidateCandidateResult> promise, bool is_fake) {
+                        td::Promise<ValidateCandidateResult> promise, bool is_fake,
+                        td::Promise<td::Ref<ShardState>> new_state_promise) {
   BlockSeqno seqno = 0;
   for (auto& p : prev) {
     if (p.seqno() > seqno) {
@@ -197,7 +198,7 @@ void run_validate_query(ShardIdFull shard, UnixTime min_ts, BlockIdExt min_maste
   td::actor::create_actor<ValidateQuery>(
       PSTRING() << (is_fake ? "fakevalidate" : "validateblock") << shard.to_str() << ":" << (seqno + 1), shard, min_ts,
       min_masterchain_block_id, std::move(prev), std::move(candidate), std::move(validator_set), std::move(manager),
-      timeout, std::move(promise), is_fake)
+      timeout, std::move(promise), is_fake, std::move(new_state_promise))
       .release();
 }
 
@@ -217,6 +218,24 @@ void run_collate_query(ShardIdFull shard, td::uint32 min_ts, const BlockIdExt& m
       .release();
 }
 
+void run_collate_query(ShardIdFull shard, td::uint32 min_ts, const BlockIdExt& min_masterchain_block_id,
+                       std::vector<BlockIdExt> prev, std::vector<td::Ref<ShardState>> prev_states,
+                       std::vector<td::Ref<BlockData>> prev_block_data, Ed25519_PublicKey collator_id,
+                       td::Ref<ValidatorSet> validator_set, td::actor::ActorId<ValidatorManager> manager,
+                       td::Timestamp timeout, td::Promise<BlockCandidate> promise) {
+  BlockSeqno seqno = 0;
+  for (auto& p : prev) {
+    if (p.seqno() > seqno) {
+      seqno = p.seqno();
+    }
+  }
+  td::actor::create_actor<Collator>(PSTRING() << "precollate" << shard.to_str() << ":" << (seqno + 1), shard, false,
+                                    min_ts, min_masterchain_block_id, std::move(prev), std::move(validator_set),
+                                    collator_id, std::move(manager), timeout, std::move(promise),
+                                    std::move(prev_states), std::move(prev_block_data))
+      .release();
+}
+
 void run_collate_hardfork(ShardIdFull shard, const BlockIdExt& min_masterchain_block_id, std::vector<BlockIdExt> prev,
                           td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
                           td::Promise<BlockCandidate> promise) {
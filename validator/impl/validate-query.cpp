@@ -51,7 +51,8 @@ std::string ErrorCtx::as_string() const {
 ValidateQuery::ValidateQuery(ShardIdFull shard, UnixTime min_ts, BlockIdExt min_masterchain_block_id,
                              std::vector<BlockIdExt> prev, BlockCandidate candidate, Ref<ValidatorSet> validator_set,
                              td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
-                             td::Promise<ValidateCandidateResult> promise, bool is_fake)
+                             td::Promise<ValidateCandidateResult> promise, bool is_fake,
+                             td::Promise<Ref<ShardState>> new_state_promise)
     : shard_(shard)
     , id_(candidate.id)
     , min_ts(min_ts)
@@ -62,6 +63,7 @@ ValidateQuery::ValidateQuery(ShardIdFull shard, UnixTime min_ts, BlockIdExt min_
     , manager(std::move(manager))
     , timeout(timeout)
     , main_promise(std::move(promise))
+    , new_state_promise_(std::move(new_state_promise))
     , is_fake_(is_fake)
     , shard_pfx_(shard_.shard)
     , shard_pfx_len_(ton::shard_prefix_length(shard_)) {
@@ -146,6 +148,14 @@ void ValidateQuery::finish_query() {
   if (main_promise) {
     main_promise.set_result(now_);
   }
+  if (new_state_promise_) {
+    auto R = ShardStateQ::fetch(id_, {}, state_root_);
+    if (R.is_ok()) {
+      new_state_promise_.set_value(Ref<ShardState>{R.move_as_ok()});
+    } else {
+      new_state_promise_.set_error(R.move_as_error());
+    }
+  }
   stop();
 }
 
@@ -118,7 +118,8 @@ class ValidateQuery : public td::actor::Actor {
   ValidateQuery(ShardIdFull shard, UnixTime min_ts, BlockIdExt min_masterchain_block_id, std::vector<BlockIdExt> prev,
                 BlockCandidate candidate, td::Ref<ValidatorSet> validator_set,
                 td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
-                td::Promise<ValidateCandidateResult> promise, bool is_fake = false);
+                td::Promise<ValidateCandidateResult> promise, bool is_fake = false,
+                td::Promise<Ref<ShardState>> new_state_promise = {});
 
  private:
   int verbosity{3 * 1};
@@ -134,6 +135,7 @@ class ValidateQuery : public td::actor::Actor {
   td::actor::ActorId<ValidatorManager> manager;
   td::Timestamp timeout;
   td::Promise<ValidateCandidateResult> main_promise;
+  td::Promise<Ref<ShardState>> new_state_promise_;
   bool after_merge_{false};
   bool after_split_{false};
   bool before_split_{false};
@@ -115,6 +115,10 @@ class ValidatorManagerImpl : public ValidatorManager {
                                   td::int64 max_length, td::Promise<td::BufferSlice> promise) override {
     UNREACHABLE();
   }
+  void get_persistent_state_size(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                 td::Promise<td::uint64> promise) override {
+    UNREACHABLE();
+  }
   void get_block_proof(BlockHandle handle, td::Promise<td::BufferSlice> promise) override;
   void get_block_proof_link(BlockHandle block_id, td::Promise<td::BufferSlice> promise) override {
     UNREACHABLE();
@@ -270,6 +274,9 @@ class ValidatorManagerImpl : public ValidatorManager {
                          td::Promise<td::BufferSlice> promise) override {
     UNREACHABLE();
   }
+  void get_archive_size(td::uint64 archive_id, td::Promise<td::uint64> promise) override {
+    UNREACHABLE();
+  }
 
   void add_shard_block_description(td::Ref<ShardTopBlockDescription> desc);
 
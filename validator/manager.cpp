@@ -300,6 +300,12 @@ void ValidatorManagerImpl::get_persistent_state_slice(BlockIdExt block_id, Block
                           std::move(promise));
 }
 
+void ValidatorManagerImpl::get_persistent_state_size(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                                     td::Promise<td::uint64> promise) {
+  td::actor::send_closure(db_, &Db::get_persistent_state_file_size, block_id, masterchain_block_id,
+                          std::move(promise));
+}
+
 void ValidatorManagerImpl::get_block_proof(BlockHandle handle, td::Promise<td::BufferSlice> promise) {
   auto P = td::PromiseCreator::lambda([promise = std::move(promise)](td::Result<td::Ref<Proof>> R) mutable {
     if (R.is_error()) {
@@ -2317,6 +2323,10 @@ void ValidatorManagerImpl::get_archive_slice(td::uint64 archive_id, td::uint64 o
   td::actor::send_closure(db_, &Db::get_archive_slice, archive_id, offset, limit, std::move(promise));
 }
 
+void ValidatorManagerImpl::get_archive_size(td::uint64 archive_id, td::Promise<td::uint64> promise) {
+  td::actor::send_closure(db_, &Db::get_archive_size, archive_id, std::move(promise));
+}
+
 bool ValidatorManagerImpl::is_validator() {
   return temp_keys_.size() > 0 || permanent_keys_.size() > 0;
 }
@@ -2410,7 +2420,13 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
 
   merger.make_promise("").set_value(std::move(vec));
 
+  for (auto &v : validator_groups_) {
+    td::actor::send_closure(v.second, &ValidatorGroup::prepare_stats,
+                            merger.make_promise(PSTRING() << "validatorsession." << v.first.to_hex() << "."));
+  }
+
   td::actor::send_closure(db_, &Db::prepare_stats, merger.make_promise("db."));
+  td::actor::send_closure(overlays_, &overlay::Overlays::get_stats, merger.make_promise(""));
 }
 
 void ValidatorManagerImpl::truncate(BlockSeqno seqno, ConstBlockHandle handle, td::Promise<td::Unit> promise) {
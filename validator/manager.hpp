@@ -318,6 +318,8 @@ class ValidatorManagerImpl : public ValidatorManager {
                             td::Promise<td::BufferSlice> promise) override;
   void get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
                                   td::int64 max_length, td::Promise<td::BufferSlice> promise) override;
+  void get_persistent_state_size(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                 td::Promise<td::uint64> promise) override;
   void get_block_proof(BlockHandle handle, td::Promise<td::BufferSlice> promise) override;
   void get_block_proof_link(BlockHandle block_id, td::Promise<td::BufferSlice> promise) override;
   void get_key_block_proof(BlockIdExt block_id, td::Promise<td::BufferSlice> promise) override;
@@ -449,6 +451,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   void get_archive_id(BlockSeqno masterchain_seqno, td::Promise<td::uint64> promise) override;
   void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
                          td::Promise<td::BufferSlice> promise) override;
+  void get_archive_size(td::uint64 archive_id, td::Promise<td::uint64> promise) override;
 
   void check_is_hardfork(BlockIdExt block_id, td::Promise<bool> promise) override {
     CHECK(block_id.is_masterchain());
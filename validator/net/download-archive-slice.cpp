@@ -19,6 +19,7 @@
 #include "download-archive-slice.hpp"
 #include "td/utils/port/path.h"
 #include "td/utils/overloaded.h"
+#include "full-node.h"
 
 namespace ton {
 
@@ -144,7 +145,24 @@ void DownloadArchiveSlice::got_archive_info(td::BufferSlice data) {
     return;
   }
 
-  get_archive_slice();
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::BufferSlice> R) {
+    if (R.is_error()) {
+      // nodes of older versions don't answer getArchiveSize, download slices one by one
+      td::actor::send_closure(SelfId, &DownloadArchiveSlice::get_archive_slice);
+    } else {
+      td::actor::send_closure(SelfId, &DownloadArchiveSlice::got_archive_size, R.move_as_ok());
+    }
+  });
+
+  auto q = create_serialize_tl_object<ton_api::tonNode_getArchiveSize>(archive_id_);
+  if (client_.empty()) {
+    td::actor::send_closure(overlays_, &overlay::Overlays::send_query, download_from_, local_id_, overlay_id_,
+                            "get_archive_size", std::move(P), td::Timestamp::in(3.0), std::move(q));
+  } else {
+    td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "get_archive_size",
+                            create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(q)),
+                            td::Timestamp::in(1.0), std::move(P));
+  }
 }
 
 void DownloadArchiveSlice::get_archive_slice() {
@@ -155,16 +173,19 @@ void DownloadArchiveSlice::get_archive_slice() {
       td::actor::send_closure(SelfId, &DownloadArchiveSlice::got_archive_slice, R.move_as_ok());
     }
   });
+  send_slice_query(offset_, slice_size(), std::move(P));
+}
 
-  auto q = create_serialize_tl_object<ton_api::tonNode_getArchiveSlice>(archive_id_, offset_, slice_size());
+void DownloadArchiveSlice::send_slice_query(td::uint64 offset, td::uint32 size, td::Promise<td::BufferSlice> promise) {
+  auto q = create_serialize_tl_object<ton_api::tonNode_getArchiveSlice>(archive_id_, offset, size);
   if (client_.empty()) {
     td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, download_from_, local_id_, overlay_id_,
-                            "get_archive_slice", std::move(P), td::Timestamp::in(3.0), std::move(q),
-                            slice_size() + 1024, rldp_);
+                            "get_archive_slice", std::move(promise), td::Timestamp::in(3.0), std::move(q),
+                            size + 1024, rldp_);
   } else {
     td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "get_archive_slice",
                             create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(q)),
-                            td::Timestamp::in(1.0), std::move(P));
+                            td::Timestamp::in(1.0), std::move(promise));
   }
 }
 
@@ -188,6 +209,77 @@ void DownloadArchiveSlice::got_archive_slice(td::BufferSlice data) {
   }
 }
 
+void DownloadArchiveSlice::got_archive_size(td::BufferSlice data) {
+  auto F = fetch_tl_object<ton_api::tonNode_ArchiveSize>(std::move(data), true);
+  if (F.is_error()) {
+    abort_query(F.move_as_error_prefix("failed to parse ArchiveSize answer: "));
+    return;
+  }
+  td::uint64 size = 0;
+  bool found = false;
+  ton_api::downcast_call(*F.move_as_ok(), td::overloaded([&](ton_api::tonNode_archiveSizeNotFound &f) {},
+                                                         [&](ton_api::tonNode_archiveSize &f) {
+                                                           size = f.size_;
+                                                           found = true;
+                                                         }));
+  if (!found) {
+    abort_query(td::Status::Error(ErrorCode::notready, "remote db not found"));
+    return;
+  }
+  chunks_ = DownloadChunks{size, slice_size()};
+  if (chunks_.is_completed()) {
+    finish_query();
+    return;
+  }
+  request_slices();
+}
+
+void DownloadArchiveSlice::request_slices() {
+  size_t idx;
+  while (in_flight_ < max_slices_in_flight() && chunks_.take(idx)) {
+    in_flight_++;
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), idx](td::Result<td::BufferSlice> R) {
+      td::actor::send_closure(SelfId, &DownloadArchiveSlice::got_slice, idx, std::move(R));
+    });
+    send_slice_query(chunks_.chunk_offset(idx), chunks_.chunk_size(idx), std::move(P));
+  }
+}
+
+void DownloadArchiveSlice::got_slice(size_t idx, td::Result<td::BufferSlice> R) {
+  CHECK(in_flight_ > 0);
+  in_flight_--;
+  if (R.is_ok() && R.ok().size() != chunks_.chunk_size(idx)) {
+    R = td::Status::Error(ErrorCode::protoviolation, PSTRING() << "bad archive slice size " << R.ok().size());
+  }
+  if (R.is_error()) {
+    if (++failures_ >= max_slice_failures()) {
+      abort_query(R.move_as_error_prefix("failed to download archive slice: "));
+      return;
+    }
+    VLOG(FULL_NODE_DEBUG) << "failed to download archive slice, retrying: " << R.error();
+    chunks_.failed(idx);
+    request_slices();
+    return;
+  }
+
+  auto data = R.move_as_ok();
+  auto W = fd_.pwrite(data.as_slice(), chunks_.chunk_offset(idx));
+  if (W.is_error()) {
+    abort_query(W.move_as_error_prefix("failed to write temp file: "));
+    return;
+  }
+  if (W.move_as_ok() != data.size()) {
+    abort_query(td::Status::Error(ErrorCode::error, "short write to temp file"));
+    return;
+  }
+  chunks_.completed(idx);
+  if (chunks_.is_completed()) {
+    finish_query();
+    return;
+  }
+  request_slices();
+}
+
 }  // namespace fullnode
 
 }  // namespace validator
@@ -24,6 +24,7 @@
 #include "rldp/rldp.h"
 #include "adnl/adnl-ext-client.h"
 #include "td/utils/port/FileFd.h"
+#include "download-chunks.hpp"
 
 namespace ton {
 
@@ -50,9 +51,20 @@ class DownloadArchiveSlice : public td::actor::Actor {
   void get_archive_slice();
   void got_archive_slice(td::BufferSlice data);
 
+  void got_archive_size(td::BufferSlice data);
+  void request_slices();
+  void got_slice(size_t idx, td::Result<td::BufferSlice> R);
+
   static constexpr td::uint32 slice_size() {
     return 1 << 17;
   }
+  static constexpr td::uint32 max_slices_in_flight() {
+    return 4;
+  }
+  // packages of different nodes differ, so slices are requested from one node and a failed slice is requested again
+  static constexpr td::uint32 max_slice_failures() {
+    return 5;
+  }
 
  private:
   BlockSeqno masterchain_seqno_;
@@ -64,6 +76,10 @@ class DownloadArchiveSlice : public td::actor::Actor {
   td::uint64 offset_ = 0;
   td::uint64 archive_id_;
 
+  DownloadChunks chunks_;
+  td::uint32 in_flight_ = 0;
+  td::uint32 failures_ = 0;
+
   adnl::AdnlNodeIdShort download_from_ = adnl::AdnlNodeIdShort::zero();
 
   td::Timestamp timeout_;
@@ -73,6 +89,8 @@ class DownloadArchiveSlice : public td::actor::Actor {
   td::actor::ActorId<adnl::Adnl> adnl_;
   td::actor::ActorId<adnl::AdnlExtClient> client_;
   td::Promise<std::string> promise_;
+
+  void send_slice_query(td::uint64 offset, td::uint32 size, td::Promise<td::BufferSlice> promise);
 };
 
 }  // namespace fullnode
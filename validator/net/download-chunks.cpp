@@ -0,0 +1,85 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "download-chunks.hpp"
+#include "td/utils/check.h"
+
+#include <algorithm>
+
+namespace ton {
+
+namespace validator {
+
+namespace fullnode {
+
+DownloadChunks::DownloadChunks(td::uint64 size, td::uint32 chunk_size) : size_(size), chunk_size_(chunk_size) {
+  CHECK(chunk_size_ > 0);
+  state_.resize(static_cast<size_t>((size_ + chunk_size_ - 1) / chunk_size_), State::Missing);
+}
+
+td::uint32 DownloadChunks::chunk_size(size_t idx) const {
+  CHECK(idx < state_.size());
+  return static_cast<td::uint32>(std::min<td::uint64>(chunk_size_, size_ - chunk_offset(idx)));
+}
+
+bool DownloadChunks::take(size_t &idx) {
+  while (first_missing_ < state_.size() && state_[first_missing_] != State::Missing) {
+    first_missing_++;
+  }
+  if (first_missing_ == state_.size()) {
+    return false;
+  }
+  idx = first_missing_++;
+  state_[idx] = State::Requested;
+  return true;
+}
+
+void DownloadChunks::completed(size_t idx) {
+  CHECK(idx < state_.size());
+  if (state_[idx] != State::Completed) {
+    state_[idx] = State::Completed;
+    completed_++;
+  }
+}
+
+void DownloadChunks::failed(size_t idx) {
+  CHECK(idx < state_.size());
+  if (state_[idx] == State::Requested) {
+    state_[idx] = State::Missing;
+    first_missing_ = std::min(first_missing_, idx);
+  }
+}
+
+td::uint64 DownloadChunks::completed_size() const {
+  if (is_completed()) {
+    return size_;
+  }
+  td::uint64 res = 0;
+  for (size_t i = 0; i < state_.size(); i++) {
+    if (state_[i] == State::Completed) {
+      res += chunk_size(i);
+    }
+  }
+  return res;
+}
+
+}  // namespace fullnode
+
+}  // namespace validator
+
+}  // namespace ton
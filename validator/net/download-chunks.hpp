@@ -0,0 +1,74 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/int_types.h"
+
+#include <vector>
+
+namespace ton {
+
+namespace validator {
+
+namespace fullnode {
+
+// Completion bitmap of a download split into fixed-size chunks. Chunks are requested independently, possibly from
+// several peers at once; a failed chunk is requested again without downloading the completed ones
+class DownloadChunks {
+ public:
+  DownloadChunks() = default;
+  DownloadChunks(td::uint64 size, td::uint32 chunk_size);
+
+  td::uint64 size() const {
+    return size_;
+  }
+  size_t chunks_count() const {
+    return state_.size();
+  }
+  td::uint64 chunk_offset(size_t idx) const {
+    return static_cast<td::uint64>(idx) * chunk_size_;
+  }
+  // the last chunk may be shorter
+  td::uint32 chunk_size(size_t idx) const;
+
+  // finds a chunk which is neither completed nor requested and marks it requested
+  bool take(size_t &idx);
+  void completed(size_t idx);
+  void failed(size_t idx);
+
+  bool is_completed() const {
+    return completed_ == state_.size();
+  }
+  td::uint64 completed_size() const;
+
+ private:
+  enum class State : td::uint8 { Missing, Requested, Completed };
+  td::uint64 size_ = 0;
+  td::uint32 chunk_size_ = 0;
+  std::vector<State> state_;
+  // there are no missing chunks before first_missing_
+  size_t first_missing_ = 0;
+  size_t completed_ = 0;
+};
+
+}  // namespace fullnode
+
+}  // namespace validator
+
+}  // namespace ton
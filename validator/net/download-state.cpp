@@ -21,6 +21,7 @@
 #include "ton/ton-io.hpp"
 #include "td/utils/overloaded.h"
 #include "full-node.h"
+#include "td/utils/misc.h"
 
 namespace ton {
 
@@ -94,6 +95,7 @@ void DownloadState::got_block_handle(BlockHandle handle) {
   if (!download_from_.is_zero() || !client_.empty()) {
     got_node_to_download(download_from_);
   } else {
+    find_peers_ = true;
     auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<std::vector<adnl::AdnlNodeIdShort>> R) {
       if (R.is_error()) {
         td::actor::send_closure(SelfId, &DownloadState::abort_query, R.move_as_error());
@@ -157,7 +159,15 @@ void DownloadState::got_block_state_description(td::BufferSlice data) {
           },
           [&, self = this](ton_api::tonNode_preparedState &f) {
             if (masterchain_block_id_.is_valid()) {
-              got_block_state_part(td::BufferSlice{}, 0);
+              auto P = td::PromiseCreator::lambda([SelfId = actor_id(self)](td::Result<td::BufferSlice> R) {
+                if (R.is_error()) {
+                  // nodes of older versions don't answer getPersistentStateSize, download from one node part by part
+                  td::actor::send_closure(SelfId, &DownloadState::got_block_state_part, td::BufferSlice{}, 0);
+                } else {
+                  td::actor::send_closure(SelfId, &DownloadState::got_state_size, R.move_as_ok());
+                }
+              });
+              self->send_size_query(self->download_from_, std::move(P));
               return;
             }
             auto P = td::PromiseCreator::lambda([SelfId = actor_id(self)](td::Result<td::BufferSlice> R) {
@@ -200,17 +210,16 @@ void DownloadState::got_block_state_part(td::BufferSlice data, td::uint32 reques
     return;
   }
 
-  td::uint32 part_size = 1 << 18;
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), part_size](td::Result<td::BufferSlice> R) {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::BufferSlice> R) {
     if (R.is_error()) {
       td::actor::send_closure(SelfId, &DownloadState::abort_query, R.move_as_error());
     } else {
-      td::actor::send_closure(SelfId, &DownloadState::got_block_state_part, R.move_as_ok(), part_size);
+      td::actor::send_closure(SelfId, &DownloadState::got_block_state_part, R.move_as_ok(), part_size());
     }
   });
 
   td::BufferSlice query = create_serialize_tl_object<ton_api::tonNode_downloadPersistentStateSlice>(
-      create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), sum_, part_size);
+      create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), sum_, part_size());
   if (client_.empty()) {
     td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, download_from_, local_id_, overlay_id_,
                             "download state", std::move(P), td::Timestamp::in(10.0), std::move(query),
@@ -227,6 +236,182 @@ void DownloadState::got_block_state(td::BufferSlice data) {
   finish_query();
 }
 
+void DownloadState::got_state_size(td::BufferSlice data) {
+  auto F = fetch_tl_object<ton_api::tonNode_PersistentStateSize>(std::move(data), true);
+  if (F.is_error()) {
+    abort_query(F.move_as_error_prefix("failed to parse PersistentStateSize answer: "));
+    return;
+  }
+  td::uint64 size = 0;
+  bool found = false;
+  ton_api::downcast_call(*F.move_as_ok(),
+                         td::overloaded([&](ton_api::tonNode_persistentStateSizeNotFound &f) {},
+                                        [&](ton_api::tonNode_persistentStateSize &f) {
+                                          size = f.size_;
+                                          found = true;
+                                        }));
+  if (!found) {
+    abort_query(td::Status::Error(ErrorCode::notready, "state not found"));
+    return;
+  }
+  if (size > FullNode::max_state_size()) {
+    abort_query(td::Status::Error(ErrorCode::protoviolation, PSTRING() << "too big state: " << size));
+    return;
+  }
+
+  chunks_ = DownloadChunks{size, part_size()};
+  state_ = td::BufferSlice{td::narrow_cast<size_t>(size)};
+  peers_[download_from_].ready = true;
+  if (find_peers_) {
+    find_peers();
+  }
+  request_parts();
+}
+
+void DownloadState::find_peers() {
+  if (finding_peers_) {
+    return;
+  }
+  finding_peers_ = true;
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<std::vector<adnl::AdnlNodeIdShort>> R) {
+    if (R.is_error()) {
+      td::actor::send_closure(SelfId, &DownloadState::got_peers, std::vector<adnl::AdnlNodeIdShort>{});
+    } else {
+      td::actor::send_closure(SelfId, &DownloadState::got_peers, R.move_as_ok());
+    }
+  });
+  td::actor::send_closure(overlays_, &overlay::Overlays::get_overlay_random_peers, local_id_, overlay_id_,
+                          static_cast<td::uint32>(max_peers()), std::move(P));
+}
+
+void DownloadState::got_peers(std::vector<adnl::AdnlNodeIdShort> peers) {
+  finding_peers_ = false;
+  size_t usable = 0;
+  for (auto &it : peers_) {
+    if (it.second.failures < max_peer_failures()) {
+      usable++;
+    }
+  }
+  for (auto &peer : peers) {
+    if (usable >= max_peers()) {
+      break;
+    }
+    if (!peers_.emplace(peer, Peer{}).second) {
+      continue;
+    }
+    usable++;
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), peer](td::Result<td::BufferSlice> R) {
+      td::actor::send_closure(SelfId, &DownloadState::got_peer_state_size, peer, std::move(R));
+    });
+    send_size_query(peer, std::move(P));
+  }
+  request_parts();
+}
+
+void DownloadState::got_peer_state_size(adnl::AdnlNodeIdShort peer, td::Result<td::BufferSlice> R) {
+  auto &p = peers_[peer];
+  // the state is served only by nodes which have the file of the same size, nodes of older versions are not used
+  p.failures = max_peer_failures();
+  if (R.is_ok()) {
+    auto F = fetch_tl_object<ton_api::tonNode_PersistentStateSize>(R.move_as_ok(), true);
+    if (F.is_ok()) {
+      ton_api::downcast_call(*F.move_as_ok(), td::overloaded([&](ton_api::tonNode_persistentStateSizeNotFound &f) {},
+                                                             [&](ton_api::tonNode_persistentStateSize &f) {
+                                                               if (static_cast<td::uint64>(f.size_) == chunks_.size()) {
+                                                                 p.ready = true;
+                                                                 p.failures = 0;
+                                                               }
+                                                             }));
+    }
+  }
+  request_parts();
+}
+
+void DownloadState::request_parts() {
+  for (auto &it : peers_) {
+    auto &peer = it.second;
+    while (peer.ready && peer.failures < max_peer_failures() && peer.in_flight < max_parts_in_flight()) {
+      size_t idx;
+      if (!chunks_.take(idx)) {
+        return;
+      }
+      peer.in_flight++;
+      auto P = td::PromiseCreator::lambda(
+          [SelfId = actor_id(this), peer = it.first, idx](td::Result<td::BufferSlice> R) {
+            td::actor::send_closure(SelfId, &DownloadState::got_part, peer, idx, std::move(R));
+          });
+      send_part_query(it.first, chunks_.chunk_offset(idx), chunks_.chunk_size(idx), std::move(P));
+    }
+  }
+
+  bool pending = finding_peers_;
+  for (auto &it : peers_) {
+    pending |= it.second.in_flight > 0 || (!it.second.ready && it.second.failures < max_peer_failures());
+  }
+  if (!pending) {
+    abort_query(last_error_.is_error() ? last_error_.move_as_error_prefix("no nodes left: ")
+                                       : td::Status::Error(ErrorCode::notready, "no nodes"));
+  }
+}
+
+void DownloadState::got_part(adnl::AdnlNodeIdShort peer, size_t idx, td::Result<td::BufferSlice> R) {
+  auto &p = peers_[peer];
+  CHECK(p.in_flight > 0);
+  p.in_flight--;
+  if (R.is_ok() && R.ok().size() != chunks_.chunk_size(idx)) {
+    R = td::Status::Error(ErrorCode::protoviolation, PSTRING() << "bad state part size " << R.ok().size());
+  }
+  if (R.is_error()) {
+    VLOG(FULL_NODE_DEBUG) << "failed to download part of state " << block_id_ << " from " << peer << ": "
+                          << R.error();
+    chunks_.failed(idx);
+    last_error_ = R.move_as_error();
+    if (++p.failures == max_peer_failures() && find_peers_) {
+      find_peers();
+    }
+    request_parts();
+    return;
+  }
+
+  state_.as_slice().substr(static_cast<size_t>(chunks_.chunk_offset(idx))).copy_from(R.ok().as_slice());
+  chunks_.completed(idx);
+  if (chunks_.is_completed()) {
+    VLOG(FULL_NODE_DEBUG) << "downloaded state " << block_id_ << " of size " << chunks_.size() << " from "
+                          << peers_.size() << " nodes";
+    finish_query();
+    return;
+  }
+  request_parts();
+}
+
+void DownloadState::send_size_query(adnl::AdnlNodeIdShort peer, td::Promise<td::BufferSlice> promise) {
+  auto query = create_serialize_tl_object<ton_api::tonNode_getPersistentStateSize>(
+      create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_));
+  if (client_.empty()) {
+    td::actor::send_closure(overlays_, &overlay::Overlays::send_query, peer, local_id_, overlay_id_, "get state size",
+                            std::move(promise), td::Timestamp::in(1.0), std::move(query));
+  } else {
+    td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "get state size",
+                            create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(query)),
+                            td::Timestamp::in(1.0), std::move(promise));
+  }
+}
+
+void DownloadState::send_part_query(adnl::AdnlNodeIdShort peer, td::uint64 offset, td::uint32 size,
+                                    td::Promise<td::BufferSlice> promise) {
+  auto query = create_serialize_tl_object<ton_api::tonNode_downloadPersistentStateSlice>(
+      create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), offset, size);
+  if (client_.empty()) {
+    td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, peer, local_id_, overlay_id_,
+                            "download state", std::move(promise), td::Timestamp::in(10.0), std::move(query),
+                            size + 1024, rldp_);
+  } else {
+    td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "download state",
+                            create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(query)),
+                            td::Timestamp::in(10.0), std::move(promise));
+  }
+}
+
 }  // namespace fullnode
 
 }  // namespace validator
@@ -23,6 +23,9 @@
 #include "validator/validator.h"
 #include "rldp/rldp.h"
 #include "adnl/adnl-ext-client.h"
+#include "download-chunks.hpp"
+
+#include <map>
 
 namespace ton {
 
@@ -50,6 +53,27 @@ class DownloadState : public td::actor::Actor {
   void got_block_state_part(td::BufferSlice data, td::uint32 requested_size);
   void got_block_state(td::BufferSlice data);
 
+  void got_state_size(td::BufferSlice data);
+  void find_peers();
+  void got_peers(std::vector<adnl::AdnlNodeIdShort> peers);
+  void got_peer_state_size(adnl::AdnlNodeIdShort peer, td::Result<td::BufferSlice> R);
+  void request_parts();
+  void got_part(adnl::AdnlNodeIdShort peer, size_t idx, td::Result<td::BufferSlice> R);
+
+  static constexpr td::uint32 part_size() {
+    return 1 << 18;
+  }
+  // peers which serve disjoint parts of a persistent state at once
+  static constexpr size_t max_peers() {
+    return 4;
+  }
+  static constexpr td::uint32 max_parts_in_flight() {
+    return 2;
+  }
+  static constexpr td::uint32 max_peer_failures() {
+    return 3;
+  }
+
  private:
   BlockIdExt block_id_;
   BlockIdExt masterchain_block_id_;
@@ -72,6 +96,24 @@ class DownloadState : public td::actor::Actor {
   td::BufferSlice state_;
   std::vector<td::BufferSlice> parts_;
   td::uint64 sum_ = 0;
+
+  void send_size_query(adnl::AdnlNodeIdShort peer, td::Promise<td::BufferSlice> promise);
+  void send_part_query(adnl::AdnlNodeIdShort peer, td::uint64 offset, td::uint32 size,
+                       td::Promise<td::BufferSlice> promise);
+
+  struct Peer {
+    // answered getPersistentStateSize with the size of the state
+    bool ready = false;
+    td::uint32 in_flight = 0;
+    td::uint32 failures = 0;
+  };
+  // nodes which serve parts of the state, failed ones are kept so that they are not selected again
+  std::map<adnl::AdnlNodeIdShort, Peer> peers_;
+  // the state is downloaded from random nodes of the overlay, more of them are added when some fail
+  bool find_peers_ = false;
+  bool finding_peers_ = false;
+  DownloadChunks chunks_;
+  td::Status last_error_;
 };
 
 }  // namespace fullnode
@@ -34,11 +34,115 @@ void ValidatorGroup::generate_block_candidate(td::uint32 round_id, td::Promise<B
     promise.set_error(td::Status::Error(ErrorCode::notready, "cannot collate block: group not started"));
     return;
   }
+  if (precollated_ && precollated_->round_id == round_id && prev_block_ids_.size() == 1 &&
+      prev_block_ids_[0] == precollated_->prev && precollated_->started && !precollated_->waiting) {
+    if (!precollated_->ready) {
+      precollated_->waiting = std::move(promise);
+      return;
+    }
+    if (precollated_->result.is_ok()) {
+      auto p = std::move(precollated_);
+      precollated_used_++;
+      promise.set_value(p->result.move_as_ok());
+      return;
+    }
+  }
+  discard_precollated(BlockIdExt{});
+  collate_block_candidate(std::move(promise));
+}
+
+void ValidatorGroup::collate_block_candidate(td::Promise<BlockCandidate> promise) {
   run_collate_query(shard_, min_ts_, min_masterchain_block_id_, prev_block_ids_,
                     Ed25519_PublicKey{local_id_full_.ed25519_value().raw()}, validator_set_, manager_,
                     td::Timestamp::in(10.0), std::move(promise));
 }
 
+void ValidatorGroup::precollate_block_candidate(td::uint32 round_id, RootHash prev_root_hash,
+                                                FileHash prev_file_hash) {
+  if (!started_ || round_id <= last_known_round_id_) {
+    return;
+  }
+  auto prev = create_next_block_id(prev_root_hash, prev_file_hash);
+  if (precollated_ && precollated_->round_id == round_id && precollated_->prev == prev) {
+    return;
+  }
+  discard_precollated(BlockIdExt{});
+  precollated_ = std::make_unique<PrecollatedCandidate>();
+  precollated_->round_id = round_id;
+  precollated_->prev = prev;
+  start_precollation();
+}
+
+void ValidatorGroup::start_precollation() {
+  CHECK(precollated_ && !precollated_->started);
+  auto it = validated_candidates_.find(precollated_->prev);
+  if (it == validated_candidates_.end()) {
+    // the candidate is not validated locally yet, precollation starts as soon as its state is known
+    return;
+  }
+  auto round_id = precollated_->round_id;
+  auto prev = precollated_->prev;
+  VLOG(VALIDATOR_DEBUG) << "precollating round " << round_id << " on top of " << prev;
+  precollated_->started = true;
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), round_id, prev](td::Result<BlockCandidate> R) {
+    td::actor::send_closure(SelfId, &ValidatorGroup::precollated_block_candidate, round_id, prev, std::move(R));
+  });
+  // the collator works on the state computed by the validation, so it does not wait for the candidate to be applied
+  run_collate_query(shard_, min_ts_, min_masterchain_block_id_, std::vector<BlockIdExt>{prev},
+                    std::vector<td::Ref<ShardState>>{it->second.state},
+                    std::vector<td::Ref<BlockData>>{it->second.block}, Ed25519_PublicKey{local_id_full_.ed25519_value().raw()}, validator_set_, manager_,
+                    td::Timestamp::in(10.0), std::move(P));
+}
+
+void ValidatorGroup::precollated_block_candidate(td::uint32 round_id, BlockIdExt prev, td::Result<BlockCandidate> R) {
+  if (!precollated_ || precollated_->round_id != round_id || precollated_->prev != prev) {
+    return;
+  }
+  if (R.is_error()) {
+    VLOG(VALIDATOR_DEBUG) << "failed to precollate round " << round_id << ": " << R.error();
+  }
+  if (precollated_->waiting) {
+    auto promise = std::move(precollated_->waiting);
+    precollated_.reset();
+    if (R.is_ok()) {
+      precollated_used_++;
+      promise.set_value(R.move_as_ok());
+    } else {
+      precollated_discarded_++;
+      collate_block_candidate(std::move(promise));
+    }
+    return;
+  }
+  precollated_->ready = true;
+  precollated_->result = std::move(R);
+}
+
+void ValidatorGroup::discard_precollated(BlockIdExt committed_prev) {
+  if (!precollated_ || precollated_->prev == committed_prev) {
+    return;
+  }
+  auto p = std::move(precollated_);
+  precollated_discarded_++;
+  if (p->waiting) {
+    collate_block_candidate(std::move(p->waiting));
+  }
+}
+
+void ValidatorGroup::candidate_validated(td::uint32 round_id, BlockIdExt block_id, td::BufferSlice data,
+                                         td::Result<td::Ref<ShardState>> R) {
+  if (round_id != last_known_round_id_ || R.is_error()) {
+    return;
+  }
+  auto B = create_block(block_id, std::move(data));
+  if (B.is_error()) {
+    return;
+  }
+  validated_candidates_[block_id] = ValidatedCandidate{R.move_as_ok(), B.move_as_ok()};
+  if (precollated_ && !precollated_->started && precollated_->prev == block_id) {
+    start_precollation();
+  }
+}
+
 void ValidatorGroup::validate_block_candidate(td::uint32 round_id, BlockCandidate block,
                                               td::Promise<UnixTime> promise) {
   if (round_id > last_known_round_id_) {
@@ -77,8 +181,14 @@ void ValidatorGroup::validate_block_candidate(td::uint32 round_id, BlockCandidat
   auto next_block_id = create_next_block_id(block.id.root_hash, block.id.file_hash);
   VLOG(VALIDATOR_DEBUG) << "validating block candidate " << next_block_id;
   block.id = next_block_id;
+  // the new state is kept for precollation of the next round on top of this candidate
+  auto SP = td::PromiseCreator::lambda([SelfId = actor_id(this), round_id, block_id = next_block_id,
+                                        data = block.data.clone()](td::Result<td::Ref<ShardState>> R) mutable {
+    td::actor::send_closure(SelfId, &ValidatorGroup::candidate_validated, round_id, block_id, std::move(data),
+                            std::move(R));
+  });
   run_validate_query(shard_, min_ts_, min_masterchain_block_id_, prev_block_ids_, std::move(block), validator_set_,
-                     manager_, td::Timestamp::in(10.0), std::move(P));
+                     manager_, td::Timestamp::in(10.0), std::move(P), false, std::move(SP));
 }
 
 void ValidatorGroup::accept_block_candidate(td::uint32 round_id, PublicKeyHash src, td::BufferSlice block_data,
@@ -122,6 +232,8 @@ void ValidatorGroup::accept_block_candidate(td::uint32 round_id, PublicKeyHash s
   run_accept_block_query(next_block_id, std::move(block), prev_block_ids_, validator_set_, std::move(sig_set),
                          std::move(approve_sig_set), src == local_id_, manager_, std::move(P));
   prev_block_ids_ = std::vector<BlockIdExt>{next_block_id};
+  validated_candidates_.clear();
+  discard_precollated(next_block_id);
 }
 
 void ValidatorGroup::retry_accept_block_query(BlockIdExt block_id, td::Ref<BlockData> block,
@@ -147,6 +259,8 @@ void ValidatorGroup::skip_round(td::uint32 round_id) {
   if (round_id >= last_known_round_id_) {
     last_known_round_id_ = round_id + 1;
   }
+  validated_candidates_.clear();
+  discard_precollated(BlockIdExt{});
 }
 
 void ValidatorGroup::get_approved_candidate(PublicKey source, RootHash root_hash, FileHash file_hash,
@@ -195,6 +309,11 @@ std::unique_ptr<validatorsession::ValidatorSession::Callback> ValidatorGroup::ma
     void on_generate_slot(td::uint32 round, td::Promise<BlockCandidate> promise) override {
       td::actor::send_closure(id_, &ValidatorGroup::generate_block_candidate, round, std::move(promise));
     }
+    void on_precollate_slot(td::uint32 round, validatorsession::ValidatorSessionRootHash prev_root_hash,
+                            validatorsession::ValidatorSessionFileHash prev_file_hash) override {
+      td::actor::send_closure(id_, &ValidatorGroup::precollate_block_candidate, round, prev_root_hash,
+                              prev_file_hash);
+    }
     void on_block_committed(td::uint32 round, PublicKey source, validatorsession::ValidatorSessionRootHash root_hash,
                             validatorsession::ValidatorSessionFileHash file_hash, td::BufferSlice data,
                             std::vector<std::pair<PublicKeyHash, td::BufferSlice>> signatures,
@@ -293,6 +412,27 @@ void ValidatorGroup::start(std::vector<BlockIdExt> prev, BlockIdExt min_masterch
   postoned_accept_.clear();
 }
 
+void ValidatorGroup::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("precollatedused", td::to_string(precollated_used_));
+  vec.emplace_back("precollateddiscarded", td::to_string(precollated_discarded_));
+  if (session_.empty()) {
+    promise.set_value(std::move(vec));
+    return;
+  }
+  auto P = td::PromiseCreator::lambda(
+      [vec = std::move(vec), promise = std::move(promise)](
+          td::Result<std::vector<std::pair<std::string, std::string>>> R) mutable {
+        if (R.is_ok()) {
+          for (auto &el : R.move_as_ok()) {
+            vec.push_back(std::move(el));
+          }
+        }
+        promise.set_value(std::move(vec));
+      });
+  td::actor::send_closure(session_, &validatorsession::ValidatorSession::prepare_stats, std::move(P));
+}
+
 void ValidatorGroup::destroy() {
   if (!session_.empty()) {
     auto ses = session_.release();
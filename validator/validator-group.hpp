@@ -24,6 +24,9 @@
 
 #include "rldp/rldp.h"
 
+#include <list>
+#include <map>
+
 namespace ton {
 
 namespace validator {
@@ -33,6 +36,10 @@ class ValidatorManager;
 class ValidatorGroup : public td::actor::Actor {
  public:
   void generate_block_candidate(td::uint32 round_id, td::Promise<BlockCandidate> promise);
+  void precollate_block_candidate(td::uint32 round_id, RootHash prev_root_hash, FileHash prev_file_hash);
+  void precollated_block_candidate(td::uint32 round_id, BlockIdExt prev, td::Result<BlockCandidate> R);
+  void candidate_validated(td::uint32 round_id, BlockIdExt block_id, td::BufferSlice data,
+                           td::Result<td::Ref<ShardState>> R);
   void validate_block_candidate(td::uint32 round_id, BlockCandidate block, td::Promise<td::uint32> promise);
   void accept_block_candidate(td::uint32 round_id, PublicKeyHash src, td::BufferSlice block, RootHash root_hash,
                               FileHash file_hash, std::vector<BlockSignature> signatures,
@@ -48,6 +55,7 @@ class ValidatorGroup : public td::actor::Actor {
   void start(std::vector<BlockIdExt> prev, BlockIdExt min_masterchain_block_id, UnixTime min_ts);
   void create_session();
   void destroy();
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise);
   void start_up() override {
     if (init_) {
       init_ = false;
@@ -90,6 +98,30 @@ class ValidatorGroup : public td::actor::Actor {
 
   std::list<PostponedAccept> postoned_accept_;
 
+  // candidates of the current round validated locally, with the states computed by the validation
+  struct ValidatedCandidate {
+    td::Ref<ShardState> state;
+    td::Ref<BlockData> block;
+  };
+  std::map<BlockIdExt, ValidatedCandidate> validated_candidates_;
+
+  // speculative collation of round_id on top of a not yet committed candidate
+  struct PrecollatedCandidate {
+    td::uint32 round_id;
+    BlockIdExt prev;
+    bool started = false;
+    bool ready = false;
+    td::Result<BlockCandidate> result;
+    td::Promise<BlockCandidate> waiting;
+  };
+  std::unique_ptr<PrecollatedCandidate> precollated_;
+  td::uint64 precollated_used_ = 0;
+  td::uint64 precollated_discarded_ = 0;
+
+  void collate_block_candidate(td::Promise<BlockCandidate> promise);
+  void start_precollation();
+  void discard_precollated(BlockIdExt committed_prev);
+
   ShardIdFull shard_;
   PublicKeyHash local_id_;
   PublicKey local_id_full_;